@@ -206,6 +206,19 @@ extern const char *(*MEM_name_ptr)(void *vmemh);
 /* Switch allocator to slower but fully guarded mode. */
 void MEM_use_guarded_allocator(void);
 
+/* Switch allocator to size-class slabs with per-thread caches,
+ * faster for many small blocks. Like the switch above this must
+ * happen before any allocation. */
+void MEM_use_slab_allocator(void);
+
+/* Sample allocations of the current allocator by their name, keeping live
+ * bytes per name over time and at the peak. Call after choosing the allocator
+ * and before starting threads, 0 uses the default sample interval. */
+void MEM_use_heap_profiler(const char *filepath, size_t sample_interval);
+/* Write the heap profile as JSON to the file given above, false when the
+ * profiler isn't used or the file couldn't be written. */
+bool MEM_heap_profiler_write(void);
+
 #ifdef __cplusplus
 /* alloc funcs for C++ only */
 #define MEM_CXX_CLASS_ALLOC_FUNCS(_id)                                        \
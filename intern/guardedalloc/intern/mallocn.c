@@ -128,3 +128,33 @@ void MEM_use_guarded_allocator(void)
 	MEM_name_ptr = MEM_guarded_name_ptr;
 #endif
 }
+
+void MEM_use_slab_allocator(void)
+{
+	MEM_allocN_len = MEM_slab_allocN_len;
+	MEM_freeN = MEM_slab_freeN;
+	MEM_dupallocN = MEM_slab_dupallocN;
+	MEM_reallocN_id = MEM_slab_reallocN_id;
+	MEM_recallocN_id = MEM_slab_recallocN_id;
+	MEM_callocN = MEM_slab_callocN;
+	MEM_mallocN = MEM_slab_mallocN;
+	MEM_mallocN_aligned = MEM_slab_mallocN_aligned;
+	MEM_mapallocN = MEM_slab_mapallocN;
+	MEM_printmemlist_pydict = MEM_slab_printmemlist_pydict;
+	MEM_printmemlist = MEM_slab_printmemlist;
+	MEM_callbackmemlist = MEM_slab_callbackmemlist;
+	MEM_printmemlist_stats = MEM_slab_printmemlist_stats;
+	MEM_set_error_callback = MEM_slab_set_error_callback;
+	MEM_check_memory_integrity = MEM_slab_check_memory_integrity;
+	MEM_set_lock_callback = MEM_slab_set_lock_callback;
+	MEM_set_memory_debug = MEM_slab_set_memory_debug;
+	MEM_get_memory_in_use = MEM_slab_get_memory_in_use;
+	MEM_get_mapped_memory_in_use = MEM_slab_get_mapped_memory_in_use;
+	MEM_get_memory_blocks_in_use = MEM_slab_get_memory_blocks_in_use;
+	MEM_reset_peak_memory = MEM_slab_reset_peak_memory;
+	MEM_get_peak_memory = MEM_slab_get_peak_memory;
+
+#ifndef NDEBUG
+	MEM_name_ptr = MEM_slab_name_ptr;
+#endif
+}
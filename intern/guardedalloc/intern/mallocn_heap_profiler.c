@@ -0,0 +1,715 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file guardedalloc/intern/mallocn_heap_profiler.c
+ *  \ingroup MEM
+ *
+ * Sampling heap profiler, works on top of any of the allocators.
+ *
+ * Instead of recording every block, one allocation per #sample_interval
+ * allocated bytes (on average) is recorded and accounts for all the bytes
+ * since the previous sample. This keeps the cost of the common path to a
+ * thread local counter on allocation and a table lookup on free, so it can
+ * be used on production scenes with the lock-free allocator.
+ *
+ * Samples are grouped by the name passed to the allocation functions, for
+ * each name the estimated live bytes are kept, sampled over time, and stored
+ * at the moment the total was highest.
+ *
+ * All profiler state is allocated with the system allocator.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef WIN32
+#  include <windows.h>
+#else
+#  include <sys/time.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
+/* to ensure strict conversions */
+#include "../../source/blender/blenlib/BLI_strict_flags.h"
+
+#include "atomic_ops.h"
+#include "mallocn_intern.h"
+
+/* Same default as tcmalloc uses, low enough to see anything relevant. */
+#define HEAP_PROFILER_SAMPLE_INTERVAL_DEFAULT (512 * 1024)
+
+/* Counting filter of sampled addresses, so most frees don't need the lock. */
+#define HEAP_PROFILER_FILTER_BITS 16
+
+/* Timeline is thinned out (and its interval doubled) when it gets this long. */
+#define HEAP_PROFILER_SNAPSHOT_MAX 512
+#define HEAP_PROFILER_SNAPSHOT_INTERVAL_DEFAULT 0.1
+
+/* Power of two size histogram buckets. */
+#define HEAP_PROFILER_SIZE_BUCKETS 48
+
+typedef struct HeapProfTag {
+	const char *name;
+	unsigned int hash;
+	/* Estimated from the samples. */
+	size_t alloc_num, alloc_bytes;
+	size_t live_bytes, peak_live_bytes;
+	size_t size_buckets[HEAP_PROFILER_SIZE_BUCKETS];
+} HeapProfTag;
+
+typedef struct HeapProfSample {
+	struct HeapProfSample *next;
+	const void *ptr;
+	unsigned int tag;
+	size_t weight;
+} HeapProfSample;
+
+typedef struct HeapProfSnapshot {
+	double time;
+	size_t live_bytes;
+	/* Live bytes of the first tags_num tags, the ones added later were zero. */
+	unsigned int tags_num;
+	size_t values_offset;
+} HeapProfSnapshot;
+
+static struct {
+	bool is_enabled;
+	char filepath[1024];
+	size_t sample_interval;
+	double time_start;
+
+	size_t lock;
+
+	/* Tags, with an open addressing hash of 1-based indices. */
+	HeapProfTag *tags;
+	unsigned int tags_num, tags_alloc;
+	unsigned int *tags_hash;
+	unsigned int tags_hash_size;
+
+	/* Live samples, chained hash by address. */
+	HeapProfSample **samples_hash;
+	unsigned int samples_hash_size, samples_num;
+	HeapProfSample *samples_free;
+
+	/* Totals. */
+	size_t live_bytes;
+	size_t peak_live_bytes;
+	double peak_time;
+	size_t *peak_tag_bytes;
+	unsigned int peak_tags_num;
+
+	/* Live bytes per tag over time. */
+	HeapProfSnapshot *snapshots;
+	unsigned int snapshots_num;
+	size_t *snapshot_values;
+	size_t snapshot_values_num, snapshot_values_alloc;
+	double snapshot_interval;
+
+	/* Allocator which does the actual work. */
+	void (*freeN)(void *vmemh);
+	void *(*dupallocN)(const void *vmemh);
+	void *(*reallocN_id)(void *vmemh, size_t len, const char *str);
+	void *(*recallocN_id)(void *vmemh, size_t len, const char *str);
+	void *(*callocN)(size_t len, const char *str);
+	void *(*mallocN)(size_t len, const char *str);
+	void *(*mallocN_aligned)(size_t len, size_t alignment, const char *str);
+	void *(*mapallocN)(size_t len, const char *str);
+} heap_profiler = {false};
+
+static unsigned short heap_profiler_filter[1 << HEAP_PROFILER_FILTER_BITS];
+
+/* Bytes this thread may still allocate before the next sample, zero until initialized. */
+static MEM_THREAD_LOCAL size_t heap_profiler_thread_countdown = 0;
+static MEM_THREAD_LOCAL unsigned int heap_profiler_thread_seed = 0;
+
+/* -------------------------------------------------------------------- */
+/* Utilities */
+
+static double heap_profiler_time(void)
+{
+#ifdef WIN32
+	static LARGE_INTEGER frequency = {0};
+	LARGE_INTEGER counter;
+	if (frequency.QuadPart == 0) {
+		QueryPerformanceFrequency(&frequency);
+	}
+	QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+#endif
+}
+
+MEM_INLINE void heap_profiler_lock(void)
+{
+	while (atomic_cas_z(&heap_profiler.lock, 0, 1) != 0) {
+		/* pass */
+	}
+}
+
+MEM_INLINE void heap_profiler_unlock(void)
+{
+	atomic_cas_z(&heap_profiler.lock, 1, 0);
+}
+
+MEM_INLINE unsigned int heap_profiler_ptr_hash(const void *ptr)
+{
+	/* blocks are at least 4 byte aligned, mix the rest */
+	const size_t key = (size_t)ptr >> 4;
+	return (unsigned int)((key * (size_t)0x9E3779B97F4A7C15ull) >> (sizeof(size_t) * 8 - 32));
+}
+
+MEM_INLINE unsigned int heap_profiler_filter_index(unsigned int hash)
+{
+	return hash >> (32 - HEAP_PROFILER_FILTER_BITS);
+}
+
+static unsigned int heap_profiler_name_hash(const char *name)
+{
+	/* FNV-1a */
+	unsigned int hash = 2166136261u;
+	for (; *name; name++) {
+		hash = (hash ^ (unsigned char)*name) * 16777619u;
+	}
+	return hash;
+}
+
+/* Randomized around the sample interval, to avoid aliasing with regular allocation patterns. */
+static size_t heap_profiler_next_countdown(void)
+{
+	heap_profiler_thread_seed = heap_profiler_thread_seed * 1103515245u + 12345u;
+	return heap_profiler.sample_interval / 2 +
+	       (size_t)(heap_profiler_thread_seed >> 8) % (heap_profiler.sample_interval + 1);
+}
+
+static unsigned int heap_profiler_size_bucket(size_t len)
+{
+	unsigned int bucket = 0;
+	while ((len >>= 1) && bucket < HEAP_PROFILER_SIZE_BUCKETS - 1) {
+		bucket++;
+	}
+	return bucket;
+}
+
+/* -------------------------------------------------------------------- */
+/* Tables, all called with the lock held */
+
+static bool heap_profiler_tags_hash_resize(unsigned int size)
+{
+	unsigned int *tags_hash = calloc(size, sizeof(*tags_hash));
+	unsigned int i;
+
+	if (tags_hash == NULL) {
+		return false;
+	}
+
+	for (i = 0; i < heap_profiler.tags_num; i++) {
+		unsigned int slot = heap_profiler.tags[i].hash & (size - 1);
+		while (tags_hash[slot]) {
+			slot = (slot + 1) & (size - 1);
+		}
+		tags_hash[slot] = i + 1;
+	}
+
+	free(heap_profiler.tags_hash);
+	heap_profiler.tags_hash = tags_hash;
+	heap_profiler.tags_hash_size = size;
+	return true;
+}
+
+/* Tags are matched by name, the same name can have different addresses. */
+static bool heap_profiler_tag_ensure(const char *name, unsigned int *r_tag)
+{
+	const unsigned int hash = heap_profiler_name_hash(name);
+	unsigned int slot;
+	HeapProfTag *tag;
+
+	if (heap_profiler.tags_num * 2 >= heap_profiler.tags_hash_size) {
+		if (!heap_profiler_tags_hash_resize(heap_profiler.tags_hash_size ? heap_profiler.tags_hash_size * 2 : 256)) {
+			return false;
+		}
+	}
+
+	slot = hash & (heap_profiler.tags_hash_size - 1);
+	while (heap_profiler.tags_hash[slot]) {
+		const unsigned int index = heap_profiler.tags_hash[slot] - 1;
+		tag = &heap_profiler.tags[index];
+		if (tag->hash == hash && (tag->name == name || strcmp(tag->name, name) == 0)) {
+			*r_tag = index;
+			return true;
+		}
+		slot = (slot + 1) & (heap_profiler.tags_hash_size - 1);
+	}
+
+	if (heap_profiler.tags_num == heap_profiler.tags_alloc) {
+		const unsigned int tags_alloc = heap_profiler.tags_alloc ? heap_profiler.tags_alloc * 2 : 128;
+		HeapProfTag *tags = realloc(heap_profiler.tags, sizeof(*tags) * tags_alloc);
+		if (tags == NULL) {
+			return false;
+		}
+		heap_profiler.tags = tags;
+		heap_profiler.tags_alloc = tags_alloc;
+	}
+
+	tag = &heap_profiler.tags[heap_profiler.tags_num];
+	memset(tag, 0, sizeof(*tag));
+	tag->name = name;
+	tag->hash = hash;
+
+	heap_profiler.tags_hash[slot] = heap_profiler.tags_num + 1;
+	*r_tag = heap_profiler.tags_num++;
+	return true;
+}
+
+static void heap_profiler_samples_hash_resize(unsigned int size)
+{
+	HeapProfSample **samples_hash = calloc(size, sizeof(*samples_hash));
+	unsigned int i;
+
+	if (samples_hash == NULL) {
+		/* keep the chains longer than we'd like */
+		return;
+	}
+
+	for (i = 0; i < heap_profiler.samples_hash_size; i++) {
+		HeapProfSample *sample = heap_profiler.samples_hash[i], *sample_next;
+		for (; sample; sample = sample_next) {
+			const unsigned int slot = heap_profiler_ptr_hash(sample->ptr) & (size - 1);
+			sample_next = sample->next;
+			sample->next = samples_hash[slot];
+			samples_hash[slot] = sample;
+		}
+	}
+
+	free(heap_profiler.samples_hash);
+	heap_profiler.samples_hash = samples_hash;
+	heap_profiler.samples_hash_size = size;
+}
+
+static void heap_profiler_snapshot_add(double time)
+{
+	HeapProfSnapshot *snapshot;
+	unsigned int i;
+
+	if (heap_profiler.snapshots_num == HEAP_PROFILER_SNAPSHOT_MAX) {
+		/* keep every other snapshot */
+		size_t values_num = 0;
+		for (i = 0; i < HEAP_PROFILER_SNAPSHOT_MAX / 2; i++) {
+			HeapProfSnapshot *src = &heap_profiler.snapshots[i * 2 + 1];
+			memmove(&heap_profiler.snapshot_values[values_num],
+			        &heap_profiler.snapshot_values[src->values_offset],
+			        sizeof(*heap_profiler.snapshot_values) * src->tags_num);
+			src->values_offset = values_num;
+			values_num += src->tags_num;
+			heap_profiler.snapshots[i] = *src;
+		}
+		heap_profiler.snapshots_num = HEAP_PROFILER_SNAPSHOT_MAX / 2;
+		heap_profiler.snapshot_values_num = values_num;
+		heap_profiler.snapshot_interval *= 2.0;
+	}
+
+	if (heap_profiler.snapshot_values_num + heap_profiler.tags_num > heap_profiler.snapshot_values_alloc) {
+		size_t values_alloc = heap_profiler.snapshot_values_alloc ? heap_profiler.snapshot_values_alloc * 2 : 4096;
+		size_t *values;
+		while (values_alloc < heap_profiler.snapshot_values_num + heap_profiler.tags_num) {
+			values_alloc *= 2;
+		}
+		values = realloc(heap_profiler.snapshot_values, sizeof(*values) * values_alloc);
+		if (values == NULL) {
+			return;
+		}
+		heap_profiler.snapshot_values = values;
+		heap_profiler.snapshot_values_alloc = values_alloc;
+	}
+
+	snapshot = &heap_profiler.snapshots[heap_profiler.snapshots_num++];
+	snapshot->time = time;
+	snapshot->live_bytes = heap_profiler.live_bytes;
+	snapshot->tags_num = heap_profiler.tags_num;
+	snapshot->values_offset = heap_profiler.snapshot_values_num;
+
+	for (i = 0; i < heap_profiler.tags_num; i++) {
+		heap_profiler.snapshot_values[heap_profiler.snapshot_values_num++] = heap_profiler.tags[i].live_bytes;
+	}
+}
+
+static void heap_profiler_peak_update(double time)
+{
+	unsigned int i;
+
+	if (heap_profiler.live_bytes <= heap_profiler.peak_live_bytes) {
+		return;
+	}
+
+	if (heap_profiler.tags_num > heap_profiler.peak_tags_num) {
+		size_t *peak_tag_bytes = realloc(heap_profiler.peak_tag_bytes,
+		                                 sizeof(*peak_tag_bytes) * heap_profiler.tags_alloc);
+		if (peak_tag_bytes == NULL) {
+			return;
+		}
+		heap_profiler.peak_tag_bytes = peak_tag_bytes;
+	}
+
+	heap_profiler.peak_live_bytes = heap_profiler.live_bytes;
+	heap_profiler.peak_time = time;
+	heap_profiler.peak_tags_num = heap_profiler.tags_num;
+	for (i = 0; i < heap_profiler.tags_num; i++) {
+		heap_profiler.peak_tag_bytes[i] = heap_profiler.tags[i].live_bytes;
+	}
+}
+
+/* -------------------------------------------------------------------- */
+/* Events */
+
+static void heap_profiler_sample_add(const void *ptr, size_t len, size_t weight, const char *str)
+{
+	const unsigned int hash = heap_profiler_ptr_hash(ptr);
+	const double time = heap_profiler_time() - heap_profiler.time_start;
+	HeapProfSample *sample;
+	HeapProfTag *tag;
+	unsigned int tag_index;
+
+	heap_profiler_lock();
+
+	if (!heap_profiler_tag_ensure(str, &tag_index)) {
+		heap_profiler_unlock();
+		return;
+	}
+
+	if (heap_profiler.samples_free) {
+		sample = heap_profiler.samples_free;
+		heap_profiler.samples_free = sample->next;
+	}
+	else if ((sample = malloc(sizeof(*sample))) == NULL) {
+		heap_profiler_unlock();
+		return;
+	}
+
+	if (heap_profiler.samples_num >= heap_profiler.samples_hash_size) {
+		heap_profiler_samples_hash_resize(heap_profiler.samples_hash_size ? heap_profiler.samples_hash_size * 2 : 1024);
+		if (heap_profiler.samples_hash == NULL) {
+			sample->next = heap_profiler.samples_free;
+			heap_profiler.samples_free = sample;
+			heap_profiler_unlock();
+			return;
+		}
+	}
+
+	sample->ptr = ptr;
+	sample->tag = tag_index;
+	sample->weight = weight;
+	sample->next = heap_profiler.samples_hash[hash & (heap_profiler.samples_hash_size - 1)];
+	heap_profiler.samples_hash[hash & (heap_profiler.samples_hash_size - 1)] = sample;
+	heap_profiler.samples_num++;
+	heap_profiler_filter[heap_profiler_filter_index(hash)]++;
+
+	tag = &heap_profiler.tags[tag_index];
+	tag->alloc_num += weight / (len ? len : 1);
+	tag->alloc_bytes += weight;
+	tag->size_buckets[heap_profiler_size_bucket(len)] += weight / (len ? len : 1);
+	tag->live_bytes += weight;
+	if (tag->live_bytes > tag->peak_live_bytes) {
+		tag->peak_live_bytes = tag->live_bytes;
+	}
+	heap_profiler.live_bytes += weight;
+
+	heap_profiler_peak_update(time);
+
+	if (heap_profiler.snapshots_num == 0 ||
+	    time - heap_profiler.snapshots[heap_profiler.snapshots_num - 1].time >= heap_profiler.snapshot_interval)
+	{
+		heap_profiler_snapshot_add(time);
+	}
+
+	heap_profiler_unlock();
+}
+
+static void heap_profiler_sample_remove(const void *ptr)
+{
+	const unsigned int hash = heap_profiler_ptr_hash(ptr);
+	HeapProfSample **sample_p;
+
+	heap_profiler_lock();
+
+	for (sample_p = &heap_profiler.samples_hash[hash & (heap_profiler.samples_hash_size - 1)];
+	     *sample_p;
+	     sample_p = &(*sample_p)->next)
+	{
+		HeapProfSample *sample = *sample_p;
+		if (sample->ptr == ptr) {
+			HeapProfTag *tag = &heap_profiler.tags[sample->tag];
+			tag->live_bytes -= sample->weight;
+			heap_profiler.live_bytes -= sample->weight;
+
+			*sample_p = sample->next;
+			sample->next = heap_profiler.samples_free;
+			heap_profiler.samples_free = sample;
+			heap_profiler.samples_num--;
+			heap_profiler_filter[heap_profiler_filter_index(hash)]--;
+			break;
+		}
+	}
+
+	heap_profiler_unlock();
+}
+
+MEM_INLINE void heap_profiler_alloc_event(const void *ptr, size_t len, const char *str)
+{
+	if (UNLIKELY(heap_profiler_thread_countdown == 0)) {
+		/* first allocation of this thread, give each thread its own sequence */
+		heap_profiler_thread_seed = (unsigned int)(size_t)&heap_profiler_thread_seed;
+		heap_profiler_thread_countdown = heap_profiler_next_countdown();
+	}
+
+	if (LIKELY(len < heap_profiler_thread_countdown)) {
+		heap_profiler_thread_countdown -= len;
+	}
+	else if (ptr) {
+		/* this block stands for all the bytes allocated since the previous sample */
+		const size_t weight = len > heap_profiler.sample_interval ? len : heap_profiler.sample_interval;
+		heap_profiler_thread_countdown = heap_profiler_next_countdown();
+		heap_profiler_sample_add(ptr, len, weight, str);
+	}
+}
+
+MEM_INLINE void heap_profiler_free_event(const void *ptr)
+{
+	/* must happen before the block is freed, another thread could get the same address */
+	if (ptr && heap_profiler_filter[heap_profiler_filter_index(heap_profiler_ptr_hash(ptr))]) {
+		heap_profiler_sample_remove(ptr);
+	}
+}
+
+/* -------------------------------------------------------------------- */
+/* Allocator wrappers */
+
+static void heap_profiler_freeN(void *vmemh)
+{
+	heap_profiler_free_event(vmemh);
+	heap_profiler.freeN(vmemh);
+}
+
+static void *heap_profiler_dupallocN(const void *vmemh)
+{
+	void *newp = heap_profiler.dupallocN(vmemh);
+	heap_profiler_alloc_event(newp, MEM_allocN_len(newp), "dupli_alloc");
+	return newp;
+}
+
+static void *heap_profiler_reallocN_id(void *vmemh, size_t len, const char *str)
+{
+	void *newp;
+	heap_profiler_free_event(vmemh);
+	newp = heap_profiler.reallocN_id(vmemh, len, str);
+	heap_profiler_alloc_event(newp, len, str);
+	return newp;
+}
+
+static void *heap_profiler_recallocN_id(void *vmemh, size_t len, const char *str)
+{
+	void *newp;
+	heap_profiler_free_event(vmemh);
+	newp = heap_profiler.recallocN_id(vmemh, len, str);
+	heap_profiler_alloc_event(newp, len, str);
+	return newp;
+}
+
+static void *heap_profiler_callocN(size_t len, const char *str)
+{
+	void *ptr = heap_profiler.callocN(len, str);
+	heap_profiler_alloc_event(ptr, len, str);
+	return ptr;
+}
+
+static void *heap_profiler_mallocN(size_t len, const char *str)
+{
+	void *ptr = heap_profiler.mallocN(len, str);
+	heap_profiler_alloc_event(ptr, len, str);
+	return ptr;
+}
+
+static void *heap_profiler_mallocN_aligned(size_t len, size_t alignment, const char *str)
+{
+	void *ptr = heap_profiler.mallocN_aligned(len, alignment, str);
+	heap_profiler_alloc_event(ptr, len, str);
+	return ptr;
+}
+
+static void *heap_profiler_mapallocN(size_t len, const char *str)
+{
+	void *ptr = heap_profiler.mapallocN(len, str);
+	heap_profiler_alloc_event(ptr, len, str);
+	return ptr;
+}
+
+/* -------------------------------------------------------------------- */
+/* JSON export */
+
+static void heap_profiler_write_string(FILE *fp, const char *str)
+{
+	fputc('"', fp);
+	for (; *str; str++) {
+		const unsigned char c = (unsigned char)*str;
+		if (c == '"' || c == '\\') {
+			fprintf(fp, "\\%c", c);
+		}
+		else if (c < 0x20) {
+			fprintf(fp, "\\u%04x", c);
+		}
+		else {
+			fputc(c, fp);
+		}
+	}
+	fputc('"', fp);
+}
+
+static void heap_profiler_write_values(FILE *fp, const size_t *values, unsigned int values_num)
+{
+	unsigned int i;
+	fputc('[', fp);
+	for (i = 0; i < values_num; i++) {
+		fprintf(fp, "%s" SIZET_FORMAT, i ? ", " : "", SIZET_ARG(values[i]));
+	}
+	fputc(']', fp);
+}
+
+static void heap_profiler_write_json_fp(FILE *fp, double time)
+{
+	unsigned int i, j;
+
+	fprintf(fp, "{\n");
+	fprintf(fp, "\t\"sample_interval\": " SIZET_FORMAT ",\n", SIZET_ARG(heap_profiler.sample_interval));
+	fprintf(fp, "\t\"duration\": %.6f,\n", time);
+	fprintf(fp, "\t\"live_bytes\": " SIZET_FORMAT ",\n", SIZET_ARG(heap_profiler.live_bytes));
+	fprintf(fp, "\t\"peak_live_bytes\": " SIZET_FORMAT ",\n", SIZET_ARG(heap_profiler.peak_live_bytes));
+	fprintf(fp, "\t\"peak_time\": %.6f,\n", heap_profiler.peak_time);
+
+	/* per tag totals, the timeline refers to tags by their index in this array */
+	fprintf(fp, "\t\"tags\": [\n");
+	for (i = 0; i < heap_profiler.tags_num; i++) {
+		const HeapProfTag *tag = &heap_profiler.tags[i];
+		bool is_first = true;
+
+		fprintf(fp, "\t\t{\"name\": ");
+		heap_profiler_write_string(fp, tag->name);
+		fprintf(fp, ", \"alloc_count\": " SIZET_FORMAT, SIZET_ARG(tag->alloc_num));
+		fprintf(fp, ", \"alloc_bytes\": " SIZET_FORMAT, SIZET_ARG(tag->alloc_bytes));
+		fprintf(fp, ", \"live_bytes\": " SIZET_FORMAT, SIZET_ARG(tag->live_bytes));
+		fprintf(fp, ", \"peak_live_bytes\": " SIZET_FORMAT, SIZET_ARG(tag->peak_live_bytes));
+		fprintf(fp, ", \"live_bytes_at_peak\": " SIZET_FORMAT,
+		        SIZET_ARG(i < heap_profiler.peak_tags_num ? heap_profiler.peak_tag_bytes[i] : 0));
+
+		/* allocation count by size, keyed by the lower bound of each power of two range */
+		fprintf(fp, ", \"sizes\": {");
+		for (j = 0; j < HEAP_PROFILER_SIZE_BUCKETS; j++) {
+			if (tag->size_buckets[j]) {
+				fprintf(fp, "%s\"" SIZET_FORMAT "\": " SIZET_FORMAT,
+				        is_first ? "" : ", ", SIZET_ARG((size_t)1 << j), SIZET_ARG(tag->size_buckets[j]));
+				is_first = false;
+			}
+		}
+		fprintf(fp, "}}%s\n", (i + 1 < heap_profiler.tags_num) ? "," : "");
+	}
+	fprintf(fp, "\t],\n");
+
+	fprintf(fp, "\t\"timeline\": [\n");
+	for (i = 0; i < heap_profiler.snapshots_num; i++) {
+		const HeapProfSnapshot *snapshot = &heap_profiler.snapshots[i];
+		fprintf(fp, "\t\t{\"time\": %.6f, \"live_bytes\": " SIZET_FORMAT ", \"tags\": ",
+		        snapshot->time, SIZET_ARG(snapshot->live_bytes));
+		heap_profiler_write_values(fp, &heap_profiler.snapshot_values[snapshot->values_offset], snapshot->tags_num);
+		fprintf(fp, "}%s\n", (i + 1 < heap_profiler.snapshots_num) ? "," : "");
+	}
+	fprintf(fp, "\t]\n");
+
+	fprintf(fp, "}\n");
+}
+
+/* -------------------------------------------------------------------- */
+/* API */
+
+void MEM_use_heap_profiler(const char *filepath, size_t sample_interval)
+{
+	if (heap_profiler.is_enabled) {
+		return;
+	}
+
+	heap_profiler.snapshots = malloc(sizeof(*heap_profiler.snapshots) * HEAP_PROFILER_SNAPSHOT_MAX);
+	if (heap_profiler.snapshots == NULL) {
+		return;
+	}
+
+	strncpy(heap_profiler.filepath, filepath, sizeof(heap_profiler.filepath) - 1);
+	heap_profiler.sample_interval = sample_interval ? sample_interval : HEAP_PROFILER_SAMPLE_INTERVAL_DEFAULT;
+	heap_profiler.snapshot_interval = HEAP_PROFILER_SNAPSHOT_INTERVAL_DEFAULT;
+	heap_profiler.time_start = heap_profiler_time();
+
+	heap_profiler.freeN = MEM_freeN;
+	heap_profiler.dupallocN = MEM_dupallocN;
+	heap_profiler.reallocN_id = MEM_reallocN_id;
+	heap_profiler.recallocN_id = MEM_recallocN_id;
+	heap_profiler.callocN = MEM_callocN;
+	heap_profiler.mallocN = MEM_mallocN;
+	heap_profiler.mallocN_aligned = MEM_mallocN_aligned;
+	heap_profiler.mapallocN = MEM_mapallocN;
+
+	MEM_freeN = heap_profiler_freeN;
+	MEM_dupallocN = heap_profiler_dupallocN;
+	MEM_reallocN_id = heap_profiler_reallocN_id;
+	MEM_recallocN_id = heap_profiler_recallocN_id;
+	MEM_callocN = heap_profiler_callocN;
+	MEM_mallocN = heap_profiler_mallocN;
+	MEM_mallocN_aligned = heap_profiler_mallocN_aligned;
+	MEM_mapallocN = heap_profiler_mapallocN;
+
+	heap_profiler.is_enabled = true;
+}
+
+bool MEM_heap_profiler_write(void)
+{
+	FILE *fp;
+	double time;
+
+	if (!heap_profiler.is_enabled) {
+		return false;
+	}
+
+	fp = fopen(heap_profiler.filepath, "w");
+	if (fp == NULL) {
+		printf("Couldn't write heap profile to '%s'\n", heap_profiler.filepath);
+		return false;
+	}
+
+	heap_profiler_lock();
+	time = heap_profiler_time() - heap_profiler.time_start;
+	/* the state at the end (usually the leaks) */
+	heap_profiler_snapshot_add(time);
+	heap_profiler_write_json_fp(fp, time);
+	heap_profiler_unlock();
+
+	fclose(fp);
+
+	printf("Heap profile written to '%s'\n", heap_profiler.filepath);
+	return true;
+}
@@ -0,0 +1,750 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file guardedalloc/intern/mallocn_slab_impl.c
+ *  \ingroup MEM
+ *
+ * Memory allocation which serves small blocks from size-class slabs.
+ *
+ * Blocks up to #SLAB_BLOCK_SIZE_MAX bytes (header included) are carved from
+ * big chunks and recycled through per-size-class free lists. Each thread keeps
+ * a small cache of free blocks per class, so the common alloc/free pair doesn't
+ * touch any shared state besides the memory counters. Bigger and aligned blocks
+ * go to the system allocator, exactly like the lock-free allocator does.
+ *
+ * The block header is the same as in the lock-free allocator, the size class is
+ * derived from the stored length, so #MEM_allocN_len works unchanged.
+ *
+ * Chunks are never given back to the system, freed blocks stay in the pools
+ * of their size class.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h> /* memcpy */
+#include <stdarg.h>
+#include <sys/types.h>
+
+#ifndef WIN32
+#  include <pthread.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
+/* to ensure strict conversions */
+#include "../../source/blender/blenlib/BLI_strict_flags.h"
+
+#include "atomic_ops.h"
+#include "mallocn_intern.h"
+
+typedef struct MemHead {
+	/* Length of allocated memory block. */
+	size_t len;
+} MemHead;
+
+typedef struct MemHeadAligned {
+	short alignment;
+	size_t len;
+} MemHeadAligned;
+
+enum {
+	MEMHEAD_MMAP_FLAG = 1,
+	MEMHEAD_ALIGN_FLAG = 2,
+};
+
+#define MEMHEAD_FROM_PTR(ptr) (((MemHead*) vmemh) - 1)
+#define PTR_FROM_MEMHEAD(memhead) (memhead + 1)
+#define MEMHEAD_ALIGNED_FROM_PTR(ptr) (((MemHeadAligned*) vmemh) - 1)
+#define MEMHEAD_IS_MMAP(memhead) ((memhead)->len & (size_t) MEMHEAD_MMAP_FLAG)
+#define MEMHEAD_IS_ALIGNED(memhead) ((memhead)->len & (size_t) MEMHEAD_ALIGN_FLAG)
+
+/* Size classes: 16 byte steps up to 256 bytes, then 64 byte steps up to 1024 bytes. */
+#define SLAB_BLOCK_SIZE_SMALL_MAX 256
+#define SLAB_BLOCK_SIZE_MAX 1024
+#define SLAB_CLASS_NUM (SLAB_BLOCK_SIZE_SMALL_MAX / 16 + (SLAB_BLOCK_SIZE_MAX - SLAB_BLOCK_SIZE_SMALL_MAX) / 64)
+
+/* Size of the chunks blocks are carved from. */
+#define SLAB_CHUNK_SIZE (64 * 1024)
+
+/* Number of free blocks moved between a thread cache and the shared pool at once. */
+#define SLAB_THREAD_CACHE_BATCH 32
+/* Thread cache gives half of its blocks back to the shared pool above this. */
+#define SLAB_THREAD_CACHE_MAX (SLAB_THREAD_CACHE_BATCH * 4)
+
+typedef struct SlabFreeBlock {
+	struct SlabFreeBlock *next;
+} SlabFreeBlock;
+
+/* Shared pool of one size class. */
+typedef struct SlabClass {
+	/* size_t, atomic_cas_u works on pointer sized integers on 64 bit. */
+	size_t lock;
+	unsigned int free_num;
+	SlabFreeBlock *free;
+	/* Not yet used part of the most recent chunk. */
+	char *chunk_cur, *chunk_end;
+	size_t chunk_num;
+} SlabClass;
+
+typedef struct SlabThreadCache {
+	SlabFreeBlock *free[SLAB_CLASS_NUM];
+	unsigned int free_num[SLAB_CLASS_NUM];
+	bool is_registered;
+} SlabThreadCache;
+
+static unsigned int totblock = 0;
+static size_t mem_in_use = 0, mmap_in_use = 0, peak_mem = 0, slab_in_use = 0;
+static bool malloc_debug_memset = false;
+
+static void (*error_callback)(const char *) = NULL;
+static void (*thread_lock_callback)(void) = NULL;
+static void (*thread_unlock_callback)(void) = NULL;
+
+static SlabClass slab_classes[SLAB_CLASS_NUM];
+static MEM_THREAD_LOCAL SlabThreadCache slab_thread_cache;
+
+/* Uncomment this to have proper peak counter. */
+#define USE_ATOMIC_MAX
+
+MEM_INLINE void update_maximum(size_t *maximum_value, size_t value)
+{
+#ifdef USE_ATOMIC_MAX
+	size_t prev_value = *maximum_value;
+	while (prev_value < value) {
+		if (atomic_cas_z(maximum_value, prev_value, value) != prev_value) {
+			break;
+		}
+	}
+#else
+	*maximum_value = value > *maximum_value ? value : *maximum_value;
+#endif
+}
+
+#ifdef __GNUC__
+__attribute__ ((format(printf, 1, 2)))
+#endif
+static void print_error(const char *str, ...)
+{
+	char buf[512];
+	va_list ap;
+
+	va_start(ap, str);
+	vsnprintf(buf, sizeof(buf), str, ap);
+	va_end(ap);
+	buf[sizeof(buf) - 1] = '\0';
+
+	if (error_callback) {
+		error_callback(buf);
+	}
+}
+
+#if defined(WIN32)
+static void mem_lock_thread(void)
+{
+	if (thread_lock_callback)
+		thread_lock_callback();
+}
+
+static void mem_unlock_thread(void)
+{
+	if (thread_unlock_callback)
+		thread_unlock_callback();
+}
+#endif
+
+/* -------------------------------------------------------------------- */
+/* Size classes and pools */
+
+MEM_INLINE bool slab_use_for_len(size_t len)
+{
+	return (len + sizeof(MemHead)) <= SLAB_BLOCK_SIZE_MAX;
+}
+
+MEM_INLINE unsigned int slab_class_from_len(size_t len)
+{
+	const size_t block_size = len + sizeof(MemHead);
+	if (block_size <= SLAB_BLOCK_SIZE_SMALL_MAX) {
+		return (unsigned int)((block_size + 15) / 16) - 1;
+	}
+	else {
+		return (unsigned int)(SLAB_BLOCK_SIZE_SMALL_MAX / 16 +
+		                      (block_size - SLAB_BLOCK_SIZE_SMALL_MAX + 63) / 64) - 1;
+	}
+}
+
+MEM_INLINE size_t slab_class_block_size(unsigned int class_index)
+{
+	if (class_index < SLAB_BLOCK_SIZE_SMALL_MAX / 16) {
+		return (size_t)(class_index + 1) * 16;
+	}
+	else {
+		return SLAB_BLOCK_SIZE_SMALL_MAX + (size_t)(class_index + 1 - SLAB_BLOCK_SIZE_SMALL_MAX / 16) * 64;
+	}
+}
+
+MEM_INLINE void slab_class_lock(SlabClass *slab)
+{
+	while (atomic_cas_z(&slab->lock, 0, 1) != 0) {
+		/* pass */
+	}
+}
+
+MEM_INLINE void slab_class_unlock(SlabClass *slab)
+{
+	atomic_cas_z(&slab->lock, 1, 0);
+}
+
+/**
+ * Move up to \a num blocks from the shared pool into the calling thread's cache,
+ * carving new blocks from a chunk when the pool runs dry.
+ *
+ * \return false when the system is out of memory.
+ */
+static bool slab_thread_cache_refill(SlabThreadCache *cache, unsigned int class_index, unsigned int num)
+{
+	SlabClass *slab = &slab_classes[class_index];
+	const size_t block_size = slab_class_block_size(class_index);
+	unsigned int i;
+
+	slab_class_lock(slab);
+
+	for (i = 0; i < num; i++) {
+		SlabFreeBlock *block;
+
+		if (slab->free) {
+			block = slab->free;
+			slab->free = block->next;
+			slab->free_num--;
+		}
+		else {
+			if (slab->chunk_cur == slab->chunk_end) {
+				char *chunk = malloc(SLAB_CHUNK_SIZE);
+				if (UNLIKELY(chunk == NULL)) {
+					break;
+				}
+				slab->chunk_cur = chunk;
+				slab->chunk_end = chunk + (SLAB_CHUNK_SIZE / block_size) * block_size;
+				slab->chunk_num++;
+				atomic_add_z(&slab_in_use, SLAB_CHUNK_SIZE);
+			}
+			block = (SlabFreeBlock *)slab->chunk_cur;
+			slab->chunk_cur += block_size;
+		}
+
+		block->next = cache->free[class_index];
+		cache->free[class_index] = block;
+		cache->free_num[class_index]++;
+	}
+
+	slab_class_unlock(slab);
+
+	return (i != 0);
+}
+
+/* Give \a num blocks of the calling thread's cache back to the shared pool. */
+static void slab_thread_cache_release(SlabThreadCache *cache, unsigned int class_index, unsigned int num)
+{
+	SlabClass *slab = &slab_classes[class_index];
+	SlabFreeBlock *first = cache->free[class_index], *last = first;
+	unsigned int i;
+
+	if (num == 0) {
+		return;
+	}
+
+	for (i = 1; i < num; i++) {
+		last = last->next;
+	}
+	cache->free[class_index] = last->next;
+	cache->free_num[class_index] -= num;
+
+	slab_class_lock(slab);
+	last->next = slab->free;
+	slab->free = first;
+	slab->free_num += num;
+	slab_class_unlock(slab);
+}
+
+#ifndef WIN32
+static pthread_key_t slab_thread_key;
+static pthread_once_t slab_thread_key_once = PTHREAD_ONCE_INIT;
+
+/* Don't lose the blocks cached by threads which exit (render threads come and go). */
+static void slab_thread_cache_exit(void *value)
+{
+	SlabThreadCache *cache = value;
+	unsigned int class_index;
+
+	for (class_index = 0; class_index < SLAB_CLASS_NUM; class_index++) {
+		slab_thread_cache_release(cache, class_index, cache->free_num[class_index]);
+	}
+}
+
+static void slab_thread_key_create(void)
+{
+	pthread_key_create(&slab_thread_key, slab_thread_cache_exit);
+}
+#endif
+
+MEM_INLINE SlabThreadCache *slab_thread_cache_get(void)
+{
+	SlabThreadCache *cache = &slab_thread_cache;
+#ifndef WIN32
+	if (UNLIKELY(!cache->is_registered)) {
+		pthread_once(&slab_thread_key_once, slab_thread_key_create);
+		pthread_setspecific(slab_thread_key, cache);
+		cache->is_registered = true;
+	}
+#endif
+	return cache;
+}
+
+static MemHead *slab_block_alloc(size_t len)
+{
+	SlabThreadCache *cache = slab_thread_cache_get();
+	const unsigned int class_index = slab_class_from_len(len);
+	SlabFreeBlock *block;
+
+	if (UNLIKELY(cache->free[class_index] == NULL)) {
+		if (!slab_thread_cache_refill(cache, class_index, SLAB_THREAD_CACHE_BATCH)) {
+			return NULL;
+		}
+	}
+
+	block = cache->free[class_index];
+	cache->free[class_index] = block->next;
+	cache->free_num[class_index]--;
+
+	return (MemHead *)block;
+}
+
+static void slab_block_free(MemHead *memh, size_t len)
+{
+	SlabThreadCache *cache = slab_thread_cache_get();
+	const unsigned int class_index = slab_class_from_len(len);
+	SlabFreeBlock *block = (SlabFreeBlock *)memh;
+
+	block->next = cache->free[class_index];
+	cache->free[class_index] = block;
+	cache->free_num[class_index]++;
+
+	if (UNLIKELY(cache->free_num[class_index] > SLAB_THREAD_CACHE_MAX)) {
+		slab_thread_cache_release(cache, class_index, SLAB_THREAD_CACHE_MAX / 2);
+	}
+}
+
+/* -------------------------------------------------------------------- */
+/* MEM API */
+
+size_t MEM_slab_allocN_len(const void *vmemh)
+{
+	if (vmemh) {
+		return MEMHEAD_FROM_PTR(vmemh)->len & ~((size_t) (MEMHEAD_MMAP_FLAG | MEMHEAD_ALIGN_FLAG));
+	}
+	else {
+		return 0;
+	}
+}
+
+void MEM_slab_freeN(void *vmemh)
+{
+	MemHead *memh = MEMHEAD_FROM_PTR(vmemh);
+	size_t len = MEM_slab_allocN_len(vmemh);
+
+	if (vmemh == NULL) {
+		print_error("Attempt to free NULL pointer\n");
+#ifdef WITH_ASSERT_ABORT
+		abort();
+#endif
+		return;
+	}
+
+	atomic_sub_u(&totblock, 1);
+	atomic_sub_z(&mem_in_use, len);
+
+	if (MEMHEAD_IS_MMAP(memh)) {
+		atomic_sub_z(&mmap_in_use, len);
+#if defined(WIN32)
+		/* our windows mmap implementation is not thread safe */
+		mem_lock_thread();
+#endif
+		if (munmap(memh, len + sizeof(MemHead)))
+			printf("Couldn't unmap memory\n");
+#if defined(WIN32)
+		mem_unlock_thread();
+#endif
+	}
+	else {
+		if (UNLIKELY(malloc_debug_memset && len)) {
+			memset(memh + 1, 255, len);
+		}
+		if (UNLIKELY(MEMHEAD_IS_ALIGNED(memh))) {
+			MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
+			aligned_free(MEMHEAD_REAL_PTR(memh_aligned));
+		}
+		else if (slab_use_for_len(len)) {
+			slab_block_free(memh, len);
+		}
+		else {
+			free(memh);
+		}
+	}
+}
+
+void *MEM_slab_dupallocN(const void *vmemh)
+{
+	void *newp = NULL;
+	if (vmemh) {
+		MemHead *memh = MEMHEAD_FROM_PTR(vmemh);
+		const size_t prev_size = MEM_slab_allocN_len(vmemh);
+		if (UNLIKELY(MEMHEAD_IS_MMAP(memh))) {
+			newp = MEM_slab_mapallocN(prev_size, "dupli_mapalloc");
+		}
+		else if (UNLIKELY(MEMHEAD_IS_ALIGNED(memh))) {
+			MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
+			newp = MEM_slab_mallocN_aligned(
+				prev_size,
+				(size_t)memh_aligned->alignment,
+				"dupli_malloc");
+		}
+		else {
+			newp = MEM_slab_mallocN(prev_size, "dupli_malloc");
+		}
+		memcpy(newp, vmemh, prev_size);
+	}
+	return newp;
+}
+
+void *MEM_slab_reallocN_id(void *vmemh, size_t len, const char *str)
+{
+	void *newp = NULL;
+
+	if (vmemh) {
+		MemHead *memh = MEMHEAD_FROM_PTR(vmemh);
+		size_t old_len = MEM_slab_allocN_len(vmemh);
+
+		if (LIKELY(!MEMHEAD_IS_ALIGNED(memh))) {
+			newp = MEM_slab_mallocN(len, "realloc");
+		}
+		else {
+			MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
+			newp = MEM_slab_mallocN_aligned(
+				len,
+				(size_t)memh_aligned->alignment,
+				"realloc");
+		}
+
+		if (newp) {
+			if (len < old_len) {
+				/* shrink */
+				memcpy(newp, vmemh, len);
+			}
+			else {
+				/* grow (or remain same size) */
+				memcpy(newp, vmemh, old_len);
+			}
+		}
+
+		MEM_slab_freeN(vmemh);
+	}
+	else {
+		newp = MEM_slab_mallocN(len, str);
+	}
+
+	return newp;
+}
+
+void *MEM_slab_recallocN_id(void *vmemh, size_t len, const char *str)
+{
+	void *newp = NULL;
+
+	if (vmemh) {
+		MemHead *memh = MEMHEAD_FROM_PTR(vmemh);
+		size_t old_len = MEM_slab_allocN_len(vmemh);
+
+		if (LIKELY(!MEMHEAD_IS_ALIGNED(memh))) {
+			newp = MEM_slab_mallocN(len, "recalloc");
+		}
+		else {
+			MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
+			newp = MEM_slab_mallocN_aligned(len,
+			                                (size_t)memh_aligned->alignment,
+			                                "recalloc");
+		}
+
+		if (newp) {
+			if (len < old_len) {
+				/* shrink */
+				memcpy(newp, vmemh, len);
+			}
+			else {
+				memcpy(newp, vmemh, old_len);
+
+				if (len > old_len) {
+					/* grow */
+					/* zero new bytes */
+					memset(((char *)newp) + old_len, 0, len - old_len);
+				}
+			}
+		}
+
+		MEM_slab_freeN(vmemh);
+	}
+	else {
+		newp = MEM_slab_callocN(len, str);
+	}
+
+	return newp;
+}
+
+void *MEM_slab_callocN(size_t len, const char *str)
+{
+	MemHead *memh;
+
+	len = SIZET_ALIGN_4(len);
+
+	if (slab_use_for_len(len)) {
+		memh = slab_block_alloc(len);
+		if (LIKELY(memh)) {
+			memset(memh + 1, 0, len);
+		}
+	}
+	else {
+		memh = (MemHead *)calloc(1, len + sizeof(MemHead));
+	}
+
+	if (LIKELY(memh)) {
+		memh->len = len;
+		atomic_add_u(&totblock, 1);
+		atomic_add_z(&mem_in_use, len);
+		update_maximum(&peak_mem, mem_in_use);
+
+		return PTR_FROM_MEMHEAD(memh);
+	}
+	print_error("Calloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
+	            SIZET_ARG(len), str, (unsigned int) mem_in_use);
+	return NULL;
+}
+
+void *MEM_slab_mallocN(size_t len, const char *str)
+{
+	MemHead *memh;
+
+	len = SIZET_ALIGN_4(len);
+
+	if (slab_use_for_len(len)) {
+		memh = slab_block_alloc(len);
+	}
+	else {
+		memh = (MemHead *)malloc(len + sizeof(MemHead));
+	}
+
+	if (LIKELY(memh)) {
+		if (UNLIKELY(malloc_debug_memset && len)) {
+			memset(memh + 1, 255, len);
+		}
+
+		memh->len = len;
+		atomic_add_u(&totblock, 1);
+		atomic_add_z(&mem_in_use, len);
+		update_maximum(&peak_mem, mem_in_use);
+
+		return PTR_FROM_MEMHEAD(memh);
+	}
+	print_error("Malloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
+	            SIZET_ARG(len), str, (unsigned int) mem_in_use);
+	return NULL;
+}
+
+void *MEM_slab_mallocN_aligned(size_t len, size_t alignment, const char *str)
+{
+	MemHeadAligned *memh;
+
+	/* Aligned blocks are rare, they always use the system allocator,
+	 * see #MEM_lockfree_mallocN_aligned for details about the padding. */
+	size_t extra_padding = MEMHEAD_ALIGN_PADDING(alignment);
+
+	assert(alignment < 1024);
+	assert(IS_POW2(alignment));
+
+	len = SIZET_ALIGN_4(len);
+
+	memh = (MemHeadAligned *)aligned_malloc(
+		len + extra_padding + sizeof(MemHeadAligned), alignment);
+
+	if (LIKELY(memh)) {
+		memh = (MemHeadAligned *)((char *)memh + extra_padding);
+
+		if (UNLIKELY(malloc_debug_memset && len)) {
+			memset(memh + 1, 255, len);
+		}
+
+		memh->len = len | (size_t) MEMHEAD_ALIGN_FLAG;
+		memh->alignment = (short) alignment;
+		atomic_add_u(&totblock, 1);
+		atomic_add_z(&mem_in_use, len);
+		update_maximum(&peak_mem, mem_in_use);
+
+		return PTR_FROM_MEMHEAD(memh);
+	}
+	print_error("Malloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
+	            SIZET_ARG(len), str, (unsigned int) mem_in_use);
+	return NULL;
+}
+
+void *MEM_slab_mapallocN(size_t len, const char *str)
+{
+	MemHead *memh;
+
+	/* on 64 bit, simply use calloc instead, as mmap does not support
+	 * allocating > 4 GB on Windows. the only reason mapalloc exists
+	 * is to get around address space limitations in 32 bit OSes. */
+	if (sizeof(void *) >= 8)
+		return MEM_slab_callocN(len, str);
+
+	len = SIZET_ALIGN_4(len);
+
+#if defined(WIN32)
+	/* our windows mmap implementation is not thread safe */
+	mem_lock_thread();
+#endif
+	memh = mmap(NULL, len + sizeof(MemHead),
+	            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+#if defined(WIN32)
+	mem_unlock_thread();
+#endif
+
+	if (memh != (MemHead *)-1) {
+		memh->len = len | (size_t) MEMHEAD_MMAP_FLAG;
+		atomic_add_u(&totblock, 1);
+		atomic_add_z(&mem_in_use, len);
+		atomic_add_z(&mmap_in_use, len);
+
+		update_maximum(&peak_mem, mem_in_use);
+		update_maximum(&peak_mem, mmap_in_use);
+
+		return PTR_FROM_MEMHEAD(memh);
+	}
+	print_error("Mapalloc returns null, fallback to regular malloc: "
+	            "len=" SIZET_FORMAT " in %s, total %u\n",
+	            SIZET_ARG(len), str, (unsigned int) mmap_in_use);
+	return MEM_slab_callocN(len, str);
+}
+
+void MEM_slab_printmemlist_pydict(void)
+{
+}
+
+void MEM_slab_printmemlist(void)
+{
+}
+
+/* unused */
+void MEM_slab_callbackmemlist(void (*func)(void *))
+{
+	(void) func;  /* Ignored. */
+}
+
+void MEM_slab_printmemlist_stats(void)
+{
+	unsigned int class_index;
+
+	printf("\ntotal memory len: %.3f MB\n",
+	       (double)mem_in_use / (double)(1024 * 1024));
+	printf("peak memory len: %.3f MB\n",
+	       (double)peak_mem / (double)(1024 * 1024));
+	printf("slab chunks len: %.3f MB\n",
+	       (double)slab_in_use / (double)(1024 * 1024));
+
+	printf("\nblock size  chunks  shared free blocks\n");
+	for (class_index = 0; class_index < SLAB_CLASS_NUM; class_index++) {
+		const SlabClass *slab = &slab_classes[class_index];
+		if (slab->chunk_num) {
+			printf("%10u  %6u  %18u\n",
+			       (unsigned int)slab_class_block_size(class_index),
+			       (unsigned int)slab->chunk_num, slab->free_num);
+		}
+	}
+
+	printf("\nFor more detailed per-block statistics run Blender with memory debugging command line argument.\n");
+
+#ifdef HAVE_MALLOC_STATS
+	printf("System Statistics:\n");
+	malloc_stats();
+#endif
+}
+
+void MEM_slab_set_error_callback(void (*func)(const char *))
+{
+	error_callback = func;
+}
+
+bool MEM_slab_check_memory_integrity(void)
+{
+	return true;
+}
+
+void MEM_slab_set_lock_callback(void (*lock)(void), void (*unlock)(void))
+{
+	thread_lock_callback = lock;
+	thread_unlock_callback = unlock;
+}
+
+void MEM_slab_set_memory_debug(void)
+{
+	malloc_debug_memset = true;
+}
+
+size_t MEM_slab_get_memory_in_use(void)
+{
+	return mem_in_use;
+}
+
+size_t MEM_slab_get_mapped_memory_in_use(void)
+{
+	return mmap_in_use;
+}
+
+unsigned int MEM_slab_get_memory_blocks_in_use(void)
+{
+	return totblock;
+}
+
+void MEM_slab_reset_peak_memory(void)
+{
+	peak_mem = mem_in_use;
+}
+
+size_t MEM_slab_get_peak_memory(void)
+{
+	return peak_mem;
+}
+
+#ifndef NDEBUG
+const char *MEM_slab_name_ptr(void *vmemh)
+{
+	if (vmemh) {
+		return "unknown block name ptr";
+	}
+	else {
+		return "MEM_slab_name_ptr(NULL)";
+	}
+}
+#endif  /* NDEBUG */
@@ -89,6 +89,7 @@ struct Object;
 struct Scene;
 struct Mesh;
 struct MLoopNorSpaceArray;
+struct MLoopNorSplitCache;
 struct BMEditMesh;
 struct KeyBlock;
 struct ModifierData;
@@ -199,6 +200,9 @@ struct DerivedMesh {
 	/* use for converting to BMesh which doesn't store bevel weight and edge crease by default */
 	char cd_flag;
 
+	/* Borrowed from the object while computing its final loop normals, may be NULL */
+	struct MLoopNorSplitCache *lnor_split_cache;
+
 	/** Calculate vert and face normals */
 	void (*calcNormals)(DerivedMesh *dm);
 
@@ -508,6 +512,9 @@ void DM_from_template(
         DerivedMeshType type,
         int numVerts, int numEdges, int numFaces,
         int numLoops, int numPolys);
+void DM_from_template_copy(
+        DerivedMesh *dm, DerivedMesh *source,
+        DerivedMeshType type);
 
 /** utility function to release a DerivedMesh's layers
  * returns 1 if DerivedMesh has to be released by the backend, 0 otherwise
@@ -193,6 +193,9 @@ void animsys_evaluate_action(struct PointerRNA *ptr, struct bAction *act, struct
 /* Evaluate Action Group */
 void animsys_evaluate_action_group(struct PointerRNA *ptr, struct bAction *act, struct bActionGroup *agrp, struct AnimMapper *remap, float ctime);
 
+/* Evaluate Action into a private copy of its ID, without changing the Action (thread-safe) */
+void animsys_evaluate_action_threadsafe(struct PointerRNA *ptr, struct bAction *act, float ctime);
+
 /* ************************************* */
 
 /* ------------ Evaluation API --------------- */
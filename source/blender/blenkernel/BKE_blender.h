@@ -42,7 +42,7 @@ extern "C" {
  * and keep comment above the defines.
  * Use STRINGIFY() rather than defining with quotes */
 #define BLENDER_VERSION         276
-#define BLENDER_SUBVERSION      0
+#define BLENDER_SUBVERSION      1
 /* Several breakages with 270, e.g. constraint deg vs rad */
 #define BLENDER_MINVERSION      270
 #define BLENDER_MINSUBVERSION   5
@@ -72,7 +72,7 @@ bool BKE_read_file_from_memory(
         struct bContext *C, const void *filebuf,
         int filelength, struct ReportList *reports, bool update_defaults);
 bool BKE_read_file_from_memfile(
-        struct bContext *C, struct MemFile *memfile,
+        struct bContext *C, struct MemFile *memfile, struct MemFile *oldmemfile,
         struct ReportList *reports);
 
 int BKE_read_file_userdef(const char *filepath, struct ReportList *reports);
@@ -101,6 +101,7 @@ extern void          BKE_undo_reset(void);
 extern void          BKE_undo_number(struct bContext *C, int nr);
 extern const char   *BKE_undo_get_name(int nr, bool *r_active);
 extern bool          BKE_undo_save_file(const char *filename);
+extern const struct MemFile *BKE_undo_get_memfile(void);
 extern struct Main  *BKE_undo_get_main(struct Scene **r_scene);
 
 /* copybuffer */
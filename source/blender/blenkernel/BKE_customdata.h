@@ -73,6 +73,9 @@ extern const CustomDataMask CD_MASK_EVERYTHING;
 #define CD_REFERENCE 3  /* use data pointers, set layer flag NOFREE */
 #define CD_DUPLICATE 4  /* do a full copy of all layers, only allowed if source
                          * has same number of elements */
+#define CD_SHARE     5  /* like CD_DUPLICATE, but layers only read by modifiers share
+                         * their data with the source until written, see
+                         * CustomData_duplicate_referenced_layer() */
 
 #define CD_TYPE_AS_MASK(_type) (CustomDataMask)((CustomDataMask)1 << (CustomDataMask)(_type))
 
@@ -47,6 +47,7 @@ extern "C" {
 struct ID;
 struct Main;
 struct Object;
+struct PointerRNA;
 struct Scene;
 
 /* Dependency graph evaluation context
@@ -112,6 +113,10 @@ void DAG_scene_free(struct Scene *sce);
  * DAG_id_tag_update will mark a given datablock to be updated. The flag indicates
  * a specific subset to be update (only object transform and data for now).
  *
+ * DAG_data_tag_update does the same for a part of a datablock (a pose bone,
+ * constraint or modifier), with the new depsgraph only that part and what depends
+ * on it is updated, the legacy depsgraph updates the whole datablock.
+ *
  * DAG_id_type_tag marks a particular datablock type as having changing. This does
  * not cause any updates but is used by external render engines to detect if for
  * example a datablock was removed. */
@@ -121,6 +126,7 @@ void DAG_on_visible_update(struct Main *bmain, const bool do_time);
 
 void DAG_id_tag_update(struct ID *id, short flag);
 void DAG_id_tag_update_ex(struct Main *bmain, struct ID *id, short flag);
+void DAG_data_tag_update(struct PointerRNA *ptr, short flag);
 void DAG_id_type_tag(struct Main *bmain, short idtype);
 int  DAG_id_type_tagged(struct Main *bmain, short idtype);
 
@@ -129,6 +129,7 @@ enum {
 	G_DEBUG_GPU_MEM =   (1 << 10), /* gpu memory in status bar */
 	G_DEBUG_DEPSGRAPH_NO_THREADS = (1 << 11),  /* sinle threaded depsgraph */
 	G_DEBUG_GPU =        (1 << 12), /* gpu debug */
+	G_DEBUG_DEPSGRAPH_TIME = (1 << 13),  /* depsgraph evaluation timing */
 };
 
 #define G_DEBUG_ALL  (G_DEBUG | G_DEBUG_FFMPEG | G_DEBUG_PYTHON | G_DEBUG_EVENTS | G_DEBUG_WM | G_DEBUG_JOBS | \
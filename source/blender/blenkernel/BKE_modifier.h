@@ -411,6 +411,24 @@ typedef struct VirtualModifierData {
 
 struct ModifierData  *modifiers_getVirtualModifierList(struct Object *ob, struct VirtualModifierData *data);
 
+/* Result of the modifier stack up to and including a modifier, so evaluation can
+ * continue after it while the key still matches, see mesh_calc_modifiers(). */
+typedef struct ModifierCheckpoint {
+	struct DerivedMesh *dm;
+	size_t mem;
+	uint64_t key;
+	bool has_key;
+} ModifierCheckpoint;
+
+bool          modifier_setCheckpoint(struct ModifierData *md, struct DerivedMesh *dm);
+void          modifier_freeCheckpoint(struct ModifierData *md);
+void          modifiers_freeCheckpoints(struct Main *bmain);
+size_t        modifiers_getCheckpointsMemory(void);
+
+void          modifier_clearEvalStats(struct ModifierData *md);
+bool          modifiers_isProfiling(void);
+void          modifiers_profile(struct Main *bmain, struct Scene *scene, int frames);
+
 /* ensure modifier correctness when changing ob->data */
 void test_object_modifiers(struct Object *ob);
 
@@ -133,6 +133,9 @@ void BKE_object_where_is_calc_time_ex(struct Scene *scene, struct Object *ob, fl
                                       struct RigidBodyWorld *rbw, float r_originmat[3][3]);
 void BKE_object_where_is_calc_mat4(struct Scene *scene, struct Object *ob, float obmat[4][4]);
 
+bool BKE_object_transform_frames_supported(struct Object *ob);
+void BKE_object_transform_frames_eval(struct Object *ob, const float *ctimes, int ctimes_num, float (*r_obmats)[4][4]);
+
 /* possibly belong in own moduke? */
 struct BoundBox *BKE_boundbox_alloc_unit(void);
 void BKE_boundbox_init_from_minmax(struct BoundBox *bb, const float min[3], const float max[3]);
@@ -72,6 +72,7 @@ typedef enum {
 /***/
 
 #define CCG_OMP_LIMIT	1000000
+#define CCG_TASK_LIMIT	65536
 
 /***/
 
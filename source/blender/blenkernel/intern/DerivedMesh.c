@@ -35,16 +35,21 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "DNA_action_types.h"
+#include "DNA_armature_types.h"
 #include "DNA_cloth_types.h"
+#include "DNA_color_types.h"
 #include "DNA_key_types.h"
 #include "DNA_material_types.h"
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
 
 #include "BLI_blenlib.h"
 #include "BLI_bitmap.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 #include "BLI_linklist.h"
@@ -59,6 +64,7 @@
 #include "BKE_object.h"
 #include "BKE_object_deform.h"
 #include "BKE_paint.h"
+#include "BKE_scene.h"
 #include "BKE_texture.h"
 #include "BKE_multires.h"
 #include "BKE_bvhutils.h"
@@ -76,9 +82,7 @@ static DerivedMesh *navmesh_dm_createNavMeshForVisualization(DerivedMesh *dm);
 #include "GPU_extensions.h"
 #include "GPU_glew.h"
 
-#ifdef WITH_OPENSUBDIV
-#  include "DNA_userdef_types.h"
-#endif
+#include "PIL_time.h"
 
 /* very slow! enable for testing only! */
 //#define USE_MODIFIER_VALIDATE
@@ -324,21 +328,17 @@ void DM_init(
 	copy_vn_i(dm->polyData.typemap, CD_NUMTYPES, -1);
 }
 
-/**
- * Utility function to initialize a DerivedMesh for the desired number
- * of vertices, edges and faces, with a layer setup copied from source
- */
-void DM_from_template_ex(
+static void dm_from_template_internal(
         DerivedMesh *dm, DerivedMesh *source, DerivedMeshType type,
         int numVerts, int numEdges, int numTessFaces,
         int numLoops, int numPolys,
-        CustomDataMask mask)
+        CustomDataMask mask, int alloctype)
 {
-	CustomData_copy(&source->vertData, &dm->vertData, mask, CD_CALLOC, numVerts);
-	CustomData_copy(&source->edgeData, &dm->edgeData, mask, CD_CALLOC, numEdges);
-	CustomData_copy(&source->faceData, &dm->faceData, mask, CD_CALLOC, numTessFaces);
-	CustomData_copy(&source->loopData, &dm->loopData, mask, CD_CALLOC, numLoops);
-	CustomData_copy(&source->polyData, &dm->polyData, mask, CD_CALLOC, numPolys);
+	CustomData_copy(&source->vertData, &dm->vertData, mask, alloctype, numVerts);
+	CustomData_copy(&source->edgeData, &dm->edgeData, mask, alloctype, numEdges);
+	CustomData_copy(&source->faceData, &dm->faceData, mask, alloctype, numTessFaces);
+	CustomData_copy(&source->loopData, &dm->loopData, mask, alloctype, numLoops);
+	CustomData_copy(&source->polyData, &dm->polyData, mask, alloctype, numPolys);
 
 	dm->cd_flag = source->cd_flag;
 
@@ -354,6 +354,23 @@ void DM_from_template_ex(
 	dm->needsFree = 1;
 	dm->dirty = 0;
 }
+
+/**
+ * Utility function to initialize a DerivedMesh for the desired number
+ * of vertices, edges and faces, with a layer setup copied from source
+ */
+void DM_from_template_ex(
+        DerivedMesh *dm, DerivedMesh *source, DerivedMeshType type,
+        int numVerts, int numEdges, int numTessFaces,
+        int numLoops, int numPolys,
+        CustomDataMask mask)
+{
+	dm_from_template_internal(
+	        dm, source, type,
+	        numVerts, numEdges, numTessFaces,
+	        numLoops, numPolys,
+	        mask, CD_CALLOC);
+}
 void DM_from_template(
         DerivedMesh *dm, DerivedMesh *source, DerivedMeshType type,
         int numVerts, int numEdges, int numTessFaces,
@@ -366,6 +383,19 @@ void DM_from_template(
 	        CD_MASK_DERIVEDMESH);
 }
 
+/**
+ * Like #DM_from_template, for a copy of source with the same number of elements:
+ * layers are copied too, or share the data of source until written (see CD_SHARE).
+ */
+void DM_from_template_copy(DerivedMesh *dm, DerivedMesh *source, DerivedMeshType type)
+{
+	dm_from_template_internal(
+	        dm, source, type,
+	        source->numVertData, source->numEdgeData, source->numTessFaceData,
+	        source->numLoopData, source->numPolyData,
+	        CD_MASK_DERIVEDMESH, CD_SHARE);
+}
+
 int DM_release(DerivedMesh *dm)
 {
 	if (dm->needsFree) {
@@ -430,9 +460,12 @@ void DM_ensure_normals(DerivedMesh *dm)
 	BLI_assert((dm->dirty & DM_DIRTY_NORMALS) == 0);
 }
 
-static void DM_calc_loop_normals(DerivedMesh *dm, const bool use_split_normals, float split_angle)
+static void DM_calc_loop_normals(
+        DerivedMesh *dm, const bool use_split_normals, float split_angle, MLoopNorSplitCache *lnor_split_cache)
 {
+	dm->lnor_split_cache = lnor_split_cache;
 	dm->calcLoopNormals(dm, use_split_normals, split_angle);
+	dm->lnor_split_cache = NULL;
 	dm->dirty |= DM_DIRTY_TESS_CDLAYERS;
 }
 
@@ -1694,6 +1727,479 @@ static void dm_ensure_display_normals(DerivedMesh *dm)
 	}
 }
 
+/* Statistics of a modifier evaluation, for ModifierData.eval_time and the following members */
+typedef struct ModifierEvalStats {
+	double time_start;
+	size_t mem_start;
+} ModifierEvalStats;
+
+static void modifier_eval_stats_begin(ModifierEvalStats *stats)
+{
+	stats->mem_start = 0;
+	if (modifiers_isProfiling()) {
+		stats->mem_start = MEM_get_memory_in_use();
+		MEM_reset_peak_memory();
+	}
+	stats->time_start = PIL_check_seconds_timer();
+}
+
+/* The size of the result is read from dm, when there is one,
+ * otherwise the modifier deformed the vertices of the original mesh. */
+static void modifier_eval_stats_end(
+        ModifierData *md, const ModifierEvalStats *stats, DerivedMesh *dm,
+        int totvert, int totedge, int totpoly)
+{
+	md->eval_time = (float)((PIL_check_seconds_timer() - stats->time_start) * 1000.0);
+
+	md->eval_memory = 0;
+	if (modifiers_isProfiling()) {
+		const size_t mem_peak = MEM_get_peak_memory();
+		if (mem_peak > stats->mem_start) {
+			md->eval_memory = (int)((mem_peak - stats->mem_start) / 1024);
+		}
+	}
+
+	if (dm) {
+		totvert = dm->getNumVerts(dm);
+		totedge = dm->getNumEdges(dm);
+		totpoly = dm->getNumPolys(dm);
+	}
+	md->eval_totvert = totvert;
+	md->eval_totedge = totedge;
+	md->eval_totpoly = totpoly;
+}
+
+/* -------------------------------------------------------------------- */
+/* Modifier stack checkpoints
+ *
+ * The result of a slow constructive modifier is kept with it (see #ModifierCheckpoint),
+ * with a key hashing everything the stack reads up to and including that modifier:
+ * the mesh, the modifier settings and the objects they use. While the key matches,
+ * evaluation continues after the last such modifier, so changing a modifier doesn't
+ * evaluate the slow ones before it again.
+ *
+ * Modifiers with state that can't be hashed (simulations, textures, most linked
+ * object types) end the part of the stack that gets keys.
+ */
+
+/* constructive modifiers taking at least this long get a checkpoint (in milliseconds) */
+#define MODIFIER_CHECKPOINT_MIN_TIME 2.0f
+
+typedef struct StackKeyLinkData {
+	BLI_HashMurmur64A *mm64;
+	bool is_valid;
+} StackKeyLinkData;
+
+static void stack_key_add_customdata(BLI_HashMurmur64A *mm64, const CustomData *data, int totelem)
+{
+	int i;
+
+	BLI_hash_mm64a_add_int(mm64, totelem);
+
+	for (i = 0; i < data->totlayer; i++) {
+		const CustomDataLayer *layer = &data->layers[i];
+
+		BLI_hash_mm64a_add_int(mm64, layer->type);
+		BLI_hash_mm64a_add_int(mm64, layer->active);
+		BLI_hash_mm64a_add_int(mm64, layer->active_rnd);
+		BLI_hash_mm64a_add(mm64, (const unsigned char *)layer->name, strlen(layer->name));
+
+		if (layer->data == NULL) {
+			continue;
+		}
+
+		if (layer->type == CD_MDEFORMVERT) {
+			const MDeformVert *dvert = layer->data;
+			int j;
+
+			for (j = 0; j < totelem; j++, dvert++) {
+				BLI_hash_mm64a_add_int(mm64, dvert->totweight);
+				if (dvert->dw) {
+					BLI_hash_mm64a_add(mm64, (const unsigned char *)dvert->dw,
+					                   sizeof(*dvert->dw) * (size_t)dvert->totweight);
+				}
+			}
+		}
+		else {
+			BLI_hash_mm64a_add(mm64, layer->data, (size_t)CustomData_sizeof(layer->type) * (size_t)totelem);
+		}
+	}
+}
+
+static void stack_key_add_object_link(void *userData, Object *ob, Object **obpoin)
+{
+	StackKeyLinkData *data = userData;
+	BLI_HashMurmur64A *mm64 = data->mm64;
+	Object *lob = *obpoin;
+
+	if (lob == NULL) {
+		return;
+	}
+
+	/* linked objects are used relative to the object */
+	BLI_hash_mm64a_add(mm64, (const unsigned char *)ob->obmat, sizeof(ob->obmat));
+	BLI_hash_mm64a_add(mm64, (const unsigned char *)lob->obmat, sizeof(lob->obmat));
+
+	if (lob == ob) {
+		return;
+	}
+
+	switch (lob->type) {
+		case OB_EMPTY:
+			break;
+		case OB_MESH:
+		{
+			DerivedMesh *dm = lob->derivedFinal;
+
+			if (dm == NULL || dm->type != DM_TYPE_CDDM) {
+				data->is_valid = false;
+				break;
+			}
+
+			stack_key_add_customdata(mm64, &dm->vertData, dm->numVertData);
+			stack_key_add_customdata(mm64, &dm->edgeData, dm->numEdgeData);
+			stack_key_add_customdata(mm64, &dm->loopData, dm->numLoopData);
+			stack_key_add_customdata(mm64, &dm->polyData, dm->numPolyData);
+			break;
+		}
+		case OB_ARMATURE:
+		{
+			bPoseChannel *pchan;
+
+			if (lob->pose == NULL) {
+				data->is_valid = false;
+				break;
+			}
+
+			for (pchan = lob->pose->chanbase.first; pchan; pchan = pchan->next) {
+				BLI_hash_mm64a_add(mm64, (const unsigned char *)pchan->name, strlen(pchan->name));
+				BLI_hash_mm64a_add(mm64, (const unsigned char *)pchan->chan_mat, sizeof(pchan->chan_mat));
+				BLI_hash_mm64a_add(mm64, (const unsigned char *)pchan->pose_mat, sizeof(pchan->pose_mat));
+				if (pchan->bone) {
+					BLI_hash_mm64a_add(mm64, (const unsigned char *)&pchan->bone->roll,
+					                   sizeof(Bone) - offsetof(Bone, roll));
+				}
+			}
+			break;
+		}
+		default:
+			/* curves, lattices... no simple way to tell if they changed */
+			data->is_valid = false;
+			break;
+	}
+}
+
+static void stack_key_add_id_link(void *userData, Object *ob, ID **idpoin)
+{
+	StackKeyLinkData *data = userData;
+
+	if (*idpoin == NULL) {
+		return;
+	}
+
+	if (GS((*idpoin)->name) == ID_OB) {
+		stack_key_add_object_link(userData, ob, (Object **)idpoin);
+	}
+	else {
+		/* textures and other data, not hashed */
+		data->is_valid = false;
+	}
+}
+
+static void stack_key_add_shapekeys(BLI_HashMurmur64A *mm64, Scene *scene, Object *ob)
+{
+	Key *key = BKE_key_from_object(ob);
+	KeyBlock *kb;
+
+	if (key == NULL) {
+		return;
+	}
+
+	BLI_hash_mm64a_add_int(mm64, key->type);
+	BLI_hash_mm64a_add_int(mm64, ob->shapenr);
+	BLI_hash_mm64a_add_int(mm64, ob->shapeflag);
+
+	if (key->type != KEY_RELATIVE) {
+		const float ctime = BKE_scene_frame_get(scene);
+		BLI_hash_mm64a_add(mm64, (const unsigned char *)&key->ctime, sizeof(key->ctime));
+		BLI_hash_mm64a_add(mm64, (const unsigned char *)&ctime, sizeof(ctime));
+	}
+
+	for (kb = key->block.first; kb; kb = kb->next) {
+		BLI_hash_mm64a_add(mm64, (const unsigned char *)&kb->pos, offsetof(KeyBlock, data) - offsetof(KeyBlock, pos));
+		BLI_hash_mm64a_add(mm64, (const unsigned char *)kb->vgroup, strlen(kb->vgroup));
+		if (kb->data) {
+			BLI_hash_mm64a_add(mm64, kb->data, (size_t)key->elemsize * (size_t)kb->totelem);
+		}
+	}
+}
+
+static void stack_key_add_curvemapping(BLI_HashMurmur64A *mm64, const CurveMapping *cumap)
+{
+	int i, j;
+
+	if (cumap == NULL) {
+		return;
+	}
+
+	BLI_hash_mm64a_add_int(mm64, cumap->flag & CUMA_DO_CLIP);
+	BLI_hash_mm64a_add(mm64, (const unsigned char *)&cumap->clipr, sizeof(cumap->clipr));
+
+	for (i = 0; i < CM_TOT; i++) {
+		const CurveMap *cuma = &cumap->cm[i];
+
+		BLI_hash_mm64a_add_int(mm64, cuma->flag);
+		BLI_hash_mm64a_add_int(mm64, cuma->totpoint);
+
+		/* not the selection */
+		for (j = 0; j < cuma->totpoint; j++) {
+			BLI_hash_mm64a_add(mm64, (const unsigned char *)&cuma->curve[j].x, sizeof(float[2]));
+			BLI_hash_mm64a_add_int(mm64, cuma->curve[j].flag & CUMA_VECTOR);
+		}
+	}
+}
+
+/* Data the modifier settings point to, the settings themselves are hashed as they're stored,
+ * so only the pointers are. Returns false when it can't be hashed. */
+static bool stack_key_add_modifier_data(BLI_HashMurmur64A *mm64, ModifierData *md)
+{
+	switch (md->type) {
+		case eModifierType_Hook:
+		{
+			HookModifierData *hmd = (HookModifierData *)md;
+			if (hmd->indexar) {
+				BLI_hash_mm64a_add(mm64, (const unsigned char *)hmd->indexar, sizeof(int) * (size_t)hmd->totindex);
+			}
+			stack_key_add_curvemapping(mm64, hmd->curfalloff);
+			break;
+		}
+		case eModifierType_Warp:
+			stack_key_add_curvemapping(mm64, ((WarpModifierData *)md)->curfalloff);
+			break;
+		case eModifierType_WeightVGEdit:
+			stack_key_add_curvemapping(mm64, ((WeightVGEditModifierData *)md)->cmap_curve);
+			break;
+		case eModifierType_LaplacianDeform:
+		{
+			LaplacianDeformModifierData *lmd = (LaplacianDeformModifierData *)md;
+			if (lmd->vertexco) {
+				BLI_hash_mm64a_add(mm64, (const unsigned char *)lmd->vertexco,
+				                   sizeof(float[3]) * (size_t)lmd->total_verts);
+			}
+			break;
+		}
+		case eModifierType_CorrectiveSmooth:
+		{
+			CorrectiveSmoothModifierData *csmd = (CorrectiveSmoothModifierData *)md;
+			if (csmd->bind_coords) {
+				BLI_hash_mm64a_add(mm64, (const unsigned char *)csmd->bind_coords,
+				                   sizeof(float[3]) * (size_t)csmd->bind_coords_num);
+			}
+			break;
+		}
+		case eModifierType_MeshDeform:
+			/* bind data */
+			return false;
+	}
+
+	return true;
+}
+
+/* Returns false when the result of the modifier can't be told from what's hashed. */
+static bool stack_key_add_modifier(BLI_HashMurmur64A *mm64, Scene *scene, Object *ob, ModifierData *md,
+                                   const int required_mode)
+{
+	const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+	const bool is_enabled = modifier_isEnabled(scene, md, required_mode);
+	StackKeyLinkData data = {mm64, true};
+
+	BLI_hash_mm64a_add_int(mm64, md->type);
+	BLI_hash_mm64a_add_int(mm64, md->mode);
+	BLI_hash_mm64a_add_int(mm64, is_enabled);
+	/* settings of the modifier type, after the common data */
+	BLI_hash_mm64a_add(mm64, (const unsigned char *)md + sizeof(ModifierData),
+	                   (size_t)mti->structSize - sizeof(ModifierData));
+
+	if (!is_enabled) {
+		return true;
+	}
+
+	if ((mti->flags & eModifierTypeFlag_UsesPointCache) ||
+	    ELEM(md->type, eModifierType_Multires, eModifierType_ParticleSystem, eModifierType_ParticleInstance,
+	         eModifierType_Explode, eModifierType_DynamicPaint, eModifierType_Collision, eModifierType_Surface,
+	         eModifierType_Ocean, eModifierType_MeshCache))
+	{
+		return false;
+	}
+
+	if (md->type == eModifierType_Subsurf) {
+		/* result may only be on the GPU */
+		SubsurfModifierData *smd = (SubsurfModifierData *)md;
+		if (smd->use_opensubdiv && U.opensubdiv_compute_type != USER_OPENSUBDIV_COMPUTE_NONE) {
+			return false;
+		}
+	}
+
+	if (mti->dependsOnTime && mti->dependsOnTime(md)) {
+		const float ctime = BKE_scene_frame_get(scene);
+		BLI_hash_mm64a_add(mm64, (const unsigned char *)&ctime, sizeof(ctime));
+	}
+
+	if (!stack_key_add_modifier_data(mm64, md)) {
+		return false;
+	}
+
+	if (md->type == eModifierType_ShapeKey) {
+		stack_key_add_shapekeys(mm64, scene, ob);
+	}
+
+	if (mti->foreachIDLink) {
+		mti->foreachIDLink(md, ob, stack_key_add_id_link, &data);
+	}
+	else if (mti->foreachObjectLink) {
+		mti->foreachObjectLink(md, ob, stack_key_add_object_link, &data);
+	}
+
+	return data.is_valid;
+}
+
+/* Everything the stack reads before the first modifier. */
+static void stack_key_init(BLI_HashMurmur64A *mm64, Scene *scene, Object *ob, CustomDataMask dataMask)
+{
+	Mesh *me = ob->data;
+	bDeformGroup *dg;
+	const int simplify = (scene->r.mode & R_SIMPLIFY) ? scene->r.simplify_subsurf : -1;
+
+	BLI_hash_mm64a_init(mm64, 0);
+
+	BLI_hash_mm64a_add(mm64, (const unsigned char *)&scene, sizeof(scene));
+	BLI_hash_mm64a_add(mm64, (const unsigned char *)&dataMask, sizeof(dataMask));
+	BLI_hash_mm64a_add_int(mm64, simplify);
+	BLI_hash_mm64a_add_int(mm64, ob->mode);
+
+	for (dg = ob->defbase.first; dg; dg = dg->next) {
+		BLI_hash_mm64a_add(mm64, (const unsigned char *)dg->name, strlen(dg->name));
+	}
+
+	stack_key_add_customdata(mm64, &me->vdata, me->totvert);
+	stack_key_add_customdata(mm64, &me->edata, me->totedge);
+	stack_key_add_customdata(mm64, &me->ldata, me->totloop);
+	stack_key_add_customdata(mm64, &me->pdata, me->totpoly);
+}
+
+static int stack_length(ModifierData *firstmd)
+{
+	ModifierData *md;
+	int len = 0;
+
+	for (md = firstmd; md; md = md->next) {
+		len++;
+	}
+
+	return len;
+}
+
+/* Fill r_keys with the key of the stack up to each modifier, starting at firstmd.
+ * Returns the number of keys, modifiers from the first one that can't be hashed
+ * on don't get one. */
+static int stack_keys_calc(
+        Scene *scene, Object *ob, ModifierData *firstmd, const BLI_HashMurmur64A *mm64_init,
+        const int required_mode, const bool check_errors, uint64_t *r_keys)
+{
+	BLI_HashMurmur64A mm64 = *mm64_init;
+	ModifierData *md;
+	int i = 0;
+
+	for (md = firstmd; md; md = md->next, i++) {
+		BLI_HashMurmur64A mm64_end;
+
+		md->scene = scene;
+
+		/* no checkpoint should hide an error */
+		if (check_errors && md->error) {
+			break;
+		}
+
+		if (!stack_key_add_modifier(&mm64, scene, ob, md, required_mode)) {
+			break;
+		}
+
+		mm64_end = mm64;
+		r_keys[i] = BLI_hash_mm64a_end(&mm64_end);
+	}
+
+	return i;
+}
+
+/* Returns the last modifier with a valid checkpoint, outdated checkpoints are freed. */
+static ModifierData *stack_checkpoints_find(
+        Scene *scene, Object *ob, ModifierData *firstmd, const BLI_HashMurmur64A *mm64_init,
+        const int required_mode)
+{
+	ModifierData *md, *resume_md = NULL;
+	uint64_t *keys;
+	int i, keys_num;
+
+	keys = MEM_mallocN(sizeof(*keys) * (size_t)stack_length(firstmd), __func__);
+	keys_num = stack_keys_calc(scene, ob, firstmd, mm64_init, required_mode, false, keys);
+
+	for (md = firstmd, i = 0; md; md = md->next, i++) {
+		if (md->checkpoint) {
+			if (i < keys_num && md->checkpoint->has_key && md->checkpoint->key == keys[i]) {
+				resume_md = md;
+			}
+			else {
+				modifier_freeCheckpoint(md);
+			}
+		}
+	}
+
+	MEM_freeN(keys);
+
+	return resume_md;
+}
+
+/* Set the keys of checkpoints made in this evaluation, after all modifiers ran
+ * (some keep runtime data in their settings). */
+static void stack_checkpoints_set_keys(
+        Scene *scene, Object *ob, ModifierData *firstmd, const BLI_HashMurmur64A *mm64_init,
+        const int required_mode)
+{
+	ModifierData *md;
+	uint64_t *keys;
+	int i, keys_num;
+
+	keys = MEM_mallocN(sizeof(*keys) * (size_t)stack_length(firstmd), __func__);
+	keys_num = stack_keys_calc(scene, ob, firstmd, mm64_init, required_mode, true, keys);
+
+	for (md = firstmd, i = 0; md; md = md->next, i++) {
+		if (md->checkpoint && !md->checkpoint->has_key) {
+			if (i < keys_num) {
+				md->checkpoint->key = keys[i];
+				md->checkpoint->has_key = true;
+			}
+			else {
+				modifier_freeCheckpoint(md);
+			}
+		}
+	}
+
+	MEM_freeN(keys);
+}
+
+static bool stack_has_checkpoints(Object *ob)
+{
+	ModifierData *md;
+
+	for (md = ob->modifiers.first; md; md = md->next) {
+		if (md->checkpoint) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /**
  * new value for useDeform -1  (hack for the gameengine):
  *
@@ -1746,6 +2252,11 @@ static void mesh_calc_modifiers(
 	ModifierApplyFlag app_flags = useRenderParams ? MOD_APPLY_RENDER : 0;
 	ModifierApplyFlag deform_app_flags = app_flags;
 
+	/* see stack_checkpoints_find() */
+	bool use_checkpoints, has_stack_key = false, has_new_checkpoints = false;
+	BLI_HashMurmur64A stack_key;
+	ModifierData *resume_md = NULL;
+	ModifierEvalStats eval_stats;
 
 	if (useCache)
 		app_flags |= MOD_APPLY_USECACHE;
@@ -1784,6 +2295,27 @@ static void mesh_calc_modifiers(
 	}
 
 	datamasks = modifiers_calcDataMasks(scene, ob, md, dataMask, required_mode, previewmd, previewmask);
+
+	/* checkpoints only for the viewport result, without data depending on the evaluation mode */
+	use_checkpoints = (useCache && !useRenderParams && (useDeform > 0) && (index == -1) && !inputVertexCos &&
+	                   !need_mapping && !build_shapekey_layers && !sculpt_mode && !do_mod_wmcol &&
+	                   (U.modifier_cache_limit != 0));
+	/* orco meshes are made along with the stack, and not kept */
+	if (dataMask & (CD_MASK_ORCO | CD_MASK_CLOTH_ORCO)) {
+		use_checkpoints = false;
+	}
+	for (curr = datamasks; curr && use_checkpoints; curr = curr->next) {
+		if (curr->mask & (CD_MASK_ORCO | CD_MASK_CLOTH_ORCO)) {
+			use_checkpoints = false;
+		}
+	}
+
+	if (use_checkpoints && stack_has_checkpoints(ob)) {
+		stack_key_init(&stack_key, scene, ob, dataMask);
+		has_stack_key = true;
+		resume_md = stack_checkpoints_find(scene, ob, firstmd, &stack_key, required_mode);
+	}
+
 	curr = datamasks;
 
 	if (r_deform) {
@@ -1802,6 +2334,7 @@ static void mesh_calc_modifiers(
 			md->scene = scene;
 			
 			if (!modifier_isEnabled(scene, md, required_mode)) {
+				modifier_clearEvalStats(md);
 				continue;
 			}
 
@@ -1813,7 +2346,9 @@ static void mesh_calc_modifiers(
 				if (!deformedVerts)
 					deformedVerts = BKE_mesh_vertexCos_get(me, &numVerts);
 
+				modifier_eval_stats_begin(&eval_stats);
 				modwrap_deformVerts(md, ob, NULL, deformedVerts, numVerts, deform_app_flags);
+				modifier_eval_stats_end(md, &eval_stats, NULL, numVerts, me->totedge, me->totpoly);
 			}
 			else {
 				break;
@@ -1860,7 +2395,24 @@ static void mesh_calc_modifiers(
 
 		md->scene = scene;
 
+		if (resume_md) {
+			/* the result up to and including resume_md is kept */
+			if (md == resume_md) {
+				BLI_assert(dm == NULL);
+				dm = CDDM_copy(md->checkpoint->dm);
+
+				if (deformedVerts) {
+					MEM_freeN(deformedVerts);
+					deformedVerts = NULL;
+				}
+
+				resume_md = NULL;
+			}
+			continue;
+		}
+
 		if (!modifier_isEnabled(scene, md, required_mode)) {
+			modifier_clearEvalStats(md);
 			continue;
 		}
 
@@ -1954,7 +2506,9 @@ static void mesh_calc_modifiers(
 				}
 			}
 
+			modifier_eval_stats_begin(&eval_stats);
 			modwrap_deformVerts(md, ob, dm, deformedVerts, numVerts, deform_app_flags);
+			modifier_eval_stats_end(md, &eval_stats, dm, numVerts, me->totedge, me->totpoly);
 		}
 		else {
 			DerivedMesh *ndm;
@@ -2034,7 +2588,9 @@ static void mesh_calc_modifiers(
 				}
 			}
 
+			modifier_eval_stats_begin(&eval_stats);
 			ndm = modwrap_applyModifier(md, ob, dm, app_flags);
+			modifier_eval_stats_end(md, &eval_stats, ndm, 0, 0, 0);
 			ASSERT_IS_VALID_DM(ndm);
 
 			if (ndm) {
@@ -2049,6 +2605,12 @@ static void mesh_calc_modifiers(
 
 					deformedVerts = NULL;
 				}
+
+				if (use_checkpoints && (md->eval_time >= MODIFIER_CHECKPOINT_MIN_TIME) &&
+				    !(md->mode & eModifierMode_Virtual))
+				{
+					has_new_checkpoints |= modifier_setCheckpoint(md, dm);
+				}
 			}
 
 			/* create an orco derivedmesh in parallel */
@@ -2116,6 +2678,13 @@ static void mesh_calc_modifiers(
 	for (md = firstmd; md; md = md->next)
 		modifier_freeTemporaryData(md);
 
+	if (has_new_checkpoints) {
+		if (!has_stack_key) {
+			stack_key_init(&stack_key, scene, ob, dataMask);
+		}
+		stack_checkpoints_set_keys(scene, ob, firstmd, &stack_key, required_mode);
+	}
+
 	/* Yay, we are done. If we have a DerivedMesh and deformed vertices
 	 * need to apply these back onto the DerivedMesh. If we have no
 	 * DerivedMesh then we need to build one.
@@ -2167,8 +2736,22 @@ static void mesh_calc_modifiers(
 	}
 
 	if (do_loop_normals) {
+		/* The viewport result keeps the topology dependent part of split normals,
+		 * which only needs to be computed again when the final mesh topology changes. */
+		MLoopNorSplitCache *lnor_split_cache = NULL;
+		if (useCache) {
+			if (ob->lnor_split_cache == NULL) {
+				ob->lnor_split_cache = BKE_lnor_split_cache_new();
+			}
+			lnor_split_cache = ob->lnor_split_cache;
+		}
+
 		/* Compute loop normals (note: will compute poly and vert normals as well, if needed!) */
-		DM_calc_loop_normals(finaldm, do_loop_normals, loop_normals_split_angle);
+		DM_calc_loop_normals(finaldm, do_loop_normals, loop_normals_split_angle, lnor_split_cache);
+	}
+	else if (useCache && ob->lnor_split_cache) {
+		BKE_lnor_split_cache_free(ob->lnor_split_cache);
+		ob->lnor_split_cache = NULL;
 	}
 
 	if (sculpt_dyntopo == false) {
@@ -2282,6 +2865,7 @@ static void editbmesh_calc_modifiers(
 
 	const bool do_loop_normals = (((Mesh *)(ob->data))->flag & ME_AUTOSMOOTH) != 0;
 	const float loop_normals_split_angle = ((Mesh *)(ob->data))->smoothresh;
+	ModifierEvalStats eval_stats;
 
 	modifiers_clearErrors(ob);
 
@@ -2309,6 +2893,7 @@ static void editbmesh_calc_modifiers(
 		md->scene = scene;
 		
 		if (!editbmesh_modifier_is_enabled(scene, md, dm)) {
+			modifier_clearEvalStats(md);
 			continue;
 		}
 
@@ -2342,10 +2927,12 @@ static void editbmesh_calc_modifiers(
 				}
 			}
 
+			modifier_eval_stats_begin(&eval_stats);
 			if (mti->deformVertsEM)
 				modwrap_deformVertsEM(md, ob, em, dm, deformedVerts, numVerts);
 			else
 				modwrap_deformVerts(md, ob, dm, deformedVerts, numVerts, 0);
+			modifier_eval_stats_end(md, &eval_stats, dm, numVerts, em->bm->totedge, em->bm->totface);
 		}
 		else {
 			DerivedMesh *ndm;
@@ -2417,10 +3004,12 @@ static void editbmesh_calc_modifiers(
 				}
 			}
 
+			modifier_eval_stats_begin(&eval_stats);
 			if (mti->applyModifierEM)
 				ndm = modwrap_applyModifierEM(md, ob, em, dm, MOD_APPLY_USECACHE | MOD_APPLY_ALLOW_GPU);
 			else
 				ndm = modwrap_applyModifier(md, ob, dm, MOD_APPLY_USECACHE | MOD_APPLY_ALLOW_GPU);
+			modifier_eval_stats_end(md, &eval_stats, ndm, 0, 0, 0);
 			ASSERT_IS_VALID_DM(ndm);
 
 			if (ndm) {
@@ -2500,9 +3089,9 @@ static void editbmesh_calc_modifiers(
 
 	if (do_loop_normals) {
 		/* Compute loop normals */
-		DM_calc_loop_normals(*r_final, do_loop_normals, loop_normals_split_angle);
+		DM_calc_loop_normals(*r_final, do_loop_normals, loop_normals_split_angle, NULL);
 		if (r_cage && *r_cage && (*r_cage != *r_final)) {
-			DM_calc_loop_normals(*r_cage, do_loop_normals, loop_normals_split_angle);
+			DM_calc_loop_normals(*r_cage, do_loop_normals, loop_normals_split_angle, NULL);
 		}
 	}
 
@@ -390,6 +390,49 @@ static void motionpaths_calc_bake_targets(Scene *scene, ListBase *targets)
 	}
 }
 
+/* When all targets are objects with transforms that can be evaluated without updating
+ * the scene, bake all frames in parallel (see BKE_object_transform_frames_eval)
+ */
+static bool motionpaths_calc_bake_targets_frames(Scene *scene, ListBase *targets)
+{
+	MPathTarget *mpt;
+	
+	for (mpt = targets->first; mpt; mpt = mpt->next) {
+		if (mpt->pchan || !BKE_object_transform_frames_supported(mpt->ob))
+			return false;
+	}
+	
+	for (mpt = targets->first; mpt; mpt = mpt->next) {
+		bMotionPath *mpath = mpt->mpath;
+		const int frames_num = mpath->end_frame - mpath->start_frame;
+		float *ctimes;
+		float (*obmats)[4][4];
+		int i;
+		
+		/* same range as motionpaths_calc_bake_targets(), exclusive of the last frame */
+		if (frames_num <= 0 || frames_num > mpath->length)
+			continue;
+		
+		ctimes = MEM_mallocN(sizeof(*ctimes) * frames_num, "motionpath ctimes");
+		obmats = MEM_mallocN(sizeof(*obmats) * frames_num, "motionpath obmats");
+		
+		/* as the scene evaluates it on each frame, with time remapping */
+		for (i = 0; i < frames_num; i++)
+			ctimes[i] = BKE_scene_frame_get_from_ctime(scene, (float)(mpath->start_frame + i));
+		
+		BKE_object_transform_frames_eval(mpt->ob, ctimes, frames_num, obmats);
+		
+		/* worldspace object location */
+		for (i = 0; i < frames_num; i++)
+			copy_v3_v3(mpath->points[i].co, obmats[i][3]);
+		
+		MEM_freeN(ctimes);
+		MEM_freeN(obmats);
+	}
+	
+	return true;
+}
+
 /* Perform baking of the given object's and/or its bones' transforms to motion paths 
  *	- scene: current scene
  *	- ob: object whose flagged motionpaths should get calculated
@@ -420,23 +463,26 @@ void animviz_calc_motionpaths(Scene *scene, ListBase *targets)
 	}
 	if (efra <= sfra) return;
 	
-	/* optimize the depsgraph for faster updates */
-	/* TODO: whether this is used should depend on some setting for the level of optimizations used */
-	motionpaths_calc_optimise_depsgraph(scene, targets);
-	
-	/* calculate path over requested range */
-	for (CFRA = sfra; CFRA <= efra; CFRA++) {
-		/* update relevant data for new frame */
-		motionpaths_calc_update_scene(scene);
+	/* no need to step through the frames */
+	if (!motionpaths_calc_bake_targets_frames(scene, targets)) {
+		/* optimize the depsgraph for faster updates */
+		/* TODO: whether this is used should depend on some setting for the level of optimizations used */
+		motionpaths_calc_optimise_depsgraph(scene, targets);
+		
+		/* calculate path over requested range */
+		for (CFRA = sfra; CFRA <= efra; CFRA++) {
+			/* update relevant data for new frame */
+			motionpaths_calc_update_scene(scene);
+			
+			/* perform baking for targets */
+			motionpaths_calc_bake_targets(scene, targets);
+		}
 		
-		/* perform baking for targets */
-		motionpaths_calc_bake_targets(scene, targets);
+		/* reset original environment */
+		CFRA = cfra;
+		motionpaths_calc_update_scene(scene);
 	}
 	
-	/* reset original environment */
-	CFRA = cfra;
-	motionpaths_calc_update_scene(scene);
-	
 	/* clear recalc flags from targets */
 	for (mpt = targets->first; mpt; mpt = mpt->next) {
 		bAnimVizSettings *avs;
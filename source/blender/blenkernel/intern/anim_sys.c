@@ -1772,6 +1772,37 @@ void animsys_evaluate_action(PointerRNA *ptr, bAction *act, AnimMapper *remap, f
 	animsys_evaluate_fcurves(ptr, &act->curves, remap, ctime);
 }
 
+/* Evaluate Action into a private copy of its ID
+ * Unlike animsys_evaluate_action() the action itself is left untouched (the curval of
+ * the F-Curves isn't set), so the same action can be evaluated for several frames at once
+ * from different threads. The ID copy must be flagged with LIB_ANIM_NO_RECALC, and the
+ * action must not have drivers (see BKE_object_transform_frames_supported()).
+ */
+void animsys_evaluate_action_threadsafe(PointerRNA *ptr, bAction *act, float ctime)
+{
+	FCurve *fcu;
+
+	if (act == NULL) return;
+
+	BLI_assert(((ID *)ptr->id.data)->flag & LIB_ANIM_NO_RECALC);
+
+	for (fcu = act->curves.first; fcu; fcu = fcu->next) {
+		/* same checks as animsys_evaluate_fcurves() and calculate_fcurve() */
+		if ((fcu->grp == NULL) || (fcu->grp->flag & AGRP_MUTED) == 0) {
+			if ((fcu->flag & (FCURVE_MUTED | FCURVE_DISABLED)) == 0 && (fcu->rna_path)) {
+				float value = fcu->curval;
+
+				BLI_assert(fcu->driver == NULL);
+
+				if ((fcu->totvert) || list_has_suitable_fmodifier(&fcu->modifiers, 0, FMI_TYPE_GENERATE_CURVE))
+					value = evaluate_fcurve(fcu, ctime);
+
+				animsys_write_rna_setting(ptr, fcu->rna_path, fcu->array_index, value);
+			}
+		}
+	}
+}
+
 /* ***************************************** */
 /* NLA System - Evaluation */
 
@@ -35,10 +35,15 @@
 #include <stdio.h>
 #include <float.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_math.h"
 #include "BLI_blenlib.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_anim_types.h"
@@ -825,6 +830,370 @@ static void pchan_bone_deform(bPoseChannel *pchan, bPoseChanDeform *pdef_info, f
 	(*contrib) += weight;
 }
 
+/* Vertices are moved into armature space and back in blocks of this size,
+ * so the matrix multiplications run on arrays. */
+#define ARM_DEFORM_BLOCK_SIZE 256
+/* Fewer blocks than this are deformed without threads. */
+#define ARM_DEFORM_PARALLEL_MIN_BLOCKS 4
+/* Influences of a block that fit in its stack buffers, blocks with more allocate them. */
+#define ARM_DEFORM_STREAM_SIZE (ARM_DEFORM_BLOCK_SIZE * 4)
+
+static void armature_deform_block_finish(
+        float postmat[4][4], float (*block_cos)[3], const bool *block_done,
+        const float *block_prevco_weight, int block_len,
+        float (*cos)[3], float (*vertexCos)[3], const bool use_prevcos)
+{
+	int j;
+
+	/* always, check the deform loop */
+	mul_m4_v3_array(postmat, block_cos, block_len);
+
+	for (j = 0; j < block_len; j++) {
+		if (!block_done[j]) {
+			continue;
+		}
+
+		copy_v3_v3(cos[j], block_cos[j]);
+
+		/* interpolate with previous modifier position using weight group */
+		if (use_prevcos) {
+			const float *co = block_cos[j];
+			float prevco_weight = block_prevco_weight[j];
+			float mw = 1.0f - prevco_weight;
+			vertexCos[j][0] = prevco_weight * vertexCos[j][0] + mw * co[0];
+			vertexCos[j][1] = prevco_weight * vertexCos[j][1] + mw * co[1];
+			vertexCos[j][2] = prevco_weight * vertexCos[j][2] + mw * co[2];
+		}
+	}
+}
+
+typedef struct ArmatureDeformData {
+	Object *armOb;
+	bPoseChanDeform *pdef_info_array;
+	bPoseChannel **defnrToPC;
+	int *defnrToPCIndex;
+	int defbase_tot;
+	/* deform vertices, indexed by vertex, NULL when there are none */
+	MDeformVert *dverts;
+	int dverts_len;
+	bool use_dverts;
+	int armature_def_nr;
+	float (*vertexCos)[3];
+	float (*cos)[3];
+	float (*defMats)[3][3];
+	int numVerts;
+	bool use_envelope, use_quaternion, invert_vgroup, use_prevcos;
+	/* some deforming bone is a B-Bone */
+	bool use_bbone;
+	float premat[4][4], postmat[4][4];
+} ArmatureDeformData;
+
+/* The vertex group influences of a block of vertices, with the group to bone lookups done:
+ * only the groups of deforming bones with a non zero weight, in the order of each MDeformVert. */
+typedef struct ArmatureDeformStream {
+	/* influences of the block's vertex j are [vert_start[j], vert_start[j + 1]) */
+	int vert_start[ARM_DEFORM_BLOCK_SIZE + 1];
+	/* the vertex is in groups of deforming bones, even if their weights are zero */
+	bool vert_deformed[ARM_DEFORM_BLOCK_SIZE];
+
+	bPoseChannel **pchan;
+	bPoseChanDeform **pdef_info;
+	float *weight;  /* envelope factor included for BONE_MULT_VG_ENV */
+	int len_alloc;
+
+	bPoseChannel *pchan_buf[ARM_DEFORM_STREAM_SIZE];
+	bPoseChanDeform *pdef_info_buf[ARM_DEFORM_STREAM_SIZE];
+	float weight_buf[ARM_DEFORM_STREAM_SIZE];
+} ArmatureDeformStream;
+
+static void armature_deform_stream_grow(ArmatureDeformStream *stream, const int len, const int len_min)
+{
+	const int len_alloc = max_ii(len_min, stream->len_alloc * 2);
+	bPoseChannel **pchan = MEM_mallocN(sizeof(*pchan) * (size_t)len_alloc, __func__);
+	bPoseChanDeform **pdef_info = MEM_mallocN(sizeof(*pdef_info) * (size_t)len_alloc, __func__);
+	float *weight = MEM_mallocN(sizeof(*weight) * (size_t)len_alloc, __func__);
+
+	memcpy(pchan, stream->pchan, sizeof(*pchan) * (size_t)len);
+	memcpy(pdef_info, stream->pdef_info, sizeof(*pdef_info) * (size_t)len);
+	memcpy(weight, stream->weight, sizeof(*weight) * (size_t)len);
+
+	if (stream->pchan != stream->pchan_buf) {
+		MEM_freeN(stream->pchan);
+		MEM_freeN(stream->pdef_info);
+		MEM_freeN(stream->weight);
+	}
+
+	stream->pchan = pchan;
+	stream->pdef_info = pdef_info;
+	stream->weight = weight;
+	stream->len_alloc = len_alloc;
+}
+
+/* block_cos are in armature space, for the envelope factor of BONE_MULT_VG_ENV bones. */
+static void armature_deform_stream_init(
+        const ArmatureDeformData *data, ArmatureDeformStream *stream,
+        const int block_start, const int block_len, float (*block_cos)[3])
+{
+	int len = 0;
+	int j;
+
+	stream->pchan = stream->pchan_buf;
+	stream->pdef_info = stream->pdef_info_buf;
+	stream->weight = stream->weight_buf;
+	stream->len_alloc = ARM_DEFORM_STREAM_SIZE;
+
+	for (j = 0; j < block_len; j++) {
+		const int i = block_start + j;
+
+		stream->vert_start[j] = len;
+		stream->vert_deformed[j] = false;
+
+		if (data->use_dverts && data->dverts && i < data->dverts_len) {
+			const MDeformVert *dvert = data->dverts + i;
+			const MDeformWeight *dw = dvert->dw;
+			unsigned int k;
+
+			if (len + dvert->totweight > stream->len_alloc) {
+				armature_deform_stream_grow(stream, len, len + dvert->totweight);
+			}
+
+			for (k = dvert->totweight; k != 0; k--, dw++) {
+				const int index = dw->def_nr;
+				bPoseChannel *pchan;
+
+				if (index >= 0 && index < data->defbase_tot && (pchan = data->defnrToPC[index])) {
+					float weight = dw->weight;
+					Bone *bone = pchan->bone;
+
+					stream->vert_deformed[j] = true;
+
+					if (bone && bone->flag & BONE_MULT_VG_ENV) {
+						weight *= distfactor_to_bone(block_cos[j], bone->arm_head, bone->arm_tail,
+						                             bone->rad_head, bone->rad_tail, bone->dist);
+					}
+
+					/* no contribution, see pchan_bone_deform() */
+					if (weight != 0.0f) {
+						stream->pchan[len] = pchan;
+						stream->pdef_info[len] = data->pdef_info_array + data->defnrToPCIndex[index];
+						stream->weight[len] = weight;
+						len++;
+					}
+				}
+			}
+		}
+	}
+
+	stream->vert_start[block_len] = len;
+}
+
+static void armature_deform_stream_free(ArmatureDeformStream *stream)
+{
+	if (stream->pchan != stream->pchan_buf) {
+		MEM_freeN(stream->pchan);
+		MEM_freeN(stream->pdef_info);
+		MEM_freeN(stream->weight);
+	}
+}
+
+/**
+ * Linear deformation by the bones of the influences [start, end) of the stream, without B-Bones.
+ * The matrices of the bones are blended first, a row per SSE register,
+ * so only one matrix is applied to the vertex instead of one for each bone.
+ */
+static void armature_deform_stream_blend_linear(
+        const ArmatureDeformStream *stream, const int start, const int end,
+        const float co[3], float vec[3], float *contrib)
+{
+	float summat[4][4];
+	float weight_sum = 0.0f;
+	int k;
+
+#ifdef __SSE2__
+	__m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps(), sum2 = _mm_setzero_ps(), sum3 = _mm_setzero_ps();
+
+	for (k = start; k < end; k++) {
+		float (*mat)[4] = stream->pchan[k]->chan_mat;
+		const __m128 weight = _mm_set1_ps(stream->weight[k]);
+
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(mat[0]), weight));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(mat[1]), weight));
+		sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(mat[2]), weight));
+		sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(mat[3]), weight));
+		weight_sum += stream->weight[k];
+	}
+
+	_mm_storeu_ps(summat[0], sum0);
+	_mm_storeu_ps(summat[1], sum1);
+	_mm_storeu_ps(summat[2], sum2);
+	_mm_storeu_ps(summat[3], sum3);
+#else
+	zero_m4(summat);
+
+	for (k = start; k < end; k++) {
+		float (*mat)[4] = stream->pchan[k]->chan_mat;
+		const float weight = stream->weight[k];
+
+		madd_v4_v4fl(summat[0], mat[0], weight);
+		madd_v4_v4fl(summat[1], mat[1], weight);
+		madd_v4_v4fl(summat[2], mat[2], weight);
+		madd_v4_v4fl(summat[3], mat[3], weight);
+		weight_sum += weight;
+	}
+#endif
+
+	/* the sum of weight * (mat * co - co) */
+	mul_v3_m4v3(vec, summat, co);
+	madd_v3_v3fl(vec, co, -weight_sum);
+
+	*contrib += weight_sum;
+}
+
+/* Deform a single vertex, co is in armature space. Returns false when the
+ * vertex is not affected and must be left untouched.
+ * Its vertex group influences are j in the stream. */
+static bool armature_deform_vert(
+        ArmatureDeformData *data, const int i, float co[3],
+        const ArmatureDeformStream *stream, const int j, float *r_prevco_weight)
+{
+	MDeformVert *dvert = NULL;
+	bPoseChanDeform *pdef_info;
+	bPoseChannel *pchan;
+	DualQuat sumdq, *dq = NULL;
+	float dco[3];
+	float sumvec[3], summat[3][3];
+	float *vec = NULL, (*smat)[3] = NULL;
+	float contrib = 0.0f;
+	float armature_weight = 1.0f; /* default to 1 if no overall def group */
+	float prevco_weight = 1.0f;   /* weight for optional cached vertexcos */
+
+	if (data->use_quaternion) {
+		memset(&sumdq, 0, sizeof(DualQuat));
+		dq = &sumdq;
+	}
+	else {
+		sumvec[0] = sumvec[1] = sumvec[2] = 0.0f;
+		vec = sumvec;
+
+		if (data->defMats) {
+			zero_m3(summat);
+			smat = summat;
+		}
+	}
+
+	if (data->armature_def_nr != -1 && data->dverts && i < data->dverts_len) {
+		dvert = data->dverts + i;
+	}
+
+	if (dvert) {
+		armature_weight = defvert_find_weight(dvert, data->armature_def_nr);
+
+		if (data->invert_vgroup)
+			armature_weight = 1.0f - armature_weight;
+
+		/* hackish: the blending factor can be used for blending with prevCos too */
+		if (data->use_prevcos) {
+			prevco_weight = armature_weight;
+			armature_weight = 1.0f;
+		}
+	}
+
+	/* check if there's any  point in calculating for this vert */
+	if (armature_weight == 0.0f)
+		return false;
+
+	if (stream->vert_deformed[j]) { /* use weight groups */
+		const int start = stream->vert_start[j], end = stream->vert_start[j + 1];
+		int k;
+
+		if (vec && !smat && !data->use_bbone) {
+			armature_deform_stream_blend_linear(stream, start, end, co, vec, &contrib);
+		}
+		else {
+			for (k = start; k < end; k++) {
+				pchan_bone_deform(stream->pchan[k], stream->pdef_info[k], stream->weight[k], vec, dq, smat, co,
+				                  &contrib);
+			}
+		}
+	}
+	/* also if there are vertexgroups but not groups with bones
+	 * (like for softbody groups) */
+	else if (data->use_envelope) {
+		pdef_info = data->pdef_info_array;
+		for (pchan = data->armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
+			if (!(pchan->bone->flag & BONE_NO_DEFORM))
+				contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
+		}
+	}
+
+	/* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
+	if (contrib > 0.0001f) {
+		if (data->use_quaternion) {
+			normalize_dq(dq, contrib);
+
+			if (armature_weight != 1.0f) {
+				copy_v3_v3(dco, co);
+				mul_v3m3_dq(dco, (data->defMats) ? summat : NULL, dq);
+				sub_v3_v3(dco, co);
+				mul_v3_fl(dco, armature_weight);
+				add_v3_v3(co, dco);
+			}
+			else
+				mul_v3m3_dq(co, (data->defMats) ? summat : NULL, dq);
+
+			smat = summat;
+		}
+		else {
+			mul_v3_fl(vec, armature_weight / contrib);
+			add_v3_v3v3(co, vec, co);
+		}
+
+		if (data->defMats) {
+			float pre[3][3], post[3][3], tmpmat[3][3];
+
+			copy_m3_m4(pre, data->premat);
+			copy_m3_m4(post, data->postmat);
+			copy_m3_m3(tmpmat, data->defMats[i]);
+
+			if (!data->use_quaternion) /* quaternion already is scale corrected */
+				mul_m3_fl(smat, armature_weight / contrib);
+
+			mul_m3_series(data->defMats[i], post, smat, pre, tmpmat);
+		}
+	}
+
+	*r_prevco_weight = prevco_weight;
+	return true;
+}
+
+/* Blocks don't share any data, so they are deformed in parallel. */
+static void armature_deform_block_cb(void *userdata, int block)
+{
+	ArmatureDeformData *data = userdata;
+	float block_cos[ARM_DEFORM_BLOCK_SIZE][3], block_prevco_weight[ARM_DEFORM_BLOCK_SIZE];
+	bool block_done[ARM_DEFORM_BLOCK_SIZE];
+	ArmatureDeformStream stream;
+	const int block_start = block * ARM_DEFORM_BLOCK_SIZE;
+	const int block_len = min_ii(ARM_DEFORM_BLOCK_SIZE, data->numVerts - block_start);
+	int j;
+
+	/* Apply the object's matrix */
+	mul_v3_m4v3_array(block_cos, data->premat, (const float (*)[3])(data->cos + block_start), block_len);
+
+	armature_deform_stream_init(data, &stream, block_start, block_len, block_cos);
+
+	for (j = 0; j < block_len; j++) {
+		block_done[j] = armature_deform_vert(data, block_start + j, block_cos[j], &stream, j,
+		                                     &block_prevco_weight[j]);
+	}
+
+	armature_deform_stream_free(&stream);
+
+	/* back to object space and written to the arrays */
+	armature_deform_block_finish(data->postmat, block_cos, block_done, block_prevco_weight, block_len,
+	                             data->cos + block_start, data->vertexCos + block_start, data->use_prevcos);
+}
+
 void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float (*vertexCos)[3],
                            float (*defMats)[3][3], int numVerts, int deformflag,
                            float (*prevCos)[3], const char *defgrp_name)
@@ -837,22 +1206,20 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 	MDeformVert *dverts = NULL;
 	bDeformGroup *dg;
 	DualQuat *dualquats = NULL;
-	float obinv[4][4], premat[4][4], postmat[4][4];
-	const short use_envelope = deformflag & ARM_DEF_ENVELOPE;
+	float obinv[4][4];
 	const short use_quaternion = deformflag & ARM_DEF_QUATERNION;
-	const short invert_vgroup = deformflag & ARM_DEF_INVERT_VGROUP;
 	int defbase_tot = 0;       /* safety for vertexgroup index overflow */
 	int i, target_totvert = 0; /* safety for vertexgroup overflow */
 	bool use_dverts = false;
 	int armature_def_nr;
 	int totchan;
+	ArmatureDeformData data;
 
 	if (arm->edbo) return;
 
 	invert_m4_m4(obinv, target->obmat);
-	copy_m4_m4(premat, target->obmat);
-	mul_m4_m4m4(postmat, obinv, armOb->obmat);
-	invert_m4_m4(premat, postmat);
+	mul_m4_m4m4(data.postmat, obinv, armOb->obmat);
+	invert_m4_m4(data.premat, data.postmat);
 
 	/* bone defmats are already in the channels, chan_mat */
 
@@ -866,11 +1233,14 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 	pdef_info_array = MEM_callocN(sizeof(bPoseChanDeform) * totchan, "bPoseChanDeform");
 
 	totchan = 0;
+	data.use_bbone = false;
 	pdef_info = pdef_info_array;
 	for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
 		if (!(pchan->bone->flag & BONE_NO_DEFORM)) {
-			if (pchan->bone->segments > 1)
+			if (pchan->bone->segments > 1) {
 				pchan_b_bone_defmats(pchan, pdef_info, use_quaternion);
+				data.use_bbone = true;
+			}
 
 			if (use_quaternion) {
 				pdef_info->dual_quat = &dualquats[totchan++];
@@ -929,150 +1299,39 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 		}
 	}
 
-	for (i = 0; i < numVerts; i++) {
-		MDeformVert *dvert;
-		DualQuat sumdq, *dq = NULL;
-		float *co, dco[3];
-		float sumvec[3], summat[3][3];
-		float *vec = NULL, (*smat)[3] = NULL;
-		float contrib = 0.0f;
-		float armature_weight = 1.0f; /* default to 1 if no overall def group */
-		float prevco_weight = 1.0f;   /* weight for optional cached vertexcos */
-
-		if (use_quaternion) {
-			memset(&sumdq, 0, sizeof(DualQuat));
-			dq = &sumdq;
-		}
-		else {
-			sumvec[0] = sumvec[1] = sumvec[2] = 0.0f;
-			vec = sumvec;
-
-			if (defMats) {
-				zero_m3(summat);
-				smat = summat;
-			}
-		}
-
-		if (use_dverts || armature_def_nr != -1) {
-			if (dm)
-				dvert = dm->getVertData(dm, i, CD_MDEFORMVERT);
-			else if (dverts && i < target_totvert)
-				dvert = dverts + i;
-			else
-				dvert = NULL;
-		}
-		else
-			dvert = NULL;
-
-		if (armature_def_nr != -1 && dvert) {
-			armature_weight = defvert_find_weight(dvert, armature_def_nr);
-
-			if (invert_vgroup)
-				armature_weight = 1.0f - armature_weight;
-
-			/* hackish: the blending factor can be used for blending with prevCos too */
-			if (prevCos) {
-				prevco_weight = armature_weight;
-				armature_weight = 1.0f;
-			}
-		}
-
-		/* check if there's any  point in calculating for this vert */
-		if (armature_weight == 0.0f)
-			continue;
-
-		/* get the coord we work on */
-		co = prevCos ? prevCos[i] : vertexCos[i];
-
-		/* Apply the object's matrix */
-		mul_m4_v3(premat, co);
-
-		if (use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
-			MDeformWeight *dw = dvert->dw;
-			int deformed = 0;
-			unsigned int j;
-
-			for (j = dvert->totweight; j != 0; j--, dw++) {
-				const int index = dw->def_nr;
-				if (index >= 0 && index < defbase_tot && (pchan = defnrToPC[index])) {
-					float weight = dw->weight;
-					Bone *bone = pchan->bone;
-					pdef_info = pdef_info_array + defnrToPCIndex[index];
-
-					deformed = 1;
-
-					if (bone && bone->flag & BONE_MULT_VG_ENV) {
-						weight *= distfactor_to_bone(co, bone->arm_head, bone->arm_tail,
-						                             bone->rad_head, bone->rad_tail, bone->dist);
-					}
-					pchan_bone_deform(pchan, pdef_info, weight, vec, dq, smat, co, &contrib);
-				}
-			}
-			/* if there are vertexgroups but not groups with bones
-			 * (like for softbody groups) */
-			if (deformed == 0 && use_envelope) {
-				pdef_info = pdef_info_array;
-				for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
-					if (!(pchan->bone->flag & BONE_NO_DEFORM))
-						contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
-				}
-			}
-		}
-		else if (use_envelope) {
-			pdef_info = pdef_info_array;
-			for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
-				if (!(pchan->bone->flag & BONE_NO_DEFORM))
-					contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
-			}
-		}
-
-		/* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
-		if (contrib > 0.0001f) {
-			if (use_quaternion) {
-				normalize_dq(dq, contrib);
-
-				if (armature_weight != 1.0f) {
-					copy_v3_v3(dco, co);
-					mul_v3m3_dq(dco, (defMats) ? summat : NULL, dq);
-					sub_v3_v3(dco, co);
-					mul_v3_fl(dco, armature_weight);
-					add_v3_v3(co, dco);
-				}
-				else
-					mul_v3m3_dq(co, (defMats) ? summat : NULL, dq);
-
-				smat = summat;
-			}
-			else {
-				mul_v3_fl(vec, armature_weight / contrib);
-				add_v3_v3v3(co, vec, co);
-			}
-
-			if (defMats) {
-				float pre[3][3], post[3][3], tmpmat[3][3];
-
-				copy_m3_m4(pre, premat);
-				copy_m3_m4(post, postmat);
-				copy_m3_m3(tmpmat, defMats[i]);
-
-				if (!use_quaternion) /* quaternion already is scale corrected */
-					mul_m3_fl(smat, armature_weight / contrib);
-
-				mul_m3_series(defMats[i], post, smat, pre, tmpmat);
-			}
-		}
-
-		/* always, check above code */
-		mul_m4_v3(postmat, co);
-
-		/* interpolate with previous modifier position using weight group */
-		if (prevCos) {
-			float mw = 1.0f - prevco_weight;
-			vertexCos[i][0] = prevco_weight * vertexCos[i][0] + mw * co[0];
-			vertexCos[i][1] = prevco_weight * vertexCos[i][1] + mw * co[1];
-			vertexCos[i][2] = prevco_weight * vertexCos[i][2] + mw * co[2];
-		}
-	}
+	/* fetch the deform vertices once, not for every vertex */
+	data.dverts = NULL;
+	data.dverts_len = 0;
+	if (use_dverts || armature_def_nr != -1) {
+		if (dm) {
+			data.dverts = dm->getVertDataArray(dm, CD_MDEFORMVERT);
+			data.dverts_len = dm->getNumVerts(dm);
+		}
+		else if (dverts) {
+			data.dverts = dverts;
+			data.dverts_len = target_totvert;
+		}
+	}
+
+	data.armOb = armOb;
+	data.pdef_info_array = pdef_info_array;
+	data.defnrToPC = defnrToPC;
+	data.defnrToPCIndex = defnrToPCIndex;
+	data.defbase_tot = defbase_tot;
+	data.use_dverts = use_dverts;
+	data.armature_def_nr = armature_def_nr;
+	/* the coords we work on */
+	data.cos = prevCos ? prevCos : vertexCos;
+	data.vertexCos = vertexCos;
+	data.defMats = defMats;
+	data.numVerts = numVerts;
+	data.use_envelope = (deformflag & ARM_DEF_ENVELOPE) != 0;
+	data.use_quaternion = use_quaternion != 0;
+	data.invert_vgroup = (deformflag & ARM_DEF_INVERT_VGROUP) != 0;
+	data.use_prevcos = prevCos != NULL;
+
+	BLI_task_parallel_range_ex(0, (numVerts + ARM_DEFORM_BLOCK_SIZE - 1) / ARM_DEFORM_BLOCK_SIZE,
+	                           &data, armature_deform_block_cb, ARM_DEFORM_PARALLEL_MIN_BLOCKS, false);
 
 	if (dualquats)
 		MEM_freeN(dualquats);
@@ -58,6 +58,8 @@
 #include "BLI_utildefines.h"
 #include "BLI_callbacks.h"
 
+#include "PIL_time.h"
+
 #include "IMB_imbuf.h"
 #include "IMB_moviecache.h"
 
@@ -555,14 +557,14 @@ bool BKE_read_file_from_memory(
 	return (bfd != NULL);
 }
 
-/* memfile is the undo buffer */
+/* memfile is the undo buffer, oldmemfile the one of the current main (optional) */
 bool BKE_read_file_from_memfile(
-        bContext *C, MemFile *memfile,
+        bContext *C, MemFile *memfile, MemFile *oldmemfile,
         ReportList *reports)
 {
 	BlendFileData *bfd;
 
-	bfd = BLO_read_from_memfile(CTX_data_main(C), G.main->name, memfile, reports);
+	bfd = BLO_read_from_memfile(CTX_data_main(C), G.main->name, memfile, oldmemfile, reports);
 	if (bfd) {
 		/* remove the unused screens and wm */
 		while (bfd->main->wm.first)
@@ -655,7 +657,8 @@ static ListBase undobase = {NULL, NULL};
 static UndoElem *curundo = NULL;
 
 
-static int read_undosave(bContext *C, UndoElem *uel)
+/* uel_current: the step of the current main, when known */
+static int read_undosave(bContext *C, UndoElem *uel, UndoElem *uel_current)
 {
 	char mainstr[sizeof(G.main->name)];
 	int success = 0, fileflags;
@@ -671,7 +674,7 @@ static int read_undosave(bContext *C, UndoElem *uel)
 	if (UNDO_DISK) 
 		success = (BKE_read_file(C, uel->str, NULL) != BKE_READ_FILE_FAIL);
 	else
-		success = BKE_read_file_from_memfile(C, &uel->memfile, NULL);
+		success = BKE_read_file_from_memfile(C, &uel->memfile, uel_current ? &uel_current->memfile : NULL, NULL);
 
 	/* restore */
 	BLI_strncpy(G.main->name, mainstr, sizeof(G.main->name)); /* restore */
@@ -680,6 +683,13 @@ static int read_undosave(bContext *C, UndoElem *uel)
 	if (success) {
 		/* important not to update time here, else non keyed tranforms are lost */
 		DAG_on_visible_update(G.main, false);
+		
+		BKE_main_id_flag_all(G.main, LIB_UNDO_KEPT, false);
+		
+		/* to find what's changed before the next undo, see BLO_read_from_memfile */
+		if (!UNDO_DISK) {
+			BLO_memfile_main_read(&uel->memfile, G.main);
+		}
 	}
 
 	return success;
@@ -752,12 +762,18 @@ void BKE_undo_write(bContext *C, const char *name)
 	}
 	else {
 		MemFile *prevfile = NULL;
+		const double time_start = PIL_check_seconds_timer();
 		
 		if (curundo->prev) prevfile = &(curundo->prev->memfile);
 		
 		memused = MEM_get_memory_in_use();
 		/* success = */ /* UNUSED */ BLO_write_file_mem(CTX_data_main(C), prevfile, &curundo->memfile, G.fileflags);
 		curundo->undosize = MEM_get_memory_in_use() - memused;
+
+		if (G.debug & G_DEBUG) {
+			printf("undo push %s: %.2f ms, %.2f MB\n", curundo->name,
+			       (PIL_check_seconds_timer() - time_start) * 1000.0, (double)curundo->undosize / (1024.0 * 1024.0));
+		}
 	}
 
 	if (U.undomemory != 0) {
@@ -793,7 +809,7 @@ void BKE_undo_step(bContext *C, int step)
 {
 	
 	if (step == 0) {
-		read_undosave(C, curundo);
+		read_undosave(C, curundo, NULL);
 	}
 	else if (step == 1) {
 		/* curundo should never be NULL, after restart or load file it should call undo_save */
@@ -803,7 +819,7 @@ void BKE_undo_step(bContext *C, int step)
 		else {
 			if (G.debug & G_DEBUG) printf("undo %s\n", curundo->name);
 			curundo = curundo->prev;
-			read_undosave(C, curundo);
+			read_undosave(C, curundo, curundo->next);
 		}
 	}
 	else {
@@ -813,7 +829,7 @@ void BKE_undo_step(bContext *C, int step)
 			// XXX error("No redo available");
 		}
 		else {
-			read_undosave(C, curundo->next);
+			read_undosave(C, curundo->next, curundo);
 			curundo = curundo->next;
 			if (G.debug & G_DEBUG) printf("redo %s\n", curundo->name);
 		}
@@ -939,11 +955,20 @@ bool BKE_undo_save_file(const char *filename)
 	return true;
 }
 
+/* the memfile of the current undo step, to save it from a thread (see: BLO_write_file_snapshot_memfile) */
+const struct MemFile *BKE_undo_get_memfile(void)
+{
+	if ((U.uiflag & USER_GLOBALUNDO) == 0 || curundo == NULL) {
+		return NULL;
+	}
+	return &curundo->memfile;
+}
+
 /* sets curscene */
 Main *BKE_undo_get_main(Scene **r_scene)
 {
 	Main *mainp = NULL;
-	BlendFileData *bfd = BLO_read_from_memfile(G.main, G.main->name, &curundo->memfile, NULL);
+	BlendFileData *bfd = BLO_read_from_memfile(G.main, G.main->name, &curundo->memfile, NULL, NULL);
 	
 	if (bfd) {
 		mainp = bfd->main;
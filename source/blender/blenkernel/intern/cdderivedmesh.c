@@ -172,12 +172,9 @@ static void cdDM_copyPolyArray(DerivedMesh *dm, MPoly *r_poly)
 static void cdDM_getMinMax(DerivedMesh *dm, float r_min[3], float r_max[3])
 {
 	CDDerivedMesh *cddm = (CDDerivedMesh *) dm;
-	int i;
 
 	if (dm->numVertData) {
-		for (i = 0; i < dm->numVertData; i++) {
-			minmax_v3v3_v3(r_min, r_max, cddm->mvert[i].co);
-		}
+		minmax_v3v3_v3_array_stride(r_min, r_max, cddm->mvert->co, sizeof(*cddm->mvert), dm->numVertData);
 	}
 	else {
 		zero_v3(r_min);
@@ -2378,17 +2375,13 @@ static DerivedMesh *cddm_copy_ex(DerivedMesh *source, int faces_from_tessfaces)
 	source->getTessFaceDataArray(source, CD_ORIGINDEX);
 	source->getPolyDataArray(source, CD_ORIGINDEX);
 
-	/* this initializes dm, and copies all non mvert/medge/mface layers */
-	DM_from_template(dm, source, DM_TYPE_CDDM, numVerts, numEdges, numTessFaces,
-	                 numLoops, numPolys);
+	/* this initializes dm, and copies all non mvert/medge/mface layers,
+	 * sharing the data of layers modifiers only read */
+	DM_from_template_copy(dm, source, DM_TYPE_CDDM);
 	dm->deformedOnly = source->deformedOnly;
 	dm->cd_flag = source->cd_flag;
 	dm->dirty = source->dirty;
 
-	CustomData_copy_data(&source->vertData, &dm->vertData, 0, 0, numVerts);
-	CustomData_copy_data(&source->edgeData, &dm->edgeData, 0, 0, numEdges);
-	CustomData_copy_data(&source->faceData, &dm->faceData, 0, 0, numTessFaces);
-
 	/* now add mvert/medge/mface layers */
 	cddm->mvert = source->dupVertArray(source);
 	cddm->medge = source->dupEdgeArray(source);
@@ -2398,10 +2391,13 @@ static DerivedMesh *cddm_copy_ex(DerivedMesh *source, int faces_from_tessfaces)
 	CustomData_add_layer(&dm->edgeData, CD_MEDGE, CD_ASSIGN, cddm->medge, numEdges);
 	CustomData_add_layer(&dm->faceData, CD_MFACE, CD_ASSIGN, cddm->mface, numTessFaces);
 	
-	if (!faces_from_tessfaces)
-		DM_DupPolys(source, dm);
-	else
+	if (!faces_from_tessfaces) {
+		CustomData_add_layer(&dm->loopData, CD_MLOOP, CD_ASSIGN, source->dupLoopArray(source), numLoops);
+		CustomData_add_layer(&dm->polyData, CD_MPOLY, CD_ASSIGN, source->dupPolyArray(source), numPolys);
+	}
+	else {
 		CDDM_tessfaces_to_faces(dm);
+	}
 
 	cddm->mloop = CustomData_get_layer(&dm->loopData, CD_MLOOP);
 	cddm->mpoly = CustomData_get_layer(&dm->polyData, CD_MPOLY);
@@ -2653,10 +2649,10 @@ void CDDM_calc_loop_normals_spacearr(
 
 	clnor_data = CustomData_get_layer(ldata, CD_CUSTOMLOOPNORMAL);
 
-	BKE_mesh_normals_loop_split(mverts, numVerts, medges, numEdges, mloops, lnors, numLoops,
-	                            mpolys, (const float (*)[3])pnors, numPolys,
-	                            use_split_normals, split_angle,
-	                            r_lnors_spacearr, clnor_data, NULL);
+	BKE_mesh_normals_loop_split_ex(mverts, numVerts, medges, numEdges, mloops, lnors, numLoops,
+	                               mpolys, (const float (*)[3])pnors, numPolys,
+	                               use_split_normals, split_angle,
+	                               r_lnors_spacearr, clnor_data, NULL, dm->lnor_split_cache);
 #ifdef DEBUG_CLNORS
 	if (r_lnors_spacearr) {
 		int i;
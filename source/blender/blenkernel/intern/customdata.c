@@ -50,6 +50,7 @@
 #include "BLI_math.h"
 #include "BLI_math_color_blend.h"
 #include "BLI_mempool.h"
+#include "BLI_threads.h"
 
 #include "BLT_translation.h"
 
@@ -1404,6 +1405,112 @@ static const char *layerType_getName(int type)
 	return LAYERTYPENAMES[type];
 }
 
+static void *layerType_dup(int type, const void *data, int totelem)
+{
+	/* MEM_dupallocN won't work in case of complex layers, like e.g.
+	 * CD_MDEFORMVERT, which has pointers to allocated data...
+	 * So in case a custom copy function is defined, use it!
+	 */
+	const LayerTypeInfo *typeInfo = layerType_getInfo(type);
+	void *dst_data;
+
+	if (typeInfo->copy) {
+		dst_data = MEM_mallocN(totelem * typeInfo->size, "CD duplicate ref layer");
+		typeInfo->copy(data, dst_data, totelem);
+	}
+	else {
+		dst_data = MEM_dupallocN(data);
+	}
+
+	return dst_data;
+}
+
+/* Shared layers
+ *
+ * Layers copied with CD_SHARE use the array of the layer they are copied from, which is freed
+ * with its last user. Like referenced layers they have CD_FLAG_NOFREE set, code writing into
+ * them has to use CustomData_duplicate_referenced_layer() to get its own copy first.
+ */
+typedef struct CustomDataShared {
+	int users;
+	int totelem;  /* size of the array, the layers may have been shrunk since */
+} CustomDataShared;
+
+/* derived meshes of other objects are copied while those are evaluated in threads */
+static ThreadMutex customdata_shared_lock = BLI_MUTEX_INITIALIZER;
+
+/* Only types that are not written into in-place on derived meshes,
+ * unlike e.g. coordinates, normals, orco or original indices. */
+static bool layerType_isShareable(int type)
+{
+	return ELEM(type, CD_MDEFORMVERT, CD_MLOOPUV, CD_MLOOPCOL, CD_MTEXPOLY, CD_PROP_FLT, CD_PROP_INT, CD_PROP_STR);
+}
+
+static bool customData_layer_can_share(const CustomDataLayer *layer, int totelem)
+{
+	if (!layerType_isShareable(layer->type) || layer->data == NULL) {
+		return false;
+	}
+	/* plain references are owned by someone else, their lifetime is unknown here */
+	else if (layer->shared == NULL) {
+		return !(layer->flag & CD_FLAG_NOFREE);
+	}
+	else {
+		return layer->shared->totelem == totelem;
+	}
+}
+
+static void customData_layer_share(CustomDataLayer *layer_src, CustomDataLayer *layer_dst, int totelem)
+{
+	BLI_mutex_lock(&customdata_shared_lock);
+	if (layer_src->shared == NULL) {
+		layer_src->shared = MEM_mallocN(sizeof(*layer_src->shared), __func__);
+		layer_src->shared->users = 1;
+		layer_src->shared->totelem = totelem;
+		layer_src->flag |= CD_FLAG_NOFREE;
+	}
+	layer_src->shared->users++;
+	BLI_mutex_unlock(&customdata_shared_lock);
+
+	layer_dst->data = layer_src->data;
+	layer_dst->shared = layer_src->shared;
+	layer_dst->flag |= CD_FLAG_NOFREE;
+}
+
+/* Drops the reference of a shared layer, or gives it its own data when keep_data is set. */
+static void customData_layer_unshare(CustomDataLayer *layer, const bool keep_data)
+{
+	CustomDataShared *shared = layer->shared;
+	const int totelem = shared->totelem;
+	bool is_last;
+
+	BLI_mutex_lock(&customdata_shared_lock);
+	is_last = (--shared->users == 0);
+	BLI_mutex_unlock(&customdata_shared_lock);
+
+	if (is_last) {
+		MEM_freeN(shared);
+
+		if (keep_data) {
+			layer->flag &= ~CD_FLAG_NOFREE;
+		}
+		else {
+			const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
+
+			if (typeInfo->free)
+				typeInfo->free(layer->data, totelem, typeInfo->size);
+			MEM_freeN(layer->data);
+			layer->data = NULL;
+		}
+	}
+	else if (keep_data) {
+		layer->data = layerType_dup(layer->type, layer->data, totelem);
+		layer->flag &= ~CD_FLAG_NOFREE;
+	}
+
+	layer->shared = NULL;
+}
+
 void customData_mask_layers__print(CustomDataMask mask)
 {
 	int i;
@@ -1487,6 +1594,7 @@ bool CustomData_merge(const struct CustomData *source, struct CustomData *dest,
 			case CD_ASSIGN:
 			case CD_REFERENCE:
 			case CD_DUPLICATE:
+			case CD_SHARE:
 				data = layer->data;
 				break;
 			default:
@@ -1494,7 +1602,19 @@ bool CustomData_merge(const struct CustomData *source, struct CustomData *dest,
 				break;
 		}
 
-		if ((alloctype == CD_ASSIGN) && (flag & CD_FLAG_NOFREE)) {
+		if (alloctype == CD_SHARE) {
+			if (customData_layer_can_share(layer, totelem)) {
+				newlayer = customData_add_layer__internal(dest, type, CD_CALLOC, NULL, 0, layer->name);
+				if (newlayer && newlayer->data == NULL) {
+					/* the source layer becomes shared too */
+					customData_layer_share(layer, newlayer, totelem);
+				}
+			}
+			else {
+				newlayer = customData_add_layer__internal(dest, type, CD_DUPLICATE, data, totelem, layer->name);
+			}
+		}
+		else if ((alloctype == CD_ASSIGN) && (flag & CD_FLAG_NOFREE)) {
 			newlayer = customData_add_layer__internal(dest, type, CD_REFERENCE, data, totelem, layer->name);
 		}
 		else {
@@ -1549,7 +1669,10 @@ static void customData_free_layer__internal(CustomDataLayer *layer, int totelem)
 {
 	const LayerTypeInfo *typeInfo;
 
-	if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
+	if (layer->shared) {
+		customData_layer_unshare(layer, false);
+	}
+	else if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
 		typeInfo = layerType_getInfo(layer->type);
 
 		if (typeInfo->free)
@@ -1899,6 +2022,7 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data, int typ
 	data->layers[index].type = type;
 	data->layers[index].flag = flag;
 	data->layers[index].data = newlayerdata;
+	data->layers[index].shared = NULL;
 
 	if (name || (name = DATA_(typeInfo->defaultname))) {
 		BLI_strncpy(data->layers[index].name, name, sizeof(data->layers[index].name));
@@ -2050,22 +2174,11 @@ static void *customData_duplicate_referenced_layer_index(CustomData *data, const
 
 	layer = &data->layers[layer_index];
 
-	if (layer->flag & CD_FLAG_NOFREE) {
-		/* MEM_dupallocN won't work in case of complex layers, like e.g.
-		 * CD_MDEFORMVERT, which has pointers to allocated data...
-		 * So in case a custom copy function is defined, use it!
-		 */
-		const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
-
-		if (typeInfo->copy) {
-			void *dst_data = MEM_mallocN(totelem * typeInfo->size, "CD duplicate ref layer");
-			typeInfo->copy(layer->data, dst_data, totelem);
-			layer->data = dst_data;
-		}
-		else {
-			layer->data = MEM_dupallocN(layer->data);
-		}
-
+	if (layer->shared) {
+		customData_layer_unshare(layer, true);
+	}
+	else if (layer->flag & CD_FLAG_NOFREE) {
+		layer->data = layerType_dup(layer->type, layer->data, totelem);
 		layer->flag &= ~CD_FLAG_NOFREE;
 	}
 
@@ -2179,7 +2292,12 @@ static void CustomData_copy_data_layer(
 	int dst_offset;
 
 	const void *src_data = source->layers[src_i].data;
-	void *dst_data = dest->layers[dst_i].data;
+	void *dst_data;
+
+	if (dest->layers[dst_i].shared) {
+		customData_layer_unshare(&dest->layers[dst_i], true);
+	}
+	dst_data = dest->layers[dst_i].data;
 
 	typeInfo = layerType_getInfo(source->layers[src_i].type);
 
@@ -2313,6 +2431,10 @@ void CustomData_interp(const CustomData *source, CustomData *dest,
 				sources[j] = POINTER_OFFSET(src_data, src_indices[j] * typeInfo->size);
 			}
 
+			if (dest->layers[dest_i].shared) {
+				customData_layer_unshare(&dest->layers[dest_i], true);
+			}
+
 			typeInfo->interp(sources, weights, sub_weights, count,
 			                 POINTER_OFFSET(dest->layers[dest_i].data, dest_index * typeInfo->size));
 
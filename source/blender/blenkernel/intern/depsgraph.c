@@ -84,6 +84,8 @@
 
 #include "GPU_buffers.h"
 
+#include "RNA_types.h"
+
 #include "atomic_ops.h"
 
 #include "depsgraph_private.h"
@@ -2476,8 +2478,12 @@ void DAG_on_visible_update(Main *bmain, const bool do_time)
 			oblay = (node) ? node->lay : ob->lay;
 
 			if ((oblay & lay) & ~scene->lay_updated) {
-				/* TODO(sergey): Why do we need armature here now but didn't need before? */
-				if (ELEM(ob->type, OB_MESH, OB_CURVE, OB_SURF, OB_FONT, OB_MBALL, OB_LATTICE, OB_ARMATURE)) {
+				/* TODO(sergey): Why do we need armature here now but didn't need before?
+				 * Objects with derived data kept over undo only need their transform,
+				 * see: blo_end_undo_reuse_map */
+				if (ELEM(ob->type, OB_MESH, OB_CURVE, OB_SURF, OB_FONT, OB_MBALL, OB_LATTICE, OB_ARMATURE) &&
+				    (ob->id.flag & LIB_UNDO_KEPT) == 0)
+				{
 					ob->recalc |= OB_RECALC_DATA;
 					lib_id_recalc_tag(bmain, &ob->id);
 				}
@@ -2969,6 +2975,16 @@ void DAG_id_tag_update(ID *id, short flag)
 	DAG_id_tag_update_ex(G.main, id, flag);
 }
 
+void DAG_data_tag_update(PointerRNA *ptr, short flag)
+{
+	if (!DEG_depsgraph_use_legacy()) {
+		DEG_data_tag_update_ex(G.main, ptr, flag);
+		return;
+	}
+
+	DAG_id_tag_update_ex(G.main, ptr->id.data, flag);
+}
+
 void DAG_id_type_tag(Main *bmain, short idtype)
 {
 	if (idtype == ID_NT) {
@@ -3591,6 +3607,11 @@ void DAG_id_tag_update_ex(Main *bmain, ID *id, short flag)
 	DEG_id_tag_update_ex(bmain, id, flag);
 }
 
+void DAG_data_tag_update(PointerRNA *ptr, short flag)
+{
+	DEG_data_tag_update_ex(G.main, ptr, flag);
+}
+
 void DAG_id_type_tag(Main *bmain, short idtype)
 {
 	DEG_id_type_tag(bmain, idtype);
@@ -1820,16 +1820,12 @@ float *BKE_displist_make_orco(Scene *scene, Object *ob, DerivedMesh *dm_final,
 void BKE_displist_minmax(ListBase *dispbase, float min[3], float max[3])
 {
 	DispList *dl;
-	const float *vert;
-	int a, tot = 0;
+	int tot = 0;
 	int doit = 0;
 
 	for (dl = dispbase->first; dl; dl = dl->next) {
 		tot = (dl->type == DL_INDEX3) ? dl->nr : dl->nr * dl->parts;
-		vert = dl->verts;
-		for (a = 0; a < tot; a++, vert += 3) {
-			minmax_v3v3_v3(min, max, vert);
-		}
+		minmax_v3v3_v3_array(min, max, (float (*)[3])dl->verts, tot);
 		doit |= (tot != 0);
 	}
 
@@ -1786,7 +1786,8 @@ static DerivedMesh *dynamicPaint_Modifier_apply(DynamicPaintModifierData *pmd,
 						/* save layer data to output layer */
 
 						/* paint layer */
-						col = CustomData_get_layer_named(&result->loopData, CD_MLOOPCOL, surface->output_name);
+						col = CustomData_duplicate_referenced_layer_named(&result->loopData, CD_MLOOPCOL,
+						                                                  surface->output_name, totloop);
 						/* if output layer is lost from a constructive modifier, re-add it */
 						if (!col && dynamicPaint_outputLayerExists(surface, ob, 0))
 							col = CustomData_add_layer_named(&result->loopData, CD_MLOOPCOL, CD_CALLOC, NULL, totloop, surface->output_name);
@@ -1803,7 +1804,8 @@ static DerivedMesh *dynamicPaint_Modifier_apply(DynamicPaintModifierData *pmd,
 						MEM_freeN(fcolor);
 
 						/* wet layer */
-						col = CustomData_get_layer_named(&result->loopData, CD_MLOOPCOL, surface->output_name2);
+						col = CustomData_duplicate_referenced_layer_named(&result->loopData, CD_MLOOPCOL,
+						                                                  surface->output_name2, totloop);
 						/* if output layer is lost from a constructive modifier, re-add it */
 						if (!col && dynamicPaint_outputLayerExists(surface, ob, 1))
 							col = CustomData_add_layer_named(&result->loopData, CD_MLOOPCOL, CD_CALLOC, NULL, totloop, surface->output_name2);
@@ -1825,7 +1827,8 @@ static DerivedMesh *dynamicPaint_Modifier_apply(DynamicPaintModifierData *pmd,
 					/* vertex group paint */
 					else if (surface->type == MOD_DPAINT_SURFACE_T_WEIGHT) {
 						int defgrp_index = defgroup_name_index(ob, surface->output_name);
-						MDeformVert *dvert = result->getVertDataArray(result, CD_MDEFORMVERT);
+						MDeformVert *dvert = CustomData_duplicate_referenced_layer(&result->vertData, CD_MDEFORMVERT,
+						                                                           result->getNumVerts(result));
 						float *weight = (float *)sData->type_data;
 
 						/* viewport preview */
@@ -430,32 +430,26 @@ LatticeDeformData *init_latt_deform(Object *oblatt, Object *ob)
 	return lattice_deform_data;
 }
 
-void calc_latt_deform(LatticeDeformData *lattice_deform_data, float co[3], float weight)
+/**
+ * \param vec: \a co in lattice space (transformed by \a latmat).
+ * \param dvert, defgrp_index: Lattice vertex group influence, when \a defgrp_index isn't -1.
+ */
+static void calc_latt_deform_ex(
+        LatticeDeformData *lattice_deform_data, const Lattice *lt,
+        const MDeformVert *dvert, const int defgrp_index,
+        float co[3], const float vec[3], float weight)
 {
-	Object *ob = lattice_deform_data->object;
-	Lattice *lt = ob->data;
 	float u, v, w, tu[4], tv[4], tw[4];
-	float vec[3];
 	int idx_w, idx_v, idx_u;
 	int ui, vi, wi, uu, vv, ww;
 
 	/* vgroup influence */
-	int defgrp_index = -1;
 	float co_prev[3], weight_blend = 0.0f;
-	MDeformVert *dvert = BKE_lattice_deform_verts_get(ob);
 
-
-	if (lt->editlatt) lt = lt->editlatt->latt;
-	if (lattice_deform_data->latticedata == NULL) return;
-
-	if (lt->vgroup[0] && dvert) {
-		defgrp_index = defgroup_name_index(ob, lt->vgroup);
+	if (defgrp_index != -1) {
 		copy_v3_v3(co_prev, co);
 	}
 
-	/* co is in local coords, treat with latmat */
-	mul_v3_m4v3(vec, lattice_deform_data->latmat, co);
-
 	/* u v w coords */
 
 	if (lt->pntsu > 1) {
@@ -543,6 +537,81 @@ void calc_latt_deform(LatticeDeformData *lattice_deform_data, float co[3], float
 
 }
 
+/* Lattice and its vertex group influence, the same for all vertices. */
+static const Lattice *latt_deform_lattice_get(
+        LatticeDeformData *lattice_deform_data,
+        const MDeformVert **r_dvert, int *r_defgrp_index)
+{
+	Object *ob = lattice_deform_data->object;
+	Lattice *lt = ob->data;
+	MDeformVert *dvert = BKE_lattice_deform_verts_get(ob);
+
+	if (lt->editlatt) lt = lt->editlatt->latt;
+
+	*r_dvert = dvert;
+	*r_defgrp_index = (lt->vgroup[0] && dvert) ? defgroup_name_index(ob, lt->vgroup) : -1;
+
+	return lt;
+}
+
+void calc_latt_deform(LatticeDeformData *lattice_deform_data, float co[3], float weight)
+{
+	const Lattice *lt;
+	const MDeformVert *dvert;
+	int defgrp_index;
+	float vec[3];
+
+	if (lattice_deform_data->latticedata == NULL) return;
+
+	lt = latt_deform_lattice_get(lattice_deform_data, &dvert, &defgrp_index);
+
+	/* co is in local coords, treat with latmat */
+	mul_v3_m4v3(vec, lattice_deform_data->latmat, co);
+
+	calc_latt_deform_ex(lattice_deform_data, lt, dvert, defgrp_index, co, vec, weight);
+}
+
+/* Vertices are moved into lattice space in blocks of this size. */
+#define LATT_DEFORM_BLOCK_SIZE 256
+
+/**
+ * #calc_latt_deform for an array of coordinates.
+ *
+ * \param weights: Per vertex weight (multiplied by \a fac), can be NULL.
+ */
+static void calc_latt_deform_array(
+        LatticeDeformData *lattice_deform_data, float (*vertexCos)[3], int numVerts,
+        const float *weights, float fac)
+{
+	const Lattice *lt;
+	const MDeformVert *dvert;
+	int defgrp_index;
+	float block_vecs[LATT_DEFORM_BLOCK_SIZE][3];
+	int block_start;
+
+	if (lattice_deform_data->latticedata == NULL) return;
+
+	lt = latt_deform_lattice_get(lattice_deform_data, &dvert, &defgrp_index);
+
+	for (block_start = 0; block_start < numVerts; block_start += LATT_DEFORM_BLOCK_SIZE) {
+		const int block_len = min_ii(LATT_DEFORM_BLOCK_SIZE, numVerts - block_start);
+		int i;
+
+		/* co is in local coords, treat with latmat */
+		mul_v3_m4v3_array(block_vecs, lattice_deform_data->latmat,
+		                  (const float (*)[3])(vertexCos + block_start), block_len);
+
+		for (i = 0; i < block_len; i++) {
+			const float weight = weights ? weights[block_start + i] * fac : fac;
+			if (weights && !(weights[block_start + i] > 0.0f)) {
+				continue;
+			}
+			calc_latt_deform_ex(lattice_deform_data, lt, dvert, defgrp_index,
+			                    vertexCos[block_start + i], block_vecs[i], weight);
+		}
+	}
+}
+
 void end_latt_deform(LatticeDeformData *lattice_deform_data)
 {
 	if (lattice_deform_data->latticedata)
@@ -911,25 +980,23 @@ void lattice_deform_verts(Object *laOb, Object *target, DerivedMesh *dm,
 	if (vgroup && vgroup[0] && use_vgroups) {
 		Mesh *me = target->data;
 		const int defgrp_index = defgroup_name_index(target, vgroup);
-		float weight;
 
 		if (defgrp_index >= 0 && (me->dvert || dm)) {
 			MDeformVert *dvert = me->dvert;
+			float *weights = MEM_mallocN(sizeof(*weights) * (size_t)numVerts, __func__);
 			
 			for (a = 0; a < numVerts; a++, dvert++) {
 				if (dm) dvert = dm->getVertData(dm, a, CD_MDEFORMVERT);
 
-				weight = defvert_find_weight(dvert, defgrp_index);
-
-				if (weight > 0.0f)
-					calc_latt_deform(lattice_deform_data, vertexCos[a], weight * fac);
+				weights[a] = defvert_find_weight(dvert, defgrp_index);
 			}
+
+			calc_latt_deform_array(lattice_deform_data, vertexCos, numVerts, weights, fac);
+			MEM_freeN(weights);
 		}
 	}
 	else {
-		for (a = 0; a < numVerts; a++) {
-			calc_latt_deform(lattice_deform_data, vertexCos[a], fac);
-		}
+		calc_latt_deform_array(lattice_deform_data, vertexCos, numVerts, NULL, fac);
 	}
 	end_latt_deform(lattice_deform_data);
 }
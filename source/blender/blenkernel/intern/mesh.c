@@ -1912,10 +1912,8 @@ int BKE_mesh_edge_other_vert(const MEdge *e, int v)
 /* basic vertex data functions */
 bool BKE_mesh_minmax(const Mesh *me, float r_min[3], float r_max[3])
 {
-	int i = me->totvert;
-	MVert *mvert;
-	for (mvert = me->mvert; i--; mvert++) {
-		minmax_v3v3_v3(r_min, r_max, mvert->co);
+	if (me->totvert) {
+		minmax_v3v3_v3_array_stride(r_min, r_max, me->mvert->co, sizeof(*me->mvert), me->totvert);
 	}
 	
 	return (me->totvert != 0);
@@ -167,11 +167,35 @@ void BKE_mesh_calc_normals_mapping_ex(
 	
 }
 
-static void mesh_calc_normals_poly_accum(
-        const MPoly *mp, const MLoop *ml,
-        const MVert *mvert,
-        float r_polyno[3], float (*r_tnorms)[3])
+typedef struct MeshCalcNormalsData {
+	const MPoly *mpolys;
+	const MLoop *mloop;
+	MVert *mverts;
+	float (*pnors)[3];
+	float (*lnors_weighted)[3];
+	int lnors_weighted_loopstart;  /* loop stored first in lnors_weighted */
+	float (*vnors)[3];
+} MeshCalcNormalsData;
+
+static void mesh_calc_normals_poly_cb(void *userdata, int pidx)
+{
+	MeshCalcNormalsData *data = userdata;
+	const MPoly *mp = &data->mpolys[pidx];
+
+	BKE_mesh_calc_poly_normal(mp, data->mloop + mp->loopstart, data->mverts, data->pnors[pidx]);
+}
+
+static void mesh_calc_normals_poly_accum_cb(void *userdata, int pidx)
 {
+	MeshCalcNormalsData *data = userdata;
+	const MPoly *mp = &data->mpolys[pidx];
+	const MLoop *ml = data->mloop + mp->loopstart;
+	const MVert *mverts = data->mverts;
+
+	float pnor_temp[3];
+	float *pnor = data->pnors ? data->pnors[pidx] : pnor_temp;
+	float (*lnors_weighted)[3] = data->lnors_weighted + (mp->loopstart - data->lnors_weighted_loopstart);
+
 	const int nverts = mp->totloop;
 	float (*edgevecbuf)[3] = BLI_array_alloca(edgevecbuf, (size_t)nverts);
 	int i;
@@ -180,14 +204,14 @@ static void mesh_calc_normals_poly_accum(
 	/* inline version of #BKE_mesh_calc_poly_normal, also does edge-vectors */
 	{
 		int i_prev = nverts - 1;
-		const float *v_prev = mvert[ml[i_prev].v].co;
+		const float *v_prev = mverts[ml[i_prev].v].co;
 		const float *v_curr;
 
-		zero_v3(r_polyno);
+		zero_v3(pnor);
 		/* Newell's Method */
 		for (i = 0; i < nverts; i++) {
-			v_curr = mvert[ml[i].v].co;
-			add_newell_cross_v3_v3v3(r_polyno, v_prev, v_curr);
+			v_curr = mverts[ml[i].v].co;
+			add_newell_cross_v3_v3v3(pnor, v_prev, v_curr);
 
 			/* Unrelated to normalize, calculate edge-vector */
 			sub_v3_v3v3(edgevecbuf[i_prev], v_prev, v_curr);
@@ -196,12 +220,12 @@ static void mesh_calc_normals_poly_accum(
 
 			v_prev = v_curr;
 		}
-		if (UNLIKELY(normalize_v3(r_polyno) == 0.0f)) {
-			r_polyno[2] = 1.0f; /* other axis set to 0.0 */
+		if (UNLIKELY(normalize_v3(pnor) == 0.0f)) {
+			pnor[2] = 1.0f; /* other axis set to 0.0 */
 		}
 	}
 
-	/* accumulate angle weighted face normal */
+	/* store angle weighted face normal for each loop, summed per vertex afterwards */
 	/* inline version of #accumulate_vertex_normals_poly */
 	{
 		const float *prev_edge = edgevecbuf[nverts - 1];
@@ -213,65 +237,113 @@ static void mesh_calc_normals_poly_accum(
 			 * this vertex */
 			const float fac = saacos(-dot_v3v3(cur_edge, prev_edge));
 
-			/* accumulate */
-			madd_v3_v3fl(r_tnorms[ml[i].v], r_polyno, fac);
+			mul_v3_v3fl(lnors_weighted[i], pnor, fac);
 			prev_edge = cur_edge;
 		}
 	}
+}
+
+static void mesh_calc_normals_poly_finalize_cb(void *userdata, int vidx)
+{
+	MeshCalcNormalsData *data = userdata;
+	MVert *mv = &data->mverts[vidx];
+	float *no = data->vnors[vidx];
+
+	if (UNLIKELY(normalize_v3(no) == 0.0f)) {
+		/* following Mesh convention; we use vertex coordinate itself for normal in this case */
+		normalize_v3_v3(no, mv->co);
+	}
 
+	normal_float_to_short_v3(mv->no, no);
 }
 
+/* polys done at once when not threaded, so their weighted loop normals are still in cache when summed */
+#define MESH_NORMALS_POLYS_BLOCK_SIZE 1024
+
+/**
+ * Vertex normals are computed in passes over separate float3 arrays (poly normals,
+ * angle weighted normal of each loop, then their sum for each vertex), so the costly parts run in parallel
+ * and only the accumulation walks the vertices in random order. The same arithmetic runs whether
+ * threaded or not, only the number of polys done in each pass changes, so normals don't depend
+ * on the number of threads.
+ */
 void BKE_mesh_calc_normals_poly(
         MVert *mverts, int numVerts,
         const MLoop *mloop, const MPoly *mpolys,
-        int UNUSED(numLoops), int numPolys, float (*r_polynors)[3],
+        int numLoops, int numPolys, float (*r_polynors)[3],
         const bool only_face_normals)
 {
-	float (*pnors)[3] = r_polynors;
-	float (*tnorms)[3];
+	MeshCalcNormalsData data = {NULL};
+	float (*vnors)[3];
+	int polys_block_size, poly_start, lnors_weighted_len = 0;
 	int i;
 	const MPoly *mp;
 
+	data.mpolys = mpolys;
+	data.mloop = mloop;
+	data.mverts = mverts;
+	data.pnors = r_polynors;
+
 	if (only_face_normals) {
-		BLI_assert((pnors != NULL) || (numPolys == 0));
+		BLI_assert((r_polynors != NULL) || (numPolys == 0));
 
-#pragma omp parallel for if (numPolys > BKE_MESH_OMP_LIMIT)
-		for (i = 0; i < numPolys; i++) {
-			BKE_mesh_calc_poly_normal(&mpolys[i], mloop + mpolys[i].loopstart, mverts, pnors[i]);
-		}
+		BLI_task_parallel_range_ex(0, numPolys, &data, mesh_calc_normals_poly_cb, BKE_MESH_OMP_LIMIT, false);
 		return;
 	}
 
 	/* first go through and calculate normals for all the polys */
-	tnorms = MEM_callocN(sizeof(*tnorms) * (size_t)numVerts, __func__);
+	data.vnors = vnors = MEM_callocN(sizeof(*vnors) * (size_t)numVerts, __func__);
 
-	if (pnors) {
-		mp = mpolys;
-		for (i = 0; i < numPolys; i++, mp++) {
-			mesh_calc_normals_poly_accum(mp, mloop + mp->loopstart, mverts, pnors[i], tnorms);
-		}
+	if ((numPolys >= BKE_MESH_OMP_LIMIT) && (BLI_task_scheduler_num_threads(BLI_task_scheduler_get()) > 1)) {
+		polys_block_size = numPolys;
 	}
 	else {
-		float tpnor[3];  /* temp poly normal */
-		mp = mpolys;
-		for (i = 0; i < numPolys; i++, mp++) {
-			mesh_calc_normals_poly_accum(mp, mloop + mp->loopstart, mverts, tpnor, tnorms);
-		}
+		polys_block_size = MESH_NORMALS_POLYS_BLOCK_SIZE;
 	}
 
-	for (i = 0; i < numVerts; i++) {
-		MVert *mv = &mverts[i];
-		float *no = tnorms[i];
+	for (poly_start = 0; poly_start < numPolys; poly_start += polys_block_size) {
+		const int poly_end = min_ii(poly_start + polys_block_size, numPolys);
+		int loop_start = INT_MAX, loop_end = 0;
 
-		if (UNLIKELY(normalize_v3(no) == 0.0f)) {
-			/* following Mesh convention; we use vertex coordinate itself for normal in this case */
-			normalize_v3_v3(no, mv->co);
+		/* loops of consecutive polys usually are consecutive too, but it isn't required */
+		for (mp = &mpolys[poly_start], i = poly_start; i < poly_end; i++, mp++) {
+			loop_start = min_ii(loop_start, mp->loopstart);
+			loop_end = max_ii(loop_end, mp->loopstart + mp->totloop);
 		}
+		BLI_assert(loop_end <= numLoops);
 
-		normal_float_to_short_v3(mv->no, no);
+		if (loop_end - loop_start > lnors_weighted_len) {
+			if (data.lnors_weighted) {
+				MEM_freeN(data.lnors_weighted);
+			}
+			lnors_weighted_len = loop_end - loop_start;
+			data.lnors_weighted = MEM_mallocN(sizeof(*data.lnors_weighted) * (size_t)lnors_weighted_len, __func__);
+		}
+		data.lnors_weighted_loopstart = loop_start;
+
+		BLI_task_parallel_range_ex(poly_start, poly_end, &data, mesh_calc_normals_poly_accum_cb,
+		                           BKE_MESH_OMP_LIMIT, false);
+
+		/* accumulate, in the same order as the polys so the result doesn't depend on scheduling */
+		for (mp = &mpolys[poly_start], i = poly_start; i < poly_end; i++, mp++) {
+			const MLoop *ml = mloop + mp->loopstart;
+			const float (*lnor)[3] = (const float (*)[3])(data.lnors_weighted + (mp->loopstart - loop_start));
+			int j;
+
+			for (j = 0; j < mp->totloop; j++) {
+				add_v3_v3(vnors[ml[j].v], lnor[j]);
+			}
+		}
 	}
 
-	MEM_freeN(tnorms);
+	if (data.lnors_weighted) {
+		MEM_freeN(data.lnors_weighted);
+	}
+	UNUSED_VARS_NDEBUG(numLoops);
+
+	BLI_task_parallel_range_ex(0, numVerts, &data, mesh_calc_normals_poly_finalize_cb, BKE_MESH_OMP_LIMIT, false);
+
+	MEM_freeN(vnors);
 }
 
 void BKE_mesh_calc_normals(Mesh *mesh)
@@ -582,20 +654,10 @@ void BKE_lnor_space_custom_normal_to_data(MLoopNorSpace *lnor_space, const float
 #define LOOP_SPLIT_TASK_BLOCK_SIZE 1024
 
 typedef struct LoopSplitTaskData {
-	/* Specific to each instance (each task). */
-	MLoopNorSpace *lnor_space;  /* We have to create those outside of tasks, since afaik memarena is not threadsafe. */
-	float (*lnor)[3];
-	const MLoop *ml_curr;
-	const MLoop *ml_prev;
 	int ml_curr_index;
 	int ml_prev_index;
-	const int *e2l_prev;  /* Also used a flag to switch between single or fan process! */
 	int mp_index;
-
-	/* This one is special, it's owned and managed by worker tasks, avoid to have to create it for each fan! */
-	BLI_Stack *edge_vectors;
-
-	char pad_c;
+	bool is_fan;  /* Used to switch between single or fan process! */
 } LoopSplitTaskData;
 
 typedef struct LoopSplitTaskDataCommon {
@@ -603,7 +665,8 @@ typedef struct LoopSplitTaskDataCommon {
 	 * Note we do not need to protect it, though, since two different tasks will *always* affect different
 	 * elements in the arrays. */
 	MLoopNorSpaceArray *lnors_spacearr;
-	BLI_bitmap *sharp_verts;
+	MLoopNorSpace *lnor_spaces;  /* One per task, we have to create those outside of tasks, since afaik memarena
+	                              * is not threadsafe. */
 	float (*loopnors)[3];
 	short (*clnors_data)[2];
 
@@ -616,19 +679,39 @@ typedef struct LoopSplitTaskDataCommon {
 	const int *loop_to_poly;
 	const float (*polynors)[3];
 
-	int numPolys;
-
-	/* ***** Workers communication. ***** */
-	ThreadQueue *task_queue;
-
+	const LoopSplitTaskData *tasks;
+	int tasks_len;
 } LoopSplitTaskDataCommon;
 
+/**
+ * Everything #BKE_mesh_normals_loop_split_ex needs that does not depend on vertex coordinates,
+ * so a deforming mesh can reuse it from one evaluation to the next.
+ */
+struct MLoopNorSplitCache {
+	/* Topology this cache was computed from, compared on each use. */
+	int numEdges, numLoops, numPolys;
+	MLoop *mloops;
+	MPoly *mpolys;
+	BLI_bitmap *sharp_edges;  /* ME_SHARP edges. */
+
+	/* Edge -> loops mapping before the split angle test, and loop -> poly mapping. */
+	int (*edge_to_loops)[2];
+	int *loop_to_poly;
+
+	/* Tasks, only valid for the same final sharp edges (split_edges), since those also depend on the angle. */
+	LoopSplitTaskData *tasks;
+	int tasks_len;
+	bool tasks_use_spacearr;
+	BLI_bitmap *split_edges;
+};
+
 #define INDEX_UNSET INT_MIN
 #define INDEX_INVALID -1
 /* See comment about edge_to_loops below. */
 #define IS_EDGE_SHARP(_e2l) (ELEM((_e2l)[1], INDEX_UNSET, INDEX_INVALID))
 
-static void split_loop_nor_single_do(LoopSplitTaskDataCommon *common_data, LoopSplitTaskData *data)
+static void split_loop_nor_single_do(
+        LoopSplitTaskDataCommon *common_data, const LoopSplitTaskData *data, MLoopNorSpace *lnor_space)
 {
 	MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
 	short (*clnors_data)[2] = common_data->clnors_data;
@@ -637,16 +720,11 @@ static void split_loop_nor_single_do(LoopSplitTaskDataCommon *common_data, LoopS
 	const MEdge *medges = common_data->medges;
 	const float (*polynors)[3] = common_data->polynors;
 
-	MLoopNorSpace *lnor_space = data->lnor_space;
-	float (*lnor)[3] = data->lnor;
-	const MLoop *ml_curr = data->ml_curr;
-	const MLoop *ml_prev = data->ml_prev;
 	const int ml_curr_index = data->ml_curr_index;
-#if 0  /* Not needed for 'single' loop. */
-	const int ml_prev_index = data->ml_prev_index;
-	const int *e2l_prev = data->e2l_prev;
-#endif
+	const MLoop *ml_curr = &common_data->mloops[ml_curr_index];
+	const MLoop *ml_prev = &common_data->mloops[data->ml_prev_index];
 	const int mp_index = data->mp_index;
+	float (*lnor)[3] = &common_data->loopnors[ml_curr_index];
 
 	/* Simple case (both edges around that vertex are sharp in current polygon),
 	 * this loop just takes its poly normal.
@@ -681,7 +759,9 @@ static void split_loop_nor_single_do(LoopSplitTaskDataCommon *common_data, LoopS
 	}
 }
 
-static void split_loop_nor_fan_do(LoopSplitTaskDataCommon *common_data, LoopSplitTaskData *data)
+static void split_loop_nor_fan_do(
+        LoopSplitTaskDataCommon *common_data, const LoopSplitTaskData *data, MLoopNorSpace *lnor_space,
+        BLI_Stack *edge_vectors)
 {
 	MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
 	float (*loopnors)[3] = common_data->loopnors;
@@ -695,18 +775,12 @@ static void split_loop_nor_fan_do(LoopSplitTaskDataCommon *common_data, LoopSpli
 	const int *loop_to_poly = common_data->loop_to_poly;
 	const float (*polynors)[3] = common_data->polynors;
 
-	MLoopNorSpace *lnor_space = data->lnor_space;
-#if 0  /* Not needed for 'fan' loops. */
-	float (*lnor)[3] = data->lnor;
-#endif
-	const MLoop *ml_curr = data->ml_curr;
-	const MLoop *ml_prev = data->ml_prev;
 	const int ml_curr_index = data->ml_curr_index;
 	const int ml_prev_index = data->ml_prev_index;
 	const int mp_index = data->mp_index;
-	const int *e2l_prev = data->e2l_prev;
-
-	BLI_Stack *edge_vectors = data->edge_vectors;
+	const MLoop *ml_curr = &mloops[ml_curr_index];
+	const MLoop *ml_prev = &mloops[ml_prev_index];
+	const int *e2l_prev = edge_to_loops[ml_prev->e];
 
 	/* Gah... We have to fan around current vertex, until we find the other non-smooth edge,
 	 * and accumulate face normals into the vertex!
@@ -914,105 +988,76 @@ static void split_loop_nor_fan_do(LoopSplitTaskDataCommon *common_data, LoopSpli
 }
 
 static void loop_split_worker_do(
-        LoopSplitTaskDataCommon *common_data, LoopSplitTaskData *data, BLI_Stack *edge_vectors)
+        LoopSplitTaskDataCommon *common_data, const int task_index, BLI_Stack *edge_vectors)
 {
-	BLI_assert(data->ml_curr);
-	if (data->e2l_prev) {
+	const LoopSplitTaskData *data = &common_data->tasks[task_index];
+	MLoopNorSpace *lnor_space = common_data->lnor_spaces ? &common_data->lnor_spaces[task_index] : NULL;
+
+	if (data->is_fan) {
 		BLI_assert((edge_vectors == NULL) || BLI_stack_is_empty(edge_vectors));
-		data->edge_vectors = edge_vectors;
-		split_loop_nor_fan_do(common_data, data);
+		split_loop_nor_fan_do(common_data, data, lnor_space, edge_vectors);
 	}
 	else {
 		/* No need for edge_vectors for 'single' case! */
-		split_loop_nor_single_do(common_data, data);
+		split_loop_nor_single_do(common_data, data, lnor_space);
 	}
 }
 
-static void loop_split_worker(TaskPool *UNUSED(pool), void *taskdata, int UNUSED(threadid))
+static void loop_split_worker(void *userdata, int block)
 {
-	LoopSplitTaskDataCommon *common_data = taskdata;
-	LoopSplitTaskData *data_buff;
+	LoopSplitTaskDataCommon *common_data = userdata;
+	const int task_start = block * LOOP_SPLIT_TASK_BLOCK_SIZE;
+	const int task_end = min_ii(task_start + LOOP_SPLIT_TASK_BLOCK_SIZE, common_data->tasks_len);
+	int i;
 
 	/* Temp edge vectors stack, only used when computing lnor spacearr. */
 	BLI_Stack *edge_vectors = common_data->lnors_spacearr ? BLI_stack_new(sizeof(float[3]), __func__) : NULL;
 
-#ifdef DEBUG_TIME
-	TIMEIT_START(loop_split_worker);
-#endif
-
-	while ((data_buff = BLI_thread_queue_pop(common_data->task_queue))) {
-		LoopSplitTaskData *data = data_buff;
-		int i;
-
-		for (i = 0; i < LOOP_SPLIT_TASK_BLOCK_SIZE; i++, data++) {
-			/* A NULL ml_curr is used to tag ended data! */
-			if (data->ml_curr == NULL) {
-				break;
-			}
-			loop_split_worker_do(common_data, data, edge_vectors);
-		}
-
-		MEM_freeN(data_buff);
+	for (i = task_start; i < task_end; i++) {
+		loop_split_worker_do(common_data, i, edge_vectors);
 	}
 
 	if (edge_vectors) {
 		BLI_stack_free(edge_vectors);
 	}
-
-#ifdef DEBUG_TIME
-	TIMEIT_END(loop_split_worker);
-#endif
 }
 
-/* Note we use data_buff to detect whether we are in threaded context or not, in later case it is NULL. */
-static void loop_split_generator_do(LoopSplitTaskDataCommon *common_data, const bool threaded)
+/**
+ * Find all loops which need their normal computed, i.e. loops between two sharp edges,
+ * and one loop of each smooth fan (only needs to know which edges are sharp, not the geometry).
+ * \a sharp_verts is only given when generating lnor spacearr.
+ */
+static LoopSplitTaskData *loop_split_generator(
+        const MLoop *mloops, const int numLoops, const MPoly *mpolys, const int numPolys,
+        const int (*edge_to_loops)[2], BLI_bitmap *sharp_verts, int *r_tasks_len)
 {
-	MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
-	BLI_bitmap *sharp_verts = common_data->sharp_verts;
-	float (*loopnors)[3] = common_data->loopnors;
-
-	const MLoop *mloops = common_data->mloops;
-	const MPoly *mpolys = common_data->mpolys;
-	const int (*edge_to_loops)[2] = common_data->edge_to_loops;
-	const int numPolys = common_data->numPolys;
+	LoopSplitTaskData *tasks = MEM_mallocN(sizeof(*tasks) * (size_t)numLoops, __func__);
+	int tasks_len = 0;
 
 	const MPoly *mp;
 	int mp_index;
 
-	LoopSplitTaskData *data, *data_buff = NULL, data_mem;
-	int data_idx = 0;
-
-	/* Temp edge vectors stack, only used when computing lnor spacearr (and we are not multi-threading). */
-	BLI_Stack *edge_vectors = (lnors_spacearr && !data_buff) ? BLI_stack_new(sizeof(float[3]), __func__) : NULL;
-
 #ifdef DEBUG_TIME
 	TIMEIT_START(loop_split_generator);
 #endif
 
-	if (!threaded) {
-		memset(&data_mem, 0, sizeof(data_mem));
-		data = &data_mem;
-	}
-
 	/* We now know edges that can be smoothed (with their vector, and their two loops), and edges that will be hard!
 	 * Now, time to generate the normals.
 	 */
 	for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
 		const MLoop *ml_curr, *ml_prev;
-		float (*lnors)[3];
 		const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
 		int ml_curr_index = mp->loopstart;
 		int ml_prev_index = ml_last_index;
 
 		ml_curr = &mloops[ml_curr_index];
 		ml_prev = &mloops[ml_prev_index];
-		lnors = &loopnors[ml_curr_index];
 
-		for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++, lnors++) {
+		for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
 			const int *e2l_curr = edge_to_loops[ml_curr->e];
 			const int *e2l_prev = edge_to_loops[ml_prev->e];
 
-			if (!IS_EDGE_SHARP(e2l_curr) && (!lnors_spacearr || BLI_BITMAP_TEST_BOOL(sharp_verts, ml_curr->v))) {
+			if (!IS_EDGE_SHARP(e2l_curr) && (!sharp_verts || BLI_BITMAP_TEST_BOOL(sharp_verts, ml_curr->v))) {
 				/* A smooth edge, and we are not generating lnor_spacearr, or the related vertex is sharp.
 				 * We skip it because it is either:
 				 * - in the middle of a 'smooth fan' already computed (or that will be as soon as we hit
@@ -1023,27 +1068,11 @@ static void loop_split_generator_do(LoopSplitTaskDataCommon *common_data, const
 				/* printf("Skipping loop %d / edge %d / vert %d(%d)\n", ml_curr_index, ml_curr->e, ml_curr->v, sharp_verts[ml_curr->v]); */
 			}
 			else {
-				if (threaded) {
-					if (data_idx == 0) {
-						data_buff = MEM_callocN(sizeof(*data_buff) * LOOP_SPLIT_TASK_BLOCK_SIZE, __func__);
-					}
-					data = &data_buff[data_idx];
-				}
+				LoopSplitTaskData *data = &tasks[tasks_len++];
 
-				if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
-					data->lnor = lnors;
-					data->ml_curr = ml_curr;
-					data->ml_prev = ml_prev;
-					data->ml_curr_index = ml_curr_index;
-#if 0  /* Not needed for 'single' loop. */
-					data->ml_prev_index = ml_prev_index;
-					data->e2l_prev = NULL;  /* Tag as 'single' task. */
-#endif
-					data->mp_index = mp_index;
-					if (lnors_spacearr) {
-						data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-					}
-				}
+				data->ml_curr_index = ml_curr_index;
+				data->ml_prev_index = ml_prev_index;
+				data->mp_index = mp_index;
 				/* We *do not need* to check/tag loops as already computed!
 				 * Due to the fact a loop only links to one of its two edges, a same fan *will never be walked
 				 * more than once!*
@@ -1052,34 +1081,10 @@ static void loop_split_generator_do(LoopSplitTaskDataCommon *common_data, const
 				 * and not the alternative (smooth curr_edge, sharp prev_edge).
 				 * All this due/thanks to link between normals and loop ordering (i.e. winding).
 				 */
-				else {
-#if 0  /* Not needed for 'fan' loops. */
-					data->lnor = lnors;
-#endif
-					data->ml_curr = ml_curr;
-					data->ml_prev = ml_prev;
-					data->ml_curr_index = ml_curr_index;
-					data->ml_prev_index = ml_prev_index;
-					data->e2l_prev = e2l_prev;  /* Also tag as 'fan' task. */
-					data->mp_index = mp_index;
-					if (lnors_spacearr) {
-						data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-						/* Tag related vertex as sharp, to avoid fanning around it again (in case it was a smooth one).
-						 * This *has* to be done outside of workers tasks! */
-						BLI_BITMAP_ENABLE(sharp_verts, ml_curr->v);
-					}
-				}
-
-				if (threaded) {
-					data_idx++;
-					if (data_idx == LOOP_SPLIT_TASK_BLOCK_SIZE) {
-						BLI_thread_queue_push(common_data->task_queue, data_buff);
-						data_idx = 0;
-					}
-				}
-				else {
-					loop_split_worker_do(common_data, data, edge_vectors);
-					memset(data, 0, sizeof(data_mem));
+				data->is_fan = !(IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev));
+				if (data->is_fan && sharp_verts) {
+					/* Tag related vertex as sharp, to avoid fanning around it again (in case it was a smooth one). */
+					BLI_BITMAP_ENABLE(sharp_verts, ml_curr->v);
 				}
 			}
 
@@ -1088,30 +1093,114 @@ static void loop_split_generator_do(LoopSplitTaskDataCommon *common_data, const
 		}
 	}
 
-	if (threaded) {
-		/* Last block of data... Since it is calloc'ed and we use first NULL item as stopper, everything is fine. */
-		if (LIKELY(data_idx)) {
-			BLI_thread_queue_push(common_data->task_queue, data_buff);
+	if (tasks_len != numLoops) {
+		if (tasks_len) {
+			tasks = MEM_reallocN(tasks, sizeof(*tasks) * (size_t)tasks_len);
+		}
+		else {
+			MEM_freeN(tasks);
+			tasks = NULL;
 		}
-
-		/* This will signal all other worker threads to wake up and finish! */
-		BLI_thread_queue_nowait(common_data->task_queue);
-	}
-
-	if (edge_vectors) {
-		BLI_stack_free(edge_vectors);
 	}
 
 #ifdef DEBUG_TIME
 	TIMEIT_END(loop_split_generator);
 #endif
+
+	*r_tasks_len = tasks_len;
+	return tasks;
+}
+
+MLoopNorSplitCache *BKE_lnor_split_cache_new(void)
+{
+	return MEM_callocN(sizeof(MLoopNorSplitCache), __func__);
+}
+
+static void loop_split_cache_tasks_clear(MLoopNorSplitCache *cache)
+{
+	MEM_SAFE_FREE(cache->tasks);
+	MEM_SAFE_FREE(cache->split_edges);
+	cache->tasks_len = 0;
+}
+
+static void loop_split_cache_clear(MLoopNorSplitCache *cache)
+{
+	loop_split_cache_tasks_clear(cache);
+	MEM_SAFE_FREE(cache->mloops);
+	MEM_SAFE_FREE(cache->mpolys);
+	MEM_SAFE_FREE(cache->sharp_edges);
+	MEM_SAFE_FREE(cache->edge_to_loops);
+	MEM_SAFE_FREE(cache->loop_to_poly);
+	cache->numEdges = cache->numLoops = cache->numPolys = 0;
+}
+
+void BKE_lnor_split_cache_free(MLoopNorSplitCache *cache)
+{
+	loop_split_cache_clear(cache);
+	MEM_freeN(cache);
+}
+
+static bool loop_split_cache_is_valid(
+        const MLoopNorSplitCache *cache, const MEdge *medges, const int numEdges,
+        const MLoop *mloops, const int numLoops, const MPoly *mpolys, const int numPolys)
+{
+	int i;
+
+	if (cache->edge_to_loops == NULL ||
+	    cache->numEdges != numEdges || cache->numLoops != numLoops || cache->numPolys != numPolys)
+	{
+		return false;
+	}
+
+	if (memcmp(cache->mloops, mloops, sizeof(*mloops) * (size_t)numLoops) != 0) {
+		return false;
+	}
+	for (i = 0; i < numPolys; i++) {
+		const MPoly *mp = &mpolys[i];
+		const MPoly *mp_cache = &cache->mpolys[i];
+		if (mp->loopstart != mp_cache->loopstart || mp->totloop != mp_cache->totloop ||
+		    (mp->flag & ME_SMOOTH) != (mp_cache->flag & ME_SMOOTH))
+		{
+			return false;
+		}
+	}
+	for (i = 0; i < numEdges; i++) {
+		if (((medges[i].flag & ME_SHARP) != 0) != BLI_BITMAP_TEST_BOOL(cache->sharp_edges, i)) {
+			return false;
+		}
+	}
+
+	return true;
 }
 
-static void loop_split_generator(TaskPool *UNUSED(pool), void *taskdata, int UNUSED(threadid))
+static void loop_split_cache_update(
+        MLoopNorSplitCache *cache, const MEdge *medges, const int numEdges,
+        const MLoop *mloops, const int numLoops, const MPoly *mpolys, const int numPolys,
+        const int (*edge_to_loops)[2], const int *loop_to_poly)
 {
-	LoopSplitTaskDataCommon *common_data = taskdata;
+	int i;
+
+	loop_split_cache_clear(cache);
 
-	loop_split_generator_do(common_data, true);
+	cache->numEdges = numEdges;
+	cache->numLoops = numLoops;
+	cache->numPolys = numPolys;
+
+	cache->mloops = MEM_mallocN(sizeof(*cache->mloops) * (size_t)numLoops, __func__);
+	memcpy(cache->mloops, mloops, sizeof(*cache->mloops) * (size_t)numLoops);
+	cache->mpolys = MEM_mallocN(sizeof(*cache->mpolys) * (size_t)numPolys, __func__);
+	memcpy(cache->mpolys, mpolys, sizeof(*cache->mpolys) * (size_t)numPolys);
+	cache->sharp_edges = BLI_BITMAP_NEW((size_t)numEdges, __func__);
+	for (i = 0; i < numEdges; i++) {
+		if (medges[i].flag & ME_SHARP) {
+			BLI_BITMAP_ENABLE(cache->sharp_edges, i);
+		}
+	}
+
+	cache->edge_to_loops = MEM_mallocN(sizeof(*cache->edge_to_loops) * (size_t)numEdges, __func__);
+	memcpy(cache->edge_to_loops, edge_to_loops, sizeof(*cache->edge_to_loops) * (size_t)numEdges);
+	cache->loop_to_poly = MEM_mallocN(sizeof(*cache->loop_to_poly) * (size_t)numLoops, __func__);
+	memcpy(cache->loop_to_poly, loop_to_poly, sizeof(*cache->loop_to_poly) * (size_t)numLoops);
 }
 
 /**
@@ -1125,6 +1214,23 @@ void BKE_mesh_normals_loop_split(
         const bool use_split_normals, float split_angle,
         MLoopNorSpaceArray *r_lnors_spacearr, short (*clnors_data)[2], int *r_loop_to_poly)
 {
+	BKE_mesh_normals_loop_split_ex(
+	        mverts, numVerts, medges, numEdges, mloops, r_loopnors, numLoops, mpolys, polynors, numPolys,
+	        use_split_normals, split_angle, r_lnors_spacearr, clnors_data, r_loop_to_poly, NULL);
+}
+
+/**
+ * \param cache: Optional, keeps the edges classification and the list of fans between calls,
+ * as long as the topology and the sharp edges of the mesh do not change (e.g. when it's only deformed).
+ */
+void BKE_mesh_normals_loop_split_ex(
+        const MVert *mverts, const int numVerts, MEdge *medges, const int numEdges,
+        MLoop *mloops, float (*r_loopnors)[3], const int numLoops,
+        MPoly *mpolys, const float (*polynors)[3], const int numPolys,
+        const bool use_split_normals, float split_angle,
+        MLoopNorSpaceArray *r_lnors_spacearr, short (*clnors_data)[2], int *r_loop_to_poly,
+        MLoopNorSplitCache *cache)
+{
 
 	/* For now this is not supported. If we do not use split normals, we do not generate anything fancy! */
 	BLI_assert(use_split_normals || !(r_lnors_spacearr));
@@ -1169,17 +1275,20 @@ void BKE_mesh_normals_loop_split(
 	 * store the negated value of loop index instead of INDEX_INVALID to retrieve the real value later in code).
 	 * Note also that lose edges always have both values set to 0!
 	 */
-	int (*edge_to_loops)[2] = MEM_callocN(sizeof(int[2]) * (size_t)numEdges, __func__);
+	int (*edge_to_loops)[2];
 
 	/* Simple mapping from a loop to its polygon index. */
-	int *loop_to_poly = r_loop_to_poly ? r_loop_to_poly : MEM_mallocN(sizeof(int) * (size_t)numLoops, __func__);
+	int *loop_to_poly;
+	bool free_loop_to_poly;
 
-	MPoly *mp;
-	int mp_index, me_index;
+	LoopSplitTaskData *tasks = NULL;
+	int tasks_len = 0;
+	BLI_bitmap *split_edges = NULL;
+	bool use_cache_tasks = false;
+
+	int me_index;
 	bool check_angle = (split_angle < (float)M_PI);
-	int i;
 
-	BLI_bitmap *sharp_verts = NULL;
 	MLoopNorSpaceArray _lnors_spacearr = {NULL};
 
 	LoopSplitTaskDataCommon common_data = {NULL};
@@ -1204,73 +1313,157 @@ void BKE_mesh_normals_loop_split(
 	}
 	if (r_lnors_spacearr) {
 		BKE_lnor_spacearr_init(r_lnors_spacearr, numLoops);
-		sharp_verts = BLI_BITMAP_NEW((size_t)numVerts, __func__);
 	}
 
-	/* This first loop check which edges are actually smooth, and compute edge vectors. */
-	for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-		MLoop *ml_curr;
-		int *e2l;
-		int ml_curr_index = mp->loopstart;
-		const int ml_last_index = (ml_curr_index + mp->totloop) - 1;
+	if (cache && loop_split_cache_is_valid(cache, medges, numEdges, mloops, numLoops, mpolys, numPolys)) {
+		int ml_index;
 
-		ml_curr = &mloops[ml_curr_index];
+		edge_to_loops = MEM_mallocN(sizeof(*edge_to_loops) * (size_t)numEdges, __func__);
+		memcpy(edge_to_loops, cache->edge_to_loops, sizeof(*edge_to_loops) * (size_t)numEdges);
 
-		for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
-			e2l = edge_to_loops[ml_curr->e];
+		if (r_loop_to_poly) {
+			memcpy(r_loop_to_poly, cache->loop_to_poly, sizeof(*r_loop_to_poly) * (size_t)numLoops);
+			loop_to_poly = r_loop_to_poly;
+		}
+		else {
+			loop_to_poly = cache->loop_to_poly;
+		}
+		free_loop_to_poly = false;
 
-			loop_to_poly[ml_curr_index] = mp_index;
+		/* Pre-populate all loop normals as if their verts were all-smooth. */
+		for (ml_index = 0; ml_index < numLoops; ml_index++) {
+			normal_short_to_float_v3(r_loopnors[ml_index], mverts[mloops[ml_index].v].no);
+		}
+	}
+	else {
+		MPoly *mp;
+		int mp_index;
 
-			/* Pre-populate all loop normals as if their verts were all-smooth, this way we don't have to compute
-			 * those later!
-			 */
-			normal_short_to_float_v3(r_loopnors[ml_curr_index], mverts[ml_curr->v].no);
-
-			/* Check whether current edge might be smooth or sharp */
-			if ((e2l[0] | e2l[1]) == 0) {
-				/* 'Empty' edge until now, set e2l[0] (and e2l[1] to INDEX_UNSET to tag it as unset). */
-				e2l[0] = ml_curr_index;
-				/* We have to check this here too, else we might miss some flat faces!!! */
-				e2l[1] = (mp->flag & ME_SMOOTH) ? INDEX_UNSET : INDEX_INVALID;
-			}
-			else if (e2l[1] == INDEX_UNSET) {
-				/* Second loop using this edge, time to test its sharpness.
-				 * An edge is sharp if it is tagged as such, or its face is not smooth,
-				 * or both poly have opposed (flipped) normals, i.e. both loops on the same edge share the same vertex,
-				 * or angle between both its polys' normals is above split_angle value.
+		edge_to_loops = MEM_callocN(sizeof(*edge_to_loops) * (size_t)numEdges, __func__);
+		loop_to_poly = r_loop_to_poly ? r_loop_to_poly : MEM_mallocN(sizeof(int) * (size_t)numLoops, __func__);
+		free_loop_to_poly = (r_loop_to_poly == NULL);
+
+		/* This first loop check which edges are actually smooth, as far as topology and tags are concerned. */
+		for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
+			MLoop *ml_curr;
+			int *e2l;
+			int ml_curr_index = mp->loopstart;
+			const int ml_last_index = (ml_curr_index + mp->totloop) - 1;
+
+			ml_curr = &mloops[ml_curr_index];
+
+			for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
+				e2l = edge_to_loops[ml_curr->e];
+
+				loop_to_poly[ml_curr_index] = mp_index;
+
+				/* Pre-populate all loop normals as if their verts were all-smooth, this way we don't have to compute
+				 * those later!
 				 */
-				if (!(mp->flag & ME_SMOOTH) || (medges[ml_curr->e].flag & ME_SHARP) ||
-				    ml_curr->v == mloops[e2l[0]].v ||
-				    (check_angle && dot_v3v3(polynors[loop_to_poly[e2l[0]]], polynors[mp_index]) < split_angle))
-				{
-					/* Note: we are sure that loop != 0 here ;) */
-					e2l[1] = INDEX_INVALID;
+				normal_short_to_float_v3(r_loopnors[ml_curr_index], mverts[ml_curr->v].no);
+
+				/* Check whether current edge might be smooth or sharp */
+				if ((e2l[0] | e2l[1]) == 0) {
+					/* 'Empty' edge until now, set e2l[0] (and e2l[1] to INDEX_UNSET to tag it as unset). */
+					e2l[0] = ml_curr_index;
+					/* We have to check this here too, else we might miss some flat faces!!! */
+					e2l[1] = (mp->flag & ME_SMOOTH) ? INDEX_UNSET : INDEX_INVALID;
 				}
-				else {
-					e2l[1] = ml_curr_index;
+				else if (e2l[1] == INDEX_UNSET) {
+					/* Second loop using this edge, time to test its sharpness.
+					 * An edge is sharp if it is tagged as such, or its face is not smooth,
+					 * or both poly have opposed (flipped) normals, i.e. both loops on the same edge share the same
+					 * vertex, or angle between both its polys' normals is above split_angle value (checked below).
+					 */
+					if (!(mp->flag & ME_SMOOTH) || (medges[ml_curr->e].flag & ME_SHARP) ||
+					    ml_curr->v == mloops[e2l[0]].v)
+					{
+						/* Note: we are sure that loop != 0 here ;) */
+						e2l[1] = INDEX_INVALID;
+					}
+					else {
+						e2l[1] = ml_curr_index;
+					}
 				}
+				else if (!IS_EDGE_SHARP(e2l)) {
+					/* More than two loops using this edge, tag as sharp if not yet done. */
+					e2l[1] = INDEX_INVALID;
+				}
+				/* Else, edge is already 'disqualified' (i.e. sharp)! */
 			}
-			else if (!IS_EDGE_SHARP(e2l)) {
-				/* More than two loops using this edge, tag as sharp if not yet done. */
+		}
+
+		if (cache) {
+			loop_split_cache_update(cache, medges, numEdges, mloops, numLoops, mpolys, numPolys,
+			                        (const int(*)[2])edge_to_loops, loop_to_poly);
+		}
+	}
+
+	if (check_angle) {
+		/* Smooth edges (only those have their second loop set) are also sharp when the angle between
+		 * their two polys' normals is above split_angle value. */
+		for (me_index = 0; me_index < numEdges; me_index++) {
+			int *e2l = edge_to_loops[me_index];
+			if (e2l[1] > 0 && dot_v3v3(polynors[loop_to_poly[e2l[0]]], polynors[loop_to_poly[e2l[1]]]) < split_angle) {
 				e2l[1] = INDEX_INVALID;
 			}
-			/* Else, edge is already 'disqualified' (i.e. sharp)! */
 		}
 	}
 
-	if (r_lnors_spacearr) {
-		/* Tag vertices that have at least one sharp edge as 'sharp' (used for the lnor spacearr computation).
-		 * XXX This third loop over edges is a bit disappointing, could not find any other way yet.
-		 *     Not really performance-critical anyway.
-		 */
+	if (cache) {
+		/* Tasks of previous call can be reused if the same edges ended up sharp. */
+		split_edges = BLI_BITMAP_NEW((size_t)numEdges, __func__);
 		for (me_index = 0; me_index < numEdges; me_index++) {
-			const int *e2l = edge_to_loops[me_index];
-			const MEdge *me = &medges[me_index];
-			if (IS_EDGE_SHARP(e2l)) {
-				BLI_BITMAP_ENABLE(sharp_verts, me->v1);
-				BLI_BITMAP_ENABLE(sharp_verts, me->v2);
+			if (IS_EDGE_SHARP(edge_to_loops[me_index])) {
+				BLI_BITMAP_ENABLE(split_edges, me_index);
+			}
+		}
+
+		if (cache->split_edges && cache->tasks_use_spacearr == (r_lnors_spacearr != NULL) &&
+		    memcmp(cache->split_edges, split_edges, BLI_BITMAP_SIZE(numEdges)) == 0)
+		{
+			tasks = cache->tasks;
+			tasks_len = cache->tasks_len;
+			use_cache_tasks = true;
+			MEM_freeN(split_edges);
+		}
+		else {
+			loop_split_cache_tasks_clear(cache);
+		}
+	}
+
+	if (!use_cache_tasks) {
+		BLI_bitmap *sharp_verts = NULL;
+
+		if (r_lnors_spacearr) {
+			/* Tag vertices that have at least one sharp edge as 'sharp' (used for the lnor spacearr computation).
+			 * XXX This third loop over edges is a bit disappointing, could not find any other way yet.
+			 *     Not really performance-critical anyway.
+			 */
+			sharp_verts = BLI_BITMAP_NEW((size_t)numVerts, __func__);
+			for (me_index = 0; me_index < numEdges; me_index++) {
+				const int *e2l = edge_to_loops[me_index];
+				const MEdge *me = &medges[me_index];
+				if (IS_EDGE_SHARP(e2l)) {
+					BLI_BITMAP_ENABLE(sharp_verts, me->v1);
+					BLI_BITMAP_ENABLE(sharp_verts, me->v2);
+				}
 			}
 		}
+
+		tasks = loop_split_generator(mloops, numLoops, mpolys, numPolys, (const int(*)[2])edge_to_loops,
+		                             sharp_verts, &tasks_len);
+
+		if (sharp_verts) {
+			MEM_freeN(sharp_verts);
+		}
+
+		if (cache) {
+			cache->tasks = tasks;
+			cache->tasks_len = tasks_len;
+			cache->tasks_use_spacearr = (r_lnors_spacearr != NULL);
+			cache->split_edges = split_edges;
+		}
 	}
 
 	/* Init data common to all tasks. */
@@ -1282,48 +1475,36 @@ void BKE_mesh_normals_loop_split(
 	common_data.medges = medges;
 	common_data.mloops = mloops;
 	common_data.mpolys = mpolys;
-	common_data.sharp_verts = sharp_verts;
 	common_data.edge_to_loops = (const int(*)[2])edge_to_loops;
 	common_data.loop_to_poly = loop_to_poly;
 	common_data.polynors = polynors;
-	common_data.numPolys = numPolys;
 
-	if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
-		/* Not enough loops to be worth the whole threading overhead... */
-		loop_split_generator_do(&common_data, false);
-	}
-	else {
-		TaskScheduler *task_scheduler;
-		TaskPool *task_pool;
-		int nbr_workers;
+	common_data.tasks = tasks;
+	common_data.tasks_len = tasks_len;
 
-		common_data.task_queue = BLI_thread_queue_init();
-
-		task_scheduler = BLI_task_scheduler_get();
-		task_pool = BLI_task_pool_create(task_scheduler, NULL);
-
-		nbr_workers = max_ii(2, BLI_task_scheduler_num_threads(task_scheduler));
-		for (i = 1; i < nbr_workers; i++) {
-			BLI_task_pool_push(task_pool, loop_split_worker, &common_data, false, TASK_PRIORITY_HIGH);
+	if (tasks_len) {
+		if (r_lnors_spacearr) {
+			common_data.lnor_spaces = BLI_memarena_calloc(r_lnors_spacearr->mem,
+			                                              sizeof(MLoopNorSpace) * (size_t)tasks_len);
 		}
-		BLI_task_pool_push(task_pool, loop_split_generator, &common_data, false, TASK_PRIORITY_HIGH);
-		BLI_task_pool_work_and_wait(task_pool);
-
-		BLI_task_pool_free(task_pool);
 
-		BLI_thread_queue_free(common_data.task_queue);
+		/* Not enough loops to be worth the whole threading overhead otherwise... */
+		BLI_task_parallel_range_ex(
+		        0, (tasks_len + LOOP_SPLIT_TASK_BLOCK_SIZE - 1) / LOOP_SPLIT_TASK_BLOCK_SIZE,
+		        &common_data, loop_split_worker,
+		        (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) ? INT_MAX : 2, true);
 	}
 
 	MEM_freeN(edge_to_loops);
-	if (!r_loop_to_poly) {
+	if (free_loop_to_poly) {
 		MEM_freeN(loop_to_poly);
 	}
+	if (cache == NULL && tasks) {
+		MEM_freeN(tasks);
+	}
 
-	if (r_lnors_spacearr) {
-		MEM_freeN(sharp_verts);
-		if (r_lnors_spacearr == &_lnors_spacearr) {
-			BKE_lnor_spacearr_free(r_lnors_spacearr);
-		}
+	if (r_lnors_spacearr == &_lnors_spacearr) {
+		BKE_lnor_spacearr_free(r_lnors_spacearr);
 	}
 
 #ifdef DEBUG_TIME
@@ -28,6 +28,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <limits.h>
 
@@ -41,6 +42,7 @@
 #include "BLI_edgehash.h"
 #include "BLI_math_base.h"
 #include "BLI_math_vector.h"
+#include "BLI_sort.h"
 
 #include "BKE_deform.h"
 #include "BKE_depsgraph.h"
@@ -119,7 +121,7 @@ static int int64_cmp(const void *v1, const void *v2)
 	return 0;
 }
 
-static int search_face_cmp(const void *v1, const void *v2)
+static int search_face_cmp(const void *v1, const void *v2, void *UNUSED(thunk))
 {
 	const SortFace *sfa = v1, *sfb = v2;
 
@@ -160,7 +162,7 @@ static int int_cmp(const void *v1, const void *v2)
 	return *(int *)v1 > *(int *)v2 ? 1 : *(int *)v1 < *(int *)v2 ? -1 : 0;
 }
 
-static int search_poly_cmp(const void *v1, const void *v2)
+static int search_poly_cmp(const void *v1, const void *v2, void *UNUSED(thunk))
 {
 	const SortPoly *sp1 = v1, *sp2 = v2;
 	const int max_idx = sp1->numverts > sp2->numverts ? sp2->numverts : sp1->numverts;
@@ -180,7 +182,7 @@ static int search_poly_cmp(const void *v1, const void *v2)
 	return sp1->numverts > sp2->numverts ? 1 : sp1->numverts < sp2->numverts ? -1 : 0;
 }
 
-static int search_polyloop_cmp(const void *v1, const void *v2)
+static int search_polyloop_cmp(const void *v1, const void *v2, void *UNUSED(thunk))
 {
 	const SortPoly *sp1 = v1, *sp2 = v2;
 
@@ -432,7 +434,7 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 			}
 		}
 
-		qsort(sort_faces, totsortface, sizeof(SortFace), search_face_cmp);
+		BLI_mergesort_parallel_r(sort_faces, totsortface, sizeof(SortFace), search_face_cmp, NULL);
 
 		sf = sort_faces;
 		sf_prev = sf;
@@ -623,7 +625,7 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 		}
 
 		/* Second check pass, testing polys using the same verts. */
-		qsort(sort_polys, totpoly, sizeof(SortPoly), search_poly_cmp);
+		BLI_mergesort_parallel_r(sort_polys, totpoly, sizeof(SortPoly), search_poly_cmp, NULL);
 		sp = prev_sp = sort_polys;
 		sp++;
 
@@ -710,7 +712,7 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 		}
 
 		/* Third check pass, testing loops used by none or more than one poly. */
-		qsort(sort_polys, totpoly, sizeof(SortPoly), search_polyloop_cmp);
+		BLI_mergesort_parallel_r(sort_polys, totpoly, sizeof(SortPoly), search_polyloop_cmp, NULL);
 		sp = sort_polys;
 		prev_sp = NULL;
 		prev_end = 0;
@@ -1301,19 +1303,6 @@ static void to_edgesort(struct EdgeSort *ed,
 	ed->is_draw = is_draw;
 }
 
-static int vergedgesort(const void *v1, const void *v2)
-{
-	const struct EdgeSort *x1 = v1, *x2 = v2;
-
-	if (x1->v1 > x2->v1) return 1;
-	else if (x1->v1 < x2->v1) return -1;
-	else if (x1->v2 > x2->v2) return 1;
-	else if (x1->v2 < x2->v2) return -1;
-
-	return 0;
-}
-
-
 /* Create edges based on known verts and faces,
  * this function is only used when loading very old blend files */
 
@@ -1362,7 +1351,9 @@ static void mesh_calc_edges_mdata(
 		}
 	}
 
-	qsort(edsort, totedge, sizeof(struct EdgeSort), vergedgesort);
+	/* by v1 then v2, the sort is stable */
+	BLI_radix_sort_u32(edsort, totedge, sizeof(struct EdgeSort), offsetof(struct EdgeSort, v2));
+	BLI_radix_sort_u32(edsort, totedge, sizeof(struct EdgeSort), offsetof(struct EdgeSort, v1));
 
 	/* count final amount */
 	for (a = totedge, ed = edsort; a > 1; a--, ed++) {
@@ -36,6 +36,7 @@
  *  \ingroup bke
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
@@ -46,20 +47,27 @@
 #include "MEM_guardedalloc.h"
 
 #include "DNA_armature_types.h"
+#include "DNA_meshdata_types.h"
 #include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
 
 #include "BLI_utildefines.h"
 #include "BLI_path_util.h"
 #include "BLI_listbase.h"
 #include "BLI_linklist.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 
 #include "BLT_translation.h"
 
 #include "BKE_appdir.h"
+#include "BKE_cdderivedmesh.h"
+#include "BKE_depsgraph.h"
 #include "BKE_key.h"
 #include "BKE_multires.h"
 #include "BKE_DerivedMesh.h"
+#include "BKE_scene.h"
 
 /* may move these, only for modifier_path_relbase */
 #include "BKE_global.h" /* ugh, G.main->name only */
@@ -68,6 +76,10 @@
 
 #include "MOD_modifiertypes.h"
 
+#include "atomic_ops.h"
+
+#include "PIL_time.h"
+
 static ModifierTypeInfo *modifier_types[NUM_MODIFIER_TYPES] = {NULL};
 static VirtualModifierData virtualModifierCommonData;
 
@@ -139,6 +151,7 @@ void modifier_free(ModifierData *md)
 
 	if (mti->freeData) mti->freeData(md);
 	if (md->error) MEM_freeN(md->error);
+	modifier_freeCheckpoint(md);
 
 	MEM_freeN(md);
 }
@@ -676,6 +689,217 @@ void modifier_freeTemporaryData(ModifierData *md)
 	}
 }
 
+/* memory used by all checkpoints, limited by U.modifier_cache_limit */
+static size_t checkpoints_memory = 0;
+
+static size_t checkpoint_customdata_memory(const CustomData *data, int totelem)
+{
+	size_t mem = 0;
+	int i;
+
+	for (i = 0; i < data->totlayer; i++) {
+		mem += (size_t)CustomData_sizeof(data->layers[i].type) * (size_t)totelem;
+	}
+
+	return mem;
+}
+
+/* Keep a copy of dm as the result of the stack up to md, replacing the previous one.
+ * The caller sets the key once it's known. Returns false when the copy doesn't
+ * fit in the memory limit. */
+bool modifier_setCheckpoint(ModifierData *md, DerivedMesh *dm)
+{
+	const size_t limit = (size_t)U.modifier_cache_limit * 1024 * 1024;
+	ModifierCheckpoint *checkpoint;
+	size_t mem;
+
+	modifier_freeCheckpoint(md);
+
+	mem = (size_t)dm->getNumVerts(dm) * sizeof(MVert) +
+	      (size_t)dm->getNumEdges(dm) * sizeof(MEdge) +
+	      (size_t)dm->getNumLoops(dm) * sizeof(MLoop) +
+	      (size_t)dm->getNumPolys(dm) * sizeof(MPoly) +
+	      checkpoint_customdata_memory(&dm->vertData, dm->numVertData) +
+	      checkpoint_customdata_memory(&dm->edgeData, dm->numEdgeData) +
+	      checkpoint_customdata_memory(&dm->loopData, dm->numLoopData) +
+	      checkpoint_customdata_memory(&dm->polyData, dm->numPolyData);
+
+	/* objects are evaluated in threads */
+	if (atomic_add_z(&checkpoints_memory, mem) > limit) {
+		atomic_sub_z(&checkpoints_memory, mem);
+		return false;
+	}
+
+	checkpoint = MEM_callocN(sizeof(*checkpoint), "ModifierCheckpoint");
+	checkpoint->dm = CDDM_copy(dm);
+	checkpoint->mem = mem;
+	md->checkpoint = checkpoint;
+
+	return true;
+}
+
+void modifier_freeCheckpoint(ModifierData *md)
+{
+	ModifierCheckpoint *checkpoint = md->checkpoint;
+
+	if (checkpoint) {
+		checkpoint->dm->release(checkpoint->dm);
+		atomic_sub_z(&checkpoints_memory, checkpoint->mem);
+		MEM_freeN(checkpoint);
+		md->checkpoint = NULL;
+	}
+}
+
+void modifiers_freeCheckpoints(Main *bmain)
+{
+	Object *ob;
+	ModifierData *md;
+
+	for (ob = bmain->object.first; ob; ob = ob->id.next) {
+		for (md = ob->modifiers.first; md; md = md->next) {
+			modifier_freeCheckpoint(md);
+		}
+	}
+}
+
+size_t modifiers_getCheckpointsMemory(void)
+{
+	return checkpoints_memory;
+}
+
+/* Reset the statistics of the last evaluation, for modifiers that are not evaluated. */
+void modifier_clearEvalStats(ModifierData *md)
+{
+	md->eval_time = 0.0f;
+	md->eval_memory = 0;
+	md->eval_totvert = md->eval_totedge = md->eval_totpoly = 0;
+}
+
+/* set while modifiers_profile() runs */
+static bool modifiers_profiling = false;
+
+/* Peak memory of modifiers is only measured while profiling: it resets
+ * the global peak, which render statistics use too. */
+bool modifiers_isProfiling(void)
+{
+	return modifiers_profiling;
+}
+
+typedef struct ModifierProfile {
+	Object *ob;
+	ModifierData *md;
+	double time_total, time_max;
+	int memory_max;
+	int totvert, totedge, totpoly;
+	int evaluations;
+} ModifierProfile;
+
+/**
+ * Evaluate the scene for \a frames frames, starting at the scene start frame,
+ * and print the time, peak memory and result size of each modifier.
+ *
+ * Every object with modifiers is re-evaluated on every frame, and stack
+ * checkpoints are freed first, so the numbers are for full evaluations.
+ * The peak memory counter is global, so objects are evaluated one at a time
+ * (as with --debug-depsgraph-no-threads), modifiers may still use threads.
+ */
+void modifiers_profile(Main *bmain, Scene *scene, int frames)
+{
+	ModifierProfile *profiles, *prof;
+	Object *ob;
+	ModifierData *md;
+	const int cfra_orig = scene->r.cfra;
+	const int frame_len = MAX2(scene->r.efra - scene->r.sfra + 1, 1);
+	const int debug_orig = G.debug;
+	double time_frames = 0.0, time_modifiers = 0.0;
+	int i, f, totprofile = 0;
+
+	for (ob = bmain->object.first; ob; ob = ob->id.next) {
+		totprofile += BLI_listbase_count(&ob->modifiers);
+	}
+
+	prof = profiles = MEM_callocN(sizeof(*profiles) * (size_t)MAX2(totprofile, 1), __func__);
+	for (ob = bmain->object.first; ob; ob = ob->id.next) {
+		for (md = ob->modifiers.first; md; md = md->next, prof++) {
+			prof->ob = ob;
+			prof->md = md;
+		}
+	}
+
+	modifiers_profiling = true;
+	G.debug |= G_DEBUG_DEPSGRAPH_NO_THREADS;
+
+	for (f = 0; f < frames; f++) {
+		double time_start;
+
+		for (ob = bmain->object.first; ob; ob = ob->id.next) {
+			if (ob->modifiers.first) {
+				DAG_id_tag_update(&ob->id, OB_RECALC_DATA);
+			}
+		}
+		modifiers_freeCheckpoints(bmain);
+
+		for (i = 0; i < totprofile; i++) {
+			modifier_clearEvalStats(profiles[i].md);
+		}
+
+		scene->r.cfra = scene->r.sfra + f % frame_len;
+
+		time_start = PIL_check_seconds_timer();
+		BKE_scene_update_for_newframe(bmain->eval_ctx, bmain, scene, scene->lay);
+		time_frames += PIL_check_seconds_timer() - time_start;
+
+		for (i = 0, prof = profiles; i < totprofile; i++, prof++) {
+			md = prof->md;
+
+			if (md->eval_time > 0.0f) {
+				prof->time_total += md->eval_time;
+				prof->time_max = MAX2(prof->time_max, (double)md->eval_time);
+				prof->memory_max = MAX2(prof->memory_max, md->eval_memory);
+				prof->totvert = md->eval_totvert;
+				prof->totedge = md->eval_totedge;
+				prof->totpoly = md->eval_totpoly;
+				prof->evaluations++;
+			}
+		}
+	}
+
+	modifiers_profiling = false;
+	if ((debug_orig & G_DEBUG_DEPSGRAPH_NO_THREADS) == 0) {
+		G.debug &= ~G_DEBUG_DEPSGRAPH_NO_THREADS;
+	}
+
+	for (i = 0; i < totprofile; i++) {
+		time_modifiers += profiles[i].time_total;
+	}
+
+	printf("\nModifier profile: %d frame(s), objects evaluated one at a time\n", frames);
+	printf("  %.3f ms per frame, %.3f ms in modifiers\n\n",
+	       (time_frames * 1000.0) / frames, time_modifiers / frames);
+	printf("  %-24s %-24s %-16s %10s %10s %6s %10s %10s %10s %10s\n",
+	       "Object", "Modifier", "Type", "Avg ms", "Max ms", "%", "Peak MB", "Verts", "Edges", "Faces");
+
+	for (i = 0, prof = profiles; i < totprofile; i++, prof++) {
+		const ModifierTypeInfo *mti = modifierType_getInfo(prof->md->type);
+
+		if (prof->evaluations == 0) {
+			continue;
+		}
+
+		printf("  %-24s %-24s %-16s %10.3f %10.3f %6.1f %10.2f %10d %10d %10d\n",
+		       prof->ob->id.name + 2, prof->md->name, mti ? mti->name : "",
+		       prof->time_total / prof->evaluations, prof->time_max,
+		       time_modifiers > 0.0 ? (prof->time_total * 100.0) / time_modifiers : 0.0,
+		       prof->memory_max / 1024.0, prof->totvert, prof->totedge, prof->totpoly);
+	}
+	printf("\n");
+
+	MEM_freeN(profiles);
+
+	scene->r.cfra = cfra_orig;
+	BKE_scene_update_for_newframe(bmain->eval_ctx, bmain, scene, scene->lay);
+}
+
 /* ensure modifier correctness when changing ob->data */
 void test_object_modifiers(Object *ob)
 {
@@ -66,6 +66,7 @@
 #include "BLI_utildefines.h"
 #include "BLI_linklist.h"
 #include "BLI_kdtree.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -115,6 +116,8 @@
 #include "BKE_camera.h"
 #include "BKE_image.h"
 
+#include "RNA_access.h"
+
 #ifdef WITH_MOD_FLUID
 #include "LBM_fluidsim.h"
 #endif
@@ -459,6 +462,10 @@ void BKE_object_free_ex(Object *ob, bool do_id_user)
 		MEM_freeN(ob->curve_cache);
 	}
 
+	if (ob->lnor_split_cache) {
+		BKE_lnor_split_cache_free(ob->lnor_split_cache);
+	}
+
 	BKE_previewimg_free(&ob->preview);
 }
 
@@ -1556,6 +1563,7 @@ Object *BKE_object_copy_ex(Main *bmain, Object *ob, bool copy_caches)
 
 	/* Copy runtime surve data. */
 	obn->curve_cache = NULL;
+	obn->lnor_split_cache = NULL;
 
 	if (ob->id.lib) {
 		BKE_id_lib_local_paths(bmain, ob->id.lib, &obn->id);
@@ -2560,6 +2568,127 @@ void BKE_object_where_is_calc(Scene *scene, Object *ob)
 	BKE_object_where_is_calc_time_ex(scene, ob, BKE_scene_frame_get(scene), NULL, NULL);
 }
 
+/* ------------------- */
+/* Evaluating transforms for many frames at once */
+
+static bool object_transform_frames_fcurve_supported(FCurve *fcu)
+{
+	const char *paths[] = {
+	    "location", "rotation_euler", "rotation_quaternion", "rotation_axis_angle", "scale",
+	    "delta_location", "delta_rotation_euler", "delta_rotation_quaternion", "delta_scale",
+	};
+	int i;
+
+	if (fcu->rna_path == NULL) {
+		return true;
+	}
+	for (i = 0; i < ARRAY_SIZE(paths); i++) {
+		if (STREQ(fcu->rna_path, paths[i])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Can the transform of this object be evaluated for other frames than the current one,
+ * without updating the scene? This is the case when the world matrix only depends on the
+ * object's own action and those of its parents, i.e. there is no feedback from other
+ * data (constraints, drivers, rigid bodies, curve or bone parents...).
+ */
+bool BKE_object_transform_frames_supported(Object *ob)
+{
+	for (; ob; ob = ob->parent) {
+		AnimData *adt = ob->adt;
+
+		if (ob->constraints.first || ob->rigidbody_object || (ob->partype & PARSLOW)) {
+			return false;
+		}
+		if (ob->parent && (((ob->partype & PARTYPE) != PAROBJECT) || (ob->parent->type == OB_CURVE))) {
+			return false;
+		}
+
+		if (adt) {
+			FCurve *fcu;
+
+			if (adt->drivers.first || adt->nla_tracks.first || adt->overrides.first || adt->remap) {
+				return false;
+			}
+			if (adt->action) {
+				for (fcu = adt->action->curves.first; fcu; fcu = fcu->next) {
+					if (fcu->driver || !object_transform_frames_fcurve_supported(fcu)) {
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+static void object_transform_frame_eval(Object *ob, float ctime, float r_obmat[4][4])
+{
+	/* private copy to evaluate the animation into, only the transform values are used */
+	Object ob_eval = *ob;
+	float locmat[4][4];
+
+	if (ob->adt && ob->adt->action) {
+		PointerRNA id_ptr;
+
+		ob_eval.id.flag |= LIB_ANIM_NO_RECALC;
+		RNA_id_pointer_create(&ob_eval.id, &id_ptr);
+		animsys_evaluate_action_threadsafe(&id_ptr, ob->adt->action, ctime);
+	}
+
+	BKE_object_to_mat4(&ob_eval, locmat);
+
+	if (ob->parent) {
+		float parentmat[4][4], tmat[4][4];
+
+		/* same as solve_parenting() for object parents */
+		object_transform_frame_eval(ob->parent, ctime, parentmat);
+		mul_m4_m4m4(tmat, parentmat, ob->parentinv);
+		mul_m4_m4m4(r_obmat, tmat, locmat);
+	}
+	else {
+		copy_m4_m4(r_obmat, locmat);
+	}
+}
+
+typedef struct ObjectTransformFramesData {
+	Object *ob;
+	const float *ctimes;
+	float (*obmats)[4][4];
+} ObjectTransformFramesData;
+
+static void object_transform_frames_eval_cb(void *userdata, int index)
+{
+	ObjectTransformFramesData *data = userdata;
+
+	object_transform_frame_eval(data->ob, data->ctimes[index], data->obmats[index]);
+}
+
+/**
+ * Evaluate the world matrix of the object for many frames in parallel, the object
+ * and the scene are not changed. Only for objects passing #BKE_object_transform_frames_supported.
+ *
+ * \param ctimes: The frames to evaluate.
+ * \param r_obmats: The world matrix for each frame.
+ */
+void BKE_object_transform_frames_eval(Object *ob, const float *ctimes, int ctimes_num, float (*r_obmats)[4][4])
+{
+	ObjectTransformFramesData data;
+
+	BLI_assert(BKE_object_transform_frames_supported(ob));
+
+	data.ob = ob;
+	data.ctimes = ctimes;
+	data.obmats = r_obmats;
+
+	BLI_task_parallel_range(0, ctimes_num, &data, object_transform_frames_eval_cb);
+}
+
 /* for calculation of the inverse parent transform, only used for editor */
 void BKE_object_workob_calc_parent(Scene *scene, Object *ob, Object *workob)
 {
@@ -0,0 +1,55 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BLI_GZIP_FRAMES_H__
+#define __BLI_GZIP_FRAMES_H__
+
+/** \file BLI_gzip_frames.h
+ *  \ingroup bli
+ *
+ * gzip files made of independently compressed members (frames),
+ * so they can be compressed and decompressed in parallel.
+ * Any gzip reader can still read them.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* size of the data in every frame (except the last) */
+#define BLI_GZIP_FRAME_SIZE (1u << 20)
+/* size of the gzip member header, see #BLI_gzip_frames_check */
+#define BLI_GZIP_FRAME_HEADER_SIZE 24
+
+typedef struct GzipFrameWriter GzipFrameWriter;
+
+GzipFrameWriter *BLI_gzip_frames_writer_new(int file, int level) ATTR_WARN_UNUSED_RESULT;
+bool BLI_gzip_frames_writer_write(GzipFrameWriter *gw, const void *data, size_t data_len) ATTR_NONNULL();
+bool BLI_gzip_frames_writer_free(GzipFrameWriter *gw) ATTR_NONNULL();
+
+bool BLI_gzip_frames_check(const void *mem, size_t mem_size) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
+void *BLI_gzip_frames_decompress(const void *mem, size_t mem_size, size_t *r_size)
+        ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __BLI_GZIP_FRAMES_H__ */
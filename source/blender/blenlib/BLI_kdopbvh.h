@@ -131,6 +131,12 @@ int BLI_bvhtree_ray_cast_all(
         BVHTree *tree, const float co[3], const float dir[3], float radius,
         BVHTree_RayCastCallback callback, void *userdata);
 
+void BLI_bvhtree_ray_cast_batch(
+        BVHTree *tree, const float (*co)[3], const float (*dir)[3], const int ray_num, float radius,
+        BVHTreeRayHit *r_hits,
+        BVHTree_RayCastCallback callback, void *userdata,
+        int flag);
+
 float BLI_bvhtree_bb_raycast(const float bv[6], const float light_start[3], const float light_end[3], float pos[3]);
 
 /* range query */
@@ -103,6 +103,9 @@ void _va_mul_m4_series_9(float R[4][4], float M1[4][4], float M2[4][4], float M3
 void mul_m4_v3(float M[4][4], float r[3]);
 void mul_v3_m4v3(float r[3], float M[4][4], const float v[3]);
 void mul_v2_m4v3(float r[2], float M[4][4], const float v[3]);
+void mul_m4_v3_array(float M[4][4], float (*vec_arr)[3], int nbr);
+void mul_v3_m4v3_array(float (*r_arr)[3], float M[4][4], const float (*vec_arr)[3], int nbr);
+void mul_m4_v3_array_soa(float M[4][4], float *x, float *y, float *z, int nbr);
 void mul_v2_m2v2(float r[2], float M[2][2], const float v[2]);
 void mul_m2v2(float M[2][2], float v[2]);
 void mul_mat3_m4_v3(float M[4][4], float r[3]);
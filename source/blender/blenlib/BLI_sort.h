@@ -49,4 +49,15 @@ __attribute__((nonnull(1, 5)))
 #endif
 ;
 
+void BLI_mergesort_parallel_r(void *a, size_t n, size_t es, BLI_sort_cmp_t cmp, void *thunk)
+#ifdef __GNUC__
+__attribute__((nonnull(1, 4)))
+#endif
+;
+
+void BLI_radix_sort_u32(void *a, size_t n, size_t es, size_t key_offset);
+void BLI_radix_sort_i32(void *a, size_t n, size_t es, size_t key_offset);
+void BLI_radix_sort_u64(void *a, size_t n, size_t es, size_t key_offset);
+void BLI_radix_sort_fl(void *a, size_t n, size_t es, size_t key_offset);
+
 #endif  /* __BLI_SORT_H__ */
@@ -40,18 +40,19 @@
  */
 
 #include <assert.h>
+#include <limits.h>
 
 #include "MEM_guardedalloc.h"
 
 #include "BLI_utildefines.h"
-#include "BLI_alloca.h"
 #include "BLI_stack.h"
 #include "BLI_kdopbvh.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_strict_flags.h"
 
-#ifdef _OPENMP
-#include <omp.h>
+#ifdef __SSE2__
+#  include <emmintrin.h>
 #endif
 
 /* used for iterative_raycast */
@@ -59,17 +60,24 @@
 
 #define MAX_TREETYPE 32
 
-/* Setting zero so we can catch bugs in OpenMP/KDOPBVH.
+/* Setting zero so we can catch bugs in threading/KDOPBVH.
  * TODO(sergey): Deduplicate the limits with PBVH from BKE.
  */
-#ifdef _OPENMP
-#  ifdef DEBUG
-#    define KDOPBVH_OMP_LIMIT 0
-#  else
-#    define KDOPBVH_OMP_LIMIT 1024
-#  endif
+#ifdef DEBUG
+#  define KDOPBVH_THREAD_LEAF_THRESHOLD 0
+#else
+#  define KDOPBVH_THREAD_LEAF_THRESHOLD 1024
 #endif
 
+/* Number of rays below which #BLI_bvhtree_ray_cast_batch doesn't bother with threads. */
+#define KDOPBVH_THREAD_RAY_THRESHOLD 64
+
+/* Pairs of nodes #BLI_bvhtree_overlap splits the trees into for each thread, at least,
+ * so a thread that is done early takes more of the work. */
+#define KDOPBVH_OVERLAP_PAIRS_PER_THREAD 8
+/* Chunk size of the stack of overlaps of each pair (bytes). */
+#define KDOPBVH_OVERLAP_CHUNK_SIZE 4096
+
 typedef unsigned char axis_t;
 
 typedef struct BVHNode {
@@ -467,7 +475,7 @@ static void create_kdop_hull(BVHTree *tree, BVHNode *node, const float *co, int
 /**
  * \note depends on the fact that the BVH's for each face is already build
  */
-static void refit_kdop_hull(BVHTree *tree, BVHNode *node, int start, int end)
+static void refit_kdop_hull(const BVHTree *tree, BVHNode *node, int start, int end)
 {
 	float newmin, newmax;
 	float *bv = node->bv;
@@ -642,7 +650,7 @@ typedef struct BVHBuildHelper {
 
 } BVHBuildHelper;
 
-static void build_implicit_tree_helper(BVHTree *tree, BVHBuildHelper *data)
+static void build_implicit_tree_helper(const BVHTree *tree, BVHBuildHelper *data)
 {
 	int depth = 0;
 	int remain;
@@ -672,7 +680,7 @@ static void build_implicit_tree_helper(BVHTree *tree, BVHBuildHelper *data)
 }
 
 // return the min index of all the leafs archivable with the given branch
-static int implicit_leafs_index(BVHBuildHelper *data, int depth, int child_index)
+static int implicit_leafs_index(const BVHBuildHelper *data, int depth, int child_index)
 {
 	int min_leaf_index = child_index * data->leafs_per_child[depth - 1];
 	if (min_leaf_index <= data->remain_leafs)
@@ -740,6 +748,81 @@ static void split_leafs(BVHNode **leafs_array, int *nth, int partitions, int spl
 	}
 }
 
+typedef struct BVHDivNodesData {
+	const BVHTree *tree;
+	BVHNode *branches_array;
+	BVHNode **leafs_array;
+
+	int tree_type;
+	int tree_offset;
+
+	const BVHBuildHelper *data;
+
+	int depth;
+	int i;
+	int first_of_next_level;
+} BVHDivNodesData;
+
+static void non_recursive_bvh_div_nodes_task_cb(void *userdata, int j)
+{
+	BVHDivNodesData *data = userdata;
+
+	int k;
+	const int parent_level_index = j - data->i;
+	BVHNode *parent = data->branches_array + j;
+	int nth_positions[MAX_TREETYPE + 1];
+	char split_axis;
+
+	int parent_leafs_begin = implicit_leafs_index(data->data, data->depth, parent_level_index);
+	int parent_leafs_end   = implicit_leafs_index(data->data, data->depth, parent_level_index + 1);
+
+	/* This calculates the bounding box of this branch
+	 * and chooses the largest axis as the axis to divide leafs */
+	refit_kdop_hull(data->tree, parent, parent_leafs_begin, parent_leafs_end);
+	split_axis = get_largest_axis(parent->bv);
+
+	/* Save split axis (this can be used on raytracing to speedup the query time) */
+	parent->main_axis = split_axis / 2;
+
+	/* Split the childs along the split_axis, note: its not needed to sort the whole leafs array
+	 * Only to assure that the elements are partitioned on a way that each child takes the elements
+	 * it would take in case the whole array was sorted.
+	 * Split_leafs takes care of that "sort" problem. */
+	nth_positions[0] = parent_leafs_begin;
+	nth_positions[data->tree_type] = parent_leafs_end;
+	for (k = 1; k < data->tree_type; k++) {
+		const int child_index = j * data->tree_type + data->tree_offset + k;
+		const int child_level_index = child_index - data->first_of_next_level; /* child level index */
+		nth_positions[k] = implicit_leafs_index(data->data, data->depth + 1, child_level_index);
+	}
+
+	split_leafs(data->leafs_array, nth_positions, data->tree_type, split_axis);
+
+	/* Setup children and totnode counters
+	 * Not really needed but currently most of BVH code relies on having an explicit children structure */
+	for (k = 0; k < data->tree_type; k++) {
+		const int child_index = j * data->tree_type + data->tree_offset + k;
+		const int child_level_index = child_index - data->first_of_next_level; /* child level index */
+
+		const int child_leafs_begin = implicit_leafs_index(data->data, data->depth + 1, child_level_index);
+		const int child_leafs_end   = implicit_leafs_index(data->data, data->depth + 1, child_level_index + 1);
+
+		if (child_leafs_end - child_leafs_begin > 1) {
+			parent->children[k] = data->branches_array + child_index;
+			parent->children[k]->parent = parent;
+		}
+		else if (child_leafs_end - child_leafs_begin == 1) {
+			parent->children[k] = data->leafs_array[child_leafs_begin];
+			parent->children[k]->parent = parent;
+		}
+		else {
+			break;
+		}
+
+		parent->totnode = (char)(k + 1);
+	}
+}
+
 /**
  * This functions builds an optimal implicit tree from the given leafs.
  * Where optimal stands for:
@@ -750,21 +833,25 @@ static void split_leafs(BVHNode **leafs_array, int *nth, int partitions, int spl
  * This function creates an implicit tree on branches_array, the leafs are given on the leafs_array.
  *
  * The tree is built per depth levels. First branches at depth 1.. then branches at depth 2.. etc..
- * The reason is that we can build level N+1 from level N without any data dependencies.. thus it allows
- * to use multithread building.
+ * The reason is that we can build level N+1 from level N without any data dependencies..
+ * so all branches of a level are split in parallel, see #non_recursive_bvh_div_nodes_task_cb.
  *
  * To archive this is necessary to find how much leafs are accessible from a certain branch, BVHBuildHelper
  * implicit_needed_branches and implicit_leafs_index are auxiliary functions to solve that "optimal-split".
  */
-static void non_recursive_bvh_div_nodes(BVHTree *tree, BVHNode *branches_array, BVHNode **leafs_array, int num_leafs)
+static void non_recursive_bvh_div_nodes(
+        const BVHTree *tree, BVHNode *branches_array, BVHNode **leafs_array, int num_leafs)
 {
 	int i;
 
 	const int tree_type   = tree->tree_type;
 	const int tree_offset = 2 - tree->tree_type; /* this value is 0 (on binary trees) and negative on the others */
 	const int num_branches = implicit_needed_branches(tree_type, num_leafs);
+	/* Levels with a single branch are never worth a task pool. */
+	const int range_threshold = (num_leafs > KDOPBVH_THREAD_LEAF_THRESHOLD) ? 2 : INT_MAX;
 
 	BVHBuildHelper data;
+	BVHDivNodesData cb_data;
 	int depth;
 	
 	/* set parent from root node to NULL */
@@ -787,72 +874,26 @@ static void non_recursive_bvh_div_nodes(BVHTree *tree, BVHNode *branches_array,
 
 	build_implicit_tree_helper(tree, &data);
 
+	cb_data.tree = tree;
+	cb_data.branches_array = branches_array;
+	cb_data.leafs_array = leafs_array;
+	cb_data.tree_type = tree_type;
+	cb_data.tree_offset = tree_offset;
+	cb_data.data = &data;
+
 	/* Loop tree levels (log N) loops */
 	for (i = 1, depth = 1; i <= num_branches; i = i * tree_type + tree_offset, depth++) {
 		const int first_of_next_level = i * tree_type + tree_offset;
 		const int end_j = min_ii(first_of_next_level, num_branches + 1);  /* index of last branch on this level */
-		int j;
 
 		/* Loop all branches on this level */
+		cb_data.first_of_next_level = first_of_next_level;
+		cb_data.i = i;
+		cb_data.depth = depth;
 
-#pragma omp parallel for private(j) schedule(static) if (num_leafs > KDOPBVH_OMP_LIMIT)
-		for (j = i; j < end_j; j++) {
-			int k;
-			const int parent_level_index = j - i;
-			BVHNode *parent = branches_array + j;
-			int nth_positions[MAX_TREETYPE + 1];
-			char split_axis;
-
-			int parent_leafs_begin = implicit_leafs_index(&data, depth, parent_level_index);
-			int parent_leafs_end   = implicit_leafs_index(&data, depth, parent_level_index + 1);
-
-			/* This calculates the bounding box of this branch
-			 * and chooses the largest axis as the axis to divide leafs */
-			refit_kdop_hull(tree, parent, parent_leafs_begin, parent_leafs_end);
-			split_axis = get_largest_axis(parent->bv);
-
-			/* Save split axis (this can be used on raytracing to speedup the query time) */
-			parent->main_axis = split_axis / 2;
-
-			/* Split the childs along the split_axis, note: its not needed to sort the whole leafs array
-			 * Only to assure that the elements are partitioned on a way that each child takes the elements
-			 * it would take in case the whole array was sorted.
-			 * Split_leafs takes care of that "sort" problem. */
-			nth_positions[0] = parent_leafs_begin;
-			nth_positions[tree_type] = parent_leafs_end;
-			for (k = 1; k < tree_type; k++) {
-				int child_index = j * tree_type + tree_offset + k;
-				int child_level_index = child_index - first_of_next_level; /* child level index */
-				nth_positions[k] = implicit_leafs_index(&data, depth + 1, child_level_index);
-			}
-
-			split_leafs(leafs_array, nth_positions, tree_type, split_axis);
-
-
-			/* Setup children and totnode counters
-			 * Not really needed but currently most of BVH code relies on having an explicit children structure */
-			for (k = 0; k < tree_type; k++) {
-				int child_index = j * tree_type + tree_offset + k;
-				int child_level_index = child_index - first_of_next_level; /* child level index */
-
-				int child_leafs_begin = implicit_leafs_index(&data, depth + 1, child_level_index);
-				int child_leafs_end   = implicit_leafs_index(&data, depth + 1, child_level_index + 1);
-
-				if (child_leafs_end - child_leafs_begin > 1) {
-					parent->children[k] = branches_array + child_index;
-					parent->children[k]->parent = parent;
-				}
-				else if (child_leafs_end - child_leafs_begin == 1) {
-					parent->children[k] = leafs_array[child_leafs_begin];
-					parent->children[k]->parent = parent;
-				}
-				else {
-					break;
-				}
-
-				parent->totnode = (char)(k + 1);
-			}
-		}
+		BLI_task_parallel_range_ex(
+		            i, end_j, &cb_data, non_recursive_bvh_div_nodes_task_cb,
+		            range_threshold, false);
 	}
 }
 
@@ -1063,7 +1104,21 @@ static bool tree_overlap_test(const BVHNode *node1, const BVHNode *node2, axis_t
 	const float *bv1     = node1->bv + (start_axis << 1);
 	const float *bv2     = node2->bv + (start_axis << 1);
 	const float *bv1_end = node1->bv + (stop_axis  << 1);
-	
+
+#ifdef __SSE2__
+	/* Test two axes (4 floats) at once: lanes 0 & 2 hold the minimums, lanes 1 & 3 the maximums.
+	 * Swapping min/max pairs of 'bv2' lets a single compare check both separation conditions. */
+	for (; bv1_end - bv1 >= 4; bv1 += 4, bv2 += 4) {
+		const __m128 a = _mm_loadu_ps(bv1);
+		const __m128 b = _mm_shuffle_ps(_mm_loadu_ps(bv2), _mm_loadu_ps(bv2), _MM_SHUFFLE(2, 3, 0, 1));
+		const int sep = (_mm_movemask_ps(_mm_cmpgt_ps(a, b)) & 0x5) |
+		                (_mm_movemask_ps(_mm_cmpgt_ps(b, a)) & 0xa);
+		if (sep) {
+			return 0;
+		}
+	}
+#endif
+
 	/* test all axis if min + max overlap */
 	for (; bv1 != bv1_end; bv1 += 2, bv2 += 2) {
 		if ((bv1[0] > bv2[1]) || (bv2[0] > bv1[1])) {
@@ -1162,14 +1217,111 @@ static void tree_overlap_traverse_cb(
 	}
 }
 
+typedef struct BVHOverlapPair {
+	const BVHNode *node1, *node2;
+	BLI_Stack *overlap;  /* store BVHTreeOverlap, found under this pair */
+} BVHOverlapPair;
+
+static void bvhtree_overlap_pair_traverse(BVHOverlapData_Shared *data_shared, BVHOverlapPair *pair, int thread)
+{
+	BVHOverlapData_Thread data;
+
+	data.shared = data_shared;
+	data.overlap = pair->overlap;
+	data.thread = thread;
+
+	if (data_shared->callback) {
+		tree_overlap_traverse_cb(&data, pair->node1, pair->node2);
+	}
+	else {
+		tree_overlap_traverse(&data, pair->node1, pair->node2);
+	}
+}
+
+static void bvhtree_overlap_task_cb(TaskPool * __restrict pool, void *taskdata, int threadid)
+{
+	bvhtree_overlap_pair_traverse(BLI_task_pool_userdata(pool), taskdata, threadid);
+}
+
 /**
- * Use to check the total number of threads #BLI_bvhtree_overlap will use.
+ * Split the overlap of \a root1 and \a root2 into at least \a pairs_min pairs of overlapping nodes,
+ * when the trees are deep enough, so there are many more tasks than threads.
+ *
+ * Each pair is replaced by the pairs of its children, in the order #tree_overlap_traverse visits them.
+ * So the overlaps found under each pair, one pair after the other, are in the order of a single traversal.
+ */
+static BVHOverlapPair *bvhtree_overlap_pairs_split(
+        const BVHOverlapData_Shared *data, const BVHNode *root1, const BVHNode *root2,
+        const int pairs_min, int *r_pairs_num)
+{
+	const int tree_type = data->tree2->tree_type;
+	BVHOverlapPair *pairs = MEM_mallocN(sizeof(*pairs), __func__);
+	int pairs_num = 1;
+	bool is_split = true;
+
+	pairs[0].node1 = root1;
+	pairs[0].node2 = root2;
+
+	while (is_split && (pairs_num < pairs_min)) {
+		BVHOverlapPair *pairs_next = MEM_mallocN(sizeof(*pairs_next) * (size_t)(pairs_num * tree_type), __func__);
+		int pairs_next_num = 0;
+		int i, j;
+
+		is_split = false;
+
+		for (i = 0; i < pairs_num; i++) {
+			const BVHNode *node1 = pairs[i].node1;
+			const BVHNode *node2 = pairs[i].node2;
+
+			if (!tree_overlap_test(node1, node2, data->start_axis, data->stop_axis)) {
+				continue;
+			}
+
+			if (node1->totnode) {
+				for (j = 0; j < tree_type; j++) {
+					if (node1->children[j]) {
+						pairs_next[pairs_next_num].node1 = node1->children[j];
+						pairs_next[pairs_next_num++].node2 = node2;
+					}
+				}
+				is_split = true;
+			}
+			else if (node2->totnode) {
+				for (j = 0; j < tree_type; j++) {
+					if (node2->children[j]) {
+						pairs_next[pairs_next_num].node1 = node1;
+						pairs_next[pairs_next_num++].node2 = node2->children[j];
+					}
+				}
+				is_split = true;
+			}
+			else {
+				/* both leafs */
+				pairs_next[pairs_next_num++] = pairs[i];
+			}
+		}
+
+		MEM_freeN(pairs);
+		pairs = pairs_next;
+		pairs_num = pairs_next_num;
+	}
+
+	*r_pairs_num = pairs_num;
+	return pairs;
+}
+
+/**
+ * Use to check the total number of threads #BLI_bvhtree_overlap will use,
+ * the thread passed to the overlap callback is lower than this.
  *
  * \warning Must be the first tree passed to #BLI_bvhtree_overlap!
  */
 int BLI_bvhtree_overlap_thread_num(const BVHTree *tree)
 {
-	return (int)MIN2(tree->tree_type, tree->nodes[tree->totleaf]->totnode);
+	if (tree->totleaf > KDOPBVH_THREAD_LEAF_THRESHOLD) {
+		return BLI_task_scheduler_num_threads(BLI_task_scheduler_get());
+	}
+	return 1;
 }
 
 BVHTreeOverlap *BLI_bvhtree_overlap(
@@ -1182,7 +1334,8 @@ BVHTreeOverlap *BLI_bvhtree_overlap(
 	size_t total = 0;
 	BVHTreeOverlap *overlap = NULL, *to = NULL;
 	BVHOverlapData_Shared data_shared;
-	BVHOverlapData_Thread *data = BLI_array_alloca(data, (size_t)thread_num);
+	BVHOverlapPair *pairs;
+	int pairs_num;
 	axis_t start_axis, stop_axis;
 	
 	/* check for compatibility of both trees (can't compare 14-DOP with 18-DOP) */
@@ -1211,37 +1364,48 @@ BVHTreeOverlap *BLI_bvhtree_overlap(
 	data_shared.callback = callback;
 	data_shared.userdata = userdata;
 
-	for (j = 0; j < thread_num; j++) {
-		/* init BVHOverlapData_Thread */
-		data[j].shared = &data_shared;
-		data[j].overlap = BLI_stack_new(sizeof(BVHTreeOverlap), __func__);
+	/* Only splitting the root nodes gave at most 'tree_type' tasks, less than the threads
+	 * of most machines. Pairs of deeper nodes go into a task pool instead, any thread
+	 * takes the next pair when it's done. */
+	pairs = bvhtree_overlap_pairs_split(
+	        &data_shared, tree1->nodes[tree1->totleaf], tree2->nodes[tree2->totleaf],
+	        (thread_num > 1) ? thread_num * KDOPBVH_OVERLAP_PAIRS_PER_THREAD : 1, &pairs_num);
 
-		/* for callback */
-		data[j].thread = j;
+	for (j = 0; j < pairs_num; j++) {
+		pairs[j].overlap = BLI_stack_new_ex(sizeof(BVHTreeOverlap), __func__, KDOPBVH_OVERLAP_CHUNK_SIZE);
 	}
 
-#pragma omp parallel for private(j) schedule(static)  if (tree1->totleaf > KDOPBVH_OMP_LIMIT)
-	for (j = 0; j < thread_num; j++) {
-		if (callback) {
-			tree_overlap_traverse_cb(&data[j], tree1->nodes[tree1->totleaf]->children[j], tree2->nodes[tree2->totleaf]);
+	if (thread_num > 1) {
+		TaskPool *task_pool = BLI_task_pool_create(BLI_task_scheduler_get(), &data_shared);
+
+		for (j = 0; j < pairs_num; j++) {
+			BLI_task_pool_push(task_pool, bvhtree_overlap_task_cb, &pairs[j], false, TASK_PRIORITY_HIGH);
 		}
-		else {
-			tree_overlap_traverse(&data[j], tree1->nodes[tree1->totleaf]->children[j], tree2->nodes[tree2->totleaf]);
+
+		BLI_task_pool_work_and_wait(task_pool);
+		BLI_task_pool_free(task_pool);
+	}
+	else {
+		for (j = 0; j < pairs_num; j++) {
+			bvhtree_overlap_pair_traverse(&data_shared, &pairs[j], 0);
 		}
 	}
 	
-	for (j = 0; j < thread_num; j++)
-		total += BLI_stack_count(data[j].overlap);
+	for (j = 0; j < pairs_num; j++)
+		total += BLI_stack_count(pairs[j].overlap);
 	
 	to = overlap = MEM_mallocN(sizeof(BVHTreeOverlap) * total, "BVHTreeOverlap");
 	
-	for (j = 0; j < thread_num; j++) {
-		unsigned int count = (unsigned int)BLI_stack_count(data[j].overlap);
-		BLI_stack_pop_n(data[j].overlap, to, count);
-		BLI_stack_free(data[j].overlap);
+	/* in the order they were found, the same whatever the number of threads */
+	for (j = 0; j < pairs_num; j++) {
+		unsigned int count = (unsigned int)BLI_stack_count(pairs[j].overlap);
+		BLI_stack_pop_n_reverse(pairs[j].overlap, to, count);
+		BLI_stack_free(pairs[j].overlap);
 		to += count;
 	}
 
+	MEM_freeN(pairs);
+
 	*r_overlap_tot = (unsigned int)total;
 	return overlap;
 }
@@ -1708,6 +1872,60 @@ int BLI_bvhtree_ray_cast(
 	return BLI_bvhtree_ray_cast_ex(tree, co, dir, radius, hit, callback, userdata, BVH_RAYCAST_DEFAULT);
 }
 
+typedef struct BVHRayCastBatchData {
+	BVHTree *tree;
+	const float (*co)[3];
+	const float (*dir)[3];
+	float radius;
+	BVHTreeRayHit *hits;
+
+	BVHTree_RayCastCallback callback;
+	void *userdata;
+	int flag;
+} BVHRayCastBatchData;
+
+static void bvhtree_ray_cast_batch_task_cb(void *userdata, int i)
+{
+	BVHRayCastBatchData *data = userdata;
+
+	BLI_bvhtree_ray_cast_ex(
+	        data->tree, data->co[i], data->dir[i], data->radius, &data->hits[i],
+	        data->callback, data->userdata, data->flag);
+}
+
+/**
+ * Cast many rays against the same tree, splitting the rays over threads.
+ *
+ * \param r_hits: One hit per ray, initialized by the caller the same way as for #BLI_bvhtree_ray_cast_ex
+ * (typically ``index = -1`` and ``dist`` set to the maximum ray length).
+ * \note \a callback is called from multiple threads and must be thread-safe.
+ */
+void BLI_bvhtree_ray_cast_batch(
+        BVHTree *tree, const float (*co)[3], const float (*dir)[3], const int ray_num, float radius,
+        BVHTreeRayHit *r_hits,
+        BVHTree_RayCastCallback callback, void *userdata,
+        int flag)
+{
+	BVHRayCastBatchData data;
+
+	if (ray_num <= 0) {
+		return;
+	}
+
+	data.tree = tree;
+	data.co = co;
+	data.dir = dir;
+	data.radius = radius;
+	data.hits = r_hits;
+	data.callback = callback;
+	data.userdata = userdata;
+	data.flag = flag;
+
+	BLI_task_parallel_range_ex(
+	            0, ray_num, &data, bvhtree_ray_cast_batch_task_cb,
+	            KDOPBVH_THREAD_RAY_THRESHOLD, false);
+}
+
 float BLI_bvhtree_bb_raycast(const float bv[6], const float light_start[3], const float light_end[3], float pos[3])
 {
 	BVHRayCastData data;
@@ -0,0 +1,355 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/gzip_frames.c
+ *  \ingroup bli
+ *
+ * \brief gzip files which can be compressed and decompressed in parallel.
+ *
+ * The data is split in frames of #BLI_GZIP_FRAME_SIZE, each compressed on its own
+ * and written as a complete gzip member. Concatenated members are a valid gzip file,
+ * so these can still be read with gzread (and older Blender versions).
+ *
+ * Every member header has an extra field ('B', 'L') with the size of the
+ * compressed member and of its data, so all frames can be found without
+ * decompressing anything (like BGZF does):
+ *
+ * <pre>
+ *  0: 1f 8b 08 04  (magic, deflate, FEXTRA)
+ *  4: 00 00 00 00  (time)
+ *  8: 00 ff        (extra flags, OS unknown)
+ * 10: 0c 00        (extra field length)
+ * 12: 'B' 'L' 08 00
+ * 16: uint32 member size, uint32 data size (little endian)
+ * 24: raw deflate data, uint32 CRC32, uint32 data size
+ * </pre>
+ */
+
+#include <string.h>
+#include <fcntl.h>
+
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#include "zlib.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_gzip_frames.h"
+#include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "BLI_strict_flags.h"
+
+#define GZIP_FRAME_TRAILER_SIZE 8
+
+static const unsigned char gzip_frame_header[16] = {
+	0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0xff, 0x0c, 0x00, 'B', 'L', 0x08, 0x00,
+};
+
+BLI_INLINE void uint32_to_le(unsigned char *r_mem, unsigned int value)
+{
+	r_mem[0] = (unsigned char)value;
+	r_mem[1] = (unsigned char)(value >> 8);
+	r_mem[2] = (unsigned char)(value >> 16);
+	r_mem[3] = (unsigned char)(value >> 24);
+}
+
+BLI_INLINE unsigned int uint32_from_le(const unsigned char *mem)
+{
+	return ((unsigned int)mem[0] |
+	        ((unsigned int)mem[1] << 8) |
+	        ((unsigned int)mem[2] << 16) |
+	        ((unsigned int)mem[3] << 24));
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Writing
+ * \{ */
+
+typedef struct GzipFrame {
+	/* compressed member, header included */
+	unsigned char *mem;
+	size_t mem_len;
+} GzipFrame;
+
+struct GzipFrameWriter {
+	int file;
+	int level;
+	bool error;
+
+	/* data of frames_num frames, compressed together when full */
+	unsigned char *data;
+	size_t data_len;
+
+	GzipFrame *frames;
+	int frames_num;
+};
+
+/**
+ * \param file: File descriptor to write to, it's not closed by #BLI_gzip_frames_writer_free.
+ * \param level: zlib compression level.
+ */
+GzipFrameWriter *BLI_gzip_frames_writer_new(int file, int level)
+{
+	GzipFrameWriter *gw = MEM_callocN(sizeof(*gw), __func__);
+	const size_t frame_mem_len = BLI_GZIP_FRAME_HEADER_SIZE + compressBound(BLI_GZIP_FRAME_SIZE) +
+	                             GZIP_FRAME_TRAILER_SIZE;
+	int i;
+
+	gw->file = file;
+	gw->level = level;
+
+	/* enough frames to keep all threads busy */
+	gw->frames_num = max_ii(2, BLI_system_thread_count() * 2);
+	gw->frames = MEM_mallocN(sizeof(*gw->frames) * (size_t)gw->frames_num, __func__);
+	for (i = 0; i < gw->frames_num; i++) {
+		gw->frames[i].mem = MEM_mallocN(frame_mem_len, __func__);
+	}
+	gw->data = MEM_mallocN((size_t)BLI_GZIP_FRAME_SIZE * (size_t)gw->frames_num, __func__);
+
+	return gw;
+}
+
+static void gzip_frame_compress_cb(void *userdata, int index)
+{
+	GzipFrameWriter *gw = userdata;
+	GzipFrame *frame = &gw->frames[index];
+	const unsigned char *data = gw->data + (size_t)index * BLI_GZIP_FRAME_SIZE;
+	const size_t data_len = MIN2(gw->data_len - (size_t)index * BLI_GZIP_FRAME_SIZE, BLI_GZIP_FRAME_SIZE);
+	z_stream strm = {NULL};
+	size_t len;
+
+	/* raw deflate, the gzip header and trailer are our own */
+	if (deflateInit2(&strm, gw->level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		gw->error = true;
+		return;
+	}
+
+	strm.next_in = (Bytef *)data;
+	strm.avail_in = (uInt)data_len;
+	strm.next_out = frame->mem + BLI_GZIP_FRAME_HEADER_SIZE;
+	strm.avail_out = (uInt)compressBound(BLI_GZIP_FRAME_SIZE);
+
+	if (deflate(&strm, Z_FINISH) != Z_STREAM_END) {
+		gw->error = true;
+	}
+	len = BLI_GZIP_FRAME_HEADER_SIZE + (size_t)strm.total_out;
+	deflateEnd(&strm);
+
+	uint32_to_le(frame->mem + len, (unsigned int)crc32(0, data, (uInt)data_len));
+	uint32_to_le(frame->mem + len + 4, (unsigned int)data_len);
+	len += GZIP_FRAME_TRAILER_SIZE;
+
+	memcpy(frame->mem, gzip_frame_header, sizeof(gzip_frame_header));
+	uint32_to_le(frame->mem + 16, (unsigned int)len);
+	uint32_to_le(frame->mem + 20, (unsigned int)data_len);
+
+	frame->mem_len = len;
+}
+
+static void gzip_frames_writer_flush(GzipFrameWriter *gw)
+{
+	const int frames_used = (int)((gw->data_len + BLI_GZIP_FRAME_SIZE - 1) / BLI_GZIP_FRAME_SIZE);
+	int i;
+
+	if (frames_used == 0) {
+		return;
+	}
+
+	BLI_task_parallel_range_ex(0, frames_used, gw, gzip_frame_compress_cb, 1, false);
+
+	for (i = 0; i < frames_used && !gw->error; i++) {
+		const GzipFrame *frame = &gw->frames[i];
+		if ((size_t)write(gw->file, frame->mem, frame->mem_len) != frame->mem_len) {
+			gw->error = true;
+		}
+	}
+
+	gw->data_len = 0;
+}
+
+/**
+ * \return false on failure (also for all following writes).
+ */
+bool BLI_gzip_frames_writer_write(GzipFrameWriter *gw, const void *data, size_t data_len)
+{
+	const size_t data_size = (size_t)BLI_GZIP_FRAME_SIZE * (size_t)gw->frames_num;
+
+	while (data_len && !gw->error) {
+		const size_t len = MIN2(data_len, data_size - gw->data_len);
+
+		memcpy(gw->data + gw->data_len, data, len);
+		gw->data_len += len;
+		data = (const char *)data + len;
+		data_len -= len;
+
+		if (gw->data_len == data_size) {
+			gzip_frames_writer_flush(gw);
+		}
+	}
+
+	return !gw->error;
+}
+
+/**
+ * Write the remaining data and free.
+ * \return false when anything failed to be written.
+ */
+bool BLI_gzip_frames_writer_free(GzipFrameWriter *gw)
+{
+	bool ok;
+	int i;
+
+	if (!gw->error) {
+		gzip_frames_writer_flush(gw);
+	}
+	ok = !gw->error;
+
+	for (i = 0; i < gw->frames_num; i++) {
+		MEM_freeN(gw->frames[i].mem);
+	}
+	MEM_freeN(gw->frames);
+	MEM_freeN(gw->data);
+	MEM_freeN(gw);
+
+	return ok;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Reading
+ * \{ */
+
+/**
+ * Is this the start of a file written with #GzipFrameWriter?
+ * Only the first #BLI_GZIP_FRAME_HEADER_SIZE bytes are needed.
+ */
+bool BLI_gzip_frames_check(const void *mem, size_t mem_size)
+{
+	return ((mem_size >= BLI_GZIP_FRAME_HEADER_SIZE) &&
+	        (memcmp(mem, gzip_frame_header, sizeof(gzip_frame_header)) == 0));
+}
+
+typedef struct GzipFrameRead {
+	const unsigned char *mem;
+	size_t mem_len;
+	unsigned char *data;
+	size_t data_len;
+} GzipFrameRead;
+
+typedef struct GzipFramesReadData {
+	GzipFrameRead *frames;
+	bool error;
+} GzipFramesReadData;
+
+static void gzip_frame_decompress_cb(void *userdata, int index)
+{
+	GzipFramesReadData *data = userdata;
+	const GzipFrameRead *frame = &data->frames[index];
+	z_stream strm = {NULL};
+	int ret;
+
+	/* gzip wrapper, so zlib checks the header and CRC */
+	if (inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK) {
+		data->error = true;
+		return;
+	}
+
+	strm.next_in = (Bytef *)frame->mem;
+	strm.avail_in = (uInt)frame->mem_len;
+	strm.next_out = frame->data;
+	strm.avail_out = (uInt)frame->data_len;
+
+	ret = inflate(&strm, Z_FINISH);
+	if (ret != Z_STREAM_END || strm.avail_out != 0 || strm.avail_in != 0) {
+		data->error = true;
+	}
+	inflateEnd(&strm);
+}
+
+/**
+ * Decompress all frames of a file written with #GzipFrameWriter, in parallel.
+ *
+ * \return The data (MEM_mallocN'd), NULL when this isn't such a file or it's damaged,
+ * in that case it can still be read as a regular gzip file.
+ */
+void *BLI_gzip_frames_decompress(const void *mem, size_t mem_size, size_t *r_size)
+{
+	const unsigned char *cmem = mem;
+	GzipFramesReadData data = {NULL};
+	unsigned char *result;
+	size_t offset, data_len = 0;
+	int frames_num = 0, i;
+
+	/* find the frames */
+	for (offset = 0; offset < mem_size; ) {
+		size_t len;
+		if (!BLI_gzip_frames_check(cmem + offset, mem_size - offset)) {
+			return NULL;
+		}
+		len = uint32_from_le(cmem + offset + 16);
+		if (len < BLI_GZIP_FRAME_HEADER_SIZE + GZIP_FRAME_TRAILER_SIZE || len > mem_size - offset) {
+			return NULL;
+		}
+		data_len += uint32_from_le(cmem + offset + 20);
+		offset += len;
+		frames_num++;
+	}
+
+	if (frames_num == 0) {
+		return NULL;
+	}
+
+	result = MEM_mallocN(MAX2(data_len, (size_t)1), __func__);
+	data.frames = MEM_mallocN(sizeof(*data.frames) * (size_t)frames_num, __func__);
+
+	data_len = 0;
+	for (i = 0, offset = 0; i < frames_num; i++) {
+		GzipFrameRead *frame = &data.frames[i];
+		frame->mem = cmem + offset;
+		frame->mem_len = uint32_from_le(frame->mem + 16);
+		frame->data = result + data_len;
+		frame->data_len = uint32_from_le(frame->mem + 20);
+		offset += frame->mem_len;
+		data_len += frame->data_len;
+	}
+
+	BLI_task_parallel_range_ex(0, frames_num, &data, gzip_frame_decompress_cb, 1, false);
+
+	MEM_freeN(data.frames);
+
+	if (data.error) {
+		MEM_freeN(result);
+		return NULL;
+	}
+
+	*r_size = data_len;
+	return result;
+}
+
+/** \} */
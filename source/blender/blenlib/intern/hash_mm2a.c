@@ -27,6 +27,8 @@
  *  Functions to compute Murmur2A hash key.
  *
  * A very fast hash generating int32 result, with few collisions and good repartition.
+ * The Murmur64A variant generates an int64 result, for keys that identify data instead of hashing it into
+ * a table, where 32 bits would make collisions likely.
  *
  * See also:
  *     reference implementation: https://smhasher.googlecode.com/svn-history/r130/trunk/MurmurHash2.cpp
@@ -143,3 +145,78 @@ uint32_t BLI_hash_mm2(const unsigned char *data, size_t len, uint32_t seed)
 	return h;
 }
 
+
+/* 64 bits variant, same incremental scheme as MurmurHash2A applied to MurmurHash64A. */
+#define MM64A_M 0xc6a4a7935bd1e995ULL
+#define MM64A_R 47
+
+#define MM64A_MIX(h, k)           \
+{                                 \
+	(k) *= MM64A_M;               \
+	(k) ^= (k) >> MM64A_R;        \
+	(k) *= MM64A_M;               \
+	(h) ^= (k);                   \
+	(h) *= MM64A_M;               \
+} (void)0
+
+#define MM64A_MIX_FINALIZE(h)     \
+{                                 \
+	(h) ^= (h) >> MM64A_R;        \
+	(h) *= MM64A_M;               \
+	(h) ^= (h) >> MM64A_R;        \
+} (void)0
+
+static void mm64a_mix_tail(BLI_HashMurmur64A *mm64, const unsigned char **data, size_t *len)
+{
+	while (*len && ((*len < 8) || mm64->count)) {
+		mm64->tail |= (uint64_t)(**data) << (mm64->count * 8);
+
+		mm64->count++;
+		(*len)--;
+		(*data)++;
+
+		if (mm64->count == 8) {
+			MM64A_MIX(mm64->hash, mm64->tail);
+			mm64->tail = 0;
+			mm64->count = 0;
+		}
+	}
+}
+
+void BLI_hash_mm64a_init(BLI_HashMurmur64A *mm64, uint64_t seed)
+{
+	mm64->hash  = seed;
+	mm64->tail  = 0;
+	mm64->size  = 0;
+	mm64->count = 0;
+}
+
+void BLI_hash_mm64a_add(BLI_HashMurmur64A *mm64, const unsigned char *data, size_t len)
+{
+	mm64->size += (uint64_t)len;
+
+	mm64a_mix_tail(mm64, &data, &len);
+
+	for (; len >= 8; data += 8, len -= 8) {
+		uint64_t k = *(const uint64_t *)data;
+
+		MM64A_MIX(mm64->hash, k);
+	}
+
+	mm64a_mix_tail(mm64, &data, &len);
+}
+
+void BLI_hash_mm64a_add_int(BLI_HashMurmur64A *mm64, int data)
+{
+	BLI_hash_mm64a_add(mm64, (const unsigned char *)&data, sizeof(data));
+}
+
+uint64_t BLI_hash_mm64a_end(BLI_HashMurmur64A *mm64)
+{
+	MM64A_MIX(mm64->hash, mm64->tail);
+	MM64A_MIX(mm64->hash, mm64->size);
+
+	MM64A_MIX_FINALIZE(mm64->hash);
+
+	return mm64->hash;
+}
@@ -33,6 +33,10 @@
 
 #include "BLI_strict_flags.h"
 
+#ifdef __SSE2__
+#  include "math_vector_sse.h"
+#endif
+
 /********************************* Init **************************************/
 
 void zero_m2(float m[2][2])
@@ -472,6 +476,89 @@ void mul_v3_m4v3(float r[3], float mat[4][4], const float vec[3])
 	r[2] = x * mat[0][2] + y * mat[1][2] + mat[2][2] * vec[2] + mat[3][2];
 }
 
+#ifdef __SSE2__
+/* Each matrix element in all lanes, the first three rows are enough for points. */
+BLI_INLINE void m4_splat_sse(__m128 r_mat[4][3], float mat[4][4])
+{
+	int i, j;
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < 3; j++) {
+			r_mat[i][j] = _mm_set1_ps(mat[i][j]);
+		}
+	}
+}
+
+/* #mul_v3_m4v3 of four vectors, same order of operations so results match exactly. */
+BLI_INLINE void mul_v3_m4v3_x4_sse(
+        __m128 r[3], __m128 mat[4][3],
+        const __m128 x, const __m128 y, const __m128 z)
+{
+	int i;
+	for (i = 0; i < 3; i++) {
+		r[i] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, mat[0][i]), _mm_mul_ps(y, mat[1][i])),
+		                             _mm_mul_ps(mat[2][i], z)),
+		                  mat[3][i]);
+	}
+}
+#endif
+
+/**
+ * #mul_v3_m4v3 for each vector in the array.
+ *
+ * \note \a r_arr and \a vec_arr may be the same array.
+ */
+void mul_v3_m4v3_array(float (*r_arr)[3], float mat[4][4], const float (*vec_arr)[3], int nbr)
+{
+#ifdef __SSE2__
+	__m128 mat_sse[4][3];
+	m4_splat_sse(mat_sse, mat);
+
+	for (; nbr >= 4; r_arr += 4, vec_arr += 4, nbr -= 4) {
+		__m128 x, y, z, r[3];
+		v3_array4_load_sse(vec_arr, &x, &y, &z);
+		mul_v3_m4v3_x4_sse(r, mat_sse, x, y, z);
+		v3_array4_store_sse(r_arr, r[0], r[1], r[2]);
+	}
+#endif
+
+	while (nbr--) {
+		mul_v3_m4v3(*r_arr++, mat, *vec_arr++);
+	}
+}
+
+/** #mul_m4_v3 for each vector in the array. */
+void mul_m4_v3_array(float mat[4][4], float (*vec_arr)[3], int nbr)
+{
+	mul_v3_m4v3_array(vec_arr, mat, (const float (*)[3])vec_arr, nbr);
+}
+
+/** Same as #mul_m4_v3_array with one array per axis. */
+void mul_m4_v3_array_soa(float mat[4][4], float *x, float *y, float *z, int nbr)
+{
+	int i = 0;
+
+#ifdef __SSE2__
+	__m128 mat_sse[4][3];
+	m4_splat_sse(mat_sse, mat);
+
+	for (; i + 4 <= nbr; i += 4) {
+		__m128 r[3];
+		mul_v3_m4v3_x4_sse(r, mat_sse, _mm_loadu_ps(&x[i]), _mm_loadu_ps(&y[i]), _mm_loadu_ps(&z[i]));
+		_mm_storeu_ps(&x[i], r[0]);
+		_mm_storeu_ps(&y[i], r[1]);
+		_mm_storeu_ps(&z[i], r[2]);
+	}
+#endif
+
+	for (; i < nbr; i++) {
+		float v[3] = {x[i], y[i], z[i]};
+		mul_m4_v3(mat, v);
+		x[i] = v[0];
+		y[i] = v[1];
+		z[i] = v[2];
+	}
+}
+
 void mul_v2_m4v3(float r[2], float mat[4][4], const float vec[3])
 {
 	const float x = vec[0];
@@ -31,6 +31,10 @@
 
 #include "BLI_strict_flags.h"
 
+#ifdef __SSE2__
+#  include "math_vector_sse.h"
+#endif
+
 //******************************* Interpolation *******************************/
 
 void interp_v2_v2v2(float target[2], const float a[2], const float b[2], const float t)
@@ -787,11 +791,120 @@ void minmax_v2v2_v2(float min[2], float max[2], const float vec[2])
 
 void minmax_v3v3_v3_array(float r_min[3], float r_max[3], float (*vec_arr)[3], int nbr)
 {
+#ifdef __SSE2__
+	if (nbr >= 4) {
+		/* Per lane min/max of four vectors at a time, no need to reorder the lanes:
+		 * the result are four vectors (12 floats) to merge at the end. */
+		float vec_min[4][3], vec_max[4][3];
+		__m128 min_a = _mm_loadu_ps(&vec_arr[0][0]), max_a = min_a;
+		__m128 min_b = _mm_loadu_ps(&vec_arr[1][1]), max_b = min_b;
+		__m128 min_c = _mm_loadu_ps(&vec_arr[2][2]), max_c = min_c;
+		int i;
+
+		for (vec_arr += 4, nbr -= 4; nbr >= 4; vec_arr += 4, nbr -= 4) {
+			const __m128 a = _mm_loadu_ps(&vec_arr[0][0]);
+			const __m128 b = _mm_loadu_ps(&vec_arr[1][1]);
+			const __m128 c = _mm_loadu_ps(&vec_arr[2][2]);
+			/* operand order keeps the current value for NaN, like #minmax_v3v3_v3 */
+			min_a = _mm_min_ps(a, min_a); max_a = _mm_max_ps(a, max_a);
+			min_b = _mm_min_ps(b, min_b); max_b = _mm_max_ps(b, max_b);
+			min_c = _mm_min_ps(c, min_c); max_c = _mm_max_ps(c, max_c);
+		}
+
+		_mm_storeu_ps(&vec_min[0][0], min_a);
+		_mm_storeu_ps(&vec_min[1][1], min_b);
+		_mm_storeu_ps(&vec_min[2][2], min_c);
+		_mm_storeu_ps(&vec_max[0][0], max_a);
+		_mm_storeu_ps(&vec_max[1][1], max_b);
+		_mm_storeu_ps(&vec_max[2][2], max_c);
+
+		for (i = 0; i < 4; i++) {
+			minmax_v3v3_v3(r_min, r_max, vec_min[i]);
+			minmax_v3v3_v3(r_min, r_max, vec_max[i]);
+		}
+	}
+#endif
+
 	while (nbr--) {
 		minmax_v3v3_v3(r_min, r_max, *vec_arr++);
 	}
 }
 
+/**
+ * Same as #minmax_v3v3_v3_array for vectors which are part of bigger structs.
+ *
+ * \param co: The first vector.
+ * \param stride: Distance in bytes between the vectors, e.g. ``sizeof(MVert)``.
+ */
+void minmax_v3v3_v3_array_stride(float r_min[3], float r_max[3], const float *co, const size_t stride, int nbr)
+{
+	const char *co_iter = (const char *)co;
+
+#ifdef __SSE2__
+	__m128 min = v3_load_sse(r_min);
+	__m128 max = v3_load_sse(r_max);
+
+	for (; nbr--; co_iter += stride) {
+		const __m128 v = v3_load_sse((const float *)co_iter);
+		min = _mm_min_ps(v, min);
+		max = _mm_max_ps(v, max);
+	}
+
+	v3_store_sse(r_min, min);
+	v3_store_sse(r_max, max);
+#else
+	for (; nbr--; co_iter += stride) {
+		minmax_v3v3_v3(r_min, r_max, (const float *)co_iter);
+	}
+#endif
+}
+
+/** Same as #minmax_v3v3_v3_array with one array per axis. */
+void minmax_v3v3_v3_array_soa(
+        float r_min[3], float r_max[3],
+        const float *x, const float *y, const float *z, int nbr)
+{
+	int i = 0;
+
+#ifdef __SSE2__
+	if (nbr >= 4) {
+		float vec_min[3][4], vec_max[3][4];
+		__m128 min_x = _mm_loadu_ps(x), max_x = min_x;
+		__m128 min_y = _mm_loadu_ps(y), max_y = min_y;
+		__m128 min_z = _mm_loadu_ps(z), max_z = min_z;
+		int j;
+
+		for (i = 4; i + 4 <= nbr; i += 4) {
+			const __m128 vx = _mm_loadu_ps(&x[i]);
+			const __m128 vy = _mm_loadu_ps(&y[i]);
+			const __m128 vz = _mm_loadu_ps(&z[i]);
+			min_x = _mm_min_ps(vx, min_x); max_x = _mm_max_ps(vx, max_x);
+			min_y = _mm_min_ps(vy, min_y); max_y = _mm_max_ps(vy, max_y);
+			min_z = _mm_min_ps(vz, min_z); max_z = _mm_max_ps(vz, max_z);
+		}
+
+		_mm_storeu_ps(vec_min[0], min_x);
+		_mm_storeu_ps(vec_min[1], min_y);
+		_mm_storeu_ps(vec_min[2], min_z);
+		_mm_storeu_ps(vec_max[0], max_x);
+		_mm_storeu_ps(vec_max[1], max_y);
+		_mm_storeu_ps(vec_max[2], max_z);
+
+		for (j = 0; j < 4; j++) {
+			const float v_min[3] = {vec_min[0][j], vec_min[1][j], vec_min[2][j]};
+			const float v_max[3] = {vec_max[0][j], vec_max[1][j], vec_max[2][j]};
+			minmax_v3v3_v3(r_min, r_max, v_min);
+			minmax_v3v3_v3(r_min, r_max, v_max);
+		}
+	}
+#endif
+
+	for (; i < nbr; i++) {
+		const float v[3] = {x[i], y[i], z[i]};
+		minmax_v3v3_v3(r_min, r_max, v);
+	}
+}
+
 /** ensure \a v1 is \a dist from \a v2 */
 void dist_ensure_v3_v3fl(float v1[3], const float v2[3], const float dist)
 {
@@ -887,6 +1000,66 @@ float normalize_vn(float *array_tar, const int size)
 	return normalize_vn_vn(array_tar, array_tar, size);
 }
 
+#ifdef __SSE2__
+/* #normalize_v3 of four vectors, with the same precision and zero length threshold. */
+BLI_INLINE void normalize_v3_x4_sse(__m128 *x, __m128 *y, __m128 *z)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(*x, *x), _mm_mul_ps(*y, *y)), _mm_mul_ps(*z, *z));
+	const __m128 is_valid = _mm_cmpgt_ps(d, _mm_set1_ps(1.0e-35f));
+	/* don't divide by zero, the result is masked out anyway */
+	const __m128 len = _mm_or_ps(_mm_and_ps(is_valid, _mm_sqrt_ps(d)), _mm_andnot_ps(is_valid, one));
+	const __m128 len_inv = _mm_div_ps(one, len);
+
+	*x = _mm_and_ps(is_valid, _mm_mul_ps(*x, len_inv));
+	*y = _mm_and_ps(is_valid, _mm_mul_ps(*y, len_inv));
+	*z = _mm_and_ps(is_valid, _mm_mul_ps(*z, len_inv));
+}
+#endif
+
+/** #normalize_v3 for each vector in the array. */
+void normalize_v3_array(float (*vec_arr)[3], int nbr)
+{
+#ifdef __SSE2__
+	for (; nbr >= 4; vec_arr += 4, nbr -= 4) {
+		__m128 x, y, z;
+		v3_array4_load_sse((const float (*)[3])vec_arr, &x, &y, &z);
+		normalize_v3_x4_sse(&x, &y, &z);
+		v3_array4_store_sse(vec_arr, x, y, z);
+	}
+#endif
+
+	while (nbr--) {
+		normalize_v3(*vec_arr++);
+	}
+}
+
+/** Same as #normalize_v3_array with one array per axis. */
+void normalize_v3_array_soa(float *x, float *y, float *z, int nbr)
+{
+	int i = 0;
+
+#ifdef __SSE2__
+	for (; i + 4 <= nbr; i += 4) {
+		__m128 vx = _mm_loadu_ps(&x[i]);
+		__m128 vy = _mm_loadu_ps(&y[i]);
+		__m128 vz = _mm_loadu_ps(&z[i]);
+		normalize_v3_x4_sse(&vx, &vy, &vz);
+		_mm_storeu_ps(&x[i], vx);
+		_mm_storeu_ps(&y[i], vy);
+		_mm_storeu_ps(&z[i], vz);
+	}
+#endif
+
+	for (; i < nbr; i++) {
+		float v[3] = {x[i], y[i], z[i]};
+		normalize_v3(v);
+		x[i] = v[0];
+		y[i] = v[1];
+		z[i] = v[2];
+	}
+}
+
 void range_vn_i(int *array_tar, const int size, const int start)
 {
 	int *array_pt = array_tar + (size - 1);
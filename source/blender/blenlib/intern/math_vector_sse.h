@@ -0,0 +1,79 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/math_vector_sse.h
+ *  \ingroup bli
+ *
+ * SSE2 helpers shared by the array functions of math_vector.c and math_matrix.c.
+ *
+ * Four 3D vectors stored after each other (AoS, 12 floats) are converted to one
+ * register per axis (SoA) and back, so one instruction handles four vectors.
+ */
+
+#ifndef __MATH_VECTOR_SSE_H__
+#define __MATH_VECTOR_SSE_H__
+
+#ifndef __SSE2__
+#  error "Only include this file when SSE2 is available"
+#endif
+
+#include <emmintrin.h>
+
+/* Vectors to SoA, lanes of the loaded registers are: x y z x, y z x y, z x y z. */
+BLI_INLINE void v3_array4_load_sse(const float (*v)[3], __m128 *r_x, __m128 *r_y, __m128 *r_z)
+{
+	const __m128 a = _mm_loadu_ps(&v[0][0]);
+	const __m128 b = _mm_loadu_ps(&v[1][1]);
+	const __m128 c = _mm_loadu_ps(&v[2][2]);
+
+	*r_x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+	*r_y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+	                      _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+	*r_z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+/* SoA back to vectors, the inverse of #v3_array4_load_sse. */
+BLI_INLINE void v3_array4_store_sse(float (*v)[3], const __m128 x, const __m128 y, const __m128 z)
+{
+	const __m128 a = _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)),
+	                                _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+	const __m128 b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)),
+	                                _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+	const __m128 c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)),
+	                                _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+
+	_mm_storeu_ps(&v[0][0], a);
+	_mm_storeu_ps(&v[1][1], b);
+	_mm_storeu_ps(&v[2][2], c);
+}
+
+/* A single vector, the last lane is zero. */
+BLI_INLINE __m128 v3_load_sse(const float v[3])
+{
+	return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)v), _mm_load_ss(&v[2]));
+}
+
+BLI_INLINE void v3_store_sse(float v[3], const __m128 a)
+{
+	_mm_storel_pi((__m64 *)v, a);
+	_mm_store_ss(&v[2], _mm_movehl_ps(a, a));
+}
+
+#endif  /* __MATH_VECTOR_SSE_H__ */
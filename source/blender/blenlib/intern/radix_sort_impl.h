@@ -0,0 +1,139 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/radix_sort_impl.h
+ *  \ingroup bli
+ *
+ * Common implementation of a stable LSD radix sort,
+ * on an array of elements of any size with an integer or float key inside.
+ *
+ * This file is to be directly included in C-source,
+ * with defines to control its use.
+ *
+ * Source file including this must define:
+ * - `SORT_IMPL_KEYTYPE`:
+ *   Type of the key as stored in the element (`int`, `float`...).
+ * - `SORT_IMPL_UKEYTYPE`:
+ *   Unsigned integer type of the same size as the key.
+ * - `SORT_IMPL_KEY_TO_UKEY(k)`:
+ *   Maps a key to an unsigned integer with the same ordering.
+ * - `SORT_IMPL_FUNC`:
+ *   Function name of the sort function.
+ */
+
+/* -------------------------------------------------------------------- */
+/* Handle External Defines */
+
+/* check we're not building directly */
+#if !defined(SORT_IMPL_KEYTYPE) || !defined(SORT_IMPL_UKEYTYPE) || \
+    !defined(SORT_IMPL_KEY_TO_UKEY) || !defined(SORT_IMPL_FUNC)
+#  error "This file can't be compiled directly, include in another source file"
+#endif
+
+#define _CONCAT_AUX(MACRO_ARG1, MACRO_ARG2) MACRO_ARG1 ## MACRO_ARG2
+#define _CONCAT(MACRO_ARG1, MACRO_ARG2) _CONCAT_AUX(MACRO_ARG1, MACRO_ARG2)
+#define _SORT_PREFIX(id) _CONCAT(SORT_IMPL_FUNC, _##id)
+
+/* local identifiers */
+#define ukey_get		_SORT_PREFIX(ukey_get)
+
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_PASSES (sizeof(SORT_IMPL_UKEYTYPE) * 8 / RADIX_BITS)
+
+
+BLI_INLINE SORT_IMPL_UKEYTYPE ukey_get(const char *elem, const size_t key_offset)
+{
+	SORT_IMPL_KEYTYPE k;
+	/* elements may not be aligned for the key type */
+	memcpy(&k, elem + key_offset, sizeof(k));
+	return SORT_IMPL_KEY_TO_UKEY(k);
+}
+
+/**
+ * \param a: Array of \a n elements, \a es bytes each.
+ * \param key_offset: Offset of the key in bytes from the start of each element.
+ */
+void SORT_IMPL_FUNC(void *a, size_t n, size_t es, size_t key_offset)
+{
+	size_t (*counts)[RADIX_SIZE];
+	char *src = a, *dst, *buf;
+	unsigned int pass;
+	size_t i;
+
+	if (n < 2) {
+		return;
+	}
+
+	/* histogram of every digit, in one pass over the keys */
+	counts = MEM_callocN(sizeof(*counts) * RADIX_PASSES, __func__);
+	for (i = 0; i < n; i++) {
+		const SORT_IMPL_UKEYTYPE k = ukey_get(src + i * es, key_offset);
+		for (pass = 0; pass < RADIX_PASSES; pass++) {
+			counts[pass][(k >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+		}
+	}
+
+	buf = dst = MEM_mallocN(n * es, __func__);
+
+	for (pass = 0; pass < RADIX_PASSES; pass++) {
+		const unsigned int shift = pass * RADIX_BITS;
+		size_t *count = counts[pass];
+		size_t offset = 0;
+		unsigned int d;
+
+		/* all keys share this digit, nothing to move */
+		if (count[(ukey_get(src, key_offset) >> shift) & (RADIX_SIZE - 1)] == n) {
+			continue;
+		}
+
+		/* counts to start offsets */
+		for (d = 0; d < RADIX_SIZE; d++) {
+			const size_t c = count[d];
+			count[d] = offset;
+			offset += c;
+		}
+
+		for (i = 0; i < n; i++) {
+			const char *elem = src + i * es;
+			const size_t d_elem = (ukey_get(elem, key_offset) >> shift) & (RADIX_SIZE - 1);
+			memcpy(dst + count[d_elem]++ * es, elem, es);
+		}
+
+		SWAP(char *, src, dst);
+	}
+
+	if (src != a) {
+		memcpy(a, src, n * es);
+	}
+
+	MEM_freeN(buf);
+	MEM_freeN(counts);
+}
+
+#undef _CONCAT_AUX
+#undef _CONCAT
+#undef _SORT_PREFIX
+
+#undef ukey_get
+
+#undef RADIX_BITS
+#undef RADIX_SIZE
+#undef RADIX_PASSES
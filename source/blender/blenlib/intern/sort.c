@@ -31,14 +31,19 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
-#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 8))
-/* do nothing! */
-#else
+#include "MEM_guardedalloc.h"
 
 #include "BLI_utildefines.h"
-
+#include "BLI_math_base.h"
 #include "BLI_sort.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 8))
+/* do nothing! */
+#else
 
 /* note: modified to use glibc arg order for callback */
 /* **** qsort based on FreeBSD source (libkern\qsort.c) **** */
@@ -178,3 +183,224 @@ loop:
 }
 
 #endif  /* __GLIBC__ */
+
+
+/* -------------------------------------------------------------------- */
+/** \name Radix Sort
+ *
+ * Stable, so sorting by the secondary key first and the primary key after that
+ * gives elements ordered by both.
+ * \{ */
+
+#define SORT_IMPL_KEYTYPE unsigned int
+#define SORT_IMPL_UKEYTYPE unsigned int
+#define SORT_IMPL_KEY_TO_UKEY(k) (k)
+#define SORT_IMPL_FUNC BLI_radix_sort_u32
+#include "radix_sort_impl.h"
+#undef SORT_IMPL_FUNC
+#undef SORT_IMPL_KEY_TO_UKEY
+#undef SORT_IMPL_UKEYTYPE
+#undef SORT_IMPL_KEYTYPE
+
+/* flip the sign bit, so negative values come first */
+#define SORT_IMPL_KEYTYPE int
+#define SORT_IMPL_UKEYTYPE unsigned int
+#define SORT_IMPL_KEY_TO_UKEY(k) ((unsigned int)(k) ^ 0x80000000u)
+#define SORT_IMPL_FUNC BLI_radix_sort_i32
+#include "radix_sort_impl.h"
+#undef SORT_IMPL_FUNC
+#undef SORT_IMPL_KEY_TO_UKEY
+#undef SORT_IMPL_UKEYTYPE
+#undef SORT_IMPL_KEYTYPE
+
+#define SORT_IMPL_KEYTYPE uint64_t
+#define SORT_IMPL_UKEYTYPE uint64_t
+#define SORT_IMPL_KEY_TO_UKEY(k) (k)
+#define SORT_IMPL_FUNC BLI_radix_sort_u64
+#include "radix_sort_impl.h"
+#undef SORT_IMPL_FUNC
+#undef SORT_IMPL_KEY_TO_UKEY
+#undef SORT_IMPL_UKEYTYPE
+#undef SORT_IMPL_KEYTYPE
+
+/* IEEE floats: negative values have all bits flipped (reversing their order),
+ * positive ones only the sign bit. */
+BLI_INLINE unsigned int radix_float_to_ukey(const float f)
+{
+	union { float f; unsigned int i; } u;
+	u.f = f;
+	return u.i ^ ((u.i & 0x80000000u) ? 0xffffffffu : 0x80000000u);
+}
+
+#define SORT_IMPL_KEYTYPE float
+#define SORT_IMPL_UKEYTYPE unsigned int
+#define SORT_IMPL_KEY_TO_UKEY(k) radix_float_to_ukey(k)
+#define SORT_IMPL_FUNC BLI_radix_sort_fl
+#include "radix_sort_impl.h"
+#undef SORT_IMPL_FUNC
+#undef SORT_IMPL_KEY_TO_UKEY
+#undef SORT_IMPL_UKEYTYPE
+#undef SORT_IMPL_KEYTYPE
+
+/** \} */
+
+
+/* -------------------------------------------------------------------- */
+/** \name Parallel Merge Sort
+ *
+ * The array is split in one chunk per thread which are sorted with #BLI_qsort_r,
+ * the sorted runs are then merged pairwise until one is left.
+ * Each merge is split at evenly spaced output positions (found with a binary search),
+ * so all threads stay busy for the last merges too.
+ * \{ */
+
+/* Below this, sort in one go. */
+#define MERGESORT_PARALLEL_THRESHOLD 8192
+
+typedef struct MergeSortData {
+	char *src, *dst;
+	size_t n, es;
+	BLI_sort_cmp_t cmp;
+	void *thunk;
+
+	/* length of the runs (chunks at first), the last one can be shorter */
+	size_t run_len;
+	/* number of parts each merge is split into */
+	int merge_parts;
+} MergeSortData;
+
+static void mergesort_chunk_cb(void *userdata, int chunk)
+{
+	MergeSortData *data = userdata;
+	const size_t start = (size_t)chunk * data->run_len;
+
+	if (start < data->n) {
+		const size_t len = MIN2(data->run_len, data->n - start);
+		BLI_qsort_r(data->src + start * data->es, len, data->es, data->cmp, data->thunk);
+	}
+}
+
+/**
+ * Number of elements taken from \a a when the first \a k elements of
+ * the merged output are taken from \a a and \a b.
+ * Elements of \a a go first when equal, keeping the merge stable.
+ */
+static size_t mergesort_corank(
+        const size_t k, const char *a, const size_t a_len, const char *b, const size_t b_len,
+        const MergeSortData *data)
+{
+	size_t lo = (k > b_len) ? k - b_len : 0;
+	size_t hi = MIN2(k, a_len);
+
+	while (lo < hi) {
+		const size_t i = (lo + hi) / 2;
+		const size_t j = k - i;
+		/* a[i] goes before b[j - 1], so more of a is needed */
+		if (data->cmp(a + i * data->es, b + (j - 1) * data->es, data->thunk) <= 0) {
+			lo = i + 1;
+		}
+		else {
+			hi = i;
+		}
+	}
+	return lo;
+}
+
+static void mergesort_merge_cb(void *userdata, int iter)
+{
+	MergeSortData *data = userdata;
+	const size_t es = data->es;
+	const size_t merge = (size_t)(iter / data->merge_parts);
+	const size_t part = (size_t)(iter % data->merge_parts);
+
+	const size_t start = merge * data->run_len * 2;
+	const size_t a_len = (start < data->n) ? MIN2(data->run_len, data->n - start) : 0;
+	const size_t b_len = (start + a_len < data->n) ? MIN2(data->run_len, data->n - start - a_len) : 0;
+	const char *a = data->src + start * es;
+	const char *b = a + a_len * es;
+	const size_t k_start = (a_len + b_len) * part / (size_t)data->merge_parts;
+	const size_t k_end = (a_len + b_len) * (part + 1) / (size_t)data->merge_parts;
+	size_t i, i_end, j, j_end;
+	char *dst = data->dst + (start + k_start) * es;
+
+	if (k_start == k_end) {
+		return;
+	}
+
+	i = mergesort_corank(k_start, a, a_len, b, b_len, data);
+	i_end = mergesort_corank(k_end, a, a_len, b, b_len, data);
+	j = k_start - i;
+	j_end = k_end - i_end;
+
+	while (i < i_end && j < j_end) {
+		if (data->cmp(a + i * es, b + j * es, data->thunk) <= 0) {
+			memcpy(dst, a + i++ * es, es);
+		}
+		else {
+			memcpy(dst, b + j++ * es, es);
+		}
+		dst += es;
+	}
+	if (i < i_end) {
+		memcpy(dst, a + i * es, (i_end - i) * es);
+	}
+	else if (j < j_end) {
+		memcpy(dst, b + j * es, (j_end - j) * es);
+	}
+}
+
+/**
+ * Sort using all threads of the task scheduler,
+ * a drop-in replacement for #BLI_qsort_r on big arrays.
+ *
+ * \note Not stable (like qsort).
+ */
+void BLI_mergesort_parallel_r(void *a, size_t n, size_t es, BLI_sort_cmp_t cmp, void *thunk)
+{
+	MergeSortData data;
+	char *buf;
+	int chunks_num, runs_num, num_threads;
+
+	num_threads = BLI_task_scheduler_num_threads(BLI_task_scheduler_get());
+
+	if (n < MERGESORT_PARALLEL_THRESHOLD || num_threads < 2) {
+		BLI_qsort_r(a, n, es, cmp, thunk);
+		return;
+	}
+
+	/* power of two, so runs pair up evenly */
+	chunks_num = (int)power_of_2_max_u((unsigned int)num_threads);
+	while ((size_t)chunks_num > 2 && n / (size_t)chunks_num < MERGESORT_PARALLEL_THRESHOLD / 2) {
+		chunks_num /= 2;
+	}
+
+	buf = MEM_mallocN(n * es, __func__);
+
+	data.src = a;
+	data.dst = buf;
+	data.n = n;
+	data.es = es;
+	data.cmp = cmp;
+	data.thunk = thunk;
+	data.run_len = (n + (size_t)chunks_num - 1) / (size_t)chunks_num;
+	data.merge_parts = 1;
+
+	BLI_task_parallel_range_ex(0, chunks_num, &data, mergesort_chunk_cb, 0, false);
+
+	/* every round the same number of tasks, fewer merges split in more parts */
+	for (runs_num = chunks_num; runs_num > 1; runs_num /= 2) {
+		data.merge_parts *= 2;
+		BLI_task_parallel_range_ex(0, chunks_num, &data, mergesort_merge_cb, 0, false);
+
+		data.run_len *= 2;
+		SWAP(char *, data.src, data.dst);
+	}
+
+	if (data.src != a) {
+		memcpy(a, data.src, n * es);
+	}
+
+	MEM_freeN(buf);
+}
+
+/** \} */
@@ -546,10 +546,10 @@ void BLI_task_parallel_range_ex(
 	ParallelRangeState state;
 	int i, num_threads, num_tasks;
 
-	BLI_assert(start < stop);
+	BLI_assert(start <= stop);
 
 	/* If it's not enough data to be crunched, don't bother with tasks at all,
-	 * do everything from the main thread.
+	 * do everything from the main thread (this also handles empty ranges).
 	 */
 	if (stop - start < range_threshold) {
 		for (i = start; i < stop; ++i) {
@@ -578,7 +578,8 @@ void BLI_task_parallel_range_ex(
 		state.chunk_size = 32;
 	}
 	else {
-		state.chunk_size = (stop - start) / (num_tasks);
+		/* Ranges smaller than the number of tasks would give empty chunks and never advance. */
+		state.chunk_size = max_ii(1, (stop - start) / (num_tasks));
 	}
 
 	for (i = 0; i < num_tasks; i++) {
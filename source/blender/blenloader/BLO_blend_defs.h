@@ -77,4 +77,35 @@ enum {
 
 #define BLEN_THUMB_MEMSIZE_FILE(_x, _y) (sizeof(int) * (size_t)(2 + (_x) * (_y)))
 
+/**
+ * Table of contents, written after the #ENDB block of regular (not undo) files,
+ * so the datablocks of a file can be listed without reading it all
+ * (files of older versions and compressed files are scanned instead).
+ *
+ * <pre>
+ * ENDB, BlendFileTocEntry[entries_num], BlendFileTocTail
+ * </pre>
+ *
+ * Stored in the endianness of the file, offsets are from the start of the file.
+ */
+typedef struct BlendFileTocEntry {
+	/* the ID's #BHead, and the size of the ID with all its DATA blocks */
+	uint64_t offset, size;
+	/* pixels of the preview sizes (see #PreviewImage), zero if not saved */
+	uint64_t preview_offset[2];
+	int code;
+	unsigned int preview_w[2], preview_h[2];
+	char name[66];  /* MAX_ID_NAME */
+	char pad[2];
+} BlendFileTocEntry;
+
+#define BLEND_TOC_MAGIC "BLENDTOC"
+
+typedef struct BlendFileTocTail {
+	/* of the first entry */
+	uint64_t offset;
+	unsigned int entries_num, entry_size;
+	char magic[8];  /* BLEND_TOC_MAGIC, not terminated */
+} BlendFileTocTail;
+
 #endif  /* __BLO_BLEND_DEFS_H__ */
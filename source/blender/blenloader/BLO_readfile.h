@@ -101,12 +101,21 @@ BlendFileData *BLO_read_from_memory(
 
 /**
  * oldmain is old main, from which we will keep libraries, images, ..
- * file name is current file, only for retrieving library data */
+ * file name is current file, only for retrieving library data
+ * oldmemfile is the undo memfile oldmain was read from or written to (optional),
+ * IDs oldmain still stores the same as memfile are kept too */
 
 BlendFileData *BLO_read_from_memfile(
-        struct Main *oldmain, const char *filename, struct MemFile *memfile,
+        struct Main *oldmain, const char *filename, struct MemFile *memfile, struct MemFile *oldmemfile,
         struct ReportList *reports);
 
+/**
+ * \a main was just read from \a memfile (undo): write it again, its IDs and ID pointers
+ * aren't the ones stored in \a memfile, to find the IDs changed before it's read again
+ * (see #BLO_read_from_memfile).
+ */
+void BLO_memfile_main_read(struct MemFile *memfile, struct Main *main);
+
 /**
  * Free's a BlendFileData structure and _all_ the
  * data associated with it (the userdef data, and
@@ -128,6 +137,18 @@ BlendHandle *BLO_blendhandle_from_file(
         const char *filepath,
         struct ReportList *reports);
 
+/**
+ * Open a blendhandle from a file path, only to list the datablocks of the file
+ * (reading just its table of contents when it has one). It can't be used for appending.
+ *
+ * \param filepath: The file path to open.
+ * \param reports: Report errors in opening the file (can be NULL).
+ * \return A handle on success, or NULL on failure.
+ */
+BlendHandle *BLO_blendhandle_from_file_toc(
+        const char *filepath,
+        struct ReportList *reports);
+
 /**
  * Open a blendhandle from memory.
  *
@@ -253,6 +274,12 @@ void BLO_library_append_all(struct Main *mainl, BlendHandle *bh);
 
 void *BLO_library_read_struct(struct FileData *fd, struct BHead *bh, const char *blockname);
 
+/**
+ * Free the library files kept open after reading them (see read_libraries),
+ * call on exit.
+ */
+void BLO_library_cache_free(void);
+
 BlendFileData *blo_read_blendafterruntime(int file, const char *name, int actualsize, struct ReportList *reports);
 
 /* internal function but we need to expose it */
@@ -33,25 +33,44 @@
  *  \ingroup blenloader
  */
 
+typedef struct MemFileBuf MemFileBuf;
+
 typedef struct {
 	void *next, *prev;
 	
-	char *buf;
+	const char *buf;
+	/* ident: the buffer is the same as the chunk at this place in the memfile compared to */
 	unsigned int ident, size;
+	/* shared (reference counted) buffer, buf points to its data */
+	MemFileBuf *mbuf;
+	/* address of the ID this chunk starts (when written for undo), NULL for the following chunks */
+	const void *id;
 	
 } MemFileChunk;
 
 typedef struct MemFile {
 	ListBase chunks;
+	/* first chunk of every ID (key is the ID address when written), see memfile_chunk_id_begin */
+	struct GHash *id_chunks;
+	/* when a main was read from this memfile: that main written right after,
+	 * with its own ID addresses, see BLO_memfile_main_read */
+	struct MemFile *main_read;
+	/* size of the buffers added for this memfile, not shared with others written before */
 	unsigned int size;
 } MemFile;
 
 /* actually only used writefile.c */
 extern void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size);
+extern void memfile_chunk_id_begin(const void *id);
+
+/* actually only used readfile.c */
+extern bool memfile_id_is_identical(const MemFile *memfile, const MemFile *memfile_other,
+                                    const void *id, const void *bhead, unsigned int bhead_size);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
 extern void BLO_memfile_merge(MemFile *first, MemFile *second);
+extern void BLO_memfile_copy_shared(const MemFile *memfile, MemFile *r_memfile);
 
 #endif
 
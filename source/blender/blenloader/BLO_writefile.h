@@ -38,9 +38,18 @@ struct MemFile;
 struct Main;
 struct ReportList;
 
+typedef struct BlendFileSnapshot BlendFileSnapshot;
+
 extern int BLO_write_file(struct Main *mainvar, const char *filepath, int write_flags,
         struct ReportList *reports, const struct BlendThumbnail *thumb);
 extern int BLO_write_file_mem(struct Main *mainvar, struct MemFile *compare, struct MemFile *current, int write_flags);
 
+extern BlendFileSnapshot *BLO_write_file_snapshot(struct Main *mainvar, const char *filepath, int write_flags,
+        struct ReportList *reports, const struct BlendThumbnail *thumb);
+extern BlendFileSnapshot *BLO_write_file_snapshot_memfile(const struct MemFile *memfile, const char *filepath,
+        int write_flags);
+extern int BLO_write_file_snapshot_save(const BlendFileSnapshot *snapshot, struct ReportList *reports);
+extern void BLO_write_file_snapshot_free(BlendFileSnapshot *snapshot);
+
 #endif
 
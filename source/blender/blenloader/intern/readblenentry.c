@@ -51,12 +51,14 @@
 #include "DNA_sdna_types.h"
 
 
+#include "BKE_global.h"
 #include "BKE_main.h"
 #include "BKE_library.h" // for BKE_main_free
 #include "BKE_idcode.h"
 
 #include "BLO_readfile.h"
 #include "BLO_undofile.h"
+#include "BLO_writefile.h"
 #include "BLO_blend_defs.h"
 
 #include "readfile.h"
@@ -81,6 +83,18 @@ BlendHandle *BLO_blendhandle_from_file(const char *filepath, ReportList *reports
 	return bh;
 }
 
+BlendHandle *BLO_blendhandle_from_file_toc(const char *filepath, ReportList *reports)
+{
+	BlendHandle *bh;
+
+	bh = (BlendHandle *)blo_openblenderfile_toc(filepath);
+	if (bh == NULL) {
+		bh = (BlendHandle *)blo_openblenderfile(filepath, reports);
+	}
+
+	return bh;
+}
+
 BlendHandle *BLO_blendhandle_from_memory(const void *mem, int memsize)
 {
 	BlendHandle *bh;
@@ -95,6 +109,16 @@ void BLO_blendhandle_print_sizes(BlendHandle *bh, void *fp)
 	FileData *fd = (FileData *) bh;
 	BHead *bhead;
 
+	if (fd->toc) {
+		/* sizes are printed for each block, the table of contents only has whole IDs */
+		FileData *fd_blocks = blo_openblenderfile(fd->relabase, NULL);
+		if (fd_blocks) {
+			BLO_blendhandle_print_sizes((BlendHandle *)fd_blocks, fp);
+			blo_freefiledata(fd_blocks);
+		}
+		return;
+	}
+
 	fprintf(fp, "[\n");
 	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
 		if (bhead->code == ENDB)
@@ -127,6 +151,18 @@ LinkNode *BLO_blendhandle_get_datablock_names(BlendHandle *bh, int ofblocktype,
 	BHead *bhead;
 	int tot = 0;
 
+	if (fd->toc) {
+		int i;
+		for (i = 0; i < fd->toc_num; i++) {
+			if (fd->toc[i].code == ofblocktype) {
+				BLI_linklist_prepend(&names, strdup(fd->toc[i].name + 2));
+				tot++;
+			}
+		}
+		*tot_names = tot;
+		return names;
+	}
+
 	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
 		if (bhead->code == ofblocktype) {
 			const char *idname = bhead_id_name(fd, bhead);
@@ -142,6 +178,64 @@ LinkNode *BLO_blendhandle_get_datablock_names(BlendHandle *bh, int ofblocktype,
 	return names;
 }
 
+static bool blendhandle_idcode_has_preview(int idcode)
+{
+	switch (idcode) {
+		case ID_MA: /* fall through */
+		case ID_TE: /* fall through */
+		case ID_IM: /* fall through */
+		case ID_WO: /* fall through */
+		case ID_LA: /* fall through */
+		case ID_OB: /* fall through */
+		case ID_GR: /* fall through */
+		case ID_SCE: /* fall through */
+			return true;
+		default:
+			return false;
+	}
+}
+
+/* only the pixels are read, from the offsets in the table of contents */
+static int blendhandle_toc_get_previews(FileData *fd, int ofblocktype, LinkNode **previews)
+{
+	int tot = 0, i, j;
+
+	if (!blendhandle_idcode_has_preview(ofblocktype)) {
+		return 0;
+	}
+
+	for (i = 0; i < fd->toc_num; i++) {
+		const BlendFileTocEntry *entry = &fd->toc[i];
+		PreviewImage *new_prv;
+
+		if (entry->code != ofblocktype) {
+			continue;
+		}
+
+		new_prv = MEM_callocN(sizeof(PreviewImage), "newpreview");
+		BLI_linklist_prepend(previews, new_prv);
+		tot++;
+
+		for (j = 0; j < NUM_ICON_SIZES; j++) {
+			const size_t len = (size_t)entry->preview_w[j] * (size_t)entry->preview_h[j] * sizeof(unsigned int);
+
+			if (entry->preview_offset[j] && len) {
+				new_prv->rect[j] = MEM_mallocN(len, __func__);
+				if (blo_toc_read_data(fd, entry->preview_offset[j], new_prv->rect[j], len)) {
+					new_prv->w[j] = entry->preview_w[j];
+					new_prv->h[j] = entry->preview_h[j];
+				}
+				else {
+					MEM_freeN(new_prv->rect[j]);
+					new_prv->rect[j] = NULL;
+				}
+			}
+		}
+	}
+
+	return tot;
+}
+
 LinkNode *BLO_blendhandle_get_previews(BlendHandle *bh, int ofblocktype, int *tot_prev)
 {
 	FileData *fd = (FileData *) bh;
@@ -152,25 +246,19 @@ LinkNode *BLO_blendhandle_get_previews(BlendHandle *bh, int ofblocktype, int *to
 	PreviewImage *new_prv = NULL;
 	int tot = 0;
 
+	if (fd->toc) {
+		*tot_prev = blendhandle_toc_get_previews(fd, ofblocktype, &previews);
+		return previews;
+	}
+
 	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
 		if (bhead->code == ofblocktype) {
 			const char *idname = bhead_id_name(fd, bhead);
-			switch (GS(idname)) {
-				case ID_MA: /* fall through */
-				case ID_TE: /* fall through */
-				case ID_IM: /* fall through */
-				case ID_WO: /* fall through */
-				case ID_LA: /* fall through */
-				case ID_OB: /* fall through */
-				case ID_GR: /* fall through */
-				case ID_SCE: /* fall through */
-					new_prv = MEM_callocN(sizeof(PreviewImage), "newpreview");
-					BLI_linklist_prepend(&previews, new_prv);
-					tot++;
-					looking = 1;
-					break;
-				default:
-					break;
+			if (blendhandle_idcode_has_preview(GS(idname))) {
+				new_prv = MEM_callocN(sizeof(PreviewImage), "newpreview");
+				BLI_linklist_prepend(&previews, new_prv);
+				tot++;
+				looking = 1;
 			}
 		}
 		else if (bhead->code == DATA) {
@@ -232,6 +320,20 @@ LinkNode *BLO_blendhandle_get_previews(BlendHandle *bh, int ofblocktype, int *to
 	return previews;
 }
 
+static void blendhandle_linkable_group_add(LinkNode **names, GSet *gathered, int code)
+{
+	if (BKE_idcode_is_valid(code)) {
+		if (BKE_idcode_is_linkable(code)) {
+			const char *str = BKE_idcode_to_name(code);
+			
+			if (!BLI_gset_haskey(gathered, (void *)str)) {
+				BLI_linklist_prepend(names, strdup(str));
+				BLI_gset_insert(gathered, (void *)str);
+			}
+		}
+	}
+}
+
 LinkNode *BLO_blendhandle_get_linkable_groups(BlendHandle *bh) 
 {
 	FileData *fd = (FileData *) bh;
@@ -239,19 +341,18 @@ LinkNode *BLO_blendhandle_get_linkable_groups(BlendHandle *bh)
 	LinkNode *names = NULL;
 	BHead *bhead;
 	
-	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
-		if (bhead->code == ENDB) {
-			break;
+	if (fd->toc) {
+		int i;
+		for (i = 0; i < fd->toc_num; i++) {
+			blendhandle_linkable_group_add(&names, gathered, fd->toc[i].code);
 		}
-		else if (BKE_idcode_is_valid(bhead->code)) {
-			if (BKE_idcode_is_linkable(bhead->code)) {
-				const char *str = BKE_idcode_to_name(bhead->code);
-				
-				if (!BLI_gset_haskey(gathered, (void *)str)) {
-					BLI_linklist_prepend(&names, strdup(str));
-					BLI_gset_insert(gathered, (void *)str);
-				}
+	}
+	else {
+		for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
+			if (bhead->code == ENDB) {
+				break;
 			}
+			blendhandle_linkable_group_add(&names, gathered, bhead->code);
 		}
 	}
 	
@@ -299,11 +400,21 @@ BlendFileData *BLO_read_from_memory(const void *mem, int memsize, ReportList *re
 	return bfd;
 }
 
-BlendFileData *BLO_read_from_memfile(Main *oldmain, const char *filename, MemFile *memfile, ReportList *reports)
+BlendFileData *BLO_read_from_memfile(
+        Main *oldmain, const char *filename, MemFile *memfile, MemFile *oldmemfile,
+        ReportList *reports)
 {
 	BlendFileData *bfd = NULL;
 	FileData *fd;
 	ListBase mainlist;
+	MemFile memfile_oldmain;
+	
+	/* oldmain can have changed since it was written to or read from oldmemfile
+	 * (operators without undo, scripts), write it again to only keep the IDs which didn't */
+	if (oldmemfile) {
+		memset(&memfile_oldmain, 0, sizeof(memfile_oldmain));
+		BLO_write_file_mem(oldmain, oldmemfile, &memfile_oldmain, G.fileflags);
+	}
 	
 	fd = blo_openblendermemfile(memfile, reports);
 	if (fd) {
@@ -329,8 +440,18 @@ BlendFileData *BLO_read_from_memfile(Main *oldmain, const char *filename, MemFil
 		
 		/* removed packed data from this trick - it's internal data that needs saves */
 		
+		/* makes lookup of IDs in old main which can be kept */
+		if (oldmemfile) {
+			blo_make_undo_reuse_map(fd, oldmain, oldmemfile, &memfile_oldmain);
+		}
+		
 		bfd = blo_read_file_internal(fd, filename);
 		
+		/* moves kept IDs and derived data to the new main */
+		if (bfd && fd->undo_old_ids) {
+			blo_end_undo_reuse_map(fd, bfd->main);
+		}
+		
 		/* ensures relinked images are not freed */
 		blo_end_image_pointer_map(fd, oldmain);
 		
@@ -355,10 +476,34 @@ BlendFileData *BLO_read_from_memfile(Main *oldmain, const char *filename, MemFil
 		
 		blo_freefiledata(fd);
 	}
+	
+	if (oldmemfile) {
+		BLO_memfile_free(&memfile_oldmain);
+		
+		/* oldmain is replaced, see BLO_memfile_main_read */
+		if (bfd && oldmemfile->main_read) {
+			BLO_memfile_free(oldmemfile->main_read);
+			MEM_freeN(oldmemfile->main_read);
+			oldmemfile->main_read = NULL;
+		}
+	}
 
 	return bfd;
 }
 
+void BLO_memfile_main_read(MemFile *memfile, Main *main)
+{
+	if (memfile->main_read) {
+		BLO_memfile_free(memfile->main_read);
+	}
+	else {
+		memfile->main_read = MEM_callocN(sizeof(*memfile->main_read), __func__);
+	}
+	
+	/* only the blocks with pointers don't share the buffers of memfile */
+	BLO_write_file_mem(main, memfile, memfile->main_read, G.fileflags);
+}
+
 void BLO_blendfiledata_free(BlendFileData *bfd)
 {
 	if (bfd->main) {
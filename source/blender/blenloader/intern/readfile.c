@@ -45,6 +45,7 @@
 #include "BLI_utildefines.h"
 #ifndef WIN32
 #  include <unistd.h> // for read close
+#  include <sys/mman.h> // for mmap munmap
 #else
 #  include <io.h> // for open close read
 #  include "winsock2.h"
@@ -105,12 +106,16 @@
 
 #include "BLI_endian_switch.h"
 #include "BLI_blenlib.h"
+#include "BLI_gzip_frames.h"
 #include "BLI_math.h"
 #include "BLI_threads.h"
+#include "BLI_task.h"
 #include "BLI_mempool.h"
 
 #include "BLT_translation.h"
 
+#include "PIL_time.h"
+
 #include "BKE_action.h"
 #include "BKE_armature.h"
 #include "BKE_brush.h"
@@ -210,6 +215,15 @@
 /* use GHash for BHead name-based lookups (speeds up linking) */
 #define USE_GHASH_BHEAD
 
+/* run direct_link of independent datablocks in parallel, after all blocks are read,
+ * off until the speedup is measured on machines with several cores */
+// #define USE_PARALLEL_DIRECT_LINK
+
+/* map uncompressed files into memory instead of reading every block (speeds up loading) */
+#ifndef WIN32
+#  define USE_BHEAD_MMAP
+#endif
+
 /***/
 
 typedef struct OldNew {
@@ -220,8 +234,11 @@ typedef struct OldNew {
 typedef struct OldNewMap {
 	OldNew *entries;
 	int nentries, entriessize;
-	int sorted;
 	int lasthit;
+	/* Index into entries for each old address (open addressing, -1 for empty slots),
+	 * twice as many slots as entriessize, see #oldnewmap_lookup_entry. */
+	int *map;
+	int map_size_exp;
 } OldNewMap;
 
 
@@ -264,30 +281,66 @@ static const char *library_parent_filepath(Library *lib)
 	return lib->parent ? lib->parent->filepath : "<direct>";
 }
 
-static OldNewMap *oldnewmap_new(void) 
+/* small, the data map is cleared (and shrunk) for every ID */
+#define OLDNEWMAP_DEFAULT_SIZE_EXP 6
+
+BLI_INLINE unsigned int oldnewmap_hash(const void *addr, const int map_size_exp)
 {
-	OldNewMap *onm= MEM_callocN(sizeof(*onm), "OldNewMap");
-	
-	onm->entriessize = 1024;
-	onm->entries = MEM_mallocN(sizeof(*onm->entries)*onm->entriessize, "OldNewMap.entries");
+	/* Fibonacci hashing, old addresses are aligned so the low bits are not used as is */
+	return (unsigned int)(((uint64_t)(uintptr_t)addr * UINT64_C(11400714819323198485)) >> (64 - map_size_exp));
+}
+
+static void oldnewmap_map_insert(OldNewMap *onm, const void *addr, int index)
+{
+	const unsigned int mask = (1u << onm->map_size_exp) - 1;
+	unsigned int slot = oldnewmap_hash(addr, onm->map_size_exp);
 	
-	return onm;
+	while (onm->map[slot] != -1) {
+		/* the same old address twice (happens for libdata), last one wins */
+		if (onm->entries[onm->map[slot]].old == addr) {
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	onm->map[slot] = index;
 }
 
-static int verg_oldnewmap(const void *v1, const void *v2)
+/* (re)create the map for the current entries */
+static void oldnewmap_map_build(OldNewMap *onm, int map_size_exp)
 {
-	const struct OldNew *x1=v1, *x2=v2;
+	int i;
 	
-	if (x1->old > x2->old) return 1;
-	else if (x1->old < x2->old) return -1;
-	return 0;
+	if (onm->map == NULL || map_size_exp != onm->map_size_exp) {
+		MEM_SAFE_FREE(onm->map);
+		onm->map = MEM_mallocN(sizeof(*onm->map) << map_size_exp, "OldNewMap.map");
+		onm->map_size_exp = map_size_exp;
+	}
+	memset(onm->map, -1, sizeof(*onm->map) << map_size_exp);
+	
+	for (i = 0; i < onm->nentries; i++) {
+		oldnewmap_map_insert(onm, onm->entries[i].old, i);
+	}
 }
 
+static void oldnewmap_init_data(OldNewMap *onm, int size_exp)
+{
+	MEM_SAFE_FREE(onm->entries);
+	
+	onm->nentries = 0;
+	onm->lasthit = 0;
+	onm->entriessize = 1 << size_exp;
+	onm->entries = MEM_mallocN(sizeof(*onm->entries) * onm->entriessize, "OldNewMap.entries");
+	
+	oldnewmap_map_build(onm, size_exp + 1);
+}
 
-static void oldnewmap_sort(FileData *fd) 
+static OldNewMap *oldnewmap_new(void) 
 {
-	qsort(fd->libmap->entries, fd->libmap->nentries, sizeof(OldNew), verg_oldnewmap);
-	fd->libmap->sorted = 1;
+	OldNewMap *onm= MEM_callocN(sizeof(*onm), "OldNewMap");
+	
+	oldnewmap_init_data(onm, OLDNEWMAP_DEFAULT_SIZE_EXP);
+	
+	return onm;
 }
 
 /* nr is zero for data, and ID code for libdata */
@@ -300,12 +353,15 @@ static void oldnewmap_insert(OldNewMap *onm, void *oldaddr, void *newaddr, int n
 	if (UNLIKELY(onm->nentries == onm->entriessize)) {
 		onm->entriessize *= 2;
 		onm->entries = MEM_reallocN(onm->entries, sizeof(*onm->entries) * onm->entriessize);
+		oldnewmap_map_build(onm, onm->map_size_exp + 1);
 	}
 
-	entry = &onm->entries[onm->nentries++];
+	entry = &onm->entries[onm->nentries];
 	entry->old = oldaddr;
 	entry->newp = newaddr;
 	entry->nr = nr;
+	
+	oldnewmap_map_insert(onm, oldaddr, onm->nentries++);
 }
 
 void blo_do_versions_oldnewmap_insert(OldNewMap *onm, void *oldaddr, void *newaddr, int nr)
@@ -314,52 +370,26 @@ void blo_do_versions_oldnewmap_insert(OldNewMap *onm, void *oldaddr, void *newad
 }
 
 /**
- * Do a full search (no state).
- *
- * \param lasthit: Use as a reference position to avoid a full search
- * from either end of the array, giving more efficient lookups.
+ * Find the entry of an old address, -1 when there is none.
  *
- * \note This would seem an ideal case for hash or btree lookups.
- * However the data is written in-order, using the \a lasthit will normally avoid calling this function.
- * Creating a btree/hash structure adds overhead for the common-case to optimize the corner-case
- * (since most entries will never be retrieved).
- * So just keep full lookups as a fall-back.
+ * \note Data is mostly looked up in the order it was written (see \a lasthit),
+ * but not always: lists linked in another order than written, libdata,
+ * and files with many small blocks (particle caches, keyframes) would make
+ * searching the entries quadratic, so a hash is kept next to them.
  */
-static int oldnewmap_lookup_entry_full(const OldNewMap *onm, const void *addr, int lasthit)
+static int oldnewmap_lookup_entry(const OldNewMap *onm, const void *addr)
 {
-	const int nentries = onm->nentries;
-	const OldNew *entries = onm->entries;
-	int i;
-
-	/* search relative to lasthit where possible */
-	if (lasthit >= 0 && lasthit < nentries) {
-
-		/* search forwards */
-		i = lasthit;
-		while (++i != nentries) {
-			if (entries[i].old == addr) {
-				return i;
-			}
-		}
-
-		/* search backwards */
-		i = lasthit + 1;
-		while (i--) {
-			if (entries[i].old == addr) {
-				return i;
-			}
-		}
-	}
-	else {
-		/* search backwards (full) */
-		i = nentries;
-		while (i--) {
-			if (entries[i].old == addr) {
-				return i;
-			}
+	const unsigned int mask = (1u << onm->map_size_exp) - 1;
+	unsigned int slot = oldnewmap_hash(addr, onm->map_size_exp);
+	int index;
+	
+	while ((index = onm->map[slot]) != -1) {
+		if (onm->entries[index].old == addr) {
+			return index;
 		}
+		slot = (slot + 1) & mask;
 	}
-
+	
 	return -1;
 }
 
@@ -379,7 +409,7 @@ static void *oldnewmap_lookup_and_inc(OldNewMap *onm, void *addr, bool increase_
 		}
 	}
 	
-	i = oldnewmap_lookup_entry_full(onm, addr, onm->lasthit);
+	i = oldnewmap_lookup_entry(onm, addr);
 	if (i != -1) {
 		OldNew *entry = &onm->entries[i];
 		BLI_assert(entry->old == addr);
@@ -395,38 +425,22 @@ static void *oldnewmap_lookup_and_inc(OldNewMap *onm, void *addr, bool increase_
 /* for libdata, nr has ID code, no increment */
 static void *oldnewmap_liblookup(OldNewMap *onm, void *addr, void *lib)
 {
+	int i;
+	
 	if (addr == NULL) {
 		return NULL;
 	}
-
-	/* lasthit works fine for non-libdata, linking there is done in same sequence as writing */
-	if (onm->sorted) {
-		OldNew entry_s, *entry;
-
-		entry_s.old = addr;
-
-		entry = bsearch(&entry_s, onm->entries, onm->nentries, sizeof(OldNew), verg_oldnewmap);
-		if (entry) {
-			ID *id = entry->newp;
-
-			if (id && (!lib || id->lib)) {
-				return id;
-			}
-		}
-	}
-	else {
-		/* note, this can be a bottle neck when loading some files */
-		const int i = oldnewmap_lookup_entry_full(onm, addr, -1);
-		if (i != -1) {
-			OldNew *entry = &onm->entries[i];
-			ID *id = entry->newp;
-			BLI_assert(entry->old == addr);
-			if (id && (!lib || id->lib)) {
-				return id;
-			}
+	
+	i = oldnewmap_lookup_entry(onm, addr);
+	if (i != -1) {
+		OldNew *entry = &onm->entries[i];
+		ID *id = entry->newp;
+		BLI_assert(entry->old == addr);
+		if (id && (!lib || id->lib)) {
+			return id;
 		}
 	}
-
+	
 	return NULL;
 }
 
@@ -445,13 +459,21 @@ static void oldnewmap_free_unused(OldNewMap *onm)
 
 static void oldnewmap_clear(OldNewMap *onm) 
 {
-	onm->nentries = 0;
-	onm->lasthit = 0;
+	/* don't keep (and clear) big arrays after an ID with lots of data */
+	if (onm->entriessize > (1 << OLDNEWMAP_DEFAULT_SIZE_EXP)) {
+		oldnewmap_init_data(onm, OLDNEWMAP_DEFAULT_SIZE_EXP);
+	}
+	else {
+		onm->nentries = 0;
+		onm->lasthit = 0;
+		memset(onm->map, -1, sizeof(*onm->map) << onm->map_size_exp);
+	}
 }
 
 static void oldnewmap_free(OldNewMap *onm) 
 {
 	MEM_freeN(onm->entries);
+	MEM_freeN(onm->map);
 	MEM_freeN(onm);
 }
 
@@ -804,6 +826,10 @@ BHead *blo_firstbhead(FileData *fd)
 	BHeadN *new_bhead;
 	BHead *bhead = NULL;
 	
+	if (fd->mmap_bheads) {
+		return fd->mmap_bheads[0];
+	}
+	
 	/* Rewind the file
 	 * Read in a new block if necessary
 	 */
@@ -819,10 +845,24 @@ BHead *blo_firstbhead(FileData *fd)
 	return(bhead);
 }
 
-BHead *blo_prevbhead(FileData *UNUSED(fd), BHead *thisblock)
+BHead *blo_prevbhead(FileData *fd, BHead *thisblock)
 {
-	BHeadN *bheadn = (BHeadN *)POINTER_OFFSET(thisblock, -offsetof(BHeadN, bhead));
-	BHeadN *prev = bheadn->prev;
+	BHeadN *bheadn, *prev;
+	
+	if (fd->mmap_bheads) {
+		/* binary search, the BHeads are in file order */
+		int lo = 0, hi = fd->mmap_bheads_num - 1;
+		while (lo < hi) {
+			const int mid = (lo + hi) / 2;
+			if (fd->mmap_bheads[mid] < thisblock) lo = mid + 1;
+			else hi = mid;
+		}
+		BLI_assert(fd->mmap_bheads[lo] == thisblock);
+		return (lo > 0) ? fd->mmap_bheads[lo - 1] : NULL;
+	}
+	
+	bheadn = (BHeadN *)POINTER_OFFSET(thisblock, -offsetof(BHeadN, bhead));
+	prev = bheadn->prev;
 	
 	return (prev) ? &prev->bhead : NULL;
 }
@@ -832,6 +872,14 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 	BHeadN *new_bhead = NULL;
 	BHead *bhead = NULL;
 	
+	if (fd->mmap_bheads) {
+		/* the data is followed by the next BHead, ENDB is always the last one */
+		if (thisblock && thisblock->code != ENDB) {
+			bhead = (BHead *)POINTER_OFFSET(thisblock + 1, thisblock->len);
+		}
+		return bhead;
+	}
+	
 	if (thisblock) {
 		/* bhead is actually a sub part of BHeadN
 		 * We calculate the BHeadN pointer from the BHead pointer below */
@@ -1052,6 +1100,177 @@ static int fd_read_from_memfile(FileData *filedata, void *buffer, unsigned int s
 	return 0;
 }
 
+static int fd_read_from_mmap(FileData *filedata, void *buffer, unsigned int size)
+{
+	/* only used for the file header, the blocks are used in place */
+	const size_t readsize = MIN2((size_t)size, filedata->mmap_size - (size_t)filedata->seek);
+	
+	memcpy(buffer, filedata->mmap_mem + filedata->seek, readsize);
+	filedata->seek += (int)readsize;
+	
+	return (int)readsize;
+}
+
+/**
+ * Index the BHeads of a whole file in memory, to use them in place without copying.
+ * #read_struct then copies the data straight from \a mem.
+ *
+ * Only done when the file was written with our pointer size and endianness,
+ * since then the BHeads in the file are the same as ours.
+ * Anything else (older or damaged files) keeps reading the regular way.
+ */
+static bool fd_bheads_in_place_init(FileData *fd, char *mem, size_t size)
+{
+	const int endian_test = 1;
+	const char header_pointer = (sizeof(void *) == 8) ? '-' : '_';
+	const char header_endian = (((const char *)&endian_test)[0] == 1) ? 'v' : 'V';
+	size_t offset;
+	int bheads_num, i;
+	bool is_valid = false;
+	
+	if (size < SIZEOFBLENDERHEADER + sizeof(BHead)) {
+		return false;
+	}
+	
+	if (!STREQLEN(mem, "BLENDER", 7) || mem[7] != header_pointer || mem[8] != header_endian) {
+		return false;
+	}
+	
+	/* count the blocks, checking they're all inside the file and it ends with ENDB */
+	bheads_num = 0;
+	for (offset = SIZEOFBLENDERHEADER; offset + sizeof(BHead) <= size; ) {
+		const BHead *bhead = (const BHead *)(mem + offset);
+		bheads_num++;
+		if (bhead->code == ENDB) {
+			is_valid = true;
+			break;
+		}
+		if (bhead->len < 0 || (size_t)bhead->len > size - offset - sizeof(BHead)) {
+			break;
+		}
+		offset += sizeof(BHead) + (size_t)bhead->len;
+	}
+	
+	if (!is_valid) {
+		return false;
+	}
+	
+	fd->mmap_bheads = MEM_mallocN(sizeof(*fd->mmap_bheads) * (size_t)bheads_num, __func__);
+	for (i = 0, offset = SIZEOFBLENDERHEADER; i < bheads_num; i++) {
+		BHead *bhead = (BHead *)(mem + offset);
+		fd->mmap_bheads[i] = bhead;
+		offset += sizeof(BHead) + (size_t)bhead->len;
+	}
+	fd->mmap_bheads_num = bheads_num;
+	fd->mmap_mem = mem;
+	fd->mmap_size = size;
+	fd->read = fd_read_from_mmap;
+	
+	return true;
+}
+
+#ifdef USE_BHEAD_MMAP
+
+/**
+ * Map an uncompressed file into memory, see #fd_bheads_in_place_init.
+ */
+static bool fd_mmap_open(FileData *fd, const char *filepath)
+{
+	size_t size;
+	char *mem;
+	int file;
+	
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
+		return false;
+	}
+	
+	size = BLI_file_descriptor_size(file);
+	if (size == (size_t)-1 || size < SIZEOFBLENDERHEADER + sizeof(BHead)) {
+		close(file);
+		return false;
+	}
+	
+	/* private, since some versioning patches the BHeads in place */
+	mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	close(file);
+	
+	if (mem == MAP_FAILED) {
+		return false;
+	}
+	
+	if (!fd_bheads_in_place_init(fd, mem, size)) {
+		munmap(mem, size);
+		return false;
+	}
+	
+	return true;
+}
+
+#endif  /* USE_BHEAD_MMAP */
+
+/**
+ * Compressed files written in frames (see BLI_gzip_frames.h) are read and
+ * decompressed at once, in parallel, instead of through gzread.
+ * Other compressed files are left to gzread.
+ */
+static bool fd_gzip_frames_open(FileData *fd, const char *filepath)
+{
+	char header[BLI_GZIP_FRAME_HEADER_SIZE];
+	size_t size, offset, data_size;
+	char *mem, *data;
+	int file;
+	
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
+		return false;
+	}
+	
+	size = BLI_file_descriptor_size(file);
+	if (size == (size_t)-1 ||
+	    read(file, header, sizeof(header)) != (int)sizeof(header) ||
+	    !BLI_gzip_frames_check(header, sizeof(header)))
+	{
+		close(file);
+		return false;
+	}
+	
+	mem = MEM_mallocN(size, __func__);
+	memcpy(mem, header, sizeof(header));
+	for (offset = sizeof(header); offset < size; ) {
+		/* in parts, read() takes an int on some systems */
+		const int readsize = read(file, mem + offset, (unsigned int)MIN2(size - offset, (size_t)(1 << 30)));
+		if (readsize <= 0) {
+			break;
+		}
+		offset += (size_t)readsize;
+	}
+	close(file);
+	
+	data = (offset == size) ? BLI_gzip_frames_decompress(mem, size, &data_size) : NULL;
+	MEM_freeN(mem);
+	
+	if (data == NULL) {
+		return false;
+	}
+	
+	if (fd_bheads_in_place_init(fd, data, data_size)) {
+		fd->mmap_is_alloc = true;
+	}
+	else if (data_size <= INT_MAX) {
+		/* another pointer size or endianness, read the blocks from memory */
+		fd->buffer = data;
+		fd->buffersize = (int)data_size;
+		fd->read = fd_read_from_memory;
+	}
+	else {
+		MEM_freeN(data);
+		return false;
+	}
+	
+	return true;
+}
+
 static FileData *filedata_new(void)
 {
 	FileData *fd = MEM_callocN(sizeof(FileData), "FileData");
@@ -1113,6 +1332,17 @@ FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
 		/* needed for library_append and read_libraries */
 		BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
 		
+		if (fd_gzip_frames_open(fd, filepath)) {
+			gzclose(fd->gzfiledes);
+			fd->gzfiledes = NULL;
+		}
+#ifdef USE_BHEAD_MMAP
+		else if (fd_mmap_open(fd, filepath)) {
+			gzclose(fd->gzfiledes);
+			fd->gzfiledes = NULL;
+		}
+#endif
+		
 		return blo_decode_and_check(fd, reports);
 	}
 }
@@ -1144,6 +1374,68 @@ static FileData *blo_openblenderfile_minimal(const char *filepath)
 	return NULL;
 }
 
+/**
+ * Read bytes of an uncompressed file at \a offset, for files opened with #blo_openblenderfile_toc.
+ */
+bool blo_toc_read_data(FileData *fd, uint64_t offset, void *buf, size_t len)
+{
+	BLI_assert(fd->filedes != -1);
+	return ((lseek(fd->filedes, (off_t)offset, SEEK_SET) == (off_t)offset) &&
+	        ((size_t)read(fd->filedes, buf, len) == len));
+}
+
+/**
+ * Open only the table of contents of a file (see #BlendFileTocTail),
+ * to list its datablocks without reading the rest of the file.
+ *
+ * \return NULL when the file doesn't have one (saved by older versions, compressed,
+ * or in another endianness), these have to be opened with #blo_openblenderfile.
+ */
+FileData *blo_openblenderfile_toc(const char *filepath)
+{
+	FileData *fd;
+	BlendFileTocTail tail;
+	uint64_t size;
+	bool ok;
+	int file;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
+		return NULL;
+	}
+
+	fd = filedata_new();
+	fd->filedes = file;
+	fd->read = fd_read_from_file;
+	BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+
+	decode_blender_header(fd);
+	size = (uint64_t)BLI_file_descriptor_size(file);
+
+	ok = ((fd->flags & FD_FLAGS_FILE_OK) &&
+	      !(fd->flags & FD_FLAGS_SWITCH_ENDIAN) &&
+	      (size >= SIZEOFBLENDERHEADER + sizeof(BHead) + sizeof(tail)) &&
+	      blo_toc_read_data(fd, size - sizeof(tail), &tail, sizeof(tail)));
+
+	ok = ok && ((memcmp(tail.magic, BLEND_TOC_MAGIC, sizeof(tail.magic)) == 0) &&
+	            (tail.entry_size == sizeof(BlendFileTocEntry)) &&
+	            (tail.offset <= size - sizeof(tail)) &&
+	            ((size - sizeof(tail) - tail.offset) == (uint64_t)tail.entries_num * sizeof(BlendFileTocEntry)));
+
+	if (ok) {
+		fd->toc = MEM_mallocN(sizeof(*fd->toc) * max_ii((int)tail.entries_num, 1), __func__);
+		fd->toc_num = (int)tail.entries_num;
+		ok = blo_toc_read_data(fd, tail.offset, fd->toc, sizeof(*fd->toc) * tail.entries_num);
+	}
+
+	if (!ok) {
+		blo_freefiledata(fd);
+		fd = NULL;
+	}
+
+	return fd;
+}
+
 static int fd_read_gzip_from_memory(FileData *filedata, void *buffer, unsigned int size)
 {
 	int err;
@@ -1256,6 +1548,18 @@ void blo_freefiledata(FileData *fd)
 		// Free all BHeadN data blocks
 		BLI_freelistN(&fd->listbase);
 		
+		if (fd->mmap_mem) {
+			if (fd->mmap_is_alloc) {
+				MEM_freeN(fd->mmap_mem);
+			}
+#ifdef USE_BHEAD_MMAP
+			else {
+				munmap(fd->mmap_mem, fd->mmap_size);
+			}
+#endif
+			MEM_freeN(fd->mmap_bheads);
+		}
+		
 		if (fd->memsdna)
 			DNA_sdna_free(fd->memsdna);
 		if (fd->filesdna)
@@ -1275,6 +1579,10 @@ void blo_freefiledata(FileData *fd)
 			oldnewmap_free(fd->soundmap);
 		if (fd->packedmap)
 			oldnewmap_free(fd->packedmap);
+		if (fd->undo_old_ids)
+			BLI_ghash_free(fd->undo_old_ids, NULL, NULL);
+		if (fd->toc)
+			MEM_freeN(fd->toc);
 		if (fd->libmap && !(fd->flags & FD_FLAGS_NOT_MY_LIBMAP))
 			oldnewmap_free(fd->libmap);
 		if (fd->bheadmap)
@@ -1787,6 +2095,285 @@ void blo_add_library_pointer_map(ListBase *mainlist, FileData *fd)
 }
 
 
+/**
+ * Is an ID of the current main still what its memfile stores: nothing changed it since
+ * it was written to or read from \a oldmemfile (operators without undo, scripts).
+ * \a memfile_oldmain is the current main written again.
+ */
+static bool undo_reuse_id_is_unchanged(MemFile *oldmemfile, MemFile *memfile_oldmain, ID *id)
+{
+	/* when read from oldmemfile, its IDs and ID pointers aren't the ones stored there,
+	 * compare to how it was written after reading instead,
+	 * unchanged data uses the same buffers */
+	MemFile *memfile_main = oldmemfile->main_read ? oldmemfile->main_read : oldmemfile;
+	
+	return memfile_id_is_identical(memfile_oldmain, memfile_main, id, NULL, 0);
+}
+
+/* undo file support: keep IDs of the current main which are stored the same in the undo step
+ * read as in the one of the current main, instead of reading them again, see: read_libblock.
+ * For now only meshes, these have the most data and are referenced by the derived data of objects. */
+void blo_make_undo_reuse_map(FileData *fd, Main *oldmain, MemFile *oldmemfile, MemFile *memfile_oldmain)
+{
+	Object *ob;
+	Mesh *me;
+	
+	fd->undo_oldmemfile = oldmemfile;
+	fd->undo_oldmain = oldmain;
+	/* by name: the current main may have been read from its memfile (after undo),
+	 * then its IDs aren't at the addresses they're stored at */
+	fd->undo_old_ids = BLI_ghash_str_new(__func__);
+	
+	for (me = oldmain->mesh.first; me; me = me->id.next) {
+		if (me->id.lib == NULL && undo_reuse_id_is_unchanged(oldmemfile, memfile_oldmain, &me->id)) {
+			BLI_ghash_insert(fd->undo_old_ids, me->id.name, me);
+		}
+	}
+	
+	/* objects which can give their derived data, see: blo_end_undo_reuse_map */
+	for (ob = oldmain->object.first; ob; ob = ob->id.next) {
+		if (ob->id.lib == NULL && undo_reuse_id_is_unchanged(oldmemfile, memfile_oldmain, &ob->id)) {
+			ob->id.flag |= LIB_UNDO_UNCHANGED;
+		}
+		else {
+			ob->id.flag &= ~LIB_UNDO_UNCHANGED;
+		}
+	}
+}
+
+/**
+ * The ID pointers of kept IDs are the ones of the current main, not the ones stored in the memfile,
+ * so these can't be looked up in the libmap: map the IDs of the current main to the ones read by name.
+ * Linked IDs and other kept IDs stay where they are.
+ */
+static OldNewMap *undo_reuse_libmap_new(FileData *fd, Main *main)
+{
+	OldNewMap *libmap = oldnewmap_new();
+	GHash *ids_new = BLI_ghash_str_new(__func__);
+	ListBase *lbarray[MAX_LIBARRAY];
+	ID *id;
+	int a, i;
+	
+	a = set_listbasepointers(main, lbarray);
+	while (a--) {
+		for (id = lbarray[a]->first; id; id = id->next) {
+			if (id->flag & LIB_UNDO_KEPT) {
+				oldnewmap_insert(libmap, id, id, GS(id->name));
+			}
+			else if (id->lib == NULL) {
+				BLI_ghash_insert(ids_new, id->name, id);
+			}
+		}
+	}
+	
+	a = set_listbasepointers(fd->undo_oldmain, lbarray);
+	while (a--) {
+		for (id = lbarray[a]->first; id; id = id->next) {
+			if (id->lib == NULL) {
+				oldnewmap_insert(libmap, id, BLI_ghash_lookup(ids_new, id->name), GS(id->name));
+			}
+		}
+	}
+	
+	/* see: blo_add_library_pointer_map */
+	for (i = 0; i < fd->libmap->nentries; i++) {
+		OldNew *entry = &fd->libmap->entries[i];
+		if (entry->old == entry->newp) {
+			oldnewmap_insert(libmap, entry->old, entry->newp, entry->nr);
+		}
+	}
+	
+	BLI_ghash_free(ids_new, NULL, NULL);
+	
+	return libmap;
+}
+
+static void undo_reuse_modifier_id_cb(void *userData, Object *UNUSED(ob), ID **idpoin)
+{
+	bool *r_is_unchanged = userData;
+	ID *id = *idpoin;
+	
+	/* the result would depend on the transform of other objects */
+	if (id && (GS(id->name) == ID_OB || (id->lib == NULL && !(id->flag & LIB_UNDO_UNCHANGED)))) {
+		*r_is_unchanged = false;
+	}
+}
+
+/* the images of the faces are read again, copies of them in derived data would point to the old ones */
+static bool undo_reuse_mesh_has_images(const Mesh *me)
+{
+	int i, j;
+	
+	for (i = 0; i < me->pdata.totlayer; i++) {
+		const CustomDataLayer *layer = &me->pdata.layers[i];
+		
+		if (layer->type == CD_MTEXPOLY) {
+			const MTexPoly *tf = layer->data;
+			
+			for (j = 0; j < me->totpoly; j++, tf++) {
+				if (tf->tpage) {
+					return true;
+				}
+			}
+		}
+	}
+	
+	return false;
+}
+
+/* simplify level as the modifier stack uses it, see: get_render_subsurf_level */
+static int undo_reuse_scene_simplify(const Scene *scene)
+{
+	return (scene->r.mode & R_SIMPLIFY) ? scene->r.simplify_subsurf : -1;
+}
+
+/* the scene settings the modifier stack reads are the same before and after reading,
+ * derived data made with other settings can't be kept (a simplify change is undone for example) */
+static bool undo_reuse_scene_derived_check(Main *newmain, Main *oldmain)
+{
+	Scene *sce, *sce_old;
+	
+	for (sce = newmain->scene.first; sce; sce = sce->id.next) {
+		if (sce->id.lib) {
+			continue;
+		}
+		
+		sce_old = BLI_findstring(&oldmain->scene, sce->id.name, offsetof(ID, name));
+		
+		/* the frame for textures of the modifiers (image sequences) */
+		if (sce_old == NULL ||
+		    undo_reuse_scene_simplify(sce) != undo_reuse_scene_simplify(sce_old) ||
+		    sce->r.cfra != sce_old->r.cfra || sce->r.subframe != sce_old->r.subframe)
+		{
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+/* can the derived data of the object before reading be used for the one read */
+static bool undo_reuse_object_derived_check(Object *ob, Object *ob_old)
+{
+	ModifierData *md, *md_old;
+	bool is_unchanged = true;
+	
+	if (ob->type != OB_MESH || ob->data != ob_old->data || !(((ID *)ob->data)->flag & LIB_UNDO_KEPT) ||
+	    ob->mode != OB_MODE_OBJECT || ob_old->derivedFinal == NULL || (ob_old->recalc & OB_RECALC_ALL) ||
+	    ob->adt || ((Mesh *)ob->data)->adt || ((Mesh *)ob->data)->key ||
+	    ob->particlesystem.first || ob->soft || (ob->parent && ob->partype == PARSKEL) ||
+	    undo_reuse_mesh_has_images(ob->data))
+	{
+		return false;
+	}
+	
+	for (md = ob->modifiers.first, md_old = ob_old->modifiers.first;
+	     md && md_old;
+	     md = md->next, md_old = md_old->next)
+	{
+		if (md->type != md_old->type || modifier_dependsOnTime(md)) {
+			return false;
+		}
+		switch (md->type) {
+			case eModifierType_ParticleSystem:
+			case eModifierType_ParticleInstance:
+			case eModifierType_Explode:
+			case eModifierType_Collision:
+			case eModifierType_Surface:
+			case eModifierType_Multires:
+				return false;
+		}
+	}
+	if (md || md_old) {
+		return false;
+	}
+	
+	modifiers_foreachIDLink(ob, undo_reuse_modifier_id_cb, &is_unchanged);
+	
+	return is_unchanged;
+}
+
+static void undo_reuse_object_derived(Object *ob, Object *ob_old)
+{
+	ModifierData *md, *md_old;
+	
+	ob->derivedFinal = ob_old->derivedFinal;
+	ob->derivedDeform = ob_old->derivedDeform;
+	ob->lastDataMask = ob_old->lastDataMask;
+	ob->customdata_mask = ob_old->customdata_mask;
+	ob->bb = ob_old->bb;
+	ob_old->derivedFinal = NULL;
+	ob_old->derivedDeform = NULL;
+	ob_old->bb = NULL;
+	
+	/* the subsurf result references the cache of its modifier */
+	for (md = ob->modifiers.first, md_old = ob_old->modifiers.first; md; md = md->next, md_old = md_old->next) {
+		if (md->type == eModifierType_Subsurf) {
+			SubsurfModifierData *smd = (SubsurfModifierData *)md;
+			SubsurfModifierData *smd_old = (SubsurfModifierData *)md_old;
+			
+			smd->mCache = smd_old->mCache;
+			smd->emCache = smd_old->emCache;
+			smd_old->mCache = NULL;
+			smd_old->emCache = NULL;
+		}
+	}
+	
+	ob->id.flag |= LIB_UNDO_KEPT;
+}
+
+/* undo file support: after reading, give the kept IDs to the new main for good,
+ * and let objects which are unchanged keep their derived data */
+void blo_end_undo_reuse_map(FileData *fd, Main *newmain)
+{
+	Main *oldmain = fd->undo_oldmain;
+	GHash *old_objects = BLI_ghash_str_new(__func__);
+	const bool use_derived = undo_reuse_scene_derived_check(newmain, oldmain);
+	Object *ob;
+	Mesh *me;
+	int totmesh = 0, totob = 0;
+	
+	for (ob = oldmain->object.first; ob; ob = ob->id.next) {
+		if (ob->id.lib == NULL && (ob->id.flag & LIB_UNDO_UNCHANGED)) {
+			BLI_ghash_insert(old_objects, ob->id.name, ob);
+		}
+	}
+	
+	for (ob = use_derived ? newmain->object.first : NULL; ob; ob = ob->id.next) {
+		if (ob->id.flag & LIB_UNDO_UNCHANGED) {
+			Object *ob_old = BLI_ghash_lookup(old_objects, ob->id.name);
+			
+			if (ob_old && undo_reuse_object_derived_check(ob, ob_old)) {
+				undo_reuse_object_derived(ob, ob_old);
+				totob++;
+			}
+		}
+	}
+	
+	for (ob = oldmain->object.first; ob; ob = ob->id.next) {
+		/* the new main has it now, old objects remove their user when freed,
+		 * which must not make it unlink its materials etc. (see: BKE_object_free_ex) */
+		if (ob->data && (((ID *)ob->data)->flag & LIB_UNDO_KEPT)) {
+			((ID *)ob->data)->us++;
+		}
+	}
+	
+	if (G.debug & G_DEBUG) {
+		for (me = newmain->mesh.first; me; me = me->id.next) {
+			totmesh += (me->id.flag & LIB_UNDO_KEPT) != 0;
+		}
+		printf("undo: kept %d meshes, derived data of %d objects\n", totmesh, totob);
+	}
+	
+	BKE_main_id_flag_all(newmain, LIB_UNDO_UNCHANGED, false);
+	
+	BLI_ghash_free(old_objects, NULL, NULL);
+	BLI_ghash_free(fd->undo_old_ids, NULL, NULL);
+	fd->undo_old_ids = NULL;
+	fd->undo_oldmain = NULL;
+	fd->undo_oldmemfile = NULL;
+}
+
 /* ********** END OLD POINTERS ****************** */
 /* ********** READ FILE ****************** */
 
@@ -4278,39 +4865,64 @@ static void lib_link_customdata_mtpoly(FileData *fd, Mesh *me, CustomData *pdata
 	}
 }
 
+/* only the ID pointers, also used for meshes kept on undo (see: blo_end_undo_reuse_map) */
+static void lib_link_mesh_pointers(FileData *fd, Mesh *me)
+{
+	int i;
+	
+	/* Link ID Properties -- and copy this comment EXACTLY for easy finding
+	 * of library blocks that implement this.*/
+	if (me->id.properties) IDP_LibLinkProperty(me->id.properties, (fd->flags & FD_FLAGS_SWITCH_ENDIAN), fd);
+	if (me->adt) lib_link_animdata(fd, &me->id, me->adt);
+	
+	/* this check added for python created meshes */
+	if (me->mat) {
+		for (i = 0; i < me->totcol; i++) {
+			me->mat[i] = newlibadr_us(fd, me->id.lib, me->mat[i]);
+		}
+	}
+	else {
+		me->totcol = 0;
+	}
+
+	me->ipo = newlibadr_us(fd, me->id.lib, me->ipo); // XXX: deprecated: old anim sys
+	me->key = newlibadr_us(fd, me->id.lib, me->key);
+	me->texcomesh = newlibadr_us(fd, me->id.lib, me->texcomesh);
+	
+	lib_link_customdata_mtface(fd, me, &me->fdata, me->totface);
+	lib_link_customdata_mtpoly(fd, me, &me->pdata, me->totpoly);
+	if (me->mr && me->mr->levels.first)
+		lib_link_customdata_mtface(fd, me, &me->mr->fdata,
+					   ((MultiresLevel*)me->mr->levels.first)->totface);
+}
+
 static void lib_link_mesh(FileData *fd, Main *main)
 {
 	Mesh *me;
+	bool has_kept = false;
 	
 	for (me = main->mesh.first; me; me = me->id.next) {
 		if (me->id.flag & LIB_NEED_LINK) {
-			int i;
-			
-			/* Link ID Properties -- and copy this comment EXACTLY for easy finding
-			 * of library blocks that implement this.*/
-			if (me->id.properties) IDP_LibLinkProperty(me->id.properties, (fd->flags & FD_FLAGS_SWITCH_ENDIAN), fd);
-			if (me->adt) lib_link_animdata(fd, &me->id, me->adt);
-			
-			/* this check added for python created meshes */
-			if (me->mat) {
-				for (i = 0; i < me->totcol; i++) {
-					me->mat[i] = newlibadr_us(fd, me->id.lib, me->mat[i]);
-				}
+			if (me->id.flag & LIB_UNDO_KEPT) {
+				has_kept = true;
+				continue;
 			}
-			else {
-				me->totcol = 0;
+			lib_link_mesh_pointers(fd, me);
+		}
+	}
+	
+	/* kept on undo, these point to the IDs of the current main */
+	if (has_kept) {
+		OldNewMap *libmap = fd->libmap;
+		
+		fd->libmap = undo_reuse_libmap_new(fd, main);
+		for (me = main->mesh.first; me; me = me->id.next) {
+			if ((me->id.flag & LIB_NEED_LINK) && (me->id.flag & LIB_UNDO_KEPT)) {
+				lib_link_mesh_pointers(fd, me);
 			}
-
-			me->ipo = newlibadr_us(fd, me->id.lib, me->ipo); // XXX: deprecated: old anim sys
-			me->key = newlibadr_us(fd, me->id.lib, me->key);
-			me->texcomesh = newlibadr_us(fd, me->id.lib, me->texcomesh);
-			
-			lib_link_customdata_mtface(fd, me, &me->fdata, me->totface);
-			lib_link_customdata_mtpoly(fd, me, &me->pdata, me->totpoly);
-			if (me->mr && me->mr->levels.first)
-				lib_link_customdata_mtface(fd, me, &me->mr->fdata,
-							   ((MultiresLevel*)me->mr->levels.first)->totface);
 		}
+		oldnewmap_free(fd->libmap);
+		fd->libmap = libmap;
 	}
 
 	/* convert texface options to material */
@@ -4318,6 +4930,12 @@ static void lib_link_mesh(FileData *fd, Main *main)
 
 	for (me = main->mesh.first; me; me = me->id.next) {
 		if (me->id.flag & LIB_NEED_LINK) {
+			/* kept on undo as it was, its derived data can still reference it */
+			if (me->id.flag & LIB_UNDO_KEPT) {
+				me->id.flag -= LIB_NEED_LINK;
+				continue;
+			}
+			
 			/*check if we need to convert mfaces to mpolys*/
 			if (me->totface && !me->totpoly) {
 				/* temporarily switch main so that reading from
@@ -4441,6 +5059,7 @@ static void direct_link_customdata(FileData *fd, CustomData *data, int count)
 			layer->flag &= ~CD_FLAG_IN_MEMORY;
 
 		layer->flag &= ~CD_FLAG_NOFREE;
+		layer->shared = NULL;
 		
 		if (CustomData_verify_versions(data, i)) {
 			layer->data = newdataadr(fd, layer->data);
@@ -4913,6 +5532,8 @@ static void direct_link_modifiers(FileData *fd, ListBase *lb)
 	for (md=lb->first; md; md=md->next) {
 		md->error = NULL;
 		md->scene = NULL;
+		md->checkpoint = NULL;
+		modifier_clearEvalStats(md);
 		
 		/* if modifiers disappear, or for upward compatibility */
 		if (NULL == modifierType_getInfo(md->type))
@@ -5420,6 +6041,7 @@ static void direct_link_object(FileData *fd, Object *ob)
 
 	/* Runtime curve data  */
 	ob->curve_cache = NULL;
+	ob->lnor_split_cache = NULL;
 
 	/* in case this value changes in future, clamp else we get undefined behavior */
 	CLAMP(ob->rotmode, ROT_MODE_MIN, ROT_MODE_MAX);
@@ -7796,87 +8418,44 @@ static const char *dataname(short id_code)
 		case ID_GD: return "Data from GD";
 		case ID_WM: return "Data from WM";
 		case ID_MC: return "Data from MC";
-		case ID_MSK: return "Data from MSK";
-		case ID_LS: return "Data from LS";
-	}
-	return "Data from Lib Block";
-	
-}
-
-static BHead *read_data_into_oldnewmap(FileData *fd, BHead *bhead, const char *allocname)
-{
-	bhead = blo_nextbhead(fd, bhead);
-	
-	while (bhead && bhead->code==DATA) {
-		void *data;
-#if 0
-		/* XXX DUMB DEBUGGING OPTION TO GIVE NAMES for guarded malloc errors */
-		short *sp = fd->filesdna->structs[bhead->SDNAnr];
-		char *tmp = malloc(100);
-		allocname = fd->filesdna->types[ sp[0] ];
-		strcpy(tmp, allocname);
-		data = read_struct(fd, bhead, tmp);
-#else
-		data = read_struct(fd, bhead, allocname);
-#endif
-		
-		if (data) {
-			oldnewmap_insert(fd->datamap, bhead->old, data, 0);
-		}
-		
-		bhead = blo_nextbhead(fd, bhead);
-	}
-	
-	return bhead;
-}
-
-static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, int flag, ID **r_id)
-{
-	/* this routine reads a libblock and its direct data. Use link functions
-	 * to connect it all
-	 */
-	ID *id;
-	ListBase *lb;
-	const char *allocname;
-	bool wrong_id = false;
-	
-	/* read libblock */
-	id = read_struct(fd, bhead, "lib block");
-	if (r_id)
-		*r_id = id;
-	if (!id)
-		return blo_nextbhead(fd, bhead);
-	
-	oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);	/* for ID_ID check */
-	
-	/* do after read_struct, for dna reconstruct */
-	if (bhead->code == ID_ID) {
-		lb = which_libbase(main, GS(id->name));
-	}
-	else {
-		lb = which_libbase(main, bhead->code);
-	}
-	
-	BLI_addtail(lb, id);
-	
-	/* clear first 8 bits */
-	id->flag = (id->flag & 0xFF00) | flag | LIB_NEED_LINK;
-	id->lib = main->curlib;
-	if (id->flag & LIB_FAKEUSER) id->us= 1;
-	else id->us = 0;
-	id->icon_id = 0;
-	id->flag &= ~(LIB_ID_RECALC|LIB_ID_RECALC_DATA|LIB_DOIT);
-	
-	/* this case cannot be direct_linked: it's just the ID part */
-	if (bhead->code == ID_ID) {
-		return blo_nextbhead(fd, bhead);
+		case ID_MSK: return "Data from MSK";
+		case ID_LS: return "Data from LS";
 	}
+	return "Data from Lib Block";
 	
-	/* need a name for the mallocN, just for debugging and sane prints on leaks */
-	allocname = dataname(GS(id->name));
+}
+
+static BHead *read_data_into_oldnewmap(FileData *fd, BHead *bhead, const char *allocname)
+{
+	bhead = blo_nextbhead(fd, bhead);
 	
-	/* read all data into fd->datamap */
-	bhead = read_data_into_oldnewmap(fd, bhead, allocname);
+	while (bhead && bhead->code==DATA) {
+		void *data;
+#if 0
+		/* XXX DUMB DEBUGGING OPTION TO GIVE NAMES for guarded malloc errors */
+		short *sp = fd->filesdna->structs[bhead->SDNAnr];
+		char *tmp = malloc(100);
+		allocname = fd->filesdna->types[ sp[0] ];
+		strcpy(tmp, allocname);
+		data = read_struct(fd, bhead, tmp);
+#else
+		data = read_struct(fd, bhead, allocname);
+#endif
+		
+		if (data) {
+			oldnewmap_insert(fd->datamap, bhead->old, data, 0);
+		}
+		
+		bhead = blo_nextbhead(fd, bhead);
+	}
+	
+	return bhead;
+}
+
+/* direct_link of an ID and its data, returns true when the ID has to be freed */
+static bool direct_link_libblock(FileData *fd, Main *main, ID *id)
+{
+	bool wrong_id = false;
 	
 	/* init pointers direct data */
 	direct_link_id(fd, id);
@@ -7986,6 +8565,225 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, int flag, ID
 			break;
 	}
 	
+	return wrong_id;
+}
+
+#ifdef USE_PARALLEL_DIRECT_LINK
+
+/* An ID with its data read, waiting for direct_link. */
+typedef struct DirectLinkDeferred {
+	ID *id;
+	OldNewMap *datamap;
+} DirectLinkDeferred;
+
+/**
+ * IDs which can be direct linked in any order and from any thread:
+ * they only use their own data (fd->datamap).
+ * Objects link logic bricks through fd->globmap, libraries and screens change the Main,
+ * others read files or use the undo maps, those are kept in file order.
+ */
+static bool direct_link_libblock_is_threadsafe(short idcode)
+{
+	switch (idcode) {
+		case ID_ME:
+		case ID_CU:
+		case ID_MB:
+		case ID_LT:
+		case ID_KE:
+		case ID_MA:
+		case ID_TE:
+		case ID_IM:
+		case ID_LA:
+		case ID_CA:
+		case ID_WO:
+		case ID_SPK:
+		case ID_AR:
+		case ID_AC:
+		case ID_NT:
+		case ID_PA:
+		case ID_GD:
+		case ID_MSK:
+		case ID_LS:
+		case ID_PAL:
+		case ID_PC:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/* Keep the ID and its data (moved out of fd->datamap) for #direct_link_deferred_all. */
+static void direct_link_deferred_add(FileData *fd, ID *id)
+{
+	DirectLinkDeferred *dld;
+	OldNewMap *datamap;
+	
+	if (fd->direct_link_deferred_num == fd->direct_link_deferred_len) {
+		fd->direct_link_deferred_len = max_ii(64, fd->direct_link_deferred_len * 2);
+		fd->direct_link_deferred = MEM_reallocN_id(
+		        fd->direct_link_deferred, sizeof(*fd->direct_link_deferred) * (size_t)fd->direct_link_deferred_len,
+		        __func__);
+	}
+	
+	/* the ID keeps this data map, reading continues with a new one */
+	datamap = fd->datamap;
+	fd->datamap = oldnewmap_new();
+	
+	dld = &fd->direct_link_deferred[fd->direct_link_deferred_num++];
+	dld->id = id;
+	dld->datamap = datamap;
+}
+
+static void direct_link_deferred_cb(void *userdata, int index)
+{
+	const FileData *fd = userdata;
+	DirectLinkDeferred *dld = &fd->direct_link_deferred[index];
+	/* same file, own data */
+	FileData fd_thread = *fd;
+	bool wrong_id;
+	
+	fd_thread.datamap = dld->datamap;
+	
+	/* Main is only used by libraries */
+	wrong_id = direct_link_libblock(&fd_thread, NULL, dld->id);
+	BLI_assert(wrong_id == false);
+	UNUSED_VARS_NDEBUG(wrong_id);
+	
+	oldnewmap_free_unused(dld->datamap);
+	oldnewmap_free(dld->datamap);
+}
+
+static void direct_link_deferred_all(FileData *fd)
+{
+	if (fd->direct_link_deferred_num) {
+		BLI_task_parallel_range_ex(0, fd->direct_link_deferred_num, fd, direct_link_deferred_cb, 2, true);
+		
+		MEM_freeN(fd->direct_link_deferred);
+		fd->direct_link_deferred = NULL;
+		fd->direct_link_deferred_num = fd->direct_link_deferred_len = 0;
+	}
+}
+
+#endif  /* USE_PARALLEL_DIRECT_LINK */
+
+/**
+ * Undo: keep the ID of the current main instead of the one read,
+ * when both are stored the same (see #blo_make_undo_reuse_map).
+ *
+ * \return The kept ID, added to \a main, or NULL when it can't be kept.
+ */
+static ID *read_libblock_undo_reuse(FileData *fd, Main *main, BHead *bhead, ID *id, int flag)
+{
+	ID *id_old = BLI_ghash_lookup(fd->undo_old_ids, id->name);
+	
+	if (id_old == NULL) {
+		return NULL;
+	}
+	
+	switch (GS(id_old->name)) {
+		case ID_ME:
+			/* edit-mode data isn't written, the mesh is not what's stored */
+			if (((Mesh *)id_old)->edit_btmesh) {
+				return NULL;
+			}
+			break;
+		default:
+			return NULL;
+	}
+	
+	BLI_ghash_remove(fd->undo_old_ids, id_old->name, NULL, NULL);
+	BLI_remlink(which_libbase(fd->undo_oldmain, GS(id_old->name)), id_old);
+	BLI_addtail(which_libbase(main, GS(id_old->name)), id_old);
+	
+	oldnewmap_insert(fd->libmap, bhead->old, id_old, bhead->code);
+	
+	/* still needs its ID pointers linked to the IDs read instead of the current ones,
+	 * but nothing else, see: lib_link_mesh */
+	id_old->flag = (id_old->flag & 0xFF00) | flag | LIB_NEED_LINK | LIB_UNDO_UNCHANGED | LIB_UNDO_KEPT;
+	id_old->flag &= ~(LIB_ID_RECALC | LIB_ID_RECALC_DATA | LIB_DOIT);
+	if (id_old->flag & LIB_FAKEUSER) id_old->us = 1;
+	else id_old->us = 0;
+	
+	return id_old;
+}
+
+static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, int flag, ID **r_id)
+{
+	/* this routine reads a libblock and its direct data. Use link functions
+	 * to connect it all
+	 */
+	ID *id;
+	ListBase *lb;
+	const char *allocname;
+	bool wrong_id = false;
+	bool is_unchanged = false;
+	
+	/* read libblock */
+	id = read_struct(fd, bhead, "lib block");
+	if (r_id)
+		*r_id = id;
+	if (!id)
+		return blo_nextbhead(fd, bhead);
+	
+	if (fd->undo_old_ids && main->curlib == NULL && bhead->code != ID_ID) {
+		if (memfile_id_is_identical(fd->memfile, fd->undo_oldmemfile, bhead->old, bhead, sizeof(*bhead))) {
+			ID *id_old = read_libblock_undo_reuse(fd, main, bhead, id, flag);
+			if (id_old) {
+				MEM_freeN(id);
+				if (r_id)
+					*r_id = id_old;
+				
+				/* skip its direct data, the kept ID has it already */
+				for (bhead = blo_nextbhead(fd, bhead); bhead && bhead->code == DATA; bhead = blo_nextbhead(fd, bhead)) {
+					/* pass */
+				}
+				return bhead;
+			}
+			is_unchanged = true;
+		}
+	}
+	
+	oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);	/* for ID_ID check */
+	
+	/* do after read_struct, for dna reconstruct */
+	if (bhead->code == ID_ID) {
+		lb = which_libbase(main, GS(id->name));
+	}
+	else {
+		lb = which_libbase(main, bhead->code);
+	}
+	
+	BLI_addtail(lb, id);
+	
+	/* clear first 8 bits */
+	id->flag = (id->flag & 0xFF00) | flag | LIB_NEED_LINK;
+	if (is_unchanged) id->flag |= LIB_UNDO_UNCHANGED;
+	id->lib = main->curlib;
+	if (id->flag & LIB_FAKEUSER) id->us= 1;
+	else id->us = 0;
+	id->icon_id = 0;
+	id->flag &= ~(LIB_ID_RECALC|LIB_ID_RECALC_DATA|LIB_DOIT);
+	
+	/* this case cannot be direct_linked: it's just the ID part */
+	if (bhead->code == ID_ID) {
+		return blo_nextbhead(fd, bhead);
+	}
+	
+	/* need a name for the mallocN, just for debugging and sane prints on leaks */
+	allocname = dataname(GS(id->name));
+	
+	/* read all data into fd->datamap */
+	bhead = read_data_into_oldnewmap(fd, bhead, allocname);
+	
+#ifdef USE_PARALLEL_DIRECT_LINK
+	if (fd->use_direct_link_deferred && direct_link_libblock_is_threadsafe(GS(id->name))) {
+		direct_link_deferred_add(fd, id);
+		return bhead;
+	}
+#endif
+	
+	wrong_id = direct_link_libblock(fd, main, id);
+	
 	oldnewmap_free_unused(fd->datamap);
 	oldnewmap_clear(fd->datamap);
 	
@@ -8140,8 +8938,6 @@ static void do_versions_after_linking(FileData *fd, Library *lib, Main *main)
 
 static void lib_link_all(FileData *fd, Main *main)
 {
-	oldnewmap_sort(fd);
-	
 	/* No load UI for undo memfiles */
 	if (fd->memfile == NULL) {
 		lib_link_windowmanager(fd, main);
@@ -8292,6 +9088,12 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 		}
 	}
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+	/* Read all blocks first, then direct_link the independent IDs in parallel.
+	 * Not for undo, the undo pointer maps (fd->imamap...) aren't thread safe. */
+	fd->use_direct_link_deferred = (fd->memfile == NULL);
+#endif
+	
 	while (bhead) {
 		switch (bhead->code) {
 		case DATA:
@@ -8341,6 +9143,12 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 		}
 	}
 	
+#ifdef USE_PARALLEL_DIRECT_LINK
+	/* before versioning and lib_link, which expect all direct data */
+	direct_link_deferred_all(fd);
+	fd->use_direct_link_deferred = false;
+#endif
+	
 	/* do before read_libraries, but skip undo case */
 	if (fd->memfile == NULL) {
 		do_versions(fd, NULL, bfd->main);
@@ -9725,6 +10533,8 @@ static Main *library_append_begin(Main *mainvar, FileData **fd, const char *file
 Main *BLO_library_append_begin(Main *mainvar, BlendHandle **bh, const char *filepath)
 {
 	FileData *fd = (FileData*)(*bh);
+	/* needs the whole file, see: BLO_blendhandle_from_file_toc */
+	BLI_assert(fd->toc == NULL);
 	return library_append_begin(mainvar, &fd, filepath);
 }
 
@@ -9814,6 +10624,165 @@ void *BLO_library_read_struct(FileData *fd, BHead *bh, const char *blockname)
 
 /* ************* READ LIBRARY ************** */
 
+/* -------------------------------------------------------------------- */
+/** \name Library File Cache
+ *
+ * Library files read in place (mapped, or decompressed at once, see #fd_bheads_in_place_init)
+ * are kept open after reading, so reading the same libraries again (reverting, reloading,
+ * linking more from them) doesn't open, decompress and decode them again.
+ * Mapped files only use memory for the pages which were read.
+ *
+ * Only used from the main thread (like all reading of libraries).
+ * \{ */
+
+/* limits of the files kept, decompressed files use their full size in memory */
+#define LIBRARY_CACHE_FILES_MAX 256
+#define LIBRARY_CACHE_ALLOC_MAX ((size_t)512 * 1024 * 1024)
+
+typedef struct LibraryCacheFile {
+	struct LibraryCacheFile *next, *prev;
+	FileData *fd;
+	char filepath[FILE_MAX];
+	/* to check the file didn't change */
+	BLI_stat_t st;
+} LibraryCacheFile;
+
+static ListBase library_cache = {NULL, NULL};
+
+static size_t library_cache_file_alloc_size(const FileData *fd)
+{
+	return fd->mmap_is_alloc ? fd->mmap_size : 0;
+}
+
+static void library_cache_file_free(LibraryCacheFile *lcf)
+{
+	BLI_remlink(&library_cache, lcf);
+	blo_freefiledata(lcf->fd);
+	MEM_freeN(lcf);
+}
+
+/**
+ * The file wasn't written to since it was kept. Reading pages of a mapped file
+ * which got truncated meanwhile would crash (SIGBUS), so this is checked before every use.
+ */
+static bool library_cache_file_is_valid(const LibraryCacheFile *lcf)
+{
+	BLI_stat_t st;
+	
+	return ((BLI_stat(lcf->filepath, &st) == 0) &&
+	        (st.st_size == lcf->st.st_size) &&
+	        (st.st_mtime == lcf->st.st_mtime) &&
+	        (st.st_ctime == lcf->st.st_ctime) &&
+	        (st.st_ino == lcf->st.st_ino));
+}
+
+/**
+ * Free the files which changed, so their memory and mappings aren't kept until they're read again.
+ */
+static void library_cache_free_invalid(void)
+{
+	LibraryCacheFile *lcf, *lcf_next;
+	
+	for (lcf = library_cache.first; lcf; lcf = lcf_next) {
+		lcf_next = lcf->next;
+		if (!library_cache_file_is_valid(lcf)) {
+			library_cache_file_free(lcf);
+		}
+	}
+}
+
+/**
+ * \return The FileData of \a filepath when it's still the same file, NULL otherwise.
+ */
+static FileData *library_cache_pop(const char *filepath)
+{
+	LibraryCacheFile *lcf;
+	
+	for (lcf = library_cache.first; lcf; lcf = lcf->next) {
+		if (BLI_path_cmp(lcf->filepath, filepath) == 0) {
+			FileData *fd = NULL;
+			
+			if (library_cache_file_is_valid(lcf)) {
+				fd = lcf->fd;
+				lcf->fd = NULL;
+				BLI_remlink(&library_cache, lcf);
+				MEM_freeN(lcf);
+			}
+			else {
+				library_cache_file_free(lcf);
+			}
+			return fd;
+		}
+	}
+	
+	return NULL;
+}
+
+/**
+ * Keep \a fd for the next time its file is read, or free it.
+ */
+static void library_cache_push(FileData *fd)
+{
+	LibraryCacheFile *lcf;
+	size_t alloc_size;
+	int tot;
+	
+	if (fd->mmap_mem == NULL || (fd->flags & FD_FLAGS_SWITCH_ENDIAN) ||
+	    library_cache_file_alloc_size(fd) > LIBRARY_CACHE_ALLOC_MAX)
+	{
+		blo_freefiledata(fd);
+		return;
+	}
+	
+	lcf = MEM_callocN(sizeof(*lcf), __func__);
+	if (BLI_stat(fd->relabase, &lcf->st) != 0) {
+		MEM_freeN(lcf);
+		blo_freefiledata(fd);
+		return;
+	}
+	BLI_strncpy(lcf->filepath, fd->relabase, sizeof(lcf->filepath));
+	
+	/* only what's needed to find the blocks again */
+	if (fd->libmap) {
+		oldnewmap_free(fd->libmap);
+		fd->libmap = NULL;
+	}
+	fd->mainlist = NULL;
+	fd->reports = NULL;
+	lcf->fd = fd;
+	BLI_addhead(&library_cache, lcf);
+	
+	/* free the least recently read files over the limits */
+	alloc_size = 0;
+	tot = 0;
+	for (lcf = library_cache.first; lcf; lcf = lcf->next) {
+		alloc_size += library_cache_file_alloc_size(lcf->fd);
+		tot++;
+	}
+	while ((tot > LIBRARY_CACHE_FILES_MAX) || (alloc_size > LIBRARY_CACHE_ALLOC_MAX)) {
+		lcf = library_cache.last;
+		alloc_size -= library_cache_file_alloc_size(lcf->fd);
+		tot--;
+		library_cache_file_free(lcf);
+	}
+}
+
+void BLO_library_cache_free(void)
+{
+	while (library_cache.first) {
+		library_cache_file_free(library_cache.first);
+	}
+}
+
+/** \} */
+
+/* time and memory used for opening the library files, reported after reading */
+typedef struct LibraryReadStats {
+	int tot, tot_cached;
+	double time_start, time_open;
+	size_t mapped_size, alloc_size;
+} LibraryReadStats;
+
 static int mainvar_count_libread_blocks(Main *mainvar)
 {
 	ListBase *lbarray[MAX_LIBARRAY];
@@ -9836,12 +10805,17 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 	Main *mainl = mainlist->first;
 	Main *mainptr;
 	ListBase *lbarray[MAX_LIBARRAY];
+	LibraryReadStats stats = {0};
 	int a;
 	bool do_it = true;
 	
 	/* expander now is callback function */
 	BLO_main_expander(expand_doit_library);
 	
+	stats.time_start = PIL_check_seconds_timer();
+	
+	library_cache_free_invalid();
+	
 	while (do_it) {
 		do_it = false;
 		
@@ -9855,6 +10829,8 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 				FileData *fd = mainptr->curlib->filedata;
 				
 				if (fd == NULL) {
+					const double time_open = PIL_check_seconds_timer();
+					bool is_cached = false;
 					
 					/* printf and reports for now... its important users know this */
 					
@@ -9878,7 +10854,13 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 						        mainptr->curlib->filepath,
 						        mainptr->curlib->name,
 						        library_parent_filepath(mainptr->curlib));
-						fd = blo_openblenderfile(mainptr->curlib->filepath, basefd->reports);
+						fd = library_cache_pop(mainptr->curlib->filepath);
+						if (fd) {
+							is_cached = true;
+						}
+						else {
+							fd = blo_openblenderfile(mainptr->curlib->filepath, basefd->reports);
+						}
 					}
 					/* allow typing in a new lib path */
 					if (G.debug_value == -666) {
@@ -9925,9 +10907,21 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 						/* subversion */
 						read_file_version(fd, mainptr);
 #ifdef USE_GHASH_BHEAD
-						read_file_bhead_idname_map_create(fd);
+						if (fd->bhead_idname_hash == NULL) {
+							read_file_bhead_idname_map_create(fd);
+						}
 #endif
-
+						
+						stats.tot++;
+						stats.tot_cached += is_cached;
+						if (fd->mmap_is_alloc) stats.alloc_size += fd->mmap_size;
+						else stats.mapped_size += fd->mmap_size;
+						stats.time_open += PIL_check_seconds_timer() - time_open;
+						
+						if (G.debug & G_DEBUG) {
+							printf("read_libraries: '%s' opened in %.2f ms%s\n", mainptr->curlib->filepath,
+							       (PIL_check_seconds_timer() - time_open) * 1000.0, is_cached ? " (cached)" : "");
+						}
 					}
 					else {
 						mainptr->curlib->filedata = NULL;
@@ -10016,9 +11010,18 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 		if (mainptr->curlib->filedata)
 			lib_link_all(mainptr->curlib->filedata, mainptr);
 		
-		if (mainptr->curlib->filedata) blo_freefiledata(mainptr->curlib->filedata);
+		/* packed libraries are freed, the others may be kept */
+		if (mainptr->curlib->filedata) library_cache_push(mainptr->curlib->filedata);
 		mainptr->curlib->filedata = NULL;
 	}
+	
+	if (stats.tot) {
+		blo_reportf_wrap(
+		        basefd->reports, RPT_INFO,
+		        TIP_("Read %d libraries in %.2f s (opening %.2f s, %d were open already), %.1f MB mapped, %.1f MB decompressed"),
+		        stats.tot, PIL_check_seconds_timer() - stats.time_start, stats.time_open, stats.tot_cached,
+		        (double)stats.mapped_size / (1024.0 * 1024.0), (double)stats.alloc_size / (1024.0 * 1024.0));
+	}
 }
 
 
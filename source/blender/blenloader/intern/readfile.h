@@ -62,6 +62,15 @@ typedef struct FileData {
 	int filedes;
 	gzFile gzfiledes;
 
+	/* variables needed for reading from a memory mapped file (see: USE_BHEAD_MMAP)
+	 * or decompressed file (mmap_is_alloc, see: fd_gzip_frames_open),
+	 * the BHeads are used in place, in file order in mmap_bheads */
+	char *mmap_mem;
+	size_t mmap_size;
+	struct BHead **mmap_bheads;
+	int mmap_bheads_num;
+	bool mmap_is_alloc;
+
 	// now only in use for library appending
 	char relabase[FILE_MAX];
 	
@@ -94,6 +103,21 @@ typedef struct FileData {
 
 	/* see: USE_GHASH_BHEAD */
 	struct GHash *bhead_idname_hash;
+
+	/* undo: IDs of the main before reading which can be kept, see: blo_make_undo_reuse_map */
+	struct MemFile *undo_oldmemfile;
+	struct Main *undo_oldmain;
+	struct GHash *undo_old_ids;
+
+	/* table of contents of files opened with blo_openblenderfile_toc,
+	 * nothing else is read then (no BHeads or DNA) */
+	struct BlendFileTocEntry *toc;
+	int toc_num;
+
+	/* see: USE_PARALLEL_DIRECT_LINK */
+	bool use_direct_link_deferred;
+	struct DirectLinkDeferred *direct_link_deferred;
+	int direct_link_deferred_num, direct_link_deferred_len;
 	
 	ListBase *mainlist;
 	
@@ -127,6 +151,8 @@ void blo_split_main(ListBase *mainlist, struct Main *main);
 BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath);
 
 FileData *blo_openblenderfile(const char *filepath, struct ReportList *reports);
+FileData *blo_openblenderfile_toc(const char *filepath);
+bool blo_toc_read_data(FileData *fd, uint64_t offset, void *buf, size_t len);
 FileData *blo_openblendermemory(const void *buffer, int buffersize, struct ReportList *reports);
 FileData *blo_openblendermemfile(struct MemFile *memfile, struct ReportList *reports);
 
@@ -140,6 +166,8 @@ void blo_end_sound_pointer_map(FileData *fd, Main *oldmain);
 void blo_make_packed_pointer_map(FileData *fd, Main *oldmain);
 void blo_end_packed_pointer_map(FileData *fd, Main *oldmain);
 void blo_add_library_pointer_map(ListBase *mainlist, FileData *fd);
+void blo_make_undo_reuse_map(FileData *fd, Main *oldmain, struct MemFile *oldmemfile, struct MemFile *memfile_oldmain);
+void blo_end_undo_reuse_map(FileData *fd, Main *newmain);
 
 void blo_freefiledata(FileData *fd);
 
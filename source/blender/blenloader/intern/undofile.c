@@ -40,97 +40,267 @@
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_threads.h"
 
 #include "BLO_undofile.h"
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/* Chunk buffers are stored once for their contents, and shared by all memfiles using them
+ * (any undo step, not only the previous one). So data which didn't change, or only moved
+ * to another place in the file, doesn't take memory again. */
+struct MemFileBuf {
+	char *data;
+	unsigned int size;
+	unsigned int hash;
+	unsigned int users;
+};
+
+/* all buffers (key and value are the same MemFileBuf), NULL when there are none */
+static GHash *memfile_bufs = NULL;
+/* memfiles can be freed from a thread, see BLO_write_file_snapshot */
+static ThreadMutex memfile_bufs_lock = BLI_MUTEX_INITIALIZER;
+
+static unsigned int memfile_buf_hash(const void *key)
+{
+	return ((const MemFileBuf *)key)->hash;
+}
+
+static bool memfile_buf_cmp(const void *a, const void *b)
+{
+	const MemFileBuf *mbuf_a = a, *mbuf_b = b;
+	return ((mbuf_a->hash != mbuf_b->hash) ||
+	        (mbuf_a->size != mbuf_b->size) ||
+	        (memcmp(mbuf_a->data, mbuf_b->data, mbuf_a->size) != 0));
+}
+
+/**
+ * \return the shared buffer with this data, added when there is none yet (\a r_is_new).
+ */
+static MemFileBuf *memfile_buf_ensure(const char *buf, unsigned int size, bool *r_is_new)
+{
+	MemFileBuf mbuf_key, *mbuf;
+
+	mbuf_key.data = (char *)buf;
+	mbuf_key.size = size;
+	mbuf_key.hash = BLI_hash_mm2((const unsigned char *)buf, size, 0);
+
+	BLI_mutex_lock(&memfile_bufs_lock);
+
+	if (memfile_bufs == NULL) {
+		memfile_bufs = BLI_ghash_new(memfile_buf_hash, memfile_buf_cmp, __func__);
+	}
+
+	mbuf = BLI_ghash_lookup(memfile_bufs, &mbuf_key);
+	*r_is_new = (mbuf == NULL);
+
+	if (mbuf) {
+		mbuf->users++;
+	}
+	else {
+		mbuf = MEM_mallocN(sizeof(*mbuf), "MemFileBuf");
+		mbuf->data = MEM_mallocN(size, "Chunk buffer");
+		memcpy(mbuf->data, buf, size);
+		mbuf->size = size;
+		mbuf->hash = mbuf_key.hash;
+		mbuf->users = 1;
+		BLI_ghash_insert(memfile_bufs, mbuf, mbuf);
+	}
+
+	BLI_mutex_unlock(&memfile_bufs_lock);
+
+	return mbuf;
+}
+
+static void memfile_buf_user_add(MemFileBuf *mbuf)
+{
+	BLI_mutex_lock(&memfile_bufs_lock);
+	mbuf->users++;
+	BLI_mutex_unlock(&memfile_bufs_lock);
+}
+
+static void memfile_buf_user_remove(MemFileBuf *mbuf)
+{
+	BLI_mutex_lock(&memfile_bufs_lock);
+
+	if (--mbuf->users == 0) {
+		BLI_ghash_remove(memfile_bufs, mbuf, NULL, NULL);
+		MEM_freeN(mbuf->data);
+		MEM_freeN(mbuf);
+
+		if (BLI_ghash_size(memfile_bufs) == 0) {
+			BLI_ghash_free(memfile_bufs, NULL, NULL);
+			memfile_bufs = NULL;
+		}
+	}
+
+	BLI_mutex_unlock(&memfile_bufs_lock);
+}
+
 /* not memfile itself */
 void BLO_memfile_free(MemFile *memfile)
 {
 	MemFileChunk *chunk;
 	
 	while ((chunk = BLI_pophead(&memfile->chunks))) {
-		if (chunk->ident == 0)
-			MEM_freeN(chunk->buf);
+		memfile_buf_user_remove(chunk->mbuf);
 		MEM_freeN(chunk);
 	}
+	if (memfile->id_chunks) {
+		BLI_ghash_free(memfile->id_chunks, NULL, NULL);
+		memfile->id_chunks = NULL;
+	}
+	if (memfile->main_read) {
+		BLO_memfile_free(memfile->main_read);
+		MEM_freeN(memfile->main_read);
+		memfile->main_read = NULL;
+	}
 	memfile->size = 0;
 }
 
+/**
+ * Fill \a r_memfile with the chunks of \a memfile, using the same buffers,
+ * so it can be written while \a memfile is freed (see #BLO_write_file_snapshot_memfile).
+ */
+void BLO_memfile_copy_shared(const MemFile *memfile, MemFile *r_memfile)
+{
+	const MemFileChunk *chunk;
+
+	memset(r_memfile, 0, sizeof(*r_memfile));
+
+	for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+		MemFileChunk *chunk_copy = MEM_mallocN(sizeof(*chunk_copy), "MemFileChunk");
+
+		*chunk_copy = *chunk;
+		chunk_copy->ident = 0;
+		chunk_copy->id = NULL;
+		memfile_buf_user_add(chunk_copy->mbuf);
+		BLI_addtail(&r_memfile->chunks, chunk_copy);
+	}
+}
+
 /* to keep list of memfiles consistent, 'first' is always first in list */
 /* result is that 'first' is being freed */
-void BLO_memfile_merge(MemFile *first, MemFile *second)
+void BLO_memfile_merge(MemFile *first, MemFile *UNUSED(second))
 {
-	MemFileChunk *fc, *sc;
-	
-	fc = first->chunks.first;
-	sc = second->chunks.first;
-	while (fc || sc) {
-		if (fc && sc) {
-			if (sc->ident) {
-				sc->ident = 0;
-				fc->ident = 1;
-			}
-		}
-		if (fc) fc = fc->next;
-		if (sc) sc = sc->next;
-	}
-	
+	/* buffers shared with 'second' have their own users, nothing to move over */
 	BLO_memfile_free(first);
 }
 
-static int my_memcmp(const int *mem1, const int *mem2, const int len)
+static MemFile *compfile = NULL;
+static MemFileChunk *compchunk = NULL;
+/* ID started by the next chunk, see memfile_chunk_id_begin */
+static const void *chunk_id = NULL;
+
+/**
+ * The next chunk added starts the data of an ID (using its address as identifier),
+ * compare it to the data of the same ID in the compared memfile from here on,
+ * so inserting or removing an ID before it doesn't make all the following chunks differ.
+ */
+void memfile_chunk_id_begin(const void *id)
 {
-	register int a = len;
-	register const int *mema = mem1;
-	register const int *memb = mem2;
-	
-	while (a--) {
-		if (*mema != *memb) return 1;
-		mema++;
-		memb++;
+	MemFileChunk *chunk;
+
+	if (compfile && compfile->id_chunks && (chunk = BLI_ghash_lookup(compfile->id_chunks, id))) {
+		compchunk = chunk;
 	}
-	return 0;
+	chunk_id = id;
 }
 
 void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size)
 {
-	static MemFileChunk *compchunk = NULL;
 	MemFileChunk *curchunk;
 	
 	/* this function inits when compare != NULL or when current == NULL  */
 	if (compare) {
+		compfile = compare;
 		compchunk = compare->chunks.first;
+		chunk_id = NULL;
 		return;
 	}
 	if (current == NULL) {
+		compfile = NULL;
 		compchunk = NULL;
+		chunk_id = NULL;
 		return;
 	}
 	
 	curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
 	curchunk->size = size;
-	curchunk->buf = NULL;
+	curchunk->mbuf = NULL;
 	curchunk->ident = 0;
+	curchunk->id = chunk_id;
 	BLI_addtail(&current->chunks, curchunk);
 	
-	/* we compare compchunk with buf */
+	if (chunk_id) {
+		if (current->id_chunks == NULL) {
+			current->id_chunks = BLI_ghash_ptr_new(__func__);
+		}
+		BLI_ghash_reinsert(current->id_chunks, (void *)chunk_id, curchunk, NULL, NULL);
+		chunk_id = NULL;
+	}
+	
+	/* we compare compchunk with buf, usually data is unchanged and at the same place,
+	 * that's found without hashing */
 	if (compchunk) {
 		if (compchunk->size == curchunk->size) {
-			if (my_memcmp((int *)compchunk->buf, (const int *)buf, size / 4) == 0) {
-				curchunk->buf = compchunk->buf;
+			if (memcmp(compchunk->buf, buf, size) == 0) {
+				curchunk->mbuf = compchunk->mbuf;
 				curchunk->ident = 1;
+				memfile_buf_user_add(curchunk->mbuf);
 			}
 		}
 		compchunk = compchunk->next;
 	}
 	
-	/* not equal... */
-	if (curchunk->buf == NULL) {
-		curchunk->buf = MEM_mallocN(size, "Chunk buffer");
-		memcpy(curchunk->buf, buf, size);
-		current->size += size;
+	/* not equal, find the data anywhere else or copy it */
+	if (curchunk->mbuf == NULL) {
+		bool is_new;
+		curchunk->mbuf = memfile_buf_ensure(buf, size, &is_new);
+		if (is_new) {
+			current->size += size;
+		}
 	}
+	
+	curchunk->buf = curchunk->mbuf->data;
 }
 
+/**
+ * Is an ID stored the same in both memfiles: the ID block and all data after it,
+ * up to the next ID, use the same buffers.
+ *
+ * \param id: The address of the ID when written, see #memfile_chunk_id_begin.
+ * \param bhead: The block header of the ID (as written), to make sure the chunk found
+ * in \a memfile starts this block (optional).
+ */
+bool memfile_id_is_identical(const MemFile *memfile, const MemFile *memfile_other,
+                             const void *id, const void *bhead, unsigned int bhead_size)
+{
+	MemFileChunk *chunk, *chunk_other;
+
+	if (memfile->id_chunks == NULL || memfile_other->id_chunks == NULL) {
+		return false;
+	}
+
+	chunk = BLI_ghash_lookup(memfile->id_chunks, id);
+	chunk_other = BLI_ghash_lookup(memfile_other->id_chunks, id);
+
+	if (chunk == NULL || chunk_other == NULL ||
+	    chunk->size < bhead_size || (bhead && memcmp(chunk->buf, bhead, bhead_size) != 0))
+	{
+		return false;
+	}
+
+	do {
+		if (chunk->mbuf != chunk_other->mbuf) {
+			return false;
+		}
+		chunk = chunk->next;
+		chunk_other = chunk_other->next;
+	} while (chunk && chunk->id == NULL && chunk_other && chunk_other->id == NULL);
+
+	/* both end with the ID */
+	return ((chunk == NULL || chunk->id) && (chunk_other == NULL || chunk_other->id));
+}
@@ -141,6 +141,7 @@
 #include "MEM_guardedalloc.h" // MEM_freeN
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
+#include "BLI_gzip_frames.h"
 #include "BLI_linklist.h"
 #include "BLI_mempool.h"
 
@@ -150,6 +151,7 @@
 #include "BKE_curve.h"
 #include "BKE_constraint.h"
 #include "BKE_global.h" // for G
+#include "BKE_idcode.h"
 #include "BKE_library.h" // for  set_listbasepointers
 #include "BKE_main.h"
 #include "BKE_node.h"
@@ -187,7 +189,8 @@
 
 typedef enum {
 	WW_WRAP_NONE = 1,
-	WW_WRAP_ZLIB,
+	WW_WRAP_ZLIB_FRAMES,
+	WW_WRAP_MEMFILE,
 } eWriteWrapType;
 
 typedef struct WriteWrap WriteWrap;
@@ -200,7 +203,11 @@ struct WriteWrap {
 	/* internal */
 	union {
 		int file_handle;
-		gzFile gz_handle;
+		struct {
+			int file_handle;
+			GzipFrameWriter *writer;
+		} gz_frames;
+		MemFile *memfile;
 	} _user_data;
 };
 
@@ -232,33 +239,56 @@ static size_t ww_write_none(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
-/* zlib */
+/* zlib, in independently compressed frames (see BLI_gzip_frames.h),
+ * this is a regular gzip file but it can be compressed and read in parallel */
 #define FILE_HANDLE(ww) \
-	(ww)->_user_data.gz_handle
+	(ww)->_user_data.gz_frames.file_handle
+#define FRAME_WRITER(ww) \
+	(ww)->_user_data.gz_frames.writer
 
-static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
+static bool ww_open_zlib_frames(WriteWrap *ww, const char *filepath)
 {
-	gzFile file;
-
-	file = BLI_gzopen(filepath, "wb1");
-
-	if (file != Z_NULL) {
-		FILE_HANDLE(ww) = file;
+	if (ww_open_none(ww, filepath)) {
+		/* same level as gzopen(filepath, "wb1") */
+		FRAME_WRITER(ww) = BLI_gzip_frames_writer_new(FILE_HANDLE(ww), 1);
 		return true;
 	}
 	else {
 		return false;
 	}
 }
-static bool ww_close_zlib(WriteWrap *ww)
+static bool ww_close_zlib_frames(WriteWrap *ww)
 {
-	return (gzclose(FILE_HANDLE(ww)) == Z_OK);
+	/* writes the last frames */
+	const bool ok = BLI_gzip_frames_writer_free(FRAME_WRITER(ww));
+	return (close(FILE_HANDLE(ww)) != -1) && ok;
 }
-static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
+static size_t ww_write_zlib_frames(WriteWrap *ww, const char *buf, size_t buf_len)
 {
-	return gzwrite(FILE_HANDLE(ww), buf, buf_len);
+	return BLI_gzip_frames_writer_write(FRAME_WRITER(ww), buf, buf_len) ? buf_len : 0;
 }
 #undef FILE_HANDLE
+#undef FRAME_WRITER
+
+/* memfile, a copy of the file in memory to write later (see: BLO_write_file_snapshot),
+ * unlike undo this writes the data as for a file, without comparing to an older memfile */
+#define MEMFILE(ww) \
+	(ww)->_user_data.memfile
+
+static bool ww_open_memfile(WriteWrap *UNUSED(ww), const char *UNUSED(filepath))
+{
+	return true;
+}
+static bool ww_close_memfile(WriteWrap *UNUSED(ww))
+{
+	return true;
+}
+static size_t ww_write_memfile(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+	memfile_chunk_add(NULL, MEMFILE(ww), buf, (unsigned int)buf_len);
+	return buf_len;
+}
+#undef MEMFILE
 
 /* --- end compression types --- */
 
@@ -267,11 +297,18 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
 	memset(r_ww, 0, sizeof(*r_ww));
 
 	switch (ww_type) {
-		case WW_WRAP_ZLIB:
+		case WW_WRAP_ZLIB_FRAMES:
 		{
-			r_ww->open  = ww_open_zlib;
-			r_ww->close = ww_close_zlib;
-			r_ww->write = ww_write_zlib;
+			r_ww->open  = ww_open_zlib_frames;
+			r_ww->close = ww_close_zlib_frames;
+			r_ww->write = ww_write_zlib_frames;
+			break;
+		}
+		case WW_WRAP_MEMFILE:
+		{
+			r_ww->open  = ww_open_memfile;
+			r_ww->close = ww_close_memfile;
+			r_ww->write = ww_write_memfile;
 			break;
 		}
 		default:
@@ -295,13 +332,18 @@ typedef struct {
 	unsigned char *buf;
 	MemFile *compare, *current;
 	
-	int tot, count, error, memsize;
+	uint64_t tot;  /* bytes written, offsets in the table of contents can be past 4 GB */
+	int count, error, memsize;
 
 	/* Wrap writing, so we can use zlib or
 	 * other compression types later, see: G_FILE_COMPRESS
 	 * Will be NULL for UNDO. */
 	WriteWrap *ww;
 
+	/* table of contents, written at the end of the file (not for undo) */
+	BlendFileTocEntry *toc;
+	unsigned int toc_num, toc_len;
+
 #ifdef USE_BMESH_SAVE_AS_COMPAT
 	char use_mesh_compat; /* option to save with older mesh format */
 #endif
@@ -346,6 +388,10 @@ static void writedata_free(WriteData *wd)
 {
 	DNA_sdna_free(wd->sdna);
 
+	if (wd->toc) {
+		MEM_freeN(wd->toc);
+	}
+
 	MEM_freeN(wd->buf);
 	MEM_freeN(wd);
 }
@@ -374,7 +420,7 @@ static void mywrite(WriteData *wd, const void *adr, int len)
 		return;
 	}
 
-	wd->tot+= len;
+	wd->tot += (uint64_t)len;
 	
 	/* if we have a single big chunk, write existing data in
 	 * buffer and write out big chunk in smaller pieces */
@@ -405,6 +451,61 @@ static void mywrite(WriteData *wd, const void *adr, int len)
 	wd->count+= len;
 }
 
+/**
+ * Add an entry to the table of contents when the block about to be written starts an ID,
+ * any other block that isn't #DATA ends the previous ID.
+ */
+static void write_toc_block_begin(WriteData *wd, int filecode, const void *data)
+{
+	BlendFileTocEntry *entry;
+
+	if (wd->current || filecode == DATA) {
+		return;
+	}
+
+	if (wd->toc_num) {
+		entry = &wd->toc[wd->toc_num - 1];
+		if (entry->size == 0) {
+			entry->size = wd->tot - entry->offset;
+		}
+	}
+
+	if (!BKE_idcode_is_valid(filecode)) {
+		return;
+	}
+
+	if (wd->toc_num == wd->toc_len) {
+		wd->toc_len = MAX2(wd->toc_len * 2, 256);
+		wd->toc = MEM_reallocN(wd->toc, sizeof(*wd->toc) * wd->toc_len);
+	}
+
+	entry = &wd->toc[wd->toc_num++];
+	memset(entry, 0, sizeof(*entry));
+	entry->offset = wd->tot;
+	entry->code = filecode;
+	BLI_strncpy(entry->name, ((const ID *)data)->name, sizeof(entry->name));
+}
+
+/* after the ENDB block */
+static void write_toc(WriteData *wd)
+{
+	BlendFileTocTail tail;
+
+	if (wd->current) {
+		return;
+	}
+
+	tail.offset = wd->tot;
+	tail.entries_num = wd->toc_num;
+	tail.entry_size = sizeof(BlendFileTocEntry);
+	memcpy(tail.magic, BLEND_TOC_MAGIC, sizeof(tail.magic));
+
+	if (wd->toc_num) {
+		mywrite(wd, wd->toc, (int)(sizeof(*wd->toc) * wd->toc_num));
+	}
+	mywrite(wd, &tail, sizeof(tail));
+}
+
 /**
  * BeGiN initializer for mywrite
  * \param ww: File write wrapper.
@@ -472,6 +573,15 @@ static void writestruct_at_address(WriteData *wd, int filecode, const char *stru
 
 	if (bh.len==0) return;
 
+	/* for undo every ID starts a new chunk, so when the size of data before it changes,
+	 * its chunks are still the same and shared with the previous undo step */
+	if (wd->current && filecode != DATA) {
+		mywrite(wd, MYWRITE_FLUSH, 0);
+		memfile_chunk_id_begin(adr);
+	}
+
+	write_toc_block_begin(wd, filecode, data);
+
 	mywrite(wd, &bh, sizeof(BHead));
 	mywrite(wd, data, bh.len);
 }
@@ -498,6 +608,8 @@ static void writedata(WriteData *wd, int filecode, int len, const void *adr)  /*
 	bh.SDNAnr = 0;
 	bh.len    = len;
 
+	write_toc_block_begin(wd, filecode, adr);
+
 	mywrite(wd, &bh, sizeof(BHead));
 	mywrite(wd, adr, len);
 }
@@ -595,6 +707,7 @@ static void write_previews(WriteData *wd, PreviewImage *prv)
 		short w = prv->w[1];
 		short h = prv->h[1];
 		unsigned int *rect = prv->rect[1];
+		int i;
 
 		/* don't write out large previews if not requested */
 		if (!(U.flag & USER_SAVE_PREVIEWS)) {
@@ -603,8 +716,18 @@ static void write_previews(WriteData *wd, PreviewImage *prv)
 			prv->rect[1] = NULL;
 		}
 		writestruct(wd, DATA, "PreviewImage", 1, prv);
-		if (prv->rect[0]) writedata(wd, DATA, prv->w[0] * prv->h[0] * sizeof(unsigned int), prv->rect[0]);
-		if (prv->rect[1]) writedata(wd, DATA, prv->w[1] * prv->h[1] * sizeof(unsigned int), prv->rect[1]);
+		for (i = 0; i < NUM_ICON_SIZES; i++) {
+			if (prv->rect[i]) {
+				/* the pixels follow the BHead, the preview belongs to the ID written last */
+				if (wd->toc_num) {
+					BlendFileTocEntry *entry = &wd->toc[wd->toc_num - 1];
+					entry->preview_offset[i] = wd->tot + sizeof(BHead);
+					entry->preview_w[i] = prv->w[i];
+					entry->preview_h[i] = prv->h[i];
+				}
+				writedata(wd, DATA, prv->w[i] * prv->h[i] * sizeof(unsigned int), prv->rect[i]);
+			}
+		}
 
 		/* restore preview, we still want to keep it in memory even if not saved to file */
 		if (!(U.flag & USER_SAVE_PREVIEWS) ) {
@@ -1533,10 +1656,19 @@ static void write_modifiers(WriteData *wd, ListBase *modbase)
 	if (modbase == NULL) return;
 	for (md=modbase->first; md; md= md->next) {
 		const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+		ModifierData *md_write;
 		if (mti == NULL) return;
-		
-		writestruct(wd, DATA, mti->structName, 1, md);
-			
+
+		/* runtime data of the last evaluation isn't written, it would change undo steps for nothing */
+		md_write = MEM_dupallocN(md);
+		md_write->eval_time = 0.0f;
+		md_write->eval_memory = 0;
+		md_write->eval_totvert = md_write->eval_totedge = md_write->eval_totpoly = 0;
+		md_write->error = NULL;
+		md_write->checkpoint = NULL;
+		writestruct_at_address(wd, DATA, mti->structName, 1, md, md_write);
+		MEM_freeN(md_write);
+
 		if (md->type==eModifierType_Hook) {
 			HookModifierData *hmd = (HookModifierData*) md;
 			
@@ -2015,6 +2147,10 @@ static void write_meshes(WriteData *wd, ListBase *idbase)
 				Mesh copy_mesh = *mesh;
 				mesh = &copy_mesh;
 
+				/* runtime data, allocated when drawn: undo compares how meshes write, see BLO_read_from_memfile */
+				mesh->bb = NULL;
+				mesh->edit_btmesh = NULL;
+
 #ifdef USE_BMESH_SAVE_WITHOUT_MFACE
 				/* cache only - don't write */
 				mesh->mface = NULL;
@@ -3789,8 +3925,11 @@ static int write_file_handle(
 	/* end of file */
 	memset(&bhead, 0, sizeof(BHead));
 	bhead.code= ENDB;
+	write_toc_block_begin(wd, ENDB, NULL);
 	mywrite(wd, &bhead, sizeof(BHead));
 
+	write_toc(wd);
+
 	blo_join_main(&mainlist);
 
 	return endwrite(wd);
@@ -3831,36 +3970,19 @@ static bool do_history(const char *name, ReportList *reports)
 	return 0;
 }
 
-/* return: success (1) */
-int BLO_write_file(
-        Main *mainvar, const char *filepath, int write_flags, ReportList *reports, const BlendThumbnail *thumb)
+/**
+ * The part of saving which uses Main: remap paths for the new file location and write.
+ * \return error (1), success (0)
+ */
+static int write_file_main(
+        Main *mainvar, WriteWrap *ww, const char *filepath, int write_flags, const BlendThumbnail *thumb)
 {
-	char tempname[FILE_MAX+1];
 	int err, write_user_block;
-	eWriteWrapType ww_type;
-	WriteWrap ww;
 
 	/* path backup/restore */
 	void     *path_list_backup = NULL;
 	const int path_list_flag = (BKE_BPATH_TRAVERSE_SKIP_LIBRARY | BKE_BPATH_TRAVERSE_SKIP_MULTIFILE);
 
-	/* open temporary file, so we preserve the original in case we crash */
-	BLI_snprintf(tempname, sizeof(tempname), "%s@", filepath);
-
-	if (write_flags & G_FILE_COMPRESS) {
-		ww_type = WW_WRAP_ZLIB;
-	}
-	else {
-		ww_type = WW_WRAP_NONE;
-	}
-
-	ww_handle_init(ww_type, &ww);
-
-	if (ww.open(&ww, tempname) == false) {
-		BKE_reportf(reports, RPT_ERROR, "Cannot open file %s for writing: %s", tempname, strerror(errno));
-		return 0;
-	}
-
 	/* check if we need to backup and restore paths */
 	if (UNLIKELY((write_flags & G_FILE_RELATIVE_REMAP) && (G_FILE_SAVE_COPY & write_flags))) {
 		path_list_backup = BKE_bpath_list_backup(mainvar, path_list_flag);
@@ -3897,22 +4019,32 @@ int BLO_write_file(
 		BKE_bpath_relative_convert(mainvar, filepath, NULL); /* note, making relative to something OTHER then G.main->name */
 
 	/* actual file writing */
-	err = write_file_handle(mainvar, &ww, NULL, NULL, write_user_block, write_flags, thumb);
-
-	ww.close(&ww);
+	err = write_file_handle(mainvar, ww, NULL, NULL, write_user_block, write_flags, thumb);
 
 	if (UNLIKELY(path_list_backup)) {
 		BKE_bpath_list_restore(mainvar, path_list_flag, path_list_backup);
 		BKE_bpath_list_free(path_list_backup);
 	}
 
-	if (err) {
-		BKE_report(reports, RPT_ERROR, strerror(errno));
-		remove(tempname);
+	return err;
+}
 
-		return 0;
+static eWriteWrapType write_file_ww_type(int write_flags)
+{
+	if (write_flags & G_FILE_COMPRESS) {
+		return WW_WRAP_ZLIB_FRAMES;
+	}
+	else {
+		return WW_WRAP_NONE;
 	}
+}
 
+/**
+ * Move the written temporary file to \a filepath, keeping file history.
+ * \return success (1)
+ */
+static int write_file_finish(const char *tempname, const char *filepath, int write_flags, ReportList *reports)
+{
 	/* file save to temporary file was successful */
 	/* now do reverse file history (move .blend1 -> .blend2, .blend -> .blend1) */
 	if (write_flags & G_FILE_HISTORY) {
@@ -3931,6 +4063,143 @@ int BLO_write_file(
 	return 1;
 }
 
+/* return: success (1) */
+int BLO_write_file(
+        Main *mainvar, const char *filepath, int write_flags, ReportList *reports, const BlendThumbnail *thumb)
+{
+	char tempname[FILE_MAX+1];
+	int err;
+	WriteWrap ww;
+
+	/* open temporary file, so we preserve the original in case we crash */
+	BLI_snprintf(tempname, sizeof(tempname), "%s@", filepath);
+
+	ww_handle_init(write_file_ww_type(write_flags), &ww);
+
+	if (ww.open(&ww, tempname) == false) {
+		BKE_reportf(reports, RPT_ERROR, "Cannot open file %s for writing: %s", tempname, strerror(errno));
+		return 0;
+	}
+
+	err = write_file_main(mainvar, &ww, filepath, write_flags, thumb);
+
+	/* compressed data is only written out completely on close */
+	if (ww.close(&ww) == false) {
+		err = 1;
+	}
+
+	if (err) {
+		BKE_report(reports, RPT_ERROR, strerror(errno));
+		remove(tempname);
+
+		return 0;
+	}
+
+	return write_file_finish(tempname, filepath, write_flags, reports);
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Saving in two steps
+ *
+ * #BLO_write_file blocks until the file is written (and compressed).
+ * Instead the file can be written to memory first, which is quick,
+ * then written to disk from a thread, since that doesn't use Main anymore.
+ * \{ */
+
+struct BlendFileSnapshot {
+	MemFile memfile;
+	char filepath[FILE_MAX];
+	int write_flags;
+};
+
+/**
+ * Write \a mainvar to memory, as #BLO_write_file would write it to \a filepath.
+ * \return The snapshot to pass to #BLO_write_file_snapshot_save, NULL on failure.
+ */
+BlendFileSnapshot *BLO_write_file_snapshot(
+        Main *mainvar, const char *filepath, int write_flags, ReportList *reports, const BlendThumbnail *thumb)
+{
+	BlendFileSnapshot *snapshot = MEM_callocN(sizeof(*snapshot), __func__);
+	WriteWrap ww;
+
+	ww_handle_init(WW_WRAP_MEMFILE, &ww);
+	ww._user_data.memfile = &snapshot->memfile;
+
+	if (write_file_main(mainvar, &ww, filepath, write_flags, thumb)) {
+		BKE_report(reports, RPT_ERROR, strerror(errno));
+		BLO_write_file_snapshot_free(snapshot);
+		return NULL;
+	}
+
+	BLI_strncpy(snapshot->filepath, filepath, sizeof(snapshot->filepath));
+	snapshot->write_flags = write_flags;
+
+	return snapshot;
+}
+
+/**
+ * A snapshot of a file already written to memory (the undo memfile), without copying its data.
+ */
+BlendFileSnapshot *BLO_write_file_snapshot_memfile(const MemFile *memfile, const char *filepath, int write_flags)
+{
+	BlendFileSnapshot *snapshot = MEM_callocN(sizeof(*snapshot), __func__);
+
+	BLO_memfile_copy_shared(memfile, &snapshot->memfile);
+	BLI_strncpy(snapshot->filepath, filepath, sizeof(snapshot->filepath));
+	snapshot->write_flags = write_flags;
+
+	return snapshot;
+}
+
+/**
+ * Compress and write a snapshot to its file, this doesn't use Main so it can run in a thread.
+ * \return success (1)
+ */
+int BLO_write_file_snapshot_save(const BlendFileSnapshot *snapshot, ReportList *reports)
+{
+	char tempname[FILE_MAX+1];
+	MemFileChunk *chunk;
+	int err = 0;
+	WriteWrap ww;
+
+	BLI_snprintf(tempname, sizeof(tempname), "%s@", snapshot->filepath);
+
+	ww_handle_init(write_file_ww_type(snapshot->write_flags), &ww);
+
+	if (ww.open(&ww, tempname) == false) {
+		BKE_reportf(reports, RPT_ERROR, "Cannot open file %s for writing: %s", tempname, strerror(errno));
+		return 0;
+	}
+
+	for (chunk = snapshot->memfile.chunks.first; chunk; chunk = chunk->next) {
+		if (ww.write(&ww, chunk->buf, chunk->size) != chunk->size) {
+			err = 1;
+			break;
+		}
+	}
+
+	if (ww.close(&ww) == false) {
+		err = 1;
+	}
+
+	if (err) {
+		BKE_report(reports, RPT_ERROR, strerror(errno));
+		remove(tempname);
+
+		return 0;
+	}
+
+	return write_file_finish(tempname, snapshot->filepath, snapshot->write_flags, reports);
+}
+
+void BLO_write_file_snapshot_free(BlendFileSnapshot *snapshot)
+{
+	BLO_memfile_free(&snapshot->memfile);
+	MEM_freeN(snapshot);
+}
+
+/** \} */
+
 /* return: success (1) */
 int BLO_write_file_mem(Main *mainvar, MemFile *compare, MemFile *current, int write_flags)
 {
@@ -120,6 +120,13 @@ void DEG_id_tag_update_ex(struct Main *bmain,
                           struct ID *id,
                           short flag);
 
+/* Tag only the nodes of the given data (pose bone, constraint, modifier...)
+ * for an update in all the dependency graphs, instead of the whole ID.
+ */
+void DEG_data_tag_update_ex(struct Main *bmain,
+                            const struct PointerRNA *ptr,
+                            short flag);
+
 /* Tag given ID type for update.
  *
  * Used by all sort of render engines to quickly check if
@@ -85,6 +85,11 @@ void DEG_stats_simple(const struct Depsgraph *graph,
                       size_t *r_operations,
                       size_t *r_relations);
 
+/* ************************************************ */
+/* Evaluation Timing */
+
+bool DEG_debug_timing_write_chrome_trace(const struct Depsgraph *graph, FILE *f);
+
 /* ************************************************ */
 /* Diagram-Based Graph Debugging */
 
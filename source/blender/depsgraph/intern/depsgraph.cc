@@ -55,6 +55,7 @@ extern "C" {
 #include "depsnode_operation.h"
 #include "depsnode_component.h"
 #include "depsgraph_intern.h"
+#include "depsgraph_debug.h"
 
 static DEG_EditorUpdateIDCb deg_editor_update_id_cb = NULL;
 static DEG_EditorUpdateSceneCb deg_editor_update_scene_cb = NULL;
@@ -63,7 +64,9 @@ static DEG_EditorUpdateScenePreCb deg_editor_update_scene_pre_cb = NULL;
 Depsgraph::Depsgraph()
   : root_node(NULL),
     need_update(false),
-    layers(0)
+    layers(0),
+    profile(NULL),
+    profile_last(NULL)
 {
 	BLI_spin_init(&lock);
 }
@@ -76,6 +79,7 @@ Depsgraph::~Depsgraph()
 	if (this->root_node != NULL) {
 		OBJECT_GUARDED_DELETE(this->root_node, RootDepsNode);
 	}
+	DepsgraphDebug::profile_free(this);
 	BLI_spin_end(&lock);
 }
 
@@ -164,7 +168,8 @@ static bool pointer_to_component_node_criteria(const PointerRNA *ptr,
 		 * so although we have unique ops for modifiers,
 		 * we can't lump them together
 		 */
-		*type = DEPSNODE_TYPE_BONE;
+		/* The whole modifier stack is a single geometry operation. */
+		*type = DEPSNODE_TYPE_GEOMETRY;
 		//*subdata = md->name;
 
 		return true;
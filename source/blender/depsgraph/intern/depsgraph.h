@@ -195,6 +195,11 @@ struct Depsgraph {
 	/* Visible layers bitfield, used for skipping invisible objects updates. */
 	int layers;
 
+	/* Timing of evaluations, only with G_DEBUG_DEPSGRAPH_TIME:
+	 * of the running one, and the last one which evaluated anything. */
+	struct DepsgraphProfile *profile;
+	struct DepsgraphProfile *profile_last;
+
 	// XXX: additional stuff like eval contexts, mempools for allocating nodes from, etc.
 };
 
@@ -32,6 +32,11 @@
 
 //#include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+
+#include "MEM_guardedalloc.h"
+
+#include "PIL_time.h"
 
 extern "C" {
 #include "BLI_utildefines.h"
@@ -855,6 +860,263 @@ void DepsgraphDebug::task_completed(Depsgraph *graph,
 	}
 }
 
+/* ********************* */
+/* Evaluation Timing */
+
+/* Start recording the timing of an evaluation, when G_DEBUG_DEPSGRAPH_TIME is set. */
+void DepsgraphDebug::profile_begin(Depsgraph *graph)
+{
+	if ((G.debug & G_DEBUG_DEPSGRAPH_TIME) == 0) {
+		profile_free(graph);
+		return;
+	}
+
+	DepsgraphProfile *profile = OBJECT_GUARDED_NEW(DepsgraphProfile);
+	profile->critical_path_time = 0.0;
+	profile->critical_path_num = 0;
+	graph->profile = profile;
+
+	for (Depsgraph::OperationNodes::const_iterator it = graph->operations.begin();
+	     it != graph->operations.end();
+	     ++it)
+	{
+		OperationDepsNode *node = *it;
+		node->profile_index = -1;
+		node->ready_time = 0.0;
+	}
+
+	profile->begin_time = PIL_check_seconds_timer();
+}
+
+void DepsgraphDebug::profile_free(Depsgraph *graph)
+{
+	if (graph->profile) {
+		OBJECT_GUARDED_DELETE(graph->profile, DepsgraphProfile);
+		graph->profile = NULL;
+	}
+	if (graph->profile_last) {
+		OBJECT_GUARDED_DELETE(graph->profile_last, DepsgraphProfile);
+		graph->profile_last = NULL;
+	}
+}
+
+void DepsgraphDebug::task_ready(Depsgraph *graph, OperationDepsNode *node)
+{
+	if (graph->profile) {
+		node->ready_time = PIL_check_seconds_timer();
+	}
+}
+
+void DepsgraphDebug::task_profile(Depsgraph *graph,
+                                  OperationDepsNode *node,
+                                  int thread_id,
+                                  double start_time,
+                                  double end_time)
+{
+	DepsgraphProfile *profile = graph->profile;
+
+	if (profile == NULL) {
+		return;
+	}
+
+	DepsgraphProfileOperation op;
+	op.name = node->full_identifier();
+	op.ready_time = (node->ready_time != 0.0) ? node->ready_time : profile->begin_time;
+	op.start_time = start_time;
+	op.end_time = end_time;
+	op.thread_id = thread_id;
+	op.is_critical = false;
+
+	BLI_spin_lock(&graph->lock);
+	node->profile_index = (int)profile->operations.size();
+	profile->operations.push_back(op);
+	profile->nodes.push_back(node);
+	BLI_spin_unlock(&graph->lock);
+}
+
+static bool profile_operation_duration_cmp(const DepsgraphProfileOperation *a,
+                                           const DepsgraphProfileOperation *b)
+{
+	return (a->end_time - a->start_time) > (b->end_time - b->start_time);
+}
+
+static void profile_print(const DepsgraphProfile *profile)
+{
+	const size_t max_lines = 10;
+	double busy_time = 0.0, wait_time = 0.0;
+	vector<const DepsgraphProfileOperation *> slowest;
+	vector<int> threads;
+
+	for (size_t i = 0; i < profile->operations.size(); i++) {
+		const DepsgraphProfileOperation *op = &profile->operations[i];
+		busy_time += op->end_time - op->start_time;
+		wait_time += op->start_time - op->ready_time;
+		slowest.push_back(op);
+		if (std::find(threads.begin(), threads.end(), op->thread_id) == threads.end()) {
+			threads.push_back(op->thread_id);
+		}
+	}
+
+	printf("Depsgraph: %d operations evaluated in %.3f ms (threads used: %d, busy %.3f ms, waited %.3f ms)\n",
+	       (int)profile->operations.size(),
+	       (profile->end_time - profile->begin_time) * 1000.0,
+	       (int)threads.size(),
+	       busy_time * 1000.0,
+	       wait_time * 1000.0);
+
+	printf("  Critical path: %.3f ms, %d operations\n",
+	       profile->critical_path_time * 1000.0,
+	       profile->critical_path_num);
+	for (size_t i = 0, lines = 0; i < profile->operations.size() && lines < max_lines; i++) {
+		const DepsgraphProfileOperation *op = &profile->operations[i];
+		if (op->is_critical && op->end_time > op->start_time) {
+			printf("    %8.3f ms  %s\n", (op->end_time - op->start_time) * 1000.0, op->name.c_str());
+			lines++;
+		}
+	}
+
+	const size_t slowest_num = std::min(max_lines, slowest.size());
+	std::partial_sort(slowest.begin(), slowest.begin() + slowest_num, slowest.end(),
+	                  profile_operation_duration_cmp);
+	printf("  Slowest operations:\n");
+	for (size_t i = 0; i < slowest_num; i++) {
+		const DepsgraphProfileOperation *op = slowest[i];
+		printf("    %8.3f ms  %s (thread %d, waited %.3f ms)\n",
+		       (op->end_time - op->start_time) * 1000.0,
+		       op->name.c_str(),
+		       op->thread_id,
+		       (op->start_time - op->ready_time) * 1000.0);
+	}
+}
+
+/* Find the critical path and print the timing. */
+void DepsgraphDebug::profile_end(Depsgraph *graph)
+{
+	DepsgraphProfile *profile = graph->profile;
+
+	if (profile == NULL) {
+		return;
+	}
+
+	profile->end_time = PIL_check_seconds_timer();
+
+	/* Longest chain ending in every operation, the inputs of an operation
+	 * completed before it so they're always handled first. */
+	const int ops_num = (int)profile->operations.size();
+	vector<double> path_time(ops_num);
+	vector<int> path_prev(ops_num);
+	int path_last = -1;
+
+	for (int i = 0; i < ops_num; i++) {
+		const DepsgraphProfileOperation &op = profile->operations[i];
+		const OperationDepsNode *node = profile->nodes[i];
+		double inputs_time = 0.0;
+
+		path_prev[i] = -1;
+
+		for (OperationDepsNode::Relations::const_iterator it = node->inlinks.begin();
+		     it != node->inlinks.end();
+		     ++it)
+		{
+			DepsRelation *rel = *it;
+			if (rel->from->type == DEPSNODE_TYPE_OPERATION &&
+			    (rel->flag & DEPSREL_FLAG_CYCLIC) == 0)
+			{
+				const int from_index = ((OperationDepsNode *)rel->from)->profile_index;
+				if (from_index != -1 && from_index < i && path_time[from_index] > inputs_time) {
+					inputs_time = path_time[from_index];
+					path_prev[i] = from_index;
+				}
+			}
+		}
+
+		path_time[i] = inputs_time + (op.end_time - op.start_time);
+		if (path_last == -1 || path_time[i] > path_time[path_last]) {
+			path_last = i;
+		}
+	}
+
+	if (path_last != -1) {
+		profile->critical_path_time = path_time[path_last];
+		for (int i = path_last; i != -1; i = path_prev[i]) {
+			profile->operations[i].is_critical = true;
+			profile->critical_path_num++;
+		}
+	}
+
+	profile->nodes.clear();
+	graph->profile = NULL;
+
+	if (ops_num == 0) {
+		/* Keep the timing of the last evaluation that did anything. */
+		OBJECT_GUARDED_DELETE(profile, DepsgraphProfile);
+		return;
+	}
+
+	profile_print(profile);
+
+	if (graph->profile_last) {
+		OBJECT_GUARDED_DELETE(graph->profile_last, DepsgraphProfile);
+	}
+	graph->profile_last = profile;
+}
+
+static void profile_json_string(FILE *f, const char *str)
+{
+	fputc('"', f);
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\') {
+			fputc('\\', f);
+			fputc(*str, f);
+		}
+		else if ((unsigned char)*str < 0x20) {
+			fprintf(f, "\\u%04x", (unsigned char)*str);
+		}
+		else {
+			fputc(*str, f);
+		}
+	}
+	fputc('"', f);
+}
+
+/**
+ * Write the timing of the last evaluation (which evaluated any operations)
+ * in the Chrome trace event format
+ * (chrome://tracing), one event per operation and thread.
+ *
+ * \return false when no timing was recorded, see: G_DEBUG_DEPSGRAPH_TIME.
+ */
+bool DEG_debug_timing_write_chrome_trace(const Depsgraph *graph, FILE *f)
+{
+	const DepsgraphProfile *profile = graph->profile_last;
+
+	if (profile == NULL) {
+		return false;
+	}
+
+	fprintf(f, "{\"traceEvents\": [\n");
+	for (size_t i = 0; i < profile->operations.size(); i++) {
+		const DepsgraphProfileOperation &op = profile->operations[i];
+		fprintf(f, "{\"name\": ");
+		profile_json_string(f, op.name.c_str());
+		fprintf(f, ", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, "
+		        "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"wait_ms\": %.3f}}%s\n",
+		        op.is_critical ? "critical_path" : "operation",
+		        op.thread_id,
+		        (op.start_time - profile->begin_time) * 1e6,
+		        (op.end_time - op.start_time) * 1e6,
+		        (op.start_time - op.ready_time) * 1e3,
+		        (i + 1 < profile->operations.size()) ? "," : "");
+	}
+	fprintf(f, "],\n\"displayTimeUnit\": \"ms\",\n");
+	fprintf(f, "\"otherData\": {\"wall_ms\": %.3f, \"critical_path_ms\": %.3f, \"critical_path_operations\": %d}}\n",
+	        (profile->end_time - profile->begin_time) * 1e3,
+	        profile->critical_path_time * 1e3,
+	        profile->critical_path_num);
+
+	return true;
+}
+
 /* ********** */
 /* Statistics */
 
@@ -46,6 +46,30 @@ struct OperationDepsNode;
 
 struct Depsgraph;
 
+/* Timing of an evaluated operation, see: G_DEBUG_DEPSGRAPH_TIME. */
+struct DepsgraphProfileOperation {
+	string name;          /* full identifier of the operation */
+	double ready_time;    /* when all its inputs were evaluated */
+	double start_time;
+	double end_time;
+	int thread_id;
+	bool is_critical;     /* on the critical path of the evaluation */
+};
+
+/* Timing of an evaluation of a graph. */
+struct DepsgraphProfile {
+	double begin_time;
+	double end_time;
+	/* In order of completion, so inputs are always before the operations using them. */
+	vector<DepsgraphProfileOperation> operations;
+	/* Longest chain of dependent operations, evaluation can't be faster than this. */
+	double critical_path_time;
+	int critical_path_num;
+
+	/* Nodes of the operations, only valid during evaluation. */
+	vector<OperationDepsNode *> nodes;
+};
+
 struct DepsgraphDebug {
 	static DepsgraphStats *stats;
 
@@ -65,6 +89,16 @@ struct DepsgraphDebug {
 	                           const OperationDepsNode *node,
 	                           double time);
 
+	static void profile_begin(Depsgraph *graph);
+	static void profile_end(Depsgraph *graph);
+	static void profile_free(Depsgraph *graph);
+	static void task_ready(Depsgraph *graph, OperationDepsNode *node);
+	static void task_profile(Depsgraph *graph,
+	                         OperationDepsNode *node,
+	                         int thread_id,
+	                         double start_time,
+	                         double end_time);
+
 	static DepsgraphStatsID *get_id_stats(ID *id, bool create);
 	static DepsgraphStatsComponent *get_component_stats(DepsgraphStatsID *id_stats,
 	                                                    const string &name,
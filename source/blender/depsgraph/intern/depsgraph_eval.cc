@@ -132,7 +132,7 @@ struct DepsgraphEvalState {
 
 static void deg_task_run_func(TaskPool *pool,
                               void *taskdata,
-                              int UNUSED(threadid))
+                              int threadid)
 {
 	DepsgraphEvalState *state = (DepsgraphEvalState *)BLI_task_pool_userdata(pool);
 	OperationDepsNode *node = (OperationDepsNode *)taskdata;
@@ -159,6 +159,12 @@ static void deg_task_run_func(TaskPool *pool,
 		DepsgraphDebug::task_completed(state->graph,
 		                               node,
 		                               end_time - start_time);
+		DepsgraphDebug::task_profile(state->graph, node, threadid, start_time, end_time);
+	}
+	else if (state->graph->profile) {
+		/* Recorded as well, so the dependencies through them are known. */
+		double time = PIL_check_seconds_timer();
+		DepsgraphDebug::task_profile(state->graph, node, threadid, time, time);
 	}
 
 	schedule_children(pool, state->graph, node, state->layers);
@@ -245,6 +251,7 @@ static void schedule_graph(TaskPool *pool,
 		    node->num_links_pending == 0 &&
 		    (id_node->layers & layers) != 0)
 		{
+			DepsgraphDebug::task_ready(graph, node);
 			BLI_task_pool_push(pool, deg_task_run_func, node, false, TASK_PRIORITY_LOW);
 			node->scheduled = true;
 		}
@@ -286,6 +293,7 @@ static void schedule_children(TaskPool *pool,
 				BLI_spin_unlock(&graph->lock);
 
 				if (need_schedule) {
+					DepsgraphDebug::task_ready(graph, child);
 					BLI_task_pool_push(pool, deg_task_run_func, child, false, TASK_PRIORITY_LOW);
 				}
 			}
@@ -350,12 +358,14 @@ void DEG_evaluate_on_refresh_ex(EvaluationContext *eval_ctx,
 	}
 
 	DepsgraphDebug::eval_begin(eval_ctx);
+	DepsgraphDebug::profile_begin(graph);
 
 	schedule_graph(task_pool, graph, layers);
 
 	BLI_task_pool_work_and_wait(task_pool);
 	BLI_task_pool_free(task_pool);
 
+	DepsgraphDebug::profile_end(graph);
 	DepsgraphDebug::eval_end(eval_ctx);
 
 	/* Clear any uncleared tags - just in case. */
@@ -50,6 +50,8 @@ extern "C" {
 #include "BKE_screen.h"
 #undef new
 
+#include "RNA_access.h"
+
 #include "DEG_depsgraph.h"
 } /* extern "C" */
 
@@ -238,6 +240,36 @@ void DEG_id_tag_update_ex(Main *bmain, ID *id, short flag)
 #endif
 }
 
+/* Tag only the nodes of the given data (pose bone, constraint, modifier...)
+ * for an update in all the dependency graphs, so only what depends on it gets
+ * re-evaluated. Falls back to tagging the whole ID when there's no such node.
+ */
+void DEG_data_tag_update_ex(Main *bmain, const PointerRNA *ptr, short flag)
+{
+	ID *id = (ID *)ptr->id.data;
+	if (id == NULL) {
+		return;
+	}
+	DEG_DEBUG_PRINTF("%s: id=%s type=%s\n",
+	                 __func__, id->name, RNA_struct_identifier(ptr->type));
+	lib_id_recalc_tag_flag(bmain, id, flag);
+	for (Scene *scene = (Scene *)bmain->scene.first;
+	     scene != NULL;
+	     scene = (Scene *)scene->id.next)
+	{
+		if (scene->depsgraph) {
+			Depsgraph *graph = scene->depsgraph;
+			DepsNode *node = graph->find_node_from_pointer(ptr, NULL);
+			if (node != NULL) {
+				node->tag_update(graph);
+			}
+			else {
+				DEG_graph_id_tag_update(bmain, graph, id);
+			}
+		}
+	}
+}
+
 /* Tag given ID type for update. */
 void DEG_id_type_tag(Main *bmain, short idtype)
 {
@@ -349,17 +381,10 @@ void DEG_graph_flush_updates(Main *bmain, Depsgraph *graph)
 			}
 		}
 
-		/* TODO(sergey): For until incremental updates are possible
-		 * witin a component at least we tag the whole component
-		 * for update.
+		/* Other operations of the component which have to be
+		 * re-evaluated along with this one.
 		 */
-		for (ComponentDepsNode::OperationMap::iterator it = node->owner->operations.begin();
-		     it != node->owner->operations.end();
-		     ++it)
-		{
-			OperationDepsNode *op = it->second;
-			op->flag |= DEPSOP_FLAG_NEEDS_UPDATE;
-		}
+		node->owner->flush_update_tag(node);
 	}
 }
 
@@ -204,7 +204,10 @@ void ComponentDepsNode::clear_operations()
 void ComponentDepsNode::tag_update(Depsgraph *graph)
 {
 	OperationDepsNode *entry_op = get_entry_operation();
-	if (entry_op != NULL && entry_op->flag & DEPSOP_FLAG_NEEDS_UPDATE) {
+	/* Only skip when tagged directly, operations tagged by the flush of
+	 * another component are not always flushed further themselves.
+	 */
+	if (entry_op != NULL && entry_op->flag & DEPSOP_FLAG_DIRECTLY_MODIFIED) {
 		return;
 	}
 	for (OperationMap::const_iterator it = operations.begin(); it != operations.end(); ++it) {
@@ -213,6 +216,14 @@ void ComponentDepsNode::tag_update(Depsgraph *graph)
 	}
 }
 
+void ComponentDepsNode::flush_update_tag(OperationDepsNode *UNUSED(op_node))
+{
+	for (OperationMap::const_iterator it = operations.begin(); it != operations.end(); ++it) {
+		OperationDepsNode *op = it->second;
+		op->flag |= DEPSOP_FLAG_NEEDS_UPDATE;
+	}
+}
+
 OperationDepsNode *ComponentDepsNode::get_entry_operation()
 {
 	if (entry_operation)
@@ -263,6 +274,22 @@ static DepsNodeFactoryImpl<SequencerComponentDepsNode> DNTI_SEQUENCER;
 
 /* Pose Component ========================================= */
 
+void PoseComponentDepsNode::flush_update_tag(OperationDepsNode *UNUSED(op_node))
+{
+	/* The init builds the IK trees which are freed again by the cleanup,
+	 * bones keep their results from the previous evaluation.
+	 */
+	OperationDepsNode *entry_op = get_entry_operation();
+	OperationDepsNode *exit_op = get_exit_operation();
+
+	if (entry_op != NULL) {
+		entry_op->flag |= DEPSOP_FLAG_NEEDS_UPDATE;
+	}
+	if (exit_op != NULL) {
+		exit_op->flag |= DEPSOP_FLAG_NEEDS_UPDATE;
+	}
+}
+
 DEG_DEPSNODE_DEFINE(PoseComponentDepsNode, DEPSNODE_TYPE_EVAL_POSE, "Pose Eval Component");
 static DepsNodeFactoryImpl<PoseComponentDepsNode> DNTI_EVAL_POSE;
 
@@ -127,6 +127,12 @@ struct ComponentDepsNode : public DepsNode {
 
 	void tag_update(Depsgraph *graph);
 
+	/* Tag operations which are to be re-evaluated together with the given one,
+	 * when the update flush reaches it. Operations of most components form a
+	 * pipeline which can only be re-run as a whole, so all of them are tagged.
+	 */
+	virtual void flush_update_tag(OperationDepsNode *op_node);
+
 	/* Evaluation Context Management .................. */
 
 	/* Initialize component's evaluation context used for the specified purpose */
@@ -175,6 +181,11 @@ struct SequencerComponentDepsNode : public ComponentDepsNode {
 };
 
 struct PoseComponentDepsNode : public ComponentDepsNode {
+	/* Only the pose init and cleanup are needed for every update, IK solvers
+	 * and bones are only evaluated when the update reaches them.
+	 */
+	void flush_update_tag(OperationDepsNode *op_node);
+
 	DEG_DEPSNODE_DECLARE;
 };
 
@@ -56,6 +56,8 @@ const char *DEG_OPNAMES[] = {
 
 OperationDepsNode::OperationDepsNode() :
     eval_priority(0.0f),
+    ready_time(0.0),
+    profile_index(-1),
     flag(0)
 {
 }
@@ -87,7 +89,7 @@ string OperationDepsNode::full_identifier() const
 
 void OperationDepsNode::tag_update(Depsgraph *graph)
 {
-	if (flag & DEPSOP_FLAG_NEEDS_UPDATE) {
+	if (flag & DEPSOP_FLAG_DIRECTLY_MODIFIED) {
 		return;
 	}
 	/* Tag for update, but also note that this was the source of an update. */
@@ -77,6 +77,10 @@ struct OperationDepsNode : public DepsNode {
 	float eval_priority;
 	bool scheduled;
 
+	/* Evaluation timing, see: DepsgraphDebug::profile_begin(). */
+	double ready_time;            /* when all inputs were evaluated */
+	int profile_index;            /* in DepsgraphProfile.operations, -1 when not evaluated */
+
 	short optype;                 /* (eDepsOperation_Type) stage of evaluation */
 	int   opcode;                 /* (eDepsOperation_Code) identifier for the operation being performed */
 
@@ -972,6 +972,18 @@ static uiLayout *draw_modifier(
 				        "OBJECT_OT_modifier_copy");
 			}
 		}
+
+		/* evaluation time, set for mesh modifiers */
+		if (md->eval_time > 0.0f) {
+			char time_str[64];
+			if (md->checkpoint && md->checkpoint->has_key) {
+				BLI_snprintf(time_str, sizeof(time_str), IFACE_("%.1f ms, cached"), md->eval_time);
+			}
+			else {
+				BLI_snprintf(time_str, sizeof(time_str), IFACE_("%.1f ms"), md->eval_time);
+			}
+			uiItemL(row, time_str, ICON_NONE);
+		}
 		
 		/* result is the layout block inside the box, that we return so that modifier settings can be drawn */
 		result = uiLayoutColumn(box, false);
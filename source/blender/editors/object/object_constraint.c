@@ -1219,16 +1219,21 @@ void ED_object_constraint_dependency_update(Main *bmain, Object *ob)
 
 void ED_object_constraint_tag_update(Object *ob, bConstraint *con)
 {
+	PointerRNA ptr;
+
 	if (ob->pose) {
 		BKE_pose_tag_update_constraint_flags(ob->pose);
 	}
 
 	object_test_constraint(ob, con);
 
+	/* only the bone or object transform owning the constraint needs updating */
+	RNA_pointer_create(&ob->id, &RNA_Constraint, con, &ptr);
+
 	if (ob->type == OB_ARMATURE)
-		DAG_id_tag_update(&ob->id, OB_RECALC_DATA | OB_RECALC_OB);
+		DAG_data_tag_update(&ptr, OB_RECALC_DATA | OB_RECALC_OB);
 	else
-		DAG_id_tag_update(&ob->id, OB_RECALC_OB);
+		DAG_data_tag_update(&ptr, OB_RECALC_OB);
 }
 
 void ED_object_constraint_dependency_tag_update(Main *bmain, Object *ob, bConstraint *con)
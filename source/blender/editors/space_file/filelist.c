@@ -2246,7 +2246,7 @@ static int filelist_readjob_list_lib(const char *root, ListBase *entries, const
 	}
 
 	/* there we go */
-	libfiledata = BLO_blendhandle_from_file(dir, NULL);
+	libfiledata = BLO_blendhandle_from_file_toc(dir, NULL);
 	if (libfiledata == NULL) {
 		return nbr_entries;
 	}
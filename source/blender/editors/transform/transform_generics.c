@@ -887,7 +887,24 @@ static void recalcData_objects(TransInfo *t)
 		
 		/* old optimize trick... this enforces to bypass the depgraph */
 		if (!(arm->flag & ARM_DELAYDEFORM)) {
-			DAG_id_tag_update(&ob->id, OB_RECALC_DATA);  /* sets recalc flags */
+			bool tagged = false;
+
+			/* only the transformed bones and what depends on them need updating,
+			 * unless auto-IK added temporary constraints */
+			if ((t->flag & T_AUTOIK) == 0) {
+				bPoseChannel *pchan;
+				for (pchan = ob->pose->chanbase.first; pchan; pchan = pchan->next) {
+					if (pchan->bone && (pchan->bone->flag & BONE_TRANSFORM)) {
+						PointerRNA ptr;
+						RNA_pointer_create(&ob->id, &RNA_PoseBone, pchan, &ptr);
+						DAG_data_tag_update(&ptr, OB_RECALC_DATA);  /* sets recalc flags */
+						tagged = true;
+					}
+				}
+			}
+			if (!tagged) {
+				DAG_id_tag_update(&ob->id, OB_RECALC_DATA);  /* sets recalc flags */
+			}
 			/* transformation of pose may affect IK tree, make sure it is rebuilt */
 			BIK_clear_data(ob->pose);
 		}
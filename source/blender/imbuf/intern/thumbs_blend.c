@@ -56,7 +56,7 @@ ImBuf *IMB_thumb_load_blend(const char *blen_path, const char *blen_group, const
 
 	if (blen_group && blen_id) {
 		LinkNode *ln, *names, *lp, *previews = NULL;
-		struct BlendHandle *libfiledata = BLO_blendhandle_from_file(blen_path, NULL);
+		struct BlendHandle *libfiledata = BLO_blendhandle_from_file_toc(blen_path, NULL);
 		int idcode = BKE_idcode_from_name(blen_group);
 		int i, nprevs, nnames;
 
@@ -280,6 +280,11 @@ enum {
 	LIB_TESTIND         = (LIB_NEED_EXPAND | LIB_INDIRECT),
 	LIB_READ            = 1 << 4,
 	LIB_NEED_LINK       = 1 << 5,
+	/* undo: stored the same in the undo step read as in the current one,
+	 * for the IDs before reading: nothing changed them since their undo step */
+	LIB_UNDO_UNCHANGED  = 1 << 6,
+	/* undo: the ID, or the object's derived data, is kept from before reading the undo step */
+	LIB_UNDO_KEPT       = 1 << 7,
 
 	LIB_NEW             = 1 << 8,
 	LIB_FAKEUSER        = 1 << 9,
@@ -50,6 +50,7 @@ typedef struct CustomDataLayer {
 	int uid;        /* shape keyblock unique id reference*/
 	char name[64];  /* layer name, MAX_CUSTOMDATA_LAYER_NAME */
 	void *data;     /* layer data */
+	struct CustomDataShared *shared;  /* runtime, users of data shared between layers (CD_SHARE) */
 } CustomDataLayer;
 
 #define MAX_CUSTOMDATA_LAYER_NAME 64
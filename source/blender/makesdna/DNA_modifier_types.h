@@ -103,13 +103,17 @@ typedef struct ModifierData {
 	struct ModifierData *next, *prev;
 
 	int type, mode;
-	int stackindex, pad;
+	int stackindex;
+	float eval_time;  /* runtime, milliseconds taken by the last evaluation */
+	int eval_memory;  /* runtime, peak kilobytes allocated by the last evaluation, 0 outside modifiers_profile() */
+	int eval_totvert, eval_totedge, eval_totpoly;  /* runtime, size of the result of the last evaluation */
 	char name[64];  /* MAX_NAME */
 
 	/* XXX for timing info set by caller... solve later? (ton) */
 	struct Scene *scene;
 
 	char *error;
+	struct ModifierCheckpoint *checkpoint;  /* runtime, cached stack result, see mesh_calc_modifiers() */
 } ModifierData;
 
 typedef enum {
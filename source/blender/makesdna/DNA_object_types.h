@@ -278,6 +278,9 @@ typedef struct Object {
 	/* Runtime valuated curve-specific data, not stored in the file */
 	struct CurveCache *curve_cache;
 
+	/* Runtime, split normals data kept while only the geometry changes, see BKE_mesh_normals_loop_split_ex() */
+	struct MLoopNorSplitCache *lnor_split_cache;
+
 	struct DerivedMesh *derivedDeform, *derivedFinal;
 	uint64_t lastDataMask;   /* the custom data layer mask that was last used to calculate derivedDeform and derivedFinal */
 	uint64_t customdata_mask; /* (extra) custom data layer mask to use for creating derivedmesh, set by depsgraph */
@@ -55,6 +55,21 @@ static void rna_Depsgraph_debug_graphviz(Depsgraph *graph, const char *filename)
 	fclose(f);
 }
 
+static void rna_Depsgraph_debug_timing_export(Depsgraph *graph, ReportList *reports, const char *filename)
+{
+	FILE *f = fopen(filename, "w");
+	if (f == NULL) {
+		BKE_reportf(reports, RPT_ERROR, "Cannot open '%s' for writing", filename);
+		return;
+	}
+
+	if (!DEG_debug_timing_write_chrome_trace(graph, f)) {
+		BKE_report(reports, RPT_WARNING, "No evaluation timing recorded, enable bpy.app.debug_depsgraph_time first");
+	}
+
+	fclose(f);
+}
+
 static void rna_Depsgraph_debug_rebuild(Depsgraph *UNUSED(graph), Main *bmain)
 {
 	Scene *sce;
@@ -95,6 +110,14 @@ static void rna_def_depsgraph(BlenderRNA *brna)
 	                                "File in which to store graphviz debug output");
 	RNA_def_property_flag(parm, PROP_REQUIRED);
 
+	func = RNA_def_function(srna, "debug_timing_export", "rna_Depsgraph_debug_timing_export");
+	RNA_def_function_ui_description(func, "Write the timing of the last evaluation as a Chrome trace "
+	                                "(needs bpy.app.debug_depsgraph_time)");
+	RNA_def_function_flag(func, FUNC_USE_REPORTS);
+	parm = RNA_def_string_file_path(func, "filename", NULL, FILE_MAX, "File Name",
+	                                "File in which to store the trace, in JSON");
+	RNA_def_property_flag(parm, PROP_REQUIRED);
+
 	func = RNA_def_function(srna, "debug_rebuild", "rna_Depsgraph_debug_rebuild");
 	RNA_def_function_flag(func, FUNC_USE_MAIN);
 	RNA_def_property_flag(parm, PROP_REQUIRED);
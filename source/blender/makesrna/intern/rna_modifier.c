@@ -422,10 +422,16 @@ static char *rna_Modifier_path(PointerRNA *ptr)
 
 static void rna_Modifier_update(Main *UNUSED(bmain), Scene *UNUSED(scene), PointerRNA *ptr)
 {
-	DAG_id_tag_update(ptr->id.data, OB_RECALC_DATA);
+	DAG_data_tag_update(ptr, OB_RECALC_DATA);
 	WM_main_add_notifier(NC_OBJECT | ND_MODIFIER, ptr->id.data);
 }
 
+static int rna_Modifier_is_cached_get(PointerRNA *ptr)
+{
+	ModifierData *md = ptr->data;
+	return (md->checkpoint && md->checkpoint->has_key);
+}
+
 static void rna_Modifier_dependency_update(Main *bmain, Scene *scene, PointerRNA *ptr)
 {
 	rna_Modifier_update(bmain, scene, ptr);
@@ -4642,6 +4648,42 @@ void RNA_def_modifier(BlenderRNA *brna)
 	RNA_def_property_ui_icon(prop, ICON_SURFACE_DATA, 0);
 	RNA_def_property_update(prop, 0, "rna_Modifier_update");
 
+	/* evaluation */
+	prop = RNA_def_property(srna, "eval_time_ms", PROP_FLOAT, PROP_NONE);
+	RNA_def_property_float_sdna(prop, NULL, "eval_time");
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_ui_text(prop, "Evaluation Time",
+	                         "Time taken by the last evaluation of the modifier, in milliseconds");
+
+	prop = RNA_def_property(srna, "eval_memory_kb", PROP_INT, PROP_UNSIGNED);
+	RNA_def_property_int_sdna(prop, NULL, "eval_memory");
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_ui_text(prop, "Evaluation Memory",
+	                         "Peak memory allocated by the last evaluation of the modifier, in kilobytes "
+	                         "(always 0, unless evaluated by the --profile-modifiers command line option)");
+
+	prop = RNA_def_property(srna, "eval_vertex_count", PROP_INT, PROP_UNSIGNED);
+	RNA_def_property_int_sdna(prop, NULL, "eval_totvert");
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_ui_text(prop, "Evaluated Vertices", "Number of vertices in the result of the last evaluation");
+
+	prop = RNA_def_property(srna, "eval_edge_count", PROP_INT, PROP_UNSIGNED);
+	RNA_def_property_int_sdna(prop, NULL, "eval_totedge");
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_ui_text(prop, "Evaluated Edges", "Number of edges in the result of the last evaluation");
+
+	prop = RNA_def_property(srna, "eval_face_count", PROP_INT, PROP_UNSIGNED);
+	RNA_def_property_int_sdna(prop, NULL, "eval_totpoly");
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_ui_text(prop, "Evaluated Faces", "Number of faces in the result of the last evaluation");
+
+	prop = RNA_def_property(srna, "is_cached", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_funcs(prop, "rna_Modifier_is_cached_get", NULL);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_ui_text(prop, "Cached",
+	                         "The result of the stack up to this modifier is kept, "
+	                         "changes to later modifiers don't evaluate it again");
+
 	/* types */
 	rna_def_modifier_subsurf(brna);
 	rna_def_modifier_lattice(brna);
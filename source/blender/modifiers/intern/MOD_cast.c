@@ -133,97 +133,61 @@ static void updateDepsgraph(ModifierData *md,
 	}
 }
 
-static void sphere_do(
-        CastModifierData *cmd, Object *ob, DerivedMesh *dm,
-        float (*vertexCos)[3], int numVerts)
-{
-	MDeformVert *dvert = NULL;
-
-	Object *ctrl_ob = NULL;
-
-	int i, defgrp_index;
-	bool has_radius = false;
+typedef struct CastUserdata {
+	CastModifierData *cmd;
+	MDeformVert *dvert;
+	int defgrp_index;
+	float (*vertexCos)[3];
+	bool use_ctrl_ob;
+	bool has_radius;
 	short flag, type;
-	float len = 0.0f;
-	float fac = cmd->fac;
-	float facm = 1.0f - fac;
-	const float fac_orig = fac;
-	float vec[3], center[3] = {0.0f, 0.0f, 0.0f};
+	float len;
+	float center[3];
 	float mat[4][4], imat[4][4];
+	float bb[8][3];
+	/* bound box, reduced from the thread's own bounds */
+	float min[3], max[3];
+} CastUserdata;
 
-	flag = cmd->flag;
-	type = cmd->type; /* projection type: sphere or cylinder */
-
-	if (type == MOD_CAST_TYPE_CYLINDER) 
-		flag &= ~MOD_CAST_Z;
-
-	ctrl_ob = cmd->object;
-
-	/* spherify's center is {0, 0, 0} (the ob's own center in its local
-	 * space), by default, but if the user defined a control object,
-	 * we use its location, transformed to ob's local space */
-	if (ctrl_ob) {
-		if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-			invert_m4_m4(imat, ctrl_ob->obmat);
-			mul_m4_m4m4(mat, imat, ob->obmat);
-			invert_m4_m4(imat, mat);
-		}
-
-		invert_m4_m4(ob->imat, ob->obmat);
-		mul_v3_m4v3(center, ob->imat, ctrl_ob->obmat[3]);
-	}
-
-	/* now we check which options the user wants */
-
-	/* 1) (flag was checked in the "if (ctrl_ob)" block above) */
-	/* 2) cmd->radius > 0.0f: only the vertices within this radius from
-	 * the center of the effect should be deformed */
-	if (cmd->radius > FLT_EPSILON) has_radius = 1;
-
-	/* 3) if we were given a vertex group name,
-	 * only those vertices should be affected */
-	modifier_get_vgroup(ob, dm, cmd->defgrp_name, &dvert, &defgrp_index);
-
-	if (flag & MOD_CAST_SIZE_FROM_RADIUS) {
-		len = cmd->radius;
-	}
-	else {
-		len = cmd->size;
-	}
-
-	if (len <= 0) {
-		for (i = 0; i < numVerts; i++) {
-			len += len_v3v3(center, vertexCos[i]);
-		}
-		len /= numVerts;
-
-		if (len == 0.0f) len = 10.0f;
-	}
+static void sphere_do_range(
+        void *__restrict userdata, int start, int stop, void *__restrict UNUSED(scratch))
+{
+	CastUserdata *data = userdata;
+	const CastModifierData *cmd = data->cmd;
+	MDeformVert *dvert = data->dvert;
+	float (*vertexCos)[3] = data->vertexCos;
+	const short flag = data->flag;
+	const float len = data->len;
+	const float fac_orig = cmd->fac;
+	float fac = fac_orig;
+	float facm = 1.0f - fac;
+	float vec[3];
+	int i;
 
-	for (i = 0; i < numVerts; i++) {
+	for (i = start; i < stop; i++) {
 		float tmp_co[3];
 
 		copy_v3_v3(tmp_co, vertexCos[i]);
-		if (ctrl_ob) {
+		if (data->use_ctrl_ob) {
 			if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-				mul_m4_v3(mat, tmp_co);
+				mul_m4_v3(data->mat, tmp_co);
 			}
 			else {
-				sub_v3_v3(tmp_co, center);
+				sub_v3_v3(tmp_co, data->center);
 			}
 		}
 
 		copy_v3_v3(vec, tmp_co);
 
-		if (type == MOD_CAST_TYPE_CYLINDER)
+		if (data->type == MOD_CAST_TYPE_CYLINDER)
 			vec[2] = 0.0f;
 
-		if (has_radius) {
+		if (data->has_radius) {
 			if (len_v3(vec) > cmd->radius) continue;
 		}
 
 		if (dvert) {
-			const float weight = defvert_find_weight(&dvert[i], defgrp_index);
+			const float weight = defvert_find_weight(&dvert[i], data->defgrp_index);
 			if (weight == 0.0f) {
 				continue;
 			}
@@ -241,12 +205,12 @@ static void sphere_do(
 		if (flag & MOD_CAST_Z)
 			tmp_co[2] = fac * vec[2] * len + facm * tmp_co[2];
 
-		if (ctrl_ob) {
+		if (data->use_ctrl_ob) {
 			if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-				mul_m4_v3(imat, tmp_co);
+				mul_m4_v3(data->imat, tmp_co);
 			}
 			else {
-				add_v3_v3(tmp_co, center);
+				add_v3_v3(tmp_co, data->center);
 			}
 		}
 
@@ -254,121 +218,138 @@ static void sphere_do(
 	}
 }
 
-static void cuboid_do(
+static void sphere_do(
         CastModifierData *cmd, Object *ob, DerivedMesh *dm,
         float (*vertexCos)[3], int numVerts)
 {
-	MDeformVert *dvert = NULL;
+	CastUserdata data = {NULL};
 	Object *ctrl_ob = NULL;
 
-	int i, defgrp_index;
-	bool has_radius = false;
-	short flag;
-	float fac = cmd->fac;
-	float facm = 1.0f - fac;
-	const float fac_orig = fac;
-	float min[3], max[3], bb[8][3];
-	float center[3] = {0.0f, 0.0f, 0.0f};
-	float mat[4][4], imat[4][4];
+	int i;
+	short flag, type;
+	float len = 0.0f;
 
 	flag = cmd->flag;
+	type = cmd->type; /* projection type: sphere or cylinder */
+
+	if (type == MOD_CAST_TYPE_CYLINDER) 
+		flag &= ~MOD_CAST_Z;
 
 	ctrl_ob = cmd->object;
 
+	/* spherify's center is {0, 0, 0} (the ob's own center in its local
+	 * space), by default, but if the user defined a control object,
+	 * we use its location, transformed to ob's local space */
+	if (ctrl_ob) {
+		if (flag & MOD_CAST_USE_OB_TRANSFORM) {
+			invert_m4_m4(data.imat, ctrl_ob->obmat);
+			mul_m4_m4m4(data.mat, data.imat, ob->obmat);
+			invert_m4_m4(data.imat, data.mat);
+		}
+
+		invert_m4_m4(ob->imat, ob->obmat);
+		mul_v3_m4v3(data.center, ob->imat, ctrl_ob->obmat[3]);
+	}
+
 	/* now we check which options the user wants */
 
 	/* 1) (flag was checked in the "if (ctrl_ob)" block above) */
 	/* 2) cmd->radius > 0.0f: only the vertices within this radius from
 	 * the center of the effect should be deformed */
-	if (cmd->radius > FLT_EPSILON) has_radius = 1;
+	if (cmd->radius > FLT_EPSILON) data.has_radius = true;
 
 	/* 3) if we were given a vertex group name,
 	 * only those vertices should be affected */
-	modifier_get_vgroup(ob, dm, cmd->defgrp_name, &dvert, &defgrp_index);
+	modifier_get_vgroup(ob, dm, cmd->defgrp_name, &data.dvert, &data.defgrp_index);
 
-	if (ctrl_ob) {
-		if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-			invert_m4_m4(imat, ctrl_ob->obmat);
-			mul_m4_m4m4(mat, imat, ob->obmat);
-			invert_m4_m4(imat, mat);
-		}
-
-		invert_m4_m4(ob->imat, ob->obmat);
-		mul_v3_m4v3(center, ob->imat, ctrl_ob->obmat[3]);
+	if (flag & MOD_CAST_SIZE_FROM_RADIUS) {
+		len = cmd->radius;
 	}
-
-	if ((flag & MOD_CAST_SIZE_FROM_RADIUS) && has_radius) {
-		for (i = 0; i < 3; i++) {
-			min[i] = -cmd->radius;
-			max[i] = cmd->radius;
-		}
+	else {
+		len = cmd->size;
 	}
-	else if (!(flag & MOD_CAST_SIZE_FROM_RADIUS) && cmd->size > 0) {
-		for (i = 0; i < 3; i++) {
-			min[i] = -cmd->size;
-			max[i] = cmd->size;
+
+	/* summed in order, so the result doesn't depend on threading */
+	if (len <= 0) {
+		for (i = 0; i < numVerts; i++) {
+			len += len_v3v3(data.center, vertexCos[i]);
 		}
+		len /= numVerts;
+
+		if (len == 0.0f) len = 10.0f;
 	}
-	else {
-		/* get bound box */
-		/* We can't use the object's bound box because other modifiers
-		 * may have changed the vertex data. */
-		INIT_MINMAX(min, max);
 
-		/* Cast's center is the ob's own center in its local space,
-		 * by default, but if the user defined a control object, we use
-		 * its location, transformed to ob's local space. */
-		if (ctrl_ob) {
-			float vec[3];
+	data.cmd = cmd;
+	data.vertexCos = vertexCos;
+	data.use_ctrl_ob = (ctrl_ob != NULL);
+	data.flag = flag;
+	data.type = type;
+	data.len = len;
 
-			/* let the center of the ctrl_ob be part of the bound box: */
-			minmax_v3v3_v3(min, max, center);
+	modifier_deform_parallel(numVerts, &data, sphere_do_range);
+}
 
-			for (i = 0; i < numVerts; i++) {
-				sub_v3_v3v3(vec, vertexCos[i], center);
-				minmax_v3v3_v3(min, max, vec);
-			}
+static void cuboid_bounds_range(
+        void *__restrict userdata, int start, int stop, void *__restrict scratch)
+{
+	CastUserdata *data = userdata;
+	float (*vertexCos)[3] = data->vertexCos;
+	float (*minmax)[3] = scratch;
+	int i;
+
+	if (data->use_ctrl_ob) {
+		float vec[3];
+
+		for (i = start; i < stop; i++) {
+			sub_v3_v3v3(vec, vertexCos[i], data->center);
+			minmax_v3v3_v3(minmax[0], minmax[1], vec);
 		}
-		else {
-			for (i = 0; i < numVerts; i++) {
-				minmax_v3v3_v3(min, max, vertexCos[i]);
-			}
+	}
+	else {
+		for (i = start; i < stop; i++) {
+			minmax_v3v3_v3(minmax[0], minmax[1], vertexCos[i]);
 		}
-
-		/* we want a symmetric bound box around the origin */
-		if (fabsf(min[0]) > fabsf(max[0])) max[0] = fabsf(min[0]);
-		if (fabsf(min[1]) > fabsf(max[1])) max[1] = fabsf(min[1]);
-		if (fabsf(min[2]) > fabsf(max[2])) max[2] = fabsf(min[2]);
-		min[0] = -max[0];
-		min[1] = -max[1];
-		min[2] = -max[2];
 	}
+}
 
-	/* building our custom bounding box */
-	bb[0][0] = bb[2][0] = bb[4][0] = bb[6][0] = min[0];
-	bb[1][0] = bb[3][0] = bb[5][0] = bb[7][0] = max[0];
-	bb[0][1] = bb[1][1] = bb[4][1] = bb[5][1] = min[1];
-	bb[2][1] = bb[3][1] = bb[6][1] = bb[7][1] = max[1];
-	bb[0][2] = bb[1][2] = bb[2][2] = bb[3][2] = min[2];
-	bb[4][2] = bb[5][2] = bb[6][2] = bb[7][2] = max[2];
+static void cuboid_bounds_finalize(void *__restrict userdata, void *__restrict scratch)
+{
+	CastUserdata *data = userdata;
+	float (*minmax)[3] = scratch;
 
-	/* ready to apply the effect, one vertex at a time */
-	for (i = 0; i < numVerts; i++) {
+	minmax_v3v3_v3(data->min, data->max, minmax[0]);
+	minmax_v3v3_v3(data->min, data->max, minmax[1]);
+}
+
+static void cuboid_do_range(
+        void *__restrict userdata, int start, int stop, void *__restrict UNUSED(scratch))
+{
+	CastUserdata *data = userdata;
+	const CastModifierData *cmd = data->cmd;
+	MDeformVert *dvert = data->dvert;
+	float (*vertexCos)[3] = data->vertexCos;
+	const short flag = data->flag;
+	const float fac_orig = cmd->fac;
+	float fac = fac_orig;
+	float facm = 1.0f - fac;
+	int i;
+
+	for (i = start; i < stop; i++) {
 		int octant, coord;
 		float d[3], dmax, apex[3], fbb;
 		float tmp_co[3];
 
 		copy_v3_v3(tmp_co, vertexCos[i]);
-		if (ctrl_ob) {
+		if (data->use_ctrl_ob) {
 			if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-				mul_m4_v3(mat, tmp_co);
+				mul_m4_v3(data->mat, tmp_co);
 			}
 			else {
-				sub_v3_v3(tmp_co, center);
+				sub_v3_v3(tmp_co, data->center);
 			}
 		}
 
-		if (has_radius) {
+		if (data->has_radius) {
 			if (fabsf(tmp_co[0]) > cmd->radius ||
 			    fabsf(tmp_co[1]) > cmd->radius ||
 			    fabsf(tmp_co[2]) > cmd->radius)
@@ -378,7 +359,7 @@ static void cuboid_do(
 		}
 
 		if (dvert) {
-			const float weight = defvert_find_weight(&dvert[i], defgrp_index);
+			const float weight = defvert_find_weight(&dvert[i], data->defgrp_index);
 			if (weight == 0.0f) {
 				continue;
 			}
@@ -402,7 +383,7 @@ static void cuboid_do(
 		if (tmp_co[2] > 0.0f) octant += 4;
 
 		/* apex is the bb's vertex at the chosen octant */
-		copy_v3_v3(apex, bb[octant]);
+		copy_v3_v3(apex, data->bb[octant]);
 
 		/* find which bb plane is closest to this vertex ... */
 		d[0] = tmp_co[0] / apex[0];
@@ -438,12 +419,12 @@ static void cuboid_do(
 		if (flag & MOD_CAST_Z)
 			tmp_co[2] = facm * tmp_co[2] + fac * tmp_co[2] * fbb;
 
-		if (ctrl_ob) {
+		if (data->use_ctrl_ob) {
 			if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-				mul_m4_v3(imat, tmp_co);
+				mul_m4_v3(data->imat, tmp_co);
 			}
 			else {
-				add_v3_v3(tmp_co, center);
+				add_v3_v3(tmp_co, data->center);
 			}
 		}
 
@@ -451,6 +432,102 @@ static void cuboid_do(
 	}
 }
 
+static void cuboid_do(
+        CastModifierData *cmd, Object *ob, DerivedMesh *dm,
+        float (*vertexCos)[3], int numVerts)
+{
+	CastUserdata data = {NULL};
+	Object *ctrl_ob = NULL;
+
+	int i;
+	short flag;
+	float *min = data.min, *max = data.max;
+
+	flag = cmd->flag;
+
+	ctrl_ob = cmd->object;
+
+	/* now we check which options the user wants */
+
+	/* 1) (flag was checked in the "if (ctrl_ob)" block above) */
+	/* 2) cmd->radius > 0.0f: only the vertices within this radius from
+	 * the center of the effect should be deformed */
+	if (cmd->radius > FLT_EPSILON) data.has_radius = true;
+
+	/* 3) if we were given a vertex group name,
+	 * only those vertices should be affected */
+	modifier_get_vgroup(ob, dm, cmd->defgrp_name, &data.dvert, &data.defgrp_index);
+
+	if (ctrl_ob) {
+		if (flag & MOD_CAST_USE_OB_TRANSFORM) {
+			invert_m4_m4(data.imat, ctrl_ob->obmat);
+			mul_m4_m4m4(data.mat, data.imat, ob->obmat);
+			invert_m4_m4(data.imat, data.mat);
+		}
+
+		invert_m4_m4(ob->imat, ob->obmat);
+		mul_v3_m4v3(data.center, ob->imat, ctrl_ob->obmat[3]);
+	}
+
+	data.cmd = cmd;
+	data.vertexCos = vertexCos;
+	data.use_ctrl_ob = (ctrl_ob != NULL);
+	data.flag = flag;
+
+	if ((flag & MOD_CAST_SIZE_FROM_RADIUS) && data.has_radius) {
+		for (i = 0; i < 3; i++) {
+			min[i] = -cmd->radius;
+			max[i] = cmd->radius;
+		}
+	}
+	else if (!(flag & MOD_CAST_SIZE_FROM_RADIUS) && cmd->size > 0) {
+		for (i = 0; i < 3; i++) {
+			min[i] = -cmd->size;
+			max[i] = cmd->size;
+		}
+	}
+	else {
+		float minmax_init[2][3];
+
+		/* get bound box */
+		/* We can't use the object's bound box because other modifiers
+		 * may have changed the vertex data. */
+		INIT_MINMAX(min, max);
+		INIT_MINMAX(minmax_init[0], minmax_init[1]);
+
+		/* Cast's center is the ob's own center in its local space,
+		 * by default, but if the user defined a control object, we use
+		 * its location, transformed to ob's local space. */
+		if (ctrl_ob) {
+			/* let the center of the ctrl_ob be part of the bound box: */
+			minmax_v3v3_v3(min, max, data.center);
+		}
+
+		modifier_deform_parallel_ex(numVerts, &data, cuboid_bounds_range,
+		                            minmax_init, sizeof(minmax_init), cuboid_bounds_finalize,
+		                            MOD_PARALLEL_MIN_VERTS);
+
+		/* we want a symmetric bound box around the origin */
+		if (fabsf(min[0]) > fabsf(max[0])) max[0] = fabsf(min[0]);
+		if (fabsf(min[1]) > fabsf(max[1])) max[1] = fabsf(min[1]);
+		if (fabsf(min[2]) > fabsf(max[2])) max[2] = fabsf(min[2]);
+		min[0] = -max[0];
+		min[1] = -max[1];
+		min[2] = -max[2];
+	}
+
+	/* building our custom bounding box */
+	data.bb[0][0] = data.bb[2][0] = data.bb[4][0] = data.bb[6][0] = min[0];
+	data.bb[1][0] = data.bb[3][0] = data.bb[5][0] = data.bb[7][0] = max[0];
+	data.bb[0][1] = data.bb[1][1] = data.bb[4][1] = data.bb[5][1] = min[1];
+	data.bb[2][1] = data.bb[3][1] = data.bb[6][1] = data.bb[7][1] = max[1];
+	data.bb[0][2] = data.bb[1][2] = data.bb[2][2] = data.bb[3][2] = min[2];
+	data.bb[4][2] = data.bb[5][2] = data.bb[6][2] = data.bb[7][2] = max[2];
+
+	/* ready to apply the effect, one vertex at a time */
+	modifier_deform_parallel(numVerts, &data, cuboid_do_range);
+}
+
 static void deformVerts(ModifierData *md, Object *ob,
                         DerivedMesh *derivedData,
                         float (*vertexCos)[3],
@@ -40,6 +40,7 @@
 #include "BLI_math.h"
 
 #include "BKE_cdderivedmesh.h"
+#include "BKE_image.h"
 #include "BKE_library.h"
 #include "BKE_mesh.h"
 #include "BKE_modifier.h"
@@ -192,58 +193,35 @@ static void updateDepsgraph(ModifierData *md,
 }
 
 /* dm must be a CDDerivedMesh */
-static void displaceModifier_do(
-        DisplaceModifierData *dmd, Object *ob,
-        DerivedMesh *dm, float (*vertexCos)[3], int numVerts)
-{
-	int i;
-	MVert *mvert;
+typedef struct DisplaceUserdata {
+	DisplaceModifierData *dmd;
+	struct ImagePool *pool;
 	MDeformVert *dvert;
-	int direction = dmd->direction;
 	int defgrp_index;
+	int direction;
 	float (*tex_co)[3];
-	float weight = 1.0f; /* init value unused but some compilers may complain */
-	const float delta_fixed = 1.0f - dmd->midlevel;  /* when no texture is used, we fallback to white */
-	float (*vert_clnors)[3] = NULL;
-
-	if (!dmd->texture && dmd->direction == MOD_DISP_DIR_RGB_XYZ) return;
-	if (dmd->strength == 0.0f) return;
-
-	mvert = CDDM_get_verts(dm);
-	modifier_get_vgroup(ob, dm, dmd->defgrp_name, &dvert, &defgrp_index);
-
-	if (dmd->texture) {
-		tex_co = MEM_callocN(sizeof(*tex_co) * numVerts,
-		                     "displaceModifier_do tex_co");
-		get_texture_coords((MappingInfoModifierData *)dmd, ob, dm, vertexCos, tex_co, numVerts);
-
-		modifier_init_texture(dmd->modifier.scene, dmd->texture);
-	}
-	else {
-		tex_co = NULL;
-	}
-
-	if (direction == MOD_DISP_DIR_CLNOR) {
-		CustomData *ldata = dm->getLoopDataLayout(dm);
-
-		if (CustomData_has_layer(ldata, CD_CUSTOMLOOPNORMAL)) {
-			float (*clnors)[3] = NULL;
-
-			if ((dm->dirty & DM_DIRTY_NORMALS) || !CustomData_has_layer(ldata, CD_NORMAL)) {
-				dm->calcLoopNormals(dm, true, (float)M_PI);
-			}
+	float (*vertexCos)[3];
+	MVert *mvert;
+	float (*vert_clnors)[3];
+} DisplaceUserdata;
 
-			clnors = CustomData_get_layer(ldata, CD_NORMAL);
-			vert_clnors = MEM_mallocN(sizeof(*vert_clnors) * (size_t)numVerts, __func__);
-			BKE_mesh_normals_loop_to_vertex(numVerts, dm->getLoopArray(dm), dm->getNumLoops(dm),
-			                                (const float (*)[3])clnors, vert_clnors);
-		}
-		else {
-			direction = MOD_DISP_DIR_NOR;
-		}
-	}
+static void displaceModifier_do_range(
+        void *__restrict userdata, int start, int stop, void *__restrict UNUSED(scratch))
+{
+	const DisplaceUserdata *data = userdata;
+	DisplaceModifierData *dmd = data->dmd;
+	MDeformVert *dvert = data->dvert;
+	float (*tex_co)[3] = data->tex_co;
+	float (*vertexCos)[3] = data->vertexCos;
+	MVert *mvert = data->mvert;
+	float (*vert_clnors)[3] = data->vert_clnors;
+	const int defgrp_index = data->defgrp_index;
+	const int direction = data->direction;
+	const float delta_fixed = 1.0f - dmd->midlevel;  /* when no texture is used, we fallback to white */
+	float weight = 1.0f; /* init value unused but some compilers may complain */
+	int i;
 
-	for (i = 0; i < numVerts; i++) {
+	for (i = start; i < stop; i++) {
 		TexResult texres;
 		float strength = dmd->strength;
 		float delta;
@@ -255,7 +233,7 @@ static void displaceModifier_do(
 
 		if (dmd->texture) {
 			texres.nor = NULL;
-			BKE_texture_get_value(dmd->modifier.scene, dmd->texture, tex_co[i], &texres, false);
+			BKE_texture_get_value_ex(dmd->modifier.scene, dmd->texture, tex_co[i], &texres, data->pool, false);
 			delta = texres.tin - dmd->midlevel;
 		}
 		else {
@@ -292,6 +270,74 @@ static void displaceModifier_do(
 				break;
 		}
 	}
+}
+
+static void displaceModifier_do(
+        DisplaceModifierData *dmd, Object *ob,
+        DerivedMesh *dm, float (*vertexCos)[3], int numVerts)
+{
+	DisplaceUserdata data = {NULL};
+	MVert *mvert;
+	MDeformVert *dvert;
+	int direction = dmd->direction;
+	int defgrp_index;
+	float (*tex_co)[3];
+	float (*vert_clnors)[3] = NULL;
+
+	if (!dmd->texture && dmd->direction == MOD_DISP_DIR_RGB_XYZ) return;
+	if (dmd->strength == 0.0f) return;
+
+	mvert = CDDM_get_verts(dm);
+	modifier_get_vgroup(ob, dm, dmd->defgrp_name, &dvert, &defgrp_index);
+
+	if (dmd->texture) {
+		tex_co = MEM_callocN(sizeof(*tex_co) * numVerts,
+		                     "displaceModifier_do tex_co");
+		get_texture_coords((MappingInfoModifierData *)dmd, ob, dm, vertexCos, tex_co, numVerts);
+
+		modifier_init_texture(dmd->modifier.scene, dmd->texture);
+
+		data.pool = BKE_image_pool_new();
+		BKE_texture_fetch_images_for_pool(dmd->texture, data.pool);
+	}
+	else {
+		tex_co = NULL;
+	}
+
+	if (direction == MOD_DISP_DIR_CLNOR) {
+		CustomData *ldata = dm->getLoopDataLayout(dm);
+
+		if (CustomData_has_layer(ldata, CD_CUSTOMLOOPNORMAL)) {
+			float (*clnors)[3] = NULL;
+
+			if ((dm->dirty & DM_DIRTY_NORMALS) || !CustomData_has_layer(ldata, CD_NORMAL)) {
+				dm->calcLoopNormals(dm, true, (float)M_PI);
+			}
+
+			clnors = CustomData_get_layer(ldata, CD_NORMAL);
+			vert_clnors = MEM_mallocN(sizeof(*vert_clnors) * (size_t)numVerts, __func__);
+			BKE_mesh_normals_loop_to_vertex(numVerts, dm->getLoopArray(dm), dm->getNumLoops(dm),
+			                                (const float (*)[3])clnors, vert_clnors);
+		}
+		else {
+			direction = MOD_DISP_DIR_NOR;
+		}
+	}
+
+	data.dmd = dmd;
+	data.dvert = dvert;
+	data.defgrp_index = defgrp_index;
+	data.direction = direction;
+	data.tex_co = tex_co;
+	data.vertexCos = vertexCos;
+	data.mvert = mvert;
+	data.vert_clnors = vert_clnors;
+
+	modifier_deform_parallel(numVerts, &data, displaceModifier_do_range);
+
+	if (data.pool) {
+		BKE_image_pool_free(data.pool);
+	}
 
 	if (tex_co) {
 		MEM_freeN(tex_co);
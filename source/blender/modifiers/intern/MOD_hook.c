@@ -36,6 +36,7 @@
 #include "DNA_meshdata_types.h"
 #include "DNA_object_types.h"
 
+#include "BLI_bitmap.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 
@@ -274,6 +275,52 @@ static void hook_co_apply(struct HookData_cb *hd, const int j)
 	}
 }
 
+struct HookData_range {
+	struct HookData_cb *hd;
+	const int *origindex_ar;
+	const int *indexar;
+	int totindex;
+	/* original indices used by indexar, to skip most vertices quickly */
+	const BLI_bitmap *indexar_used;
+	int indexar_used_len;
+};
+
+static void hook_co_apply_range(
+        void *__restrict userdata, int start, int stop, void *__restrict UNUSED(scratch))
+{
+	struct HookData_range *data = userdata;
+	int j;
+
+	for (j = start; j < stop; j++) {
+		hook_co_apply(data->hd, j);
+	}
+}
+
+/* each vertex checks the indices itself, so vertices are independent
+ * and duplicate indices are applied in order, as before */
+static void hook_co_apply_origindex_range(
+        void *__restrict userdata, int start, int stop, void *__restrict UNUSED(scratch))
+{
+	struct HookData_range *data = userdata;
+	int i, j;
+
+	for (j = start; j < stop; j++) {
+		const int origindex = data->origindex_ar[j];
+
+		if (origindex < 0 || origindex >= data->indexar_used_len ||
+		    !BLI_BITMAP_TEST(data->indexar_used, origindex))
+		{
+			continue;
+		}
+
+		for (i = 0; i < data->totindex; i++) {
+			if (data->indexar[i] == origindex) {
+				hook_co_apply(data->hd, j);
+			}
+		}
+	}
+}
+
 static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
                            float (*vertexCos)[3], int numVerts)
 {
@@ -281,6 +328,7 @@ static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
 	float dmat[4][4];
 	int i, *index_pt;
 	struct HookData_cb hd;
+	struct HookData_range range = {&hd};
 	
 	if (hmd->curfalloff == NULL) {
 		/* should never happen, but bad lib linking could cause it */
@@ -344,17 +392,26 @@ static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
 		
 		/* if DerivedMesh is present and has original index data, use it */
 		if (dm && (origindex_ar = dm->getVertDataArray(dm, CD_ORIGINDEX))) {
+			int *indexar = MEM_mallocN(sizeof(*indexar) * (size_t)hmd->totindex, __func__);
+			BLI_bitmap *indexar_used = BLI_BITMAP_NEW(numVerts, __func__);
+			int totindex = 0;
+
 			for (i = 0, index_pt = hmd->indexar; i < hmd->totindex; i++, index_pt++) {
-				if (*index_pt < numVerts) {
-					int j;
-					
-					for (j = 0; j < numVerts; j++) {
-						if (origindex_ar[j] == *index_pt) {
-							hook_co_apply(&hd, j);
-						}
-					}
+				if (*index_pt >= 0 && *index_pt < numVerts) {
+					indexar[totindex++] = *index_pt;
+					BLI_BITMAP_ENABLE(indexar_used, *index_pt);
 				}
 			}
+
+			range.origindex_ar = origindex_ar;
+			range.indexar = indexar;
+			range.totindex = totindex;
+			range.indexar_used = indexar_used;
+			range.indexar_used_len = numVerts;
+			modifier_deform_parallel(numVerts, &range, hook_co_apply_origindex_range);
+
+			MEM_freeN(indexar);
+			MEM_freeN(indexar_used);
 		}
 		else { /* missing dm or ORIGINDEX */
 			for (i = 0, index_pt = hmd->indexar; i < hmd->totindex; i++, index_pt++) {
@@ -365,9 +422,7 @@ static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
 		}
 	}
 	else if (hd.dvert) {  /* vertex group hook */
-		for (i = 0; i < numVerts; i++) {
-			hook_co_apply(&hd, i);
-		}
+		modifier_deform_parallel(numVerts, &range, hook_co_apply_range);
 	}
 }
 
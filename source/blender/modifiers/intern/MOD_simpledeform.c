@@ -140,19 +140,97 @@ static void simpleDeform_bend(const float factor, const float dcut[3], float r_c
 }
 
 
-/* simple deform modifier */
-static void SimpleDeformModifier_do(SimpleDeformModifierData *smd, struct Object *ob, struct DerivedMesh *dm,
-                                    float (*vertexCos)[3], int numVerts)
+typedef struct SimpleDeformUserdata {
+	SimpleDeformModifierData *smd;
+	float (*vertexCos)[3];
+	const SpaceTransform *transf;
+	MDeformVert *dvert;
+	int vgroup;
+	int limit_axis;
+	float smd_limit[2], smd_factor;
+	void (*simpleDeform_callback)(const float factor, const float dcut[3], float co[3]);
+	/* range of the vertices along limit_axis */
+	float lower, upper;
+} SimpleDeformUserdata;
+
+static void simpleDeform_limits_range(
+        void *__restrict userdata, int start, int stop, void *__restrict scratch)
+{
+	const SimpleDeformUserdata *data = userdata;
+	float *range = scratch;
+	int i;
+
+	for (i = start; i < stop; i++) {
+		float tmp[3];
+		copy_v3_v3(tmp, data->vertexCos[i]);
+
+		if (data->transf) {
+			BLI_space_transform_apply(data->transf, tmp);
+		}
+
+		range[0] = min_ff(range[0], tmp[data->limit_axis]);
+		range[1] = max_ff(range[1], tmp[data->limit_axis]);
+	}
+}
+
+static void simpleDeform_limits_finalize(void *__restrict userdata, void *__restrict scratch)
+{
+	SimpleDeformUserdata *data = userdata;
+	const float *range = scratch;
+
+	data->lower = min_ff(data->lower, range[0]);
+	data->upper = max_ff(data->upper, range[1]);
+}
+
+static void simpleDeform_do_range(
+        void *__restrict userdata, int start, int stop, void *__restrict UNUSED(scratch))
 {
 	static const float lock_axis[2] = {0.0f, 0.0f};
 
+	const SimpleDeformUserdata *data = userdata;
+	const SimpleDeformModifierData *smd = data->smd;
+	float (*vertexCos)[3] = data->vertexCos;
+	const SpaceTransform *transf = data->transf;
 	int i;
+
+	for (i = start; i < stop; i++) {
+		float weight = defvert_array_find_weight_safe(data->dvert, i, data->vgroup);
+
+		if (weight != 0.0f) {
+			float co[3], dcut[3] = {0.0f, 0.0f, 0.0f};
+
+			if (transf) {
+				BLI_space_transform_apply(transf, vertexCos[i]);
+			}
+
+			copy_v3_v3(co, vertexCos[i]);
+
+			/* Apply axis limits */
+			if (smd->mode != MOD_SIMPLEDEFORM_MODE_BEND) { /* Bend mode shoulnt have any lock axis */
+				if (smd->axis & MOD_SIMPLEDEFORM_LOCK_AXIS_X) axis_limit(0, lock_axis, co, dcut);
+				if (smd->axis & MOD_SIMPLEDEFORM_LOCK_AXIS_Y) axis_limit(1, lock_axis, co, dcut);
+			}
+			axis_limit(data->limit_axis, data->smd_limit, co, dcut);
+
+			data->simpleDeform_callback(data->smd_factor, dcut, co);  /* apply deform */
+			interp_v3_v3v3(vertexCos[i], vertexCos[i], co, weight);  /* Use vertex weight has coef of linear interpolation */
+
+			if (transf) {
+				BLI_space_transform_invert(transf, vertexCos[i]);
+			}
+		}
+	}
+}
+
+/* simple deform modifier */
+static void SimpleDeformModifier_do(SimpleDeformModifierData *smd, struct Object *ob, struct DerivedMesh *dm,
+                                    float (*vertexCos)[3], int numVerts)
+{
+	SimpleDeformUserdata data = {NULL};
 	int limit_axis = 0;
 	float smd_limit[2], smd_factor;
 	SpaceTransform *transf = NULL, tmp_transf;
 	void (*simpleDeform_callback)(const float factor, const float dcut[3], float co[3]) = NULL;  /* Mode callback */
-	int vgroup;
-	MDeformVert *dvert;
 
 	/* Safe-check */
 	if (smd->origin == ob) smd->origin = NULL;  /* No self references */
@@ -172,23 +250,25 @@ static void SimpleDeformModifier_do(SimpleDeformModifierData *smd, struct Object
 	 * Bend limits on X.. all other modes limit on Z */
 	limit_axis  = (smd->mode == MOD_SIMPLEDEFORM_MODE_BEND) ? 0 : 2;
 
+	data.smd = smd;
+	data.vertexCos = vertexCos;
+	data.transf = transf;
+	data.limit_axis = limit_axis;
+
 	/* Update limits if needed */
 	{
-		float lower =  FLT_MAX;
-		float upper = -FLT_MAX;
+		const float range_init[2] = {FLT_MAX, -FLT_MAX};
+		float lower, upper;
 
-		for (i = 0; i < numVerts; i++) {
-			float tmp[3];
-			copy_v3_v3(tmp, vertexCos[i]);
-
-			if (transf) {
-				BLI_space_transform_apply(transf, tmp);
-			}
+		data.lower =  FLT_MAX;
+		data.upper = -FLT_MAX;
 
-			lower = min_ff(lower, tmp[limit_axis]);
-			upper = max_ff(upper, tmp[limit_axis]);
-		}
+		modifier_deform_parallel_ex(numVerts, &data, simpleDeform_limits_range,
+		                            range_init, sizeof(range_init), simpleDeform_limits_finalize,
+		                            MOD_PARALLEL_MIN_VERTS);
 
+		lower = data.lower;
+		upper = data.upper;
 
 		/* SMD values are normalized to the BV, calculate the absolut values */
 		smd_limit[1] = lower + (upper - lower) * smd->limit[1];
@@ -212,35 +292,13 @@ static void SimpleDeformModifier_do(SimpleDeformModifierData *smd, struct Object
 		}
 	}
 
-	modifier_get_vgroup(ob, dm, smd->vgroup_name, &dvert, &vgroup);
-
-	for (i = 0; i < numVerts; i++) {
-		float weight = defvert_array_find_weight_safe(dvert, i, vgroup);
+	modifier_get_vgroup(ob, dm, smd->vgroup_name, &data.dvert, &data.vgroup);
 
-		if (weight != 0.0f) {
-			float co[3], dcut[3] = {0.0f, 0.0f, 0.0f};
+	copy_v2_v2(data.smd_limit, smd_limit);
+	data.smd_factor = smd_factor;
+	data.simpleDeform_callback = simpleDeform_callback;
 
-			if (transf) {
-				BLI_space_transform_apply(transf, vertexCos[i]);
-			}
-
-			copy_v3_v3(co, vertexCos[i]);
-
-			/* Apply axis limits */
-			if (smd->mode != MOD_SIMPLEDEFORM_MODE_BEND) { /* Bend mode shoulnt have any lock axis */
-				if (smd->axis & MOD_SIMPLEDEFORM_LOCK_AXIS_X) axis_limit(0, lock_axis, co, dcut);
-				if (smd->axis & MOD_SIMPLEDEFORM_LOCK_AXIS_Y) axis_limit(1, lock_axis, co, dcut);
-			}
-			axis_limit(limit_axis, smd_limit, co, dcut);
-
-			simpleDeform_callback(smd_factor, dcut, co);  /* apply deform */
-			interp_v3_v3v3(vertexCos[i], vertexCos[i], co, weight);  /* Use vertex weight has coef of linear interpolation */
-
-			if (transf) {
-				BLI_space_transform_invert(transf, vertexCos[i]);
-			}
-		}
-	}
+	modifier_deform_parallel(numVerts, &data, simpleDeform_do_range);
 }
 
 
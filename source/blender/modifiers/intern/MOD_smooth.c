@@ -41,6 +41,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BKE_cdderivedmesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_particle.h"
 #include "BKE_deform.h"
 
@@ -91,128 +92,188 @@ static CustomDataMask requiredDataMask(Object *UNUSED(ob), ModifierData *md)
 	return dataMask;
 }
 
-static void smoothModifier_do(
-        SmoothModifierData *smd, Object *ob, DerivedMesh *dm,
-        float (*vertexCos)[3], int numVerts)
-{
-	MDeformVert *dvert = NULL;
-	MEdge *medges = NULL;
-
-	int i, j, numDMEdges, defgrp_index;
+typedef struct SmoothUserdata {
+	SmoothModifierData *smd;
+	float (*vertexCos)[3];
+	MDeformVert *dvert;
+	int defgrp_index;
+	const MEdge *medges;
+	const MeshElemMap *vert_edges;
+	float (*ftmp)[3];
 	unsigned char *uctmp;
-	float *ftmp, fac, facm;
-
-	ftmp = (float *)MEM_callocN(3 * sizeof(float) * numVerts,
-	                            "smoothmodifier_f");
-	if (!ftmp) return;
-	uctmp = (unsigned char *)MEM_callocN(sizeof(unsigned char) * numVerts,
-	                                     "smoothmodifier_uc");
-	if (!uctmp) {
-		if (ftmp) MEM_freeN(ftmp);
-		return;
-	}
+} SmoothUserdata;
 
-	fac = smd->fac;
-	facm = 1 - fac;
+/* Sum the edge centers around each vertex. Edges are visited in the same
+ * order per vertex as when scattering from the edges, so the sums match. */
+static void smoothModifier_gather_range(
+        void *__restrict userdata, int start, int stop, void *__restrict UNUSED(scratch))
+{
+	SmoothUserdata *data = userdata;
+	float (*vertexCos)[3] = data->vertexCos;
+	int i, j;
 
-	if (dm->getNumVerts(dm) == numVerts) {
-		medges = dm->getEdgeArray(dm);
-		numDMEdges = dm->getNumEdges(dm);
-	}
-	else {
-		medges = NULL;
-		numDMEdges = 0;
-	}
+	for (i = start; i < stop; i++) {
+		const MeshElemMap *map = &data->vert_edges[i];
+		float *fp = data->ftmp[i];
+		unsigned char uc = 0;
 
-	modifier_get_vgroup(ob, dm, smd->defgrp_name, &dvert, &defgrp_index);
+		zero_v3(fp);
 
-	/* NOTICE: this can be optimized a little bit by moving the
-	 * if (dvert) out of the loop, if needed */
-	for (j = 0; j < smd->repeat; j++) {
-		for (i = 0; i < numDMEdges; i++) {
+		for (j = 0; j < map->count && uc < 255; j++) {
+			const MEdge *me = &data->medges[map->indices[j]];
 			float fvec[3];
-			float *v1, *v2;
-			unsigned int idx1, idx2;
 
-			idx1 = medges[i].v1;
-			idx2 = medges[i].v2;
+			mid_v3_v3v3(fvec, vertexCos[me->v1], vertexCos[me->v2]);
+			add_v3_v3(fp, fvec);
+			uc++;
+		}
 
-			v1 = vertexCos[idx1];
-			v2 = vertexCos[idx2];
+		data->uctmp[i] = uc;
+	}
+}
 
-			mid_v3_v3v3(fvec, v1, v2);
+static void smoothModifier_scatter(SmoothUserdata *data, int numVerts, int numDMEdges)
+{
+	float (*vertexCos)[3] = data->vertexCos;
+	float (*ftmp)[3] = data->ftmp;
+	unsigned char *uctmp = data->uctmp;
+	int i;
+
+	memset(ftmp, 0, sizeof(*ftmp) * (size_t)numVerts);
+	memset(uctmp, 0, sizeof(*uctmp) * (size_t)numVerts);
+
+	for (i = 0; i < numDMEdges; i++) {
+		float fvec[3];
+		unsigned int idx1, idx2;
 
-			v1 = &ftmp[idx1 * 3];
-			v2 = &ftmp[idx2 * 3];
+		idx1 = data->medges[i].v1;
+		idx2 = data->medges[i].v2;
 
-			if (uctmp[idx1] < 255) {
-				uctmp[idx1]++;
-				add_v3_v3(v1, fvec);
-			}
-			if (uctmp[idx2] < 255) {
-				uctmp[idx2]++;
-				add_v3_v3(v2, fvec);
-			}
+		mid_v3_v3v3(fvec, vertexCos[idx1], vertexCos[idx2]);
+
+		if (uctmp[idx1] < 255) {
+			uctmp[idx1]++;
+			add_v3_v3(ftmp[idx1], fvec);
+		}
+		if (uctmp[idx2] < 255) {
+			uctmp[idx2]++;
+			add_v3_v3(ftmp[idx2], fvec);
 		}
+	}
+}
 
-		if (dvert) {
-			MDeformVert *dv = dvert;
-			for (i = 0; i < numVerts; i++, dv++) {
-				float f, fm, facw, *fp, *v;
-				short flag = smd->flag;
+static void smoothModifier_apply_range(
+        void *__restrict userdata, int start, int stop, void *__restrict UNUSED(scratch))
+{
+	SmoothUserdata *data = userdata;
+	MDeformVert *dvert = data->dvert;
+	const float fac = data->smd->fac;
+	const float facm = 1.0f - fac;
+	const short flag = data->smd->flag;
+	int i;
+
+	if (dvert) {
+		for (i = start; i < stop; i++) {
+			float f, fm, facw, *fp, *v;
+
+			v = data->vertexCos[i];
+			fp = data->ftmp[i];
+
+
+			f = defvert_find_weight(&dvert[i], data->defgrp_index);
+			if (f <= 0.0f) continue;
+
+			f *= fac;
+			fm = 1.0f - f;
+
+			/* fp is the sum of uctmp[i] verts, so must be averaged */
+			facw = 0.0f;
+			if (data->uctmp[i]) 
+				facw = f / (float)data->uctmp[i];
+
+			if (flag & MOD_SMOOTH_X)
+				v[0] = fm * v[0] + facw * fp[0];
+			if (flag & MOD_SMOOTH_Y)
+				v[1] = fm * v[1] + facw * fp[1];
+			if (flag & MOD_SMOOTH_Z)
+				v[2] = fm * v[2] + facw * fp[2];
+		}
+	}
+	else { /* no vertex group */
+		for (i = start; i < stop; i++) {
+			float facw, *fp, *v;
+
+			v = data->vertexCos[i];
+			fp = data->ftmp[i];
+
+			/* fp is the sum of uctmp[i] verts, so must be averaged */
+			facw = 0.0f;
+			if (data->uctmp[i]) 
+				facw = fac / (float)data->uctmp[i];
+
+			if (flag & MOD_SMOOTH_X)
+				v[0] = facm * v[0] + facw * fp[0];
+			if (flag & MOD_SMOOTH_Y)
+				v[1] = facm * v[1] + facw * fp[1];
+			if (flag & MOD_SMOOTH_Z)
+				v[2] = facm * v[2] + facw * fp[2];
+		}
+	}
+}
 
-				v = vertexCos[i];
-				fp = &ftmp[i * 3];
+static void smoothModifier_do(
+        SmoothModifierData *smd, Object *ob, DerivedMesh *dm,
+        float (*vertexCos)[3], int numVerts)
+{
+	SmoothUserdata data = {NULL};
+	MeshElemMap *vert_edges = NULL;
+	int *vert_edges_mem = NULL;
+	MEdge *medges = NULL;
+	int j, numDMEdges;
+	bool use_gather;
 
+	if (dm->getNumVerts(dm) == numVerts) {
+		medges = dm->getEdgeArray(dm);
+		numDMEdges = dm->getNumEdges(dm);
+	}
+	else {
+		medges = NULL;
+		numDMEdges = 0;
+	}
 
-				f = defvert_find_weight(dv, defgrp_index);
-				if (f <= 0.0f) continue;
+	/* With threads, vertices gather from their edges instead of edges
+	 * scattering to their vertices, so both passes of an iteration run in
+	 * parallel. The map costs more than the scatter on a single thread. */
+	use_gather = modifier_deform_parallel_is_threaded(numVerts, MOD_PARALLEL_MIN_VERTS);
+	if (use_gather) {
+		BKE_mesh_vert_edge_map_create(&vert_edges, &vert_edges_mem, medges, numVerts, numDMEdges);
+	}
 
-				f *= fac;
-				fm = 1.0f - f;
+	data.smd = smd;
+	data.vertexCos = vertexCos;
+	data.medges = medges;
+	data.vert_edges = vert_edges;
+	data.ftmp = MEM_mallocN(sizeof(*data.ftmp) * (size_t)numVerts, "smoothmodifier_f");
+	data.uctmp = MEM_mallocN(sizeof(*data.uctmp) * (size_t)numVerts, "smoothmodifier_uc");
 
-				/* fp is the sum of uctmp[i] verts, so must be averaged */
-				facw = 0.0f;
-				if (uctmp[i]) 
-					facw = f / (float)uctmp[i];
+	modifier_get_vgroup(ob, dm, smd->defgrp_name, &data.dvert, &data.defgrp_index);
 
-				if (flag & MOD_SMOOTH_X)
-					v[0] = fm * v[0] + facw * fp[0];
-				if (flag & MOD_SMOOTH_Y)
-					v[1] = fm * v[1] + facw * fp[1];
-				if (flag & MOD_SMOOTH_Z)
-					v[2] = fm * v[2] + facw * fp[2];
-			}
+	for (j = 0; j < smd->repeat; j++) {
+		if (use_gather) {
+			modifier_deform_parallel(numVerts, &data, smoothModifier_gather_range);
 		}
-		else { /* no vertex group */
-			for (i = 0; i < numVerts; i++) {
-				float facw, *fp, *v;
-				short flag = smd->flag;
-
-				v = vertexCos[i];
-				fp = &ftmp[i * 3];
-
-				/* fp is the sum of uctmp[i] verts, so must be averaged */
-				facw = 0.0f;
-				if (uctmp[i]) 
-					facw = fac / (float)uctmp[i];
-
-				if (flag & MOD_SMOOTH_X)
-					v[0] = facm * v[0] + facw * fp[0];
-				if (flag & MOD_SMOOTH_Y)
-					v[1] = facm * v[1] + facw * fp[1];
-				if (flag & MOD_SMOOTH_Z)
-					v[2] = facm * v[2] + facw * fp[2];
-			}
-
+		else {
+			smoothModifier_scatter(&data, numVerts, numDMEdges);
 		}
-
-		memset(ftmp, 0, 3 * sizeof(float) * numVerts);
-		memset(uctmp, 0, sizeof(unsigned char) * numVerts);
+		modifier_deform_parallel(numVerts, &data, smoothModifier_apply_range);
 	}
 
-	MEM_freeN(ftmp);
-	MEM_freeN(uctmp);
+	MEM_freeN(data.ftmp);
+	MEM_freeN(data.uctmp);
+	if (use_gather) {
+		MEM_freeN(vert_edges);
+		MEM_freeN(vert_edges_mem);
+	}
 }
 
 static void deformVerts(ModifierData *md, Object *ob, DerivedMesh *derivedData,
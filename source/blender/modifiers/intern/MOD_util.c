@@ -39,8 +39,10 @@
 #include "DNA_scene_types.h"
 
 #include "BLI_utildefines.h"
+#include "BLI_math_base.h"
 #include "BLI_math_vector.h"
 #include "BLI_math_matrix.h"
+#include "BLI_task.h"
 
 #include "BKE_cdderivedmesh.h"
 #include "BKE_deform.h"
@@ -55,9 +57,7 @@
 
 #include "MEM_guardedalloc.h"
 
-#ifdef OPENNL_THREADING_HACK
 #include "BLI_threads.h"
-#endif
 
 void modifier_init_texture(const Scene *scene, Tex *tex)
 {
@@ -234,6 +234,178 @@ void modifier_get_vgroup(Object *ob, DerivedMesh *dm, const char *name, MDeformV
 }
 
 
+/* Parallel deform helper.
+ *
+ * Tasks pull chunks of vertices from a shared counter, the same way
+ * BLI_task_parallel_range does, but the callback gets the whole range
+ * so it can keep state in locals, and optionally a scratch block which
+ * is private to the thread running it. */
+
+typedef struct ModifierParallelState {
+	void *userdata;
+	ModifierParallelRangeFunc func;
+
+	/* one scratch_size block per scheduler thread, indexed by thread id */
+	char *scratch;
+	bool *scratch_used;
+	size_t scratch_size;
+
+	int iter, stop;
+	int chunk_size;
+	SpinLock lock;
+} ModifierParallelState;
+
+BLI_INLINE bool modifier_parallel_next_range(
+        ModifierParallelState *__restrict state,
+        int *__restrict r_start, int *__restrict r_stop)
+{
+	bool result = false;
+	BLI_spin_lock(&state->lock);
+	if (state->iter < state->stop) {
+		*r_start = state->iter;
+		*r_stop = min_ii(state->iter + state->chunk_size, state->stop);
+		state->iter = *r_stop;
+		result = true;
+	}
+	BLI_spin_unlock(&state->lock);
+	return result;
+}
+
+static void modifier_parallel_task(
+        TaskPool *__restrict pool,
+        void *UNUSED(taskdata),
+        int threadid)
+{
+	ModifierParallelState *__restrict state = BLI_task_pool_userdata(pool);
+	void *scratch = NULL;
+	int start, stop;
+
+	if (state->scratch_size != 0) {
+		scratch = state->scratch + state->scratch_size * (size_t)threadid;
+	}
+
+	while (modifier_parallel_next_range(state, &start, &stop)) {
+		if (scratch) {
+			state->scratch_used[threadid] = true;
+		}
+		state->func(state->userdata, start, stop, scratch);
+	}
+}
+
+/* When false, modifier_deform_parallel_ex() runs the whole range from the calling thread. */
+bool modifier_deform_parallel_is_threaded(int numVerts, const int min_verts)
+{
+	return (numVerts >= min_verts) && (BLI_task_scheduler_num_threads(BLI_task_scheduler_get()) > 1);
+}
+
+/**
+ * Call \a func for ranges covering [0, numVerts), from multiple threads when
+ * there are at least \a min_verts vertices.
+ *
+ * \param scratch_init: Initial value of each thread's scratch block,
+ * NULL to zero it.
+ * \param finalize: Called from the calling thread for every scratch block
+ * which was used, in thread order, so results can be reduced.
+ */
+void modifier_deform_parallel_ex(
+        int numVerts, void *userdata, ModifierParallelRangeFunc func,
+        const void *scratch_init, size_t scratch_size, ModifierParallelFinalizeFunc finalize,
+        const int min_verts)
+{
+	TaskScheduler *task_scheduler;
+	TaskPool *task_pool;
+	ModifierParallelState state;
+	int i, num_threads, num_tasks;
+
+	if (numVerts <= 0) {
+		return;
+	}
+
+	if (!modifier_deform_parallel_is_threaded(numVerts, min_verts)) {
+		void *scratch = NULL;
+
+		if (scratch_size != 0) {
+			scratch = MEM_mallocN(scratch_size, __func__);
+			if (scratch_init) {
+				memcpy(scratch, scratch_init, scratch_size);
+			}
+			else {
+				memset(scratch, 0, scratch_size);
+			}
+		}
+
+		func(userdata, 0, numVerts, scratch);
+
+		if (scratch) {
+			if (finalize) {
+				finalize(userdata, scratch);
+			}
+			MEM_freeN(scratch);
+		}
+		return;
+	}
+
+	task_scheduler = BLI_task_scheduler_get();
+	num_threads = BLI_task_scheduler_num_threads(task_scheduler);
+
+	state.userdata = userdata;
+	state.func = func;
+	state.scratch = NULL;
+	state.scratch_used = NULL;
+	state.scratch_size = scratch_size;
+	state.iter = 0;
+	state.stop = numVerts;
+
+	if (scratch_size != 0) {
+		state.scratch = MEM_mallocN(scratch_size * (size_t)num_threads, __func__);
+		state.scratch_used = MEM_callocN(sizeof(*state.scratch_used) * (size_t)num_threads, __func__);
+		for (i = 0; i < num_threads; i++) {
+			if (scratch_init) {
+				memcpy(state.scratch + scratch_size * (size_t)i, scratch_init, scratch_size);
+			}
+			else {
+				memset(state.scratch + scratch_size * (size_t)i, 0, scratch_size);
+			}
+		}
+	}
+
+	/* Several chunks per task keep threads busy when the cost per vertex
+	 * varies, e.g. with vertex groups or textures, while keeping the
+	 * number of spin lock round trips low. */
+	num_tasks = num_threads * 2;
+	state.chunk_size = max_ii(64, numVerts / (num_tasks * 4));
+	BLI_spin_init(&state.lock);
+
+	task_pool = BLI_task_pool_create(task_scheduler, &state);
+
+	for (i = 0; i < num_tasks; i++) {
+		BLI_task_pool_push(task_pool, modifier_parallel_task, NULL, false, TASK_PRIORITY_HIGH);
+	}
+
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
+
+	BLI_spin_end(&state.lock);
+
+	if (state.scratch) {
+		if (finalize) {
+			for (i = 0; i < num_threads; i++) {
+				if (state.scratch_used[i]) {
+					finalize(userdata, state.scratch + scratch_size * (size_t)i);
+				}
+			}
+		}
+		MEM_freeN(state.scratch);
+		MEM_freeN(state.scratch_used);
+	}
+}
+
+void modifier_deform_parallel(int numVerts, void *userdata, ModifierParallelRangeFunc func)
+{
+	modifier_deform_parallel_ex(numVerts, userdata, func, NULL, 0, NULL, MOD_PARALLEL_MIN_VERTS);
+}
+
+
 #ifdef OPENNL_THREADING_HACK
 
 static ThreadMutex opennl_context_mutex = BLI_MUTEX_INITIALIZER;
@@ -52,6 +52,19 @@ struct DerivedMesh *get_dm_for_modifier(struct Object *ob, ModifierApplyFlag fla
 void modifier_get_vgroup(struct Object *ob, struct DerivedMesh *dm,
                          const char *name, struct MDeformVert **dvert, int *defgrp_index);
 
+/* below this many vertices the per-thread overhead isn't worth it */
+#define MOD_PARALLEL_MIN_VERTS 1024
+
+typedef void (*ModifierParallelRangeFunc)(void *__restrict userdata, int start, int stop, void *__restrict scratch);
+typedef void (*ModifierParallelFinalizeFunc)(void *__restrict userdata, void *__restrict scratch);
+
+bool modifier_deform_parallel_is_threaded(int numVerts, const int min_verts);
+void modifier_deform_parallel_ex(
+        int numVerts, void *userdata, ModifierParallelRangeFunc func,
+        const void *scratch_init, size_t scratch_size, ModifierParallelFinalizeFunc finalize,
+        const int min_verts);
+void modifier_deform_parallel(int numVerts, void *userdata, ModifierParallelRangeFunc func);
+
 /* XXX workaround for non-threadsafe context in OpenNL (T38403)
  * OpenNL uses global pointer for "current context", which causes
  * conflict when multiple modifiers get evaluated in threaded depgraph.
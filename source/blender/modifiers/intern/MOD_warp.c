@@ -36,6 +36,7 @@
 #include "BLI_utildefines.h"
 
 #include "BKE_cdderivedmesh.h"
+#include "BKE_image.h"
 #include "BKE_modifier.h"
 #include "BKE_deform.h"
 #include "BKE_texture.h"
@@ -173,78 +174,40 @@ static void updateDepsgraph(ModifierData *md,
 	}
 }
 
-static void warpModifier_do(WarpModifierData *wmd, Object *ob,
-                            DerivedMesh *dm, float (*vertexCos)[3], int numVerts)
-{
-	float obinv[4][4];
+typedef struct WarpUserdata {
+	WarpModifierData *wmd;
+	struct ImagePool *pool;
+	float (*vertexCos)[3];
+	float (*tex_co)[3];
+	MDeformVert *dvert;
+	int defgrp_index;
+	float strength;
 	float mat_from[4][4];
 	float mat_from_inv[4][4];
-	float mat_to[4][4];
-	float mat_unit[4][4];
 	float mat_final[4][4];
+	float mat_unit[4][4];
+} WarpUserdata;
 
-	float tmat[4][4];
-
+static void warpModifier_do_range(
+        void *__restrict userdata, int start, int stop, void *__restrict UNUSED(scratch))
+{
+	WarpUserdata *data = userdata;
+	WarpModifierData *wmd = data->wmd;
+	float (*vertexCos)[3] = data->vertexCos;
+	float (*tex_co)[3] = data->tex_co;
+	MDeformVert *dvert = data->dvert, *dv = NULL;
+	const int defgrp_index = data->defgrp_index;
 	const float falloff_radius_sq = SQUARE(wmd->falloff_radius);
-	float strength = wmd->strength;
-	float fac = 1.0f, weight;
+	const float strength = data->strength;
+	float fac = 1.0f, weight = strength;
+	float tmat[4][4];
 	int i;
-	int defgrp_index;
-	MDeformVert *dvert, *dv = NULL;
-
-	float (*tex_co)[3] = NULL;
-
-	if (!(wmd->object_from && wmd->object_to))
-		return;
-
-	modifier_get_vgroup(ob, dm, wmd->defgrp_name, &dvert, &defgrp_index);
-	if (dvert == NULL) {
-		defgrp_index = -1;
-	}
-
-	if (wmd->curfalloff == NULL) /* should never happen, but bad lib linking could cause it */
-		wmd->curfalloff = curvemapping_add(1, 0.0f, 0.0f, 1.0f, 1.0f);
-
-	if (wmd->curfalloff) {
-		curvemapping_initialize(wmd->curfalloff);
-	}
-
-	invert_m4_m4(obinv, ob->obmat);
 
-	mul_m4_m4m4(mat_from, obinv, wmd->object_from->obmat);
-	mul_m4_m4m4(mat_to, obinv, wmd->object_to->obmat);
-
-	invert_m4_m4(tmat, mat_from); // swap?
-	mul_m4_m4m4(mat_final, tmat, mat_to);
-
-	invert_m4_m4(mat_from_inv, mat_from);
-
-	unit_m4(mat_unit);
-
-	if (strength < 0.0f) {
-		float loc[3];
-		strength = -strength;
-
-		/* inverted location is not useful, just use the negative */
-		copy_v3_v3(loc, mat_final[3]);
-		invert_m4(mat_final);
-		negate_v3_v3(mat_final[3], loc);
-
-	}
-	weight = strength;
-
-	if (wmd->texture) {
-		tex_co = MEM_mallocN(sizeof(*tex_co) * numVerts, "warpModifier_do tex_co");
-		get_texture_coords((MappingInfoModifierData *)wmd, ob, dm, vertexCos, tex_co, numVerts);
-
-		modifier_init_texture(wmd->modifier.scene, wmd->texture);
-	}
-
-	for (i = 0; i < numVerts; i++) {
+	for (i = start; i < stop; i++) {
 		float *co = vertexCos[i];
 
 		if (wmd->falloff_type == eWarp_Falloff_None ||
-		    ((fac = len_squared_v3v3(co, mat_from[3])) < falloff_radius_sq &&
+		    ((fac = len_squared_v3v3(co, data->mat_from[3])) < falloff_radius_sq &&
 		     (fac = (wmd->falloff_radius - sqrtf(fac)) / wmd->falloff_radius)))
 		{
 			/* skip if no vert group found */
@@ -293,35 +256,122 @@ static void warpModifier_do(WarpModifierData *wmd, Object *ob,
 			if (tex_co) {
 				TexResult texres;
 				texres.nor = NULL;
-				BKE_texture_get_value(wmd->modifier.scene, wmd->texture, tex_co[i], &texres, false);
+				BKE_texture_get_value_ex(wmd->modifier.scene, wmd->texture, tex_co[i], &texres, data->pool, false);
 				fac *= texres.tin;
 			}
 
 			if (fac != 0.0f) {
 				/* into the 'from' objects space */
-				mul_m4_v3(mat_from_inv, co);
+				mul_m4_v3(data->mat_from_inv, co);
 
 				if (fac == 1.0f) {
-					mul_m4_v3(mat_final, co);
+					mul_m4_v3(data->mat_final, co);
 				}
 				else {
 					if (wmd->flag & MOD_WARP_VOLUME_PRESERVE) {
 						/* interpolate the matrix for nicer locations */
-						blend_m4_m4m4(tmat, mat_unit, mat_final, fac);
+						blend_m4_m4m4(tmat, data->mat_unit, data->mat_final, fac);
 						mul_m4_v3(tmat, co);
 					}
 					else {
 						float tvec[3];
-						mul_v3_m4v3(tvec, mat_final, co);
+						mul_v3_m4v3(tvec, data->mat_final, co);
 						interp_v3_v3v3(co, co, tvec, fac);
 					}
 				}
 
 				/* out of the 'from' objects space */
-				mul_m4_v3(mat_from, co);
+				mul_m4_v3(data->mat_from, co);
 			}
 		}
 	}
+}
+
+static void warpModifier_do(WarpModifierData *wmd, Object *ob,
+                            DerivedMesh *dm, float (*vertexCos)[3], int numVerts)
+{
+	float obinv[4][4];
+	float mat_from[4][4];
+	float mat_from_inv[4][4];
+	float mat_to[4][4];
+	float mat_unit[4][4];
+	float mat_final[4][4];
+
+	float tmat[4][4];
+
+	WarpUserdata data = {NULL};
+	float strength = wmd->strength;
+	int defgrp_index;
+	MDeformVert *dvert;
+
+	float (*tex_co)[3] = NULL;
+
+	if (!(wmd->object_from && wmd->object_to))
+		return;
+
+	modifier_get_vgroup(ob, dm, wmd->defgrp_name, &dvert, &defgrp_index);
+	if (dvert == NULL) {
+		defgrp_index = -1;
+	}
+
+	if (wmd->curfalloff == NULL) /* should never happen, but bad lib linking could cause it */
+		wmd->curfalloff = curvemapping_add(1, 0.0f, 0.0f, 1.0f, 1.0f);
+
+	if (wmd->curfalloff) {
+		curvemapping_initialize(wmd->curfalloff);
+	}
+
+	invert_m4_m4(obinv, ob->obmat);
+
+	mul_m4_m4m4(mat_from, obinv, wmd->object_from->obmat);
+	mul_m4_m4m4(mat_to, obinv, wmd->object_to->obmat);
+
+	invert_m4_m4(tmat, mat_from); // swap?
+	mul_m4_m4m4(mat_final, tmat, mat_to);
+
+	invert_m4_m4(mat_from_inv, mat_from);
+
+	unit_m4(mat_unit);
+
+	if (strength < 0.0f) {
+		float loc[3];
+		strength = -strength;
+
+		/* inverted location is not useful, just use the negative */
+		copy_v3_v3(loc, mat_final[3]);
+		invert_m4(mat_final);
+		negate_v3_v3(mat_final[3], loc);
+
+	}
+
+	if (wmd->texture) {
+		tex_co = MEM_mallocN(sizeof(*tex_co) * numVerts, "warpModifier_do tex_co");
+		get_texture_coords((MappingInfoModifierData *)wmd, ob, dm, vertexCos, tex_co, numVerts);
+
+		modifier_init_texture(wmd->modifier.scene, wmd->texture);
+	}
+
+	data.wmd = wmd;
+	data.vertexCos = vertexCos;
+	data.tex_co = tex_co;
+	data.dvert = dvert;
+	data.defgrp_index = defgrp_index;
+	data.strength = strength;
+	copy_m4_m4(data.mat_from, mat_from);
+	copy_m4_m4(data.mat_from_inv, mat_from_inv);
+	copy_m4_m4(data.mat_final, mat_final);
+	copy_m4_m4(data.mat_unit, mat_unit);
+
+	if (wmd->texture) {
+		data.pool = BKE_image_pool_new();
+		BKE_texture_fetch_images_for_pool(wmd->texture, data.pool);
+	}
+
+	modifier_deform_parallel(numVerts, &data, warpModifier_do_range);
+
+	if (data.pool) {
+		BKE_image_pool_free(data.pool);
+	}
 
 	if (tex_co)
 		MEM_freeN(tex_co);
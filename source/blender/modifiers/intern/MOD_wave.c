@@ -44,6 +44,7 @@
 
 #include "BKE_deform.h"
 #include "BKE_DerivedMesh.h"
+#include "BKE_image.h"
 #include "BKE_library.h"
 #include "BKE_scene.h"
 #include "BKE_texture.h"
@@ -185,11 +186,134 @@ static CustomDataMask requiredDataMask(Object *UNUSED(ob), ModifierData *md)
 	return dataMask;
 }
 
+typedef struct WaveUserdata {
+	WaveModifierData *wmd;
+	struct ImagePool *pool;
+	MVert *mvert;
+	MDeformVert *dvert;
+	int defgrp_index;
+	float (*tex_co)[3];
+	float (*vertexCos)[3];
+	float ctime, minfac, lifefac;
+} WaveUserdata;
+
+static void waveModifier_do_range(
+        void *__restrict userdata, int start, int stop, void *__restrict UNUSED(scratch))
+{
+	const WaveUserdata *data = userdata;
+	WaveModifierData *wmd = data->wmd;
+	MVert *mvert = data->mvert;
+	MDeformVert *dvert = data->dvert;
+	float (*tex_co)[3] = data->tex_co;
+	const int defgrp_index = data->defgrp_index;
+	const float ctime = data->ctime;
+	const float minfac = data->minfac;
+	const float lifefac = data->lifefac;
+	const int wmd_axis = wmd->flag & (MOD_WAVE_X | MOD_WAVE_Y);
+	const float falloff = wmd->falloff;
+	float falloff_fac = 1.0f; /* when falloff == 0.0f this stays at 1.0f */
+	/* avoid divide by zero checks within the loop */
+	const float falloff_inv = falloff ? 1.0f / falloff : 1.0f;
+	int i;
+
+	for (i = start; i < stop; i++) {
+		float *co = data->vertexCos[i];
+		float x = co[0] - wmd->startx;
+		float y = co[1] - wmd->starty;
+		float amplit = 0.0f;
+		float def_weight = 1.0f;
+
+		/* get weights */
+		if (dvert) {
+			def_weight = defvert_find_weight(&dvert[i], defgrp_index);
+
+			/* if this vert isn't in the vgroup, don't deform it */
+			if (def_weight == 0.0f) {
+				continue;
+			}
+		}
+
+		switch (wmd_axis) {
+			case MOD_WAVE_X | MOD_WAVE_Y:
+				amplit = sqrtf(x * x + y * y);
+				break;
+			case MOD_WAVE_X:
+				amplit = x;
+				break;
+			case MOD_WAVE_Y:
+				amplit = y;
+				break;
+		}
+
+		/* this way it makes nice circles */
+		amplit -= (ctime - wmd->timeoffs) * wmd->speed;
+
+		if (wmd->flag & MOD_WAVE_CYCL) {
+			amplit = (float)fmodf(amplit - wmd->width, 2.0f * wmd->width) +
+			         wmd->width;
+		}
+
+		if (falloff != 0.0f) {
+			float dist = 0.0f;
+
+			switch (wmd_axis) {
+				case MOD_WAVE_X | MOD_WAVE_Y:
+					dist = sqrtf(x * x + y * y);
+					break;
+				case MOD_WAVE_X:
+					dist = fabsf(x);
+					break;
+				case MOD_WAVE_Y:
+					dist = fabsf(y);
+					break;
+			}
+
+			falloff_fac = (1.0f - (dist * falloff_inv));
+			CLAMP(falloff_fac, 0.0f, 1.0f);
+		}
+
+		/* GAUSSIAN */
+		if ((falloff_fac != 0.0f) && (amplit > -wmd->width) && (amplit < wmd->width)) {
+			amplit = amplit * wmd->narrow;
+			amplit = (float)(1.0f / expf(amplit * amplit) - minfac);
+
+			/*apply texture*/
+			if (wmd->texture) {
+				TexResult texres;
+				texres.nor = NULL;
+				BKE_texture_get_value_ex(wmd->modifier.scene, wmd->texture, tex_co[i], &texres, data->pool, false);
+				amplit *= texres.tin;
+			}
+
+			/*apply weight & falloff */
+			amplit *= def_weight * falloff_fac;
+
+			if (mvert) {
+				/* move along normals */
+				if (wmd->flag & MOD_WAVE_NORM_X) {
+					co[0] += (lifefac * amplit) * mvert[i].no[0] / 32767.0f;
+				}
+				if (wmd->flag & MOD_WAVE_NORM_Y) {
+					co[1] += (lifefac * amplit) * mvert[i].no[1] / 32767.0f;
+				}
+				if (wmd->flag & MOD_WAVE_NORM_Z) {
+					co[2] += (lifefac * amplit) * mvert[i].no[2] / 32767.0f;
+				}
+			}
+			else {
+				/* move along local z axis */
+				co[2] += lifefac * amplit;
+			}
+		}
+	}
+}
+
 static void waveModifier_do(WaveModifierData *md, 
                             Scene *scene, Object *ob, DerivedMesh *dm,
                             float (*vertexCos)[3], int numVerts)
 {
 	WaveModifierData *wmd = (WaveModifierData *) md;
+	WaveUserdata data = {NULL};
 	MVert *mvert = NULL;
 	MDeformVert *dvert;
 	int defgrp_index;
@@ -197,9 +321,6 @@ static void waveModifier_do(WaveModifierData *md,
 	float minfac = (float)(1.0 / exp(wmd->width * wmd->narrow * wmd->width * wmd->narrow));
 	float lifefac = wmd->height;
 	float (*tex_co)[3] = NULL;
-	const int wmd_axis = wmd->flag & (MOD_WAVE_X | MOD_WAVE_Y);
-	const float falloff = wmd->falloff;
-	float falloff_fac = 1.0f; /* when falloff == 0.0f this stays at 1.0f */
 
 	if ((wmd->flag & MOD_WAVE_NORM) && (ob->type == OB_MESH))
 		mvert = dm->getVertArray(dm);
@@ -239,99 +360,25 @@ static void waveModifier_do(WaveModifierData *md,
 	}
 
 	if (lifefac != 0.0f) {
-		/* avoid divide by zero checks within the loop */
-		float falloff_inv = falloff ? 1.0f / falloff : 1.0f;
-		int i;
-
-		for (i = 0; i < numVerts; i++) {
-			float *co = vertexCos[i];
-			float x = co[0] - wmd->startx;
-			float y = co[1] - wmd->starty;
-			float amplit = 0.0f;
-			float def_weight = 1.0f;
-
-			/* get weights */
-			if (dvert) {
-				def_weight = defvert_find_weight(&dvert[i], defgrp_index);
-
-				/* if this vert isn't in the vgroup, don't deform it */
-				if (def_weight == 0.0f) {
-					continue;
-				}
-			}
-
-			switch (wmd_axis) {
-				case MOD_WAVE_X | MOD_WAVE_Y:
-					amplit = sqrtf(x * x + y * y);
-					break;
-				case MOD_WAVE_X:
-					amplit = x;
-					break;
-				case MOD_WAVE_Y:
-					amplit = y;
-					break;
-			}
-
-			/* this way it makes nice circles */
-			amplit -= (ctime - wmd->timeoffs) * wmd->speed;
-
-			if (wmd->flag & MOD_WAVE_CYCL) {
-				amplit = (float)fmodf(amplit - wmd->width, 2.0f * wmd->width) +
-				         wmd->width;
-			}
-
-			if (falloff != 0.0f) {
-				float dist = 0.0f;
-
-				switch (wmd_axis) {
-					case MOD_WAVE_X | MOD_WAVE_Y:
-						dist = sqrtf(x * x + y * y);
-						break;
-					case MOD_WAVE_X:
-						dist = fabsf(x);
-						break;
-					case MOD_WAVE_Y:
-						dist = fabsf(y);
-						break;
-				}
-
-				falloff_fac = (1.0f - (dist * falloff_inv));
-				CLAMP(falloff_fac, 0.0f, 1.0f);
-			}
+		data.wmd = wmd;
+		data.mvert = mvert;
+		data.dvert = dvert;
+		data.defgrp_index = defgrp_index;
+		data.tex_co = tex_co;
+		data.vertexCos = vertexCos;
+		data.ctime = ctime;
+		data.minfac = minfac;
+		data.lifefac = lifefac;
+
+		if (wmd->texture) {
+			data.pool = BKE_image_pool_new();
+			BKE_texture_fetch_images_for_pool(wmd->texture, data.pool);
+		}
 
-			/* GAUSSIAN */
-			if ((falloff_fac != 0.0f) && (amplit > -wmd->width) && (amplit < wmd->width)) {
-				amplit = amplit * wmd->narrow;
-				amplit = (float)(1.0f / expf(amplit * amplit) - minfac);
-
-				/*apply texture*/
-				if (wmd->texture) {
-					TexResult texres;
-					texres.nor = NULL;
-					BKE_texture_get_value(wmd->modifier.scene, wmd->texture, tex_co[i], &texres, false);
-					amplit *= texres.tin;
-				}
+		modifier_deform_parallel(numVerts, &data, waveModifier_do_range);
 
-				/*apply weight & falloff */
-				amplit *= def_weight * falloff_fac;
-
-				if (mvert) {
-					/* move along normals */
-					if (wmd->flag & MOD_WAVE_NORM_X) {
-						co[0] += (lifefac * amplit) * mvert[i].no[0] / 32767.0f;
-					}
-					if (wmd->flag & MOD_WAVE_NORM_Y) {
-						co[1] += (lifefac * amplit) * mvert[i].no[1] / 32767.0f;
-					}
-					if (wmd->flag & MOD_WAVE_NORM_Z) {
-						co[2] += (lifefac * amplit) * mvert[i].no[2] / 32767.0f;
-					}
-				}
-				else {
-					/* move along local z axis */
-					co[2] += lifefac * amplit;
-				}
-			}
+		if (data.pool) {
+			BKE_image_pool_free(data.pool);
 		}
 	}
 
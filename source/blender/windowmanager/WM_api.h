@@ -425,6 +425,7 @@ enum {
 	WM_JOB_TYPE_CLIP_PREFETCH,
 	WM_JOB_TYPE_SEQ_BUILD_PROXY,
 	WM_JOB_TYPE_SEQ_BUILD_PREVIEW,
+	WM_JOB_TYPE_AUTOSAVE,
 	/* add as needed, screencast, seq proxy build
 	 * if having hard coded values is a problem */
 };
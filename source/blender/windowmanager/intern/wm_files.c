@@ -85,6 +85,7 @@
 
 #include "BLO_readfile.h"
 #include "BLO_writefile.h"
+#include "BLO_undofile.h"
 
 #include "RNA_access.h"
 
@@ -1180,11 +1181,42 @@ void WM_autosave_init(wmWindowManager *wm)
 		wm->autosavetimer = WM_event_add_timer(wm, NULL, TIMERAUTOSAVE, U.savetime * 60.0);
 }
 
+static void wm_autosave_job_startjob(void *customdata, short *UNUSED(stop), short *UNUSED(do_update), float *UNUSED(progress))
+{
+	const BlendFileSnapshot *snapshot = customdata;
+
+	/* no error reporting to console, and not stopped on exit, the file should be complete */
+	BLO_write_file_snapshot_save(snapshot, NULL);
+}
+
+static void wm_autosave_job_free(void *customdata)
+{
+	BLO_write_file_snapshot_free(customdata);
+}
+
+/**
+ * The slow part of saving (compression and writing to disk) runs in a job,
+ * so the UI doesn't stall while saving big files.
+ */
+static void wm_autosave_write_job(wmWindowManager *wm, BlendFileSnapshot *snapshot)
+{
+	wmJob *wm_job;
+
+	wm_job = WM_jobs_get(wm, NULL, wm, "Auto Save", 0, WM_JOB_TYPE_AUTOSAVE);
+	WM_jobs_customdata_set(wm_job, snapshot, wm_autosave_job_free);
+	WM_jobs_timer(wm_job, 1.0, 0, 0);
+	WM_jobs_callbacks(wm_job, wm_autosave_job_startjob, NULL, NULL, NULL);
+
+	WM_jobs_start(wm, wm_job);
+}
+
 void wm_autosave_timer(const bContext *C, wmWindowManager *wm, wmTimer *UNUSED(wt))
 {
 	wmWindow *win;
 	wmEventHandler *handler;
+	BlendFileSnapshot *snapshot = NULL;
 	char filepath[FILE_MAX];
+	int fileflags;
 	
 	WM_event_remove_timer(wm, NULL, wm->autosavetimer);
 
@@ -1198,20 +1230,39 @@ void wm_autosave_timer(const bContext *C, wmWindowManager *wm, wmTimer *UNUSED(w
 		}
 	}
 
+	/* the previous auto save is still being written, try again in 10 seconds */
+	if (WM_jobs_test(wm, wm, WM_JOB_TYPE_AUTOSAVE)) {
+		wm->autosavetimer = WM_event_add_timer(wm, NULL, TIMERAUTOSAVE, 10.0);
+		return;
+	}
+
 	wm_autosave_location(filepath);
 
+	fileflags = G.fileflags & ~(G_FILE_AUTOPLAY | G_FILE_HISTORY);
+
 	if (U.uiflag & USER_GLOBALUNDO) {
-		/* fast save of last undobuffer, now with UI */
-		BKE_undo_save_file(filepath);
+		/* fast save of last undobuffer, now with UI, it's only referenced here */
+		const MemFile *memfile = BKE_undo_get_memfile();
+
+		if (memfile) {
+			snapshot = BLO_write_file_snapshot_memfile(memfile, filepath, fileflags);
+		}
 	}
 	else {
 		/*  save as regular blend file */
-		int fileflags = G.fileflags & ~(G_FILE_COMPRESS | G_FILE_AUTOPLAY | G_FILE_HISTORY);
-
 		ED_editors_flush_edits(C, false);
 
-		/* no error reporting to console */
-		BLO_write_file(CTX_data_main(C), filepath, fileflags, NULL, NULL);
+		/* copying the file to memory first is only worth it to compress it in the job */
+		if (fileflags & G_FILE_COMPRESS) {
+			snapshot = BLO_write_file_snapshot(CTX_data_main(C), filepath, fileflags, NULL, NULL);
+		}
+		else {
+			BLO_write_file(CTX_data_main(C), filepath, fileflags, NULL, NULL);
+		}
+	}
+
+	if (snapshot) {
+		wm_autosave_write_job(wm, snapshot);
 	}
 	/* do timer after file write, just in case file write takes a long time */
 	wm->autosavetimer = WM_event_add_timer(wm, NULL, TIMERAUTOSAVE, U.savetime * 60.0);
@@ -51,6 +51,7 @@
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
+#include "BLO_readfile.h"
 #include "BLO_writefile.h"
 
 #include "BKE_blender.h"
@@ -496,6 +497,7 @@ void WM_exit_ext(bContext *C, const bool do_python)
 #endif
 	
 	free_blender();  /* blender.c, does entire library and spacetypes */
+	BLO_library_cache_free();
 //	free_matcopybuf();
 	free_anim_copybuf();
 	free_anim_drivers_copybuf();
@@ -564,6 +566,9 @@ void WM_exit_ext(bContext *C, const bool do_python)
 
 	BLI_threadapi_exit();
 
+	/* after freeing everything, so the last state in the profile are the leaks */
+	MEM_heap_profiler_write();
+
 	if (MEM_get_memory_blocks_in_use() != 0) {
 		size_t mem_in_use = MEM_get_memory_in_use() + MEM_get_memory_in_use();
 		printf("Error: Not freed memory blocks: %u, total unfreed memory %f MB\n",
@@ -265,6 +265,7 @@ static int print_help(int UNUSED(argc), const char **UNUSED(argv), void *data)
 	BLI_argsPrintArgDoc(ba, "--render-output");
 	BLI_argsPrintArgDoc(ba, "--engine");
 	BLI_argsPrintArgDoc(ba, "--threads");
+	BLI_argsPrintArgDoc(ba, "--profile-modifiers");
 	
 	printf("\n");
 	printf("Format Options:\n");
@@ -320,10 +321,12 @@ static int print_help(int UNUSED(argc), const char **UNUSED(argv), void *data)
 	BLI_argsPrintArgDoc(ba, "--debug-cycles");
 #endif
 	BLI_argsPrintArgDoc(ba, "--debug-memory");
+	BLI_argsPrintArgDoc(ba, "--profile-memory");
 	BLI_argsPrintArgDoc(ba, "--debug-jobs");
 	BLI_argsPrintArgDoc(ba, "--debug-python");
 	BLI_argsPrintArgDoc(ba, "--debug-depsgraph");
 	BLI_argsPrintArgDoc(ba, "--debug-depsgraph-no-threads");
+	BLI_argsPrintArgDoc(ba, "--debug-depsgraph-time");
 
 	BLI_argsPrintArgDoc(ba, "--debug-gpumem");
 	BLI_argsPrintArgDoc(ba, "--debug-wm");
@@ -364,6 +367,7 @@ static int print_help(int UNUSED(argc), const char **UNUSED(argv), void *data)
 	printf("\n");
 	printf("Experimental features:\n");
 	BLI_argsPrintArgDoc(ba, "--enable-new-depsgraph");
+	BLI_argsPrintArgDoc(ba, "--enable-slab-allocator");
 
 	printf("Argument Parsing:\n");
 	printf("\tArguments must be separated by white space, eg:\n");
@@ -487,6 +491,24 @@ static int debug_mode_memory(int UNUSED(argc), const char **UNUSED(argv), void *
 	return 0;
 }
 
+static int enable_slab_allocator(int UNUSED(argc), const char **UNUSED(argv), void *UNUSED(data))
+{
+	/* Handled before any allocation happens, see main(). */
+	return 0;
+}
+
+static int profile_memory(int argc, const char **UNUSED(argv), void *UNUSED(data))
+{
+	/* Handled before any allocation happens, see main(). */
+	if (argc > 1) {
+		return 1;
+	}
+	else {
+		printf("\nError: you must specify a filepath after '--profile-memory'.\n");
+		return 0;
+	}
+}
+
 static int set_debug_value(int argc, const char **argv, void *UNUSED(data))
 {
 	if (argc > 1) {
@@ -1122,6 +1144,33 @@ static int render_animation(int UNUSED(argc), const char **UNUSED(argv), void *d
 	return 0;
 }
 
+static int profile_modifiers(int argc, const char **argv, void *data)
+{
+	bContext *C = data;
+	Scene *scene = CTX_data_scene(C);
+	if (scene) {
+		if (argc > 1) {
+			int frames = atoi(argv[1]);
+
+			if (frames < 1) {
+				printf("\nError: number of frames must be at least 1 for '--profile-modifiers'.\n");
+				return 1;
+			}
+
+			modifiers_profile(CTX_data_main(C), scene, frames);
+			return 1;
+		}
+		else {
+			printf("\nError: number of frames must follow '--profile-modifiers'.\n");
+			return 0;
+		}
+	}
+	else {
+		printf("\nError: no blend loaded. cannot use '--profile-modifiers'.\n");
+		return 0;
+	}
+}
+
 static int set_scene(int argc, const char **argv, void *data)
 {
 	if (argc > 1) {
@@ -1552,15 +1601,18 @@ static void setupArguments(bContext *C, bArgs *ba, SYS_SystemHandle *syshandle)
 	BLI_argsAdd(ba, 1, NULL, "--debug-cycles", "\n\tEnable debug messages from Cycles", debug_mode_cycles, NULL);
 #endif
 	BLI_argsAdd(ba, 1, NULL, "--debug-memory", "\n\tEnable fully guarded memory allocation and debugging", debug_mode_memory, NULL);
+	BLI_argsAdd(ba, 1, NULL, "--profile-memory", "<filepath>\n\tSample memory allocations by name, the profile is written as JSON to <filepath> on exit", profile_memory, NULL);
 
 	BLI_argsAdd(ba, 1, NULL, "--debug-value", "<value>\n\tSet debug value of <value> on startup\n", set_debug_value, NULL);
 	BLI_argsAdd(ba, 1, NULL, "--debug-jobs",  "\n\tEnable time profiling for background jobs.", debug_mode_generic, (void *)G_DEBUG_JOBS);
 	BLI_argsAdd(ba, 1, NULL, "--debug-gpu",  "\n\tEnable gpu debug context and information for OpenGL 4.3+.", debug_mode_generic, (void *)G_DEBUG_GPU);
 	BLI_argsAdd(ba, 1, NULL, "--debug-depsgraph", "\n\tEnable debug messages from dependency graph", debug_mode_generic, (void *)G_DEBUG_DEPSGRAPH);
 	BLI_argsAdd(ba, 1, NULL, "--debug-depsgraph-no-threads", "\n\tSwitch dependency graph to a single threaded evaluation", debug_mode_generic, (void *)G_DEBUG_DEPSGRAPH_NO_THREADS);
+	BLI_argsAdd(ba, 1, NULL, "--debug-depsgraph-time", "\n\tPrint the timing and critical path of new dependency graph evaluations", debug_mode_generic, (void *)G_DEBUG_DEPSGRAPH_TIME);
 	BLI_argsAdd(ba, 1, NULL, "--debug-gpumem", "\n\tEnable GPU memory stats in status bar", debug_mode_generic, (void *)G_DEBUG_GPU_MEM);
 
 	BLI_argsAdd(ba, 1, NULL, "--enable-new-depsgraph", "\n\tUse new dependency graph", depsgraph_use_new, NULL);
+	BLI_argsAdd(ba, 1, NULL, "--enable-slab-allocator", "\n\tServe small memory blocks from size-class slabs with per-thread caches", enable_slab_allocator, NULL);
 
 	BLI_argsAdd(ba, 1, NULL, "--verbose", "<verbose>\n\tSet logging verbosity level.", set_verbosity, NULL);
 
@@ -1590,6 +1642,7 @@ static void setupArguments(bContext *C, bArgs *ba, SYS_SystemHandle *syshandle)
 	BLI_argsAdd(ba, 4, "-g", NULL, game_doc, set_ge_parameters, syshandle);
 	BLI_argsAdd(ba, 4, "-f", "--render-frame", "<frame>\n\tRender frame <frame> and save it.\n\t+<frame> start frame relative, -<frame> end frame relative.", render_frame, C);
 	BLI_argsAdd(ba, 4, "-a", "--render-anim", "\n\tRender frames from start to end (inclusive)", render_animation, C);
+	BLI_argsAdd(ba, 4, NULL, "--profile-modifiers", "<frames>\n\tEvaluate <frames> frames from the start frame and print the time, peak memory and result size of each modifier", profile_modifiers, C);
 	BLI_argsAdd(ba, 4, "-S", "--scene", "<name>\n\tSet the active scene <name> for rendering", set_scene, C);
 	BLI_argsAdd(ba, 4, "-s", "--frame-start", "<frame>\n\tSet start to frame <frame> (use before the -a argument)", set_start_frame, C);
 	BLI_argsAdd(ba, 4, "-e", "--frame-end", "<frame>\n\tSet end to frame <frame> (use before the -a argument)", set_end_frame, C);
@@ -1678,19 +1731,39 @@ int main(
 	 *       guarded allocator before any allocation happened.
 	 */
 	{
+		bool use_guarded_allocator = false, use_slab_allocator = false;
+		const char *heap_profile_filepath = NULL;
 		int i;
 		for (i = 0; i < argc; i++) {
 			if (STREQ(argv[i], "--debug") || STREQ(argv[i], "-d") ||
 			    STREQ(argv[i], "--debug-memory") || STREQ(argv[i], "--debug-all"))
 			{
-				printf("Switching to fully guarded memory allocator.\n");
-				MEM_use_guarded_allocator();
-				break;
+				use_guarded_allocator = true;
+			}
+			else if (STREQ(argv[i], "--enable-slab-allocator")) {
+				use_slab_allocator = true;
+			}
+			else if (STREQ(argv[i], "--profile-memory") && (i + 1 < argc)) {
+				heap_profile_filepath = argv[i + 1];
 			}
 			else if (STREQ(argv[i], "--")) {
 				break;
 			}
 		}
+
+		/* Debugging wins, the guarded allocator is the one which can find memory errors. */
+		if (use_guarded_allocator) {
+			printf("Switching to fully guarded memory allocator.\n");
+			MEM_use_guarded_allocator();
+		}
+		else if (use_slab_allocator) {
+			MEM_use_slab_allocator();
+		}
+
+		/* Works on top of whichever allocator is used. */
+		if (heap_profile_filepath) {
+			MEM_use_heap_profiler(heap_profile_filepath, 0);
+		}
 	}
 
 #ifdef BUILD_DATE
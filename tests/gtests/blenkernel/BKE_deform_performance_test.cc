@@ -0,0 +1,258 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <math.h>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+
+#include "DNA_meshdata_types.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_math_rotation.h"
+#include "BLI_threads.h"
+
+#include "BKE_cdderivedmesh.h"
+#include "BKE_customdata.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_mesh.h"
+
+#include "PIL_time.h"
+}
+
+/* quads of the mesh along each side, about 100k verts */
+#define GRID_SIZE 320
+/* frames evaluated per case, the first one isn't timed */
+#define FRAMES_NUM 11
+
+static DerivedMesh *grid_dm_new(int size)
+{
+	const int verts_num = (size + 1) * (size + 1);
+	DerivedMesh *dm = CDDM_new(verts_num, 0, 0, size * size * 4, size * size);
+	MVert *mvert = dm->getVertArray(dm);
+	MLoop *mloop = dm->getLoopArray(dm);
+	MPoly *mpoly = dm->getPolyArray(dm);
+
+	for (int y = 0; y <= size; y++) {
+		for (int x = 0; x <= size; x++, mvert++) {
+			mvert->co[0] = (float)x / size;
+			mvert->co[1] = (float)y / size;
+			mvert->co[2] = 0.0f;
+		}
+	}
+
+	for (int y = 0; y < size; y++) {
+		for (int x = 0; x < size; x++, mpoly++) {
+			const int v = y * (size + 1) + x;
+
+			mpoly->loopstart = (int)(mloop - dm->getLoopArray(dm));
+			mpoly->totloop = 4;
+			(mloop++)->v = v;
+			(mloop++)->v = v + 1;
+			(mloop++)->v = v + size + 2;
+			(mloop++)->v = v + size + 1;
+		}
+	}
+
+	CDDM_calc_edges(dm);
+
+	return dm;
+}
+
+/* a wave moving along the grid, so the normals change on every frame */
+static void grid_cos_deform(float (*cos)[3], int verts_num, int frame)
+{
+	for (int i = 0; i < verts_num; i++) {
+		cos[i][2] = 0.1f * sinf(10.0f * cos[i][0] + 0.1f * frame) * cosf(10.0f * cos[i][1]);
+	}
+}
+
+/**
+ * Deform \a FRAMES_NUM frames the way a deform-only modifier stack does:
+ * get the coordinates, deform them, apply them to a copy and compute its normals.
+ * \return Average time of a frame (milliseconds), \a r_time_normals only covers the normals.
+ */
+static double deform_frames_eval(DerivedMesh *dm, double *r_time_normals, unsigned int *r_hash)
+{
+	const int verts_num = dm->getNumVerts(dm);
+	double time_total = 0.0;
+
+	*r_time_normals = 0.0;
+
+	for (int frame = 0; frame < FRAMES_NUM; frame++) {
+		double time_start, time_normals;
+		float (*cos)[3] = (float (*)[3])MEM_mallocN(sizeof(*cos) * (size_t)verts_num, __func__);
+		DerivedMesh *result;
+
+		time_start = PIL_check_seconds_timer();
+		dm->getVertCos(dm, cos);
+		grid_cos_deform(cos, verts_num, frame);
+		result = CDDM_copy(dm);
+		CDDM_apply_vert_coords(result, cos);
+
+		time_normals = PIL_check_seconds_timer();
+		CDDM_calc_normals(result);
+
+		if (frame > 0) {
+			time_total += PIL_check_seconds_timer() - time_start;
+			*r_time_normals += PIL_check_seconds_timer() - time_normals;
+		}
+
+		if (frame == FRAMES_NUM - 1) {
+			*r_hash = BLI_hash_mm2((const unsigned char *)result->getVertArray(result),
+			                       sizeof(MVert) * (size_t)verts_num, 0);
+		}
+
+		result->release(result);
+		MEM_freeN(cos);
+	}
+
+	*r_time_normals *= 1000.0 / (FRAMES_NUM - 1);
+	return time_total * 1000.0 / (FRAMES_NUM - 1);
+}
+
+/* the task scheduler is created again with the overridden thread count */
+static void threads_num_override_set(int threads_num)
+{
+	BLI_system_num_threads_override_set(threads_num);
+	BLI_threadapi_exit();
+	BLI_threadapi_init();
+}
+
+/**
+ * Deform throughput with one thread and with all of them,
+ * vertex normals must be the same whatever the number of threads.
+ */
+TEST(deform, Performance)
+{
+	const int threads_num = BLI_system_thread_count();
+	DerivedMesh *dm;
+	unsigned int hash_single, hash_threaded;
+	double time_single, time_threaded, time_normals_single, time_normals_threaded;
+
+	BLI_threadapi_init();
+	dm = grid_dm_new(GRID_SIZE);
+
+	printf("\n========== deform: %d verts, %d faces, %d threads ==========\n",
+	       dm->getNumVerts(dm), dm->getNumPolys(dm), threads_num);
+
+	threads_num_override_set(1);
+	time_single = deform_frames_eval(dm, &time_normals_single, &hash_single);
+
+	threads_num_override_set(0);
+	time_threaded = deform_frames_eval(dm, &time_normals_threaded, &hash_threaded);
+
+	printf("1 thread   %8.2f ms per frame (normals %8.2f ms), %6.2f Mverts/s\n",
+	       time_single, time_normals_single, dm->getNumVerts(dm) / (time_single * 1000.0));
+	printf("%d threads  %8.2f ms per frame (normals %8.2f ms), %6.2f Mverts/s\n",
+	       threads_num, time_threaded, time_normals_threaded, dm->getNumVerts(dm) / (time_threaded * 1000.0));
+
+	EXPECT_EQ(hash_single, hash_threaded);
+
+	dm->release(dm);
+	BLI_threadapi_exit();
+}
+
+/**
+ * Deform \a FRAMES_NUM frames of an auto smooth mesh and compute its loop normals,
+ * with the topology cache the viewport keeps on the object or without it.
+ * \return Time of the fastest frame for the loop normals (milliseconds).
+ */
+static double split_normals_frames_eval(DerivedMesh *dm, bool use_cache, unsigned int *r_hash)
+{
+	const int verts_num = dm->getNumVerts(dm);
+	const int loops_num = dm->getNumLoops(dm);
+	MLoopNorSplitCache *lnor_split_cache = use_cache ? BKE_lnor_split_cache_new() : NULL;
+	float (*cos)[3] = (float (*)[3])MEM_mallocN(sizeof(*cos) * (size_t)verts_num, __func__);
+	double time_min = 0.0;
+
+	dm->getVertCos(dm, cos);
+
+	for (int frame = 0; frame < FRAMES_NUM; frame++) {
+		double time_start;
+
+		grid_cos_deform(cos, verts_num, frame);
+		CDDM_apply_vert_coords(dm, cos);
+
+		time_start = PIL_check_seconds_timer();
+		dm->lnor_split_cache = lnor_split_cache;
+		dm->calcLoopNormals(dm, true, DEG2RADF(30.0f));
+		dm->lnor_split_cache = NULL;
+
+		if (frame > 0) {
+			const double time = PIL_check_seconds_timer() - time_start;
+			time_min = (frame == 1) ? time : MIN2(time_min, time);
+		}
+
+		if (frame == FRAMES_NUM - 1) {
+			*r_hash = BLI_hash_mm2((const unsigned char *)CustomData_get_layer(&dm->loopData, CD_NORMAL),
+			                       sizeof(float[3]) * (size_t)loops_num, 0);
+		}
+
+		CustomData_free_layers(&dm->loopData, CD_NORMAL, loops_num);
+	}
+
+	if (lnor_split_cache) {
+		BKE_lnor_split_cache_free(lnor_split_cache);
+	}
+	MEM_freeN(cos);
+
+	return time_min * 1000.0;
+}
+
+/**
+ * Split normals with one thread and with all of them, with and without the topology cache,
+ * loop normals must be the same in all cases.
+ */
+TEST(deform, SplitNormals)
+{
+	const int threads_num = BLI_system_thread_count();
+	DerivedMesh *dm;
+	MPoly *mpoly;
+	MEdge *medge;
+	unsigned int hash_ref = 0;
+
+	BLI_threadapi_init();
+	dm = grid_dm_new(GRID_SIZE);
+
+	/* smooth, with some sharp edges so there are fans to split */
+	mpoly = dm->getPolyArray(dm);
+	for (int i = 0; i < dm->getNumPolys(dm); i++) {
+		mpoly[i].flag |= ME_SMOOTH;
+	}
+	medge = dm->getEdgeArray(dm);
+	for (int i = 0; i < dm->getNumEdges(dm); i += 13) {
+		medge[i].flag |= ME_SHARP;
+	}
+
+	printf("\n========== split normals: %d loops, %d faces, %d threads ==========\n",
+	       dm->getNumLoops(dm), dm->getNumPolys(dm), threads_num);
+
+	for (int i = 0; i < 2; i++) {
+		const bool use_cache = (i == 1);
+		unsigned int hash_single, hash_threaded;
+		double time_single, time_threaded;
+
+		threads_num_override_set(1);
+		time_single = split_normals_frames_eval(dm, use_cache, &hash_single);
+
+		threads_num_override_set(0);
+		time_threaded = split_normals_frames_eval(dm, use_cache, &hash_threaded);
+
+		printf("%-14s 1 thread %8.2f ms, %d threads %8.2f ms\n",
+		       use_cache ? "cached" : "not cached", time_single, threads_num, time_threaded);
+
+		EXPECT_EQ(hash_single, hash_threaded);
+		if (i == 0) {
+			hash_ref = hash_single;
+		}
+		else {
+			EXPECT_EQ(hash_ref, hash_single);
+		}
+	}
+
+	dm->release(dm);
+	BLI_threadapi_exit();
+}
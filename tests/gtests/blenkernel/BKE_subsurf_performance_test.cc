@@ -0,0 +1,177 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_threads.h"
+
+#include "BKE_cdderivedmesh.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_modifier.h"
+#include "BKE_subsurf.h"
+
+#include "PIL_time.h"
+}
+
+/* quads of the base mesh along each side */
+#define GRID_SIZE 64
+/* frames evaluated per case, the first one isn't timed */
+#define FRAMES_NUM 11
+#define LEVELS_MAX 4
+
+static DerivedMesh *grid_dm_new(int size)
+{
+	const int verts_num = (size + 1) * (size + 1);
+	DerivedMesh *dm = CDDM_new(verts_num, 0, 0, size * size * 4, size * size);
+	MVert *mvert = dm->getVertArray(dm);
+	MLoop *mloop = dm->getLoopArray(dm);
+	MPoly *mpoly = dm->getPolyArray(dm);
+
+	for (int y = 0; y <= size; y++) {
+		for (int x = 0; x <= size; x++, mvert++) {
+			mvert->co[0] = (float)x / size;
+			mvert->co[1] = (float)y / size;
+			mvert->co[2] = 0.0f;
+		}
+	}
+
+	for (int y = 0; y < size; y++) {
+		for (int x = 0; x < size; x++, mpoly++) {
+			const int v = y * (size + 1) + x;
+
+			mpoly->loopstart = (int)(mloop - dm->getLoopArray(dm));
+			mpoly->totloop = 4;
+			(mloop++)->v = v;
+			(mloop++)->v = v + 1;
+			(mloop++)->v = v + size + 2;
+			(mloop++)->v = v + size + 1;
+		}
+	}
+
+	CDDM_calc_edges(dm);
+
+	return dm;
+}
+
+/* move the vertices a little, as a deformed mesh would on every frame */
+static void grid_dm_deform(DerivedMesh *dm, int frame)
+{
+	MVert *mvert = dm->getVertArray(dm);
+	const int verts_num = dm->getNumVerts(dm);
+
+	for (int i = 0; i < verts_num; i++) {
+		mvert[i].co[2] = 0.01f * frame * mvert[i].co[0];
+	}
+}
+
+static unsigned int result_hash(DerivedMesh *result)
+{
+	DerivedMesh *dm = CDDM_copy(result);
+	unsigned int hash = BLI_hash_mm2((const unsigned char *)dm->getVertArray(dm),
+	                                 sizeof(MVert) * (size_t)dm->getNumVerts(dm), 0);
+	dm->release(dm);
+	return hash;
+}
+
+/**
+ * Evaluate \a FRAMES_NUM frames.
+ * \return Time of the fastest frame (milliseconds), other processes
+ * make the average too noisy to compare one thread and all of them.
+ */
+static double subsurf_frames_eval(DerivedMesh *dm, int levels, SubsurfFlags flags, bool use_incremental,
+                                  unsigned int *r_hash)
+{
+	SubsurfModifierData *smd = (SubsurfModifierData *)modifier_new(eModifierType_Subsurf);
+	double time_min = 0.0;
+
+	smd->levels = smd->renderLevels = (short)levels;
+	if (use_incremental) {
+		smd->flags |= eSubsurfModifierFlag_Incremental;
+	}
+
+	for (int frame = 0; frame < FRAMES_NUM; frame++) {
+		double time_start;
+		DerivedMesh *result;
+
+		grid_dm_deform(dm, frame);
+
+		time_start = PIL_check_seconds_timer();
+		result = subsurf_make_derived_from_derived(dm, smd, NULL, flags);
+		if (frame > 0) {
+			const double time = PIL_check_seconds_timer() - time_start;
+			time_min = (frame == 1) ? time : MIN2(time_min, time);
+		}
+
+		if (frame == FRAMES_NUM - 1) {
+			*r_hash = result_hash(result);
+		}
+		result->release(result);
+	}
+
+	modifier_free((ModifierData *)smd);
+
+	return time_min * 1000.0;
+}
+
+/* the task scheduler is created again with the overridden thread count */
+static void threads_num_override_set(int threads_num)
+{
+	BLI_system_num_threads_override_set(threads_num);
+	BLI_threadapi_exit();
+	BLI_threadapi_init();
+}
+
+/**
+ * Subdivision with one thread and with all of them, the threaded evaluation
+ * must give the same result. The incremental mode keeps the subdivided
+ * topology between frames (cached CCGSubSurf), only updating positions.
+ */
+TEST(subsurf, Performance)
+{
+	const int threads_num = BLI_system_thread_count();
+	DerivedMesh *dm;
+
+	BLI_threadapi_init();
+	BKE_modifier_init();
+	dm = grid_dm_new(GRID_SIZE);
+
+	printf("\n========== subsurf: %d faces, %d threads ==========\n", dm->getNumPolys(dm), threads_num);
+
+	for (int levels = 1; levels <= LEVELS_MAX; levels++) {
+		const struct {
+			const char *name;
+			SubsurfFlags flags;
+			bool use_incremental;
+		} cases[] = {
+			{"render", SUBSURF_USE_RENDER_PARAMS, false},
+			{"viewport", SUBSURF_IS_FINAL_CALC, false},
+			{"viewport incremental", SUBSURF_IS_FINAL_CALC, true},
+		};
+
+		for (int i = 0; i < (int)ARRAY_SIZE(cases); i++) {
+			unsigned int hash_single, hash_threaded;
+			double time_single, time_threaded;
+
+			threads_num_override_set(1);
+			time_single = subsurf_frames_eval(dm, levels, cases[i].flags, cases[i].use_incremental, &hash_single);
+
+			threads_num_override_set(0);
+			time_threaded = subsurf_frames_eval(dm, levels, cases[i].flags, cases[i].use_incremental, &hash_threaded);
+
+			printf("level %d %-20s 1 thread %8.2f ms, %d threads %8.2f ms\n",
+			       levels, cases[i].name, time_single, threads_num, time_threaded);
+
+			EXPECT_EQ(hash_single, hash_threaded);
+		}
+	}
+
+	dm->release(dm);
+	BLI_threadapi_exit();
+}
@@ -0,0 +1,142 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "zlib.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_gzip_frames.h"
+#include "BLI_rand.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+}
+
+#define DATA_SIZE (256 * 1024 * 1024)
+
+/* Roughly like the contents of a .blend: mesh coordinates, indices and zeroed structs. */
+static unsigned char *blend_like_data_new(void)
+{
+	struct RNG *rng = BLI_rng_new(0);
+	unsigned char *data = (unsigned char *)MEM_callocN(DATA_SIZE, __func__);
+	size_t offset = 0;
+
+	while (offset + (1 << 16) <= DATA_SIZE) {
+		const unsigned int kind = BLI_rng_get_uint(rng) % 3;
+		const size_t len = 1024 + BLI_rng_get_uint(rng) % ((1 << 16) - 1024);
+		if (kind == 0) {
+			float *co = (float *)(data + offset);
+			for (size_t i = 0; i < len / sizeof(float); i++) {
+				co[i] = (float)(i % 100) * 0.01f + BLI_rng_get_float(rng) * 0.001f;
+			}
+		}
+		else if (kind == 1) {
+			int *index = (int *)(data + offset);
+			for (size_t i = 0; i < len / sizeof(int); i++) {
+				index[i] = (int)(i / 4) + (int)(BLI_rng_get_uint(rng) % 8);
+			}
+		}
+		/* else zeroes */
+		offset += len;
+	}
+
+	BLI_rng_free(rng);
+	return data;
+}
+
+static size_t file_size(FILE *file)
+{
+	fseek(file, 0, SEEK_END);
+	const size_t size = (size_t)ftell(file);
+	fseek(file, 0, SEEK_SET);
+	return size;
+}
+
+static void print_result(const char *id, size_t size, double time_compress, double time_decompress)
+{
+	printf("%s: %.1f MB (%.1f%%), compress %.2fs (%.0f MB/s), decompress %.2fs (%.0f MB/s)\n",
+	       id, (double)size / (1024.0 * 1024.0), 100.0 * (double)size / DATA_SIZE,
+	       time_compress, DATA_SIZE / (1024.0 * 1024.0) / time_compress,
+	       time_decompress, DATA_SIZE / (1024.0 * 1024.0) / time_decompress);
+}
+
+/* the task scheduler is created again with the overridden thread count */
+static void threads_num_override_set(int threads_num)
+{
+	BLI_system_num_threads_override_set(threads_num);
+	BLI_threadapi_exit();
+	BLI_threadapi_init();
+}
+
+TEST(gzip_frames, CompareToGzip)
+{
+	BLI_threadapi_init();
+
+	unsigned char *data = blend_like_data_new();
+	unsigned char *result = (unsigned char *)MEM_mallocN(DATA_SIZE, __func__);
+
+	/* regular gzip, one stream, as .blend files were saved before */
+	{
+		FILE *file = tmpfile();
+		double time = PIL_check_seconds_timer();
+		gzFile gzfile = gzdopen(dup(fileno(file)), "wb1");
+		gzwrite(gzfile, data, DATA_SIZE);
+		gzclose(gzfile);
+		const double time_compress = PIL_check_seconds_timer() - time;
+
+		const size_t size = file_size(file);
+		time = PIL_check_seconds_timer();
+		gzfile = gzdopen(dup(fileno(file)), "rb");
+		EXPECT_EQ(DATA_SIZE, gzread(gzfile, result, DATA_SIZE));
+		gzclose(gzfile);
+		const double time_decompress = PIL_check_seconds_timer() - time;
+
+		EXPECT_EQ(0, memcmp(data, result, DATA_SIZE));
+		print_result("gzip", size, time_compress, time_decompress);
+		fclose(file);
+	}
+
+	/* frames, including reading the file into memory for decompression,
+	 * with one thread and with all of them */
+	for (int pass = 0; pass < 2; pass++) {
+		char id[32];
+
+		threads_num_override_set(pass == 0 ? 1 : 0);
+		snprintf(id, sizeof(id), "frames, %d threads", BLI_system_thread_count());
+
+		FILE *file = tmpfile();
+		double time = PIL_check_seconds_timer();
+		GzipFrameWriter *gw = BLI_gzip_frames_writer_new(fileno(file), 1);
+		EXPECT_TRUE(BLI_gzip_frames_writer_write(gw, data, DATA_SIZE));
+		EXPECT_TRUE(BLI_gzip_frames_writer_free(gw));
+		const double time_compress = PIL_check_seconds_timer() - time;
+
+		const size_t size = file_size(file);
+		time = PIL_check_seconds_timer();
+		unsigned char *mem = (unsigned char *)MEM_mallocN(size, __func__);
+		EXPECT_EQ(size, fread(mem, 1, size, file));
+		size_t result_len;
+		unsigned char *frames_result = (unsigned char *)BLI_gzip_frames_decompress(mem, size, &result_len);
+		const double time_decompress = PIL_check_seconds_timer() - time;
+
+		ASSERT_TRUE(frames_result != NULL);
+		EXPECT_EQ(DATA_SIZE, result_len);
+		EXPECT_EQ(0, memcmp(data, frames_result, DATA_SIZE));
+		print_result(id, size, time_compress, time_decompress);
+
+		MEM_freeN(frames_result);
+		MEM_freeN(mem);
+		fclose(file);
+	}
+
+	MEM_freeN(result);
+	MEM_freeN(data);
+
+	BLI_system_num_threads_override_set(0);
+	BLI_threadapi_exit();
+}
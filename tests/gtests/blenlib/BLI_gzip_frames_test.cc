@@ -0,0 +1,147 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "zlib.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_gzip_frames.h"
+#include "BLI_rand.h"
+#include "BLI_threads.h"
+}
+
+/* Some compressible data, the values repeat in a small range. */
+static unsigned char *test_data_new(size_t len)
+{
+	struct RNG *rng = BLI_rng_new(0);
+	unsigned char *data = (unsigned char *)MEM_mallocN(len + 1, __func__);
+	for (size_t i = 0; i < len; i++) {
+		data[i] = (unsigned char)(BLI_rng_get_uint(rng) % 16);
+	}
+	BLI_rng_free(rng);
+	return data;
+}
+
+/* Write in uneven parts, so writes cross the frame boundaries. */
+static FILE *test_file_write(const unsigned char *data, size_t len)
+{
+	FILE *file = tmpfile();
+	GzipFrameWriter *gw = BLI_gzip_frames_writer_new(fileno(file), 1);
+	size_t offset = 0, part = 1;
+
+	while (offset < len) {
+		const size_t part_len = MIN2(part, len - offset);
+		EXPECT_TRUE(BLI_gzip_frames_writer_write(gw, data + offset, part_len));
+		offset += part_len;
+		part = part * 7 + 3;
+	}
+	EXPECT_TRUE(BLI_gzip_frames_writer_free(gw));
+
+	return file;
+}
+
+static unsigned char *test_file_read(FILE *file, size_t *r_len)
+{
+	fseek(file, 0, SEEK_END);
+	*r_len = (size_t)ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	unsigned char *mem = (unsigned char *)MEM_mallocN(*r_len + 1, __func__);
+	EXPECT_EQ(*r_len, fread(mem, 1, *r_len, file));
+	return mem;
+}
+
+static void test_roundtrip(size_t len)
+{
+	unsigned char *data = test_data_new(len);
+	FILE *file = test_file_write(data, len);
+	size_t mem_len, result_len = 0;
+	unsigned char *mem = test_file_read(file, &mem_len);
+
+	EXPECT_TRUE(len == 0 || BLI_gzip_frames_check(mem, mem_len));
+
+	if (len != 0) {
+		unsigned char *result = (unsigned char *)BLI_gzip_frames_decompress(mem, mem_len, &result_len);
+		ASSERT_TRUE(result != NULL);
+		EXPECT_EQ(len, result_len);
+		EXPECT_EQ(0, memcmp(data, result, len));
+		MEM_freeN(result);
+	}
+
+	/* any gzip reader can read it */
+	lseek(fileno(file), 0, SEEK_SET);
+	gzFile gzfile = gzdopen(dup(fileno(file)), "rb");
+	unsigned char *result = (unsigned char *)MEM_mallocN(len + 1, __func__);
+	EXPECT_EQ((int)len, gzread(gzfile, result, (unsigned int)len + 1));
+	EXPECT_EQ(0, memcmp(data, result, len));
+	gzclose(gzfile);
+
+	MEM_freeN(result);
+	MEM_freeN(mem);
+	MEM_freeN(data);
+	fclose(file);
+}
+
+TEST(gzip_frames, RoundTrip)
+{
+	BLI_system_num_threads_override_set(4);
+	BLI_threadapi_init();
+
+	test_roundtrip(0);
+	test_roundtrip(1);
+	test_roundtrip(BLI_GZIP_FRAME_SIZE - 1);
+	test_roundtrip(BLI_GZIP_FRAME_SIZE);
+	/* more than fit the writer's frames at once */
+	test_roundtrip(BLI_GZIP_FRAME_SIZE * 19 + 1234);
+
+	BLI_threadapi_exit();
+	BLI_system_num_threads_override_set(0);
+}
+
+TEST(gzip_frames, Damaged)
+{
+	BLI_threadapi_init();
+
+	const size_t len = BLI_GZIP_FRAME_SIZE * 3;
+	unsigned char *data = test_data_new(len);
+	FILE *file = test_file_write(data, len);
+	size_t mem_len, result_len;
+	unsigned char *mem = test_file_read(file, &mem_len);
+
+	/* CRC error in the last frame */
+	mem[mem_len - 6] ^= 1;
+	EXPECT_EQ(NULL, BLI_gzip_frames_decompress(mem, mem_len, &result_len));
+	mem[mem_len - 6] ^= 1;
+
+	/* truncated */
+	EXPECT_EQ(NULL, BLI_gzip_frames_decompress(mem, mem_len - 1, &result_len));
+
+	MEM_freeN(mem);
+	MEM_freeN(data);
+	fclose(file);
+
+	BLI_threadapi_exit();
+}
+
+TEST(gzip_frames, RegularGzip)
+{
+	const unsigned char data[] = "BLENDER-v274";
+	FILE *file = tmpfile();
+	gzFile gzfile = gzdopen(dup(fileno(file)), "wb1");
+	gzwrite(gzfile, data, sizeof(data));
+	gzclose(gzfile);
+
+	size_t mem_len, result_len;
+	unsigned char *mem = test_file_read(file, &mem_len);
+	EXPECT_FALSE(BLI_gzip_frames_check(mem, mem_len));
+	EXPECT_EQ(NULL, BLI_gzip_frames_decompress(mem, mem_len, &result_len));
+
+	MEM_freeN(mem);
+	fclose(file);
+}
@@ -73,3 +73,62 @@ TEST(hash_mm2a, MM2AIntegers)
 #endif
 	EXPECT_EQ(hash, BLI_hash_mm2a_end(&mm2));
 }
+
+/* There is no reference implementation of the incremental 64 bits variant,
+ * it must give the same hash however the data is split. */
+TEST(hash_mm2a, MM64AConcatenate)
+{
+	BLI_HashMurmur64A mm64;
+	uint64_t hash;
+
+	const char *data1 = "Blender";
+	const char *data2 = " is ";
+	const char *data3 = "FaNtAsTiC";
+	const char *data123 = "Blender is FaNtAsTiC";
+	const int ints[4] = {1, 2, 3, 4};
+
+	BLI_hash_mm64a_init(&mm64, 0);
+	BLI_hash_mm64a_add(&mm64, (const unsigned char *)data1, strlen(data1));
+	BLI_hash_mm64a_add(&mm64, (const unsigned char *)data2, strlen(data2));
+	BLI_hash_mm64a_add(&mm64, (const unsigned char *)data3, strlen(data3));
+	hash = BLI_hash_mm64a_end(&mm64);
+	BLI_hash_mm64a_init(&mm64, 0);
+	BLI_hash_mm64a_add(&mm64, (const unsigned char *)data123, strlen(data123));
+	EXPECT_EQ(hash, BLI_hash_mm64a_end(&mm64));
+
+	BLI_hash_mm64a_init(&mm64, 0);
+	BLI_hash_mm64a_add_int(&mm64, ints[0]);
+	BLI_hash_mm64a_add_int(&mm64, ints[1]);
+	BLI_hash_mm64a_add_int(&mm64, ints[2]);
+	BLI_hash_mm64a_add_int(&mm64, ints[3]);
+	hash = BLI_hash_mm64a_end(&mm64);
+	BLI_hash_mm64a_init(&mm64, 0);
+	BLI_hash_mm64a_add(&mm64, (const unsigned char *)ints, sizeof(ints));
+	EXPECT_EQ(hash, BLI_hash_mm64a_end(&mm64));
+}
+
+/* Data only differing in its size (trailing zeros), or another seed, must give another hash, in the upper 32 bits too. */
+TEST(hash_mm2a, MM64ADifferent)
+{
+	BLI_HashMurmur64A mm64;
+	uint64_t hash_a, hash_b;
+
+	const unsigned char zeros[16] = {0};
+
+	BLI_hash_mm64a_init(&mm64, 0);
+	BLI_hash_mm64a_add(&mm64, zeros, 8);
+	hash_a = BLI_hash_mm64a_end(&mm64);
+	BLI_hash_mm64a_init(&mm64, 0);
+	BLI_hash_mm64a_add(&mm64, zeros, 16);
+	hash_b = BLI_hash_mm64a_end(&mm64);
+	EXPECT_NE(hash_a, hash_b);
+
+	BLI_hash_mm64a_init(&mm64, 0);
+	BLI_hash_mm64a_add(&mm64, zeros, 8);
+	hash_a = BLI_hash_mm64a_end(&mm64);
+	BLI_hash_mm64a_init(&mm64, 1);
+	BLI_hash_mm64a_add(&mm64, zeros, 8);
+	hash_b = BLI_hash_mm64a_end(&mm64);
+	EXPECT_NE(hash_a, hash_b);
+	EXPECT_NE(hash_a >> 32, hash_b >> 32);
+}
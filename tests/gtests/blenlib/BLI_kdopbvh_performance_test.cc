@@ -0,0 +1,138 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_kdopbvh.h"
+#include "BLI_rand.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Roughly a multi-million face mesh worth of leafs. */
+#define POINTS_NUM 2000000
+#define RAYS_NUM 100000
+
+static void rng_v3_array(struct RNG *rng, float (*coords)[3], int coords_num, float scale)
+{
+	for (int i = 0; i < coords_num; i++) {
+		for (int j = 0; j < 3; j++) {
+			coords[i][j] = (BLI_rng_get_float(rng) * 2.0f - 1.0f) * scale;
+		}
+	}
+}
+
+/* the task scheduler is created again with the overridden thread count */
+static void threads_num_override_set(int threads_num)
+{
+	BLI_system_num_threads_override_set(threads_num);
+	BLI_threadapi_exit();
+	BLI_threadapi_init();
+}
+
+static void kdopbvh_tests(char tree_type, char axis, const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	BLI_threadapi_init();
+
+	struct RNG *rng = BLI_rng_new(0);
+	float (*coords)[3] = (float (*)[3])MEM_mallocN(sizeof(*coords) * POINTS_NUM, __func__);
+	rng_v3_array(rng, coords, POINTS_NUM, 100.0f);
+
+	BVHTree *tree = NULL;
+	unsigned int overlap_tot[2] = {0, 0};
+
+	/* balance and overlap with one thread, then with all of them: the same pairs must be found */
+	for (int pass = 0; pass < 2; pass++) {
+		threads_num_override_set(pass == 0 ? 1 : 0);
+		printf("%d threads\n", BLI_system_thread_count());
+
+		if (tree) {
+			BLI_bvhtree_free(tree);
+		}
+		tree = BLI_bvhtree_new(POINTS_NUM, 0.01f, tree_type, axis);
+
+		{
+			TIMEIT_START(bvhtree_insert);
+			for (int i = 0; i < POINTS_NUM; i++) {
+				BLI_bvhtree_insert(tree, i, coords[i], 1);
+			}
+			TIMEIT_END(bvhtree_insert);
+		}
+
+		{
+			TIMEIT_START(bvhtree_balance);
+			BLI_bvhtree_balance(tree);
+			TIMEIT_END(bvhtree_balance);
+		}
+
+		{
+			BVHTreeOverlap *overlap;
+			TIMEIT_START(bvhtree_overlap_self);
+			overlap = BLI_bvhtree_overlap(tree, tree, &overlap_tot[pass], NULL, NULL);
+			TIMEIT_END(bvhtree_overlap_self);
+			printf("overlap pairs: %u\n", overlap_tot[pass]);
+			if (overlap) {
+				MEM_freeN(overlap);
+			}
+		}
+	}
+
+	EXPECT_EQ(overlap_tot[0], overlap_tot[1]);
+
+	{
+		float (*ray_co)[3] = (float (*)[3])MEM_mallocN(sizeof(*ray_co) * RAYS_NUM, __func__);
+		float (*ray_dir)[3] = (float (*)[3])MEM_mallocN(sizeof(*ray_dir) * RAYS_NUM, __func__);
+		BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits) * RAYS_NUM, __func__);
+
+		rng_v3_array(rng, ray_co, RAYS_NUM, 150.0f);
+		for (int i = 0; i < RAYS_NUM; i++) {
+			sub_v3_v3v3(ray_dir[i], coords[i], ray_co[i]);
+			normalize_v3(ray_dir[i]);
+		}
+
+		TIMEIT_START(bvhtree_ray_cast);
+		for (int i = 0; i < RAYS_NUM; i++) {
+			hits[i].index = -1;
+			hits[i].dist = FLT_MAX;
+			BLI_bvhtree_ray_cast(tree, ray_co[i], ray_dir[i], 0.0f, &hits[i], NULL, NULL);
+		}
+		TIMEIT_END(bvhtree_ray_cast);
+
+		for (int i = 0; i < RAYS_NUM; i++) {
+			hits[i].index = -1;
+			hits[i].dist = FLT_MAX;
+		}
+
+		TIMEIT_START(bvhtree_ray_cast_batch);
+		BLI_bvhtree_ray_cast_batch(tree, ray_co, ray_dir, RAYS_NUM, 0.0f, hits, NULL, NULL, BVH_RAYCAST_DEFAULT);
+		TIMEIT_END(bvhtree_ray_cast_batch);
+
+		MEM_freeN(ray_co);
+		MEM_freeN(ray_dir);
+		MEM_freeN(hits);
+	}
+
+	BLI_bvhtree_free(tree);
+	MEM_freeN(coords);
+	BLI_rng_free(rng);
+
+	BLI_system_num_threads_override_set(0);
+	BLI_threadapi_exit();
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdopbvh, Binary_AABB)
+{
+	kdopbvh_tests(2, 6, "Binary tree, 6-DOP (AABB)");
+}
+
+TEST(kdopbvh, Quad_26DOP)
+{
+	kdopbvh_tests(4, 26, "Quad tree, 26-DOP");
+}
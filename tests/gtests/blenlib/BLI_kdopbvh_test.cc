@@ -0,0 +1,215 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_kdopbvh.h"
+#include "BLI_rand.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+}
+
+/* Enough leafs to go over the threading threshold of the tree build. */
+#define POINTS_NUM 5000
+#define RAYS_NUM 500
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+static void rng_v3_array(struct RNG *rng, float (*coords)[3], int coords_num, float scale)
+{
+	for (int i = 0; i < coords_num; i++) {
+		for (int j = 0; j < 3; j++) {
+			coords[i][j] = (BLI_rng_get_float(rng) * 2.0f - 1.0f) * scale;
+		}
+	}
+}
+
+static BVHTree *bvhtree_from_points(const float (*coords)[3], int coords_num, float epsilon, char tree_type, char axis)
+{
+	/* tree build and overlap run on the task scheduler */
+	BLI_threadapi_init();
+
+	BVHTree *tree = BLI_bvhtree_new(coords_num, epsilon, tree_type, axis);
+	for (int i = 0; i < coords_num; i++) {
+		BLI_bvhtree_insert(tree, i, coords[i], 1);
+	}
+	BLI_bvhtree_balance(tree);
+	return tree;
+}
+
+/* Same comparisons as the tree uses for AABB's, so the result is exact. */
+static unsigned int overlap_count_brute_force(const float (*coords)[3], int coords_num, float epsilon)
+{
+	unsigned int tot = 0;
+	for (int a = 0; a < coords_num; a++) {
+		for (int b = 0; b < coords_num; b++) {
+			if (a == b) {
+				continue;
+			}
+			bool overlap = true;
+			for (int j = 0; j < 3; j++) {
+				if (((coords[a][j] - epsilon) > (coords[b][j] + epsilon)) ||
+				    ((coords[b][j] - epsilon) > (coords[a][j] + epsilon)))
+				{
+					overlap = false;
+					break;
+				}
+			}
+			tot += overlap ? 1 : 0;
+		}
+	}
+	return tot;
+}
+
+static void find_nearest_points_test(char tree_type, char axis)
+{
+	struct RNG *rng = BLI_rng_new(tree_type * 100 + axis);
+	float (*coords)[3] = (float (*)[3])MEM_mallocN(sizeof(*coords) * POINTS_NUM, __func__);
+	rng_v3_array(rng, coords, POINTS_NUM, 100.0f);
+
+	BVHTree *tree = bvhtree_from_points(coords, POINTS_NUM, 0.0f, tree_type, axis);
+
+	for (int i = 0; i < POINTS_NUM; i++) {
+		EXPECT_EQ(i, BLI_bvhtree_find_nearest(tree, coords[i], NULL, NULL, NULL));
+	}
+
+	BLI_bvhtree_free(tree);
+	MEM_freeN(coords);
+	BLI_rng_free(rng);
+}
+
+static void overlap_points_test(char tree_type, char axis)
+{
+	const float epsilon = 2.0f;
+	struct RNG *rng = BLI_rng_new(tree_type * 100 + axis);
+	float (*coords)[3] = (float (*)[3])MEM_mallocN(sizeof(*coords) * POINTS_NUM, __func__);
+	rng_v3_array(rng, coords, POINTS_NUM, 100.0f);
+
+	BVHTree *tree = bvhtree_from_points(coords, POINTS_NUM, epsilon, tree_type, axis);
+
+	unsigned int overlap_tot = 0;
+	BVHTreeOverlap *overlap = BLI_bvhtree_overlap(tree, tree, &overlap_tot, NULL, NULL);
+
+	EXPECT_EQ(overlap_count_brute_force(coords, POINTS_NUM, epsilon), overlap_tot);
+
+	if (overlap) {
+		MEM_freeN(overlap);
+	}
+	BLI_bvhtree_free(tree);
+	MEM_freeN(coords);
+	BLI_rng_free(rng);
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+TEST(kdopbvh, Single)
+{
+	const float co[3] = {1.0f, 2.0f, 3.0f};
+	BVHTree *tree = bvhtree_from_points(&co, 1, 0.0f, 2, 6);
+	EXPECT_EQ(0, BLI_bvhtree_find_nearest(tree, co, NULL, NULL, NULL));
+	BLI_bvhtree_free(tree);
+}
+
+TEST(kdopbvh, FindNearest_2_6)  { find_nearest_points_test(2, 6); }
+TEST(kdopbvh, FindNearest_4_8)  { find_nearest_points_test(4, 8); }
+TEST(kdopbvh, FindNearest_8_26) { find_nearest_points_test(8, 26); }
+
+/* AABB trees, so the overlap count can be checked exactly. */
+TEST(kdopbvh, OverlapSelf_2_6)  { overlap_points_test(2, 6); }
+TEST(kdopbvh, OverlapSelf_4_6)  { overlap_points_test(4, 6); }
+
+/* The thread passed to the callback is in range, and the overlaps found in the same order with any number of threads. */
+static bool overlap_thread_cb(void *userdata, int UNUSED(index_a), int UNUSED(index_b), int thread)
+{
+	const int thread_num = *(const int *)userdata;
+	EXPECT_GE(thread, 0);
+	EXPECT_LT(thread, thread_num);
+	return true;
+}
+
+static BVHTreeOverlap *overlap_threads_eval(BVHTree *tree, int threads_num, unsigned int *r_overlap_tot)
+{
+	/* the task scheduler is created again with the overridden thread count */
+	BLI_system_num_threads_override_set(threads_num);
+	BLI_threadapi_exit();
+	BLI_threadapi_init();
+
+	int thread_num = BLI_bvhtree_overlap_thread_num(tree);
+	EXPECT_EQ(threads_num, thread_num);
+	return BLI_bvhtree_overlap(tree, tree, r_overlap_tot, overlap_thread_cb, &thread_num);
+}
+
+TEST(kdopbvh, OverlapThreads)
+{
+	struct RNG *rng = BLI_rng_new(0);
+	float (*coords)[3] = (float (*)[3])MEM_mallocN(sizeof(*coords) * POINTS_NUM, __func__);
+	rng_v3_array(rng, coords, POINTS_NUM, 100.0f);
+
+	BVHTree *tree = bvhtree_from_points(coords, POINTS_NUM, 2.0f, 4, 6);
+
+	unsigned int overlap_single_tot = 0, overlap_threaded_tot = 0;
+	BVHTreeOverlap *overlap_single = overlap_threads_eval(tree, 1, &overlap_single_tot);
+	BVHTreeOverlap *overlap_threaded = overlap_threads_eval(tree, 4, &overlap_threaded_tot);
+
+	EXPECT_EQ(overlap_count_brute_force(coords, POINTS_NUM, 2.0f), overlap_single_tot);
+	ASSERT_EQ(overlap_single_tot, overlap_threaded_tot);
+	for (unsigned int i = 0; i < overlap_single_tot; i++) {
+		EXPECT_EQ(overlap_single[i].indexA, overlap_threaded[i].indexA);
+		EXPECT_EQ(overlap_single[i].indexB, overlap_threaded[i].indexB);
+	}
+
+	BLI_system_num_threads_override_set(0);
+	BLI_threadapi_exit();
+	BLI_threadapi_init();
+
+	MEM_freeN(overlap_single);
+	MEM_freeN(overlap_threaded);
+	BLI_bvhtree_free(tree);
+	MEM_freeN(coords);
+	BLI_rng_free(rng);
+}
+
+TEST(kdopbvh, RayCastBatch)
+{
+	struct RNG *rng = BLI_rng_new(0);
+	float (*coords)[3] = (float (*)[3])MEM_mallocN(sizeof(*coords) * POINTS_NUM, __func__);
+	float (*ray_co)[3] = (float (*)[3])MEM_mallocN(sizeof(*ray_co) * RAYS_NUM, __func__);
+	float (*ray_dir)[3] = (float (*)[3])MEM_mallocN(sizeof(*ray_dir) * RAYS_NUM, __func__);
+	BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits) * RAYS_NUM, __func__);
+
+	rng_v3_array(rng, coords, POINTS_NUM, 100.0f);
+	rng_v3_array(rng, ray_co, RAYS_NUM, 150.0f);
+	for (int i = 0; i < RAYS_NUM; i++) {
+		/* aim each ray close to one of the points, so most rays hit something */
+		sub_v3_v3v3(ray_dir[i], coords[i], ray_co[i]);
+		normalize_v3(ray_dir[i]);
+		hits[i].index = -1;
+		hits[i].dist = FLT_MAX;
+	}
+
+	BVHTree *tree = bvhtree_from_points(coords, POINTS_NUM, 0.5f, 4, 26);
+
+	BLI_bvhtree_ray_cast_batch(tree, ray_co, ray_dir, RAYS_NUM, 0.0f, hits, NULL, NULL, BVH_RAYCAST_DEFAULT);
+
+	for (int i = 0; i < RAYS_NUM; i++) {
+		BVHTreeRayHit hit;
+		hit.index = -1;
+		hit.dist = FLT_MAX;
+		BLI_bvhtree_ray_cast(tree, ray_co[i], ray_dir[i], 0.0f, &hit, NULL, NULL);
+
+		EXPECT_NE(-1, hits[i].index);
+		EXPECT_EQ(hit.index, hits[i].index);
+		EXPECT_EQ(hit.dist, hits[i].dist);
+	}
+
+	BLI_bvhtree_free(tree);
+	MEM_freeN(coords);
+	MEM_freeN(ray_co);
+	MEM_freeN(ray_dir);
+	MEM_freeN(hits);
+	BLI_rng_free(rng);
+}
@@ -0,0 +1,110 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_rand.h"
+#include "BLI_math.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* A few million vertices, about what a dense sculpt or scan mesh has. */
+#define VECS_NUM 4000000
+#define REPEAT_NUM 10
+
+static float (*rng_v3_array_new(int vecs_num, float scale))[3]
+{
+	struct RNG *rng = BLI_rng_new(0);
+	float (*vecs)[3] = (float (*)[3])MEM_mallocN(sizeof(*vecs) * (size_t)vecs_num, __func__);
+	for (int i = 0; i < vecs_num; i++) {
+		for (int j = 0; j < 3; j++) {
+			vecs[i][j] = (BLI_rng_get_float(rng) * 2.0f - 1.0f) * scale;
+		}
+	}
+	BLI_rng_free(rng);
+	return vecs;
+}
+
+TEST(math_array, Transform)
+{
+	float (*vecs)[3] = rng_v3_array_new(VECS_NUM, 100.0f);
+	float mat[4][4];
+	const float loc[3] = {1.0f, -2.0f, 3.5f}, eul[3] = {0.3f, -1.2f, 2.0f}, size[3] = {1.0f, 0.5f, 2.0f};
+
+	loc_eul_size_to_mat4(mat, loc, eul, size);
+
+	{
+		TIMEIT_START(mul_m4_v3);
+		for (int r = 0; r < REPEAT_NUM; r++) {
+			for (int i = 0; i < VECS_NUM; i++) {
+				mul_m4_v3(mat, vecs[i]);
+			}
+		}
+		TIMEIT_END(mul_m4_v3);
+	}
+
+	{
+		TIMEIT_START(mul_m4_v3_array);
+		for (int r = 0; r < REPEAT_NUM; r++) {
+			mul_m4_v3_array(mat, vecs, VECS_NUM);
+		}
+		TIMEIT_END(mul_m4_v3_array);
+	}
+
+	MEM_freeN(vecs);
+}
+
+TEST(math_array, Normalize)
+{
+	float (*vecs)[3] = rng_v3_array_new(VECS_NUM, 100.0f);
+
+	{
+		TIMEIT_START(normalize_v3);
+		for (int r = 0; r < REPEAT_NUM; r++) {
+			for (int i = 0; i < VECS_NUM; i++) {
+				normalize_v3(vecs[i]);
+			}
+		}
+		TIMEIT_END(normalize_v3);
+	}
+
+	{
+		TIMEIT_START(normalize_v3_array);
+		for (int r = 0; r < REPEAT_NUM; r++) {
+			normalize_v3_array(vecs, VECS_NUM);
+		}
+		TIMEIT_END(normalize_v3_array);
+	}
+
+	MEM_freeN(vecs);
+}
+
+TEST(math_array, MinMax)
+{
+	float (*vecs)[3] = rng_v3_array_new(VECS_NUM, 100.0f);
+	float min[3], max[3];
+
+	{
+		TIMEIT_START(minmax_v3v3_v3);
+		for (int r = 0; r < REPEAT_NUM; r++) {
+			INIT_MINMAX(min, max);
+			for (int i = 0; i < VECS_NUM; i++) {
+				minmax_v3v3_v3(min, max, vecs[i]);
+			}
+		}
+		TIMEIT_END(minmax_v3v3_v3);
+	}
+
+	{
+		TIMEIT_START(minmax_v3v3_v3_array);
+		for (int r = 0; r < REPEAT_NUM; r++) {
+			INIT_MINMAX(min, max);
+			minmax_v3v3_v3_array(min, max, vecs, VECS_NUM);
+		}
+		TIMEIT_END(minmax_v3v3_v3_array);
+	}
+
+	MEM_freeN(vecs);
+}
@@ -0,0 +1,105 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_rand.h"
+#include "BLI_math.h"
+}
+
+/* Not a multiple of four, so the remainder of the SSE loops runs too. */
+#define VECS_NUM 1023
+
+static void rng_v3_array(float (*vecs)[3], int vecs_num, float scale)
+{
+	struct RNG *rng = BLI_rng_new(0);
+	for (int i = 0; i < vecs_num; i++) {
+		for (int j = 0; j < 3; j++) {
+			vecs[i][j] = (BLI_rng_get_float(rng) * 2.0f - 1.0f) * scale;
+		}
+	}
+	BLI_rng_free(rng);
+}
+
+static void test_matrix(float mat[4][4])
+{
+	const float loc[3] = {1.0f, -2.0f, 3.5f};
+	const float eul[3] = {0.3f, -1.2f, 2.0f};
+	const float size[3] = {1.0f, 0.5f, 2.0f};
+	loc_eul_size_to_mat4(mat, loc, eul, size);
+	/* and something which isn't affine */
+	mat[0][3] = 0.25f;
+}
+
+/* The array functions do the same operations in the same order as #mul_m4_v3,
+ * so the results have to be exactly the same. */
+TEST(math_matrix, MulArray)
+{
+	float mat[4][4];
+	float vecs[VECS_NUM][3], vecs_ref[VECS_NUM][3], vecs_out[VECS_NUM][3];
+
+	test_matrix(mat);
+	rng_v3_array(vecs, VECS_NUM, 100.0f);
+	memcpy(vecs_ref, vecs, sizeof(vecs));
+	for (int i = 0; i < VECS_NUM; i++) {
+		mul_m4_v3(mat, vecs_ref[i]);
+	}
+
+	mul_v3_m4v3_array(vecs_out, mat, (const float (*)[3])vecs, VECS_NUM);
+	mul_m4_v3_array(mat, vecs, VECS_NUM);
+
+	for (int i = 0; i < VECS_NUM; i++) {
+		EXPECT_V3_NEAR(vecs_ref[i], vecs_out[i], 0.0f);
+		EXPECT_V3_NEAR(vecs_ref[i], vecs[i], 0.0f);
+	}
+}
+
+TEST(math_matrix, MulArrayShort)
+{
+	float mat[4][4];
+	float vecs[7][3], vecs_ref[7][3];
+
+	test_matrix(mat);
+	rng_v3_array(vecs, 7, 10.0f);
+
+	/* only the scalar remainder, and the vectors after it untouched */
+	for (int num = 0; num < 7; num++) {
+		float vecs_out[7][3];
+		memcpy(vecs_out, vecs, sizeof(vecs));
+		memcpy(vecs_ref, vecs, sizeof(vecs));
+		for (int i = 0; i < num; i++) {
+			mul_m4_v3(mat, vecs_ref[i]);
+		}
+
+		mul_m4_v3_array(mat, vecs_out, num);
+
+		for (int i = 0; i < 7; i++) {
+			EXPECT_V3_NEAR(vecs_ref[i], vecs_out[i], 0.0f);
+		}
+	}
+}
+
+TEST(math_matrix, MulArraySoA)
+{
+	float mat[4][4];
+	float vecs[VECS_NUM][3];
+	float x[VECS_NUM], y[VECS_NUM], z[VECS_NUM];
+
+	test_matrix(mat);
+	rng_v3_array(vecs, VECS_NUM, 100.0f);
+	for (int i = 0; i < VECS_NUM; i++) {
+		x[i] = vecs[i][0];
+		y[i] = vecs[i][1];
+		z[i] = vecs[i][2];
+		mul_m4_v3(mat, vecs[i]);
+	}
+
+	mul_m4_v3_array_soa(mat, x, y, z, VECS_NUM);
+
+	for (int i = 0; i < VECS_NUM; i++) {
+		const float co[3] = {x[i], y[i], z[i]};
+		EXPECT_V3_NEAR(vecs[i], co, 0.0f);
+	}
+}
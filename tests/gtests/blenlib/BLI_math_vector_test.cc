@@ -0,0 +1,137 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_rand.h"
+#include "BLI_math.h"
+}
+
+/* Not a multiple of four, so the remainder of the SSE loops runs too. */
+#define VECS_NUM 1023
+
+static void rng_v3_array(float (*vecs)[3], int vecs_num, float scale)
+{
+	struct RNG *rng = BLI_rng_new(0);
+	for (int i = 0; i < vecs_num; i++) {
+		for (int j = 0; j < 3; j++) {
+			vecs[i][j] = (BLI_rng_get_float(rng) * 2.0f - 1.0f) * scale;
+		}
+	}
+	BLI_rng_free(rng);
+}
+
+TEST(math_vector, NormalizeArray)
+{
+	float vecs[VECS_NUM][3], vecs_ref[VECS_NUM][3];
+
+	rng_v3_array(vecs, VECS_NUM, 100.0f);
+	zero_v3(vecs[5]);
+	copy_v3_fl(vecs[9], 1e-20f);
+	memcpy(vecs_ref, vecs, sizeof(vecs));
+
+	normalize_v3_array(vecs, VECS_NUM);
+
+	for (int i = 0; i < VECS_NUM; i++) {
+		normalize_v3(vecs_ref[i]);
+		EXPECT_V3_NEAR(vecs_ref[i], vecs[i], 1e-6f);
+	}
+	/* too short to normalize, like #normalize_v3 */
+	EXPECT_EQ(0.0f, len_v3(vecs[5]));
+	EXPECT_EQ(0.0f, len_v3(vecs[9]));
+}
+
+TEST(math_vector, NormalizeArraySoA)
+{
+	float vecs[VECS_NUM][3];
+	float x[VECS_NUM], y[VECS_NUM], z[VECS_NUM];
+
+	rng_v3_array(vecs, VECS_NUM, 100.0f);
+	for (int i = 0; i < VECS_NUM; i++) {
+		x[i] = vecs[i][0];
+		y[i] = vecs[i][1];
+		z[i] = vecs[i][2];
+	}
+
+	normalize_v3_array_soa(x, y, z, VECS_NUM);
+
+	for (int i = 0; i < VECS_NUM; i++) {
+		const float co[3] = {x[i], y[i], z[i]};
+		normalize_v3(vecs[i]);
+		EXPECT_V3_NEAR(vecs[i], co, 1e-6f);
+	}
+}
+
+TEST(math_vector, MinMaxArray)
+{
+	float vecs[VECS_NUM][3];
+	float x[VECS_NUM], y[VECS_NUM], z[VECS_NUM];
+
+	rng_v3_array(vecs, VECS_NUM, 100.0f);
+	for (int i = 0; i < VECS_NUM; i++) {
+		x[i] = vecs[i][0];
+		y[i] = vecs[i][1];
+		z[i] = vecs[i][2];
+	}
+
+	/* every count up to a few SSE iterations, plus the whole array */
+	for (int num = 1; num <= VECS_NUM; num = (num < 16) ? num + 1 : VECS_NUM) {
+		float min_ref[3], max_ref[3];
+		float min[3], max[3];
+
+		INIT_MINMAX(min_ref, max_ref);
+		for (int i = 0; i < num; i++) {
+			minmax_v3v3_v3(min_ref, max_ref, vecs[i]);
+		}
+
+		INIT_MINMAX(min, max);
+		minmax_v3v3_v3_array(min, max, vecs, num);
+		EXPECT_V3_NEAR(min_ref, min, 0.0f);
+		EXPECT_V3_NEAR(max_ref, max, 0.0f);
+
+		INIT_MINMAX(min, max);
+		minmax_v3v3_v3_array_soa(min, max, x, y, z, num);
+		EXPECT_V3_NEAR(min_ref, min, 0.0f);
+		EXPECT_V3_NEAR(max_ref, max, 0.0f);
+
+		if (num == VECS_NUM) {
+			break;
+		}
+	}
+}
+
+TEST(math_vector, MinMaxArrayStride)
+{
+	/* like MVert, other data after the coordinate */
+	struct Vert {
+		float co[3];
+		short no[3];
+		char flag, bweight;
+	};
+	float vecs[VECS_NUM][3];
+	Vert verts[VECS_NUM];
+	float min_ref[3], max_ref[3];
+	float min[3], max[3];
+
+	rng_v3_array(vecs, VECS_NUM, 100.0f);
+	INIT_MINMAX(min_ref, max_ref);
+	for (int i = 0; i < VECS_NUM; i++) {
+		copy_v3_v3(verts[i].co, vecs[i]);
+		minmax_v3v3_v3(min_ref, max_ref, vecs[i]);
+	}
+
+	/* existing bounds are extended, not reset */
+	const float outside[3] = {-1000.0f, -1000.0f, -1000.0f};
+	copy_v3_v3(min, outside);
+	copy_v3_v3(max, outside);
+	minmax_v3v3_v3_array_stride(min, max, verts[0].co, sizeof(Vert), VECS_NUM);
+	EXPECT_V3_NEAR(outside, min, 0.0f);
+	EXPECT_V3_NEAR(max_ref, max, 0.0f);
+
+	INIT_MINMAX(min, max);
+	minmax_v3v3_v3_array_stride(min, max, verts[0].co, sizeof(Vert), VECS_NUM);
+	EXPECT_V3_NEAR(min_ref, min, 0.0f);
+	EXPECT_V3_NEAR(max_ref, max, 0.0f);
+}
@@ -0,0 +1,85 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <stddef.h>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_rand.h"
+#include "BLI_sort.h"
+#include "BLI_sort_utils.h"
+#include "BLI_threads.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Edges or polygons of a multi-million face mesh. */
+#define ITEMS_NUM 4000000
+
+static struct SortIntByInt *sort_items_new(void)
+{
+	struct RNG *rng = BLI_rng_new(0);
+	struct SortIntByInt *items = (struct SortIntByInt *)MEM_mallocN(sizeof(*items) * ITEMS_NUM, __func__);
+	for (int i = 0; i < ITEMS_NUM; i++) {
+		items[i].sort_value = (int)(BLI_rng_get_uint(rng) % (ITEMS_NUM * 4));
+		items[i].data = i;
+	}
+	BLI_rng_free(rng);
+	return items;
+}
+
+static int sort_item_cmp(const void *a, const void *b, void *UNUSED(thunk))
+{
+	return BLI_sortutil_cmp_int(a, b);
+}
+
+static void sort_items_check(const struct SortIntByInt *items)
+{
+	for (int i = 1; i < ITEMS_NUM; i++) {
+		EXPECT_LE(items[i - 1].sort_value, items[i].sort_value);
+	}
+}
+
+TEST(sort, IntKeys)
+{
+	BLI_threadapi_init();
+
+	struct SortIntByInt *items = sort_items_new();
+	{
+		TIMEIT_START(qsort);
+		qsort(items, ITEMS_NUM, sizeof(*items), BLI_sortutil_cmp_int);
+		TIMEIT_END(qsort);
+	}
+	sort_items_check(items);
+	MEM_freeN(items);
+
+	items = sort_items_new();
+	{
+		TIMEIT_START(BLI_qsort);
+		BLI_qsort_r(items, ITEMS_NUM, sizeof(*items), sort_item_cmp, items);
+		TIMEIT_END(BLI_qsort);
+	}
+	sort_items_check(items);
+	MEM_freeN(items);
+
+	items = sort_items_new();
+	{
+		TIMEIT_START(BLI_mergesort_parallel_r);
+		BLI_mergesort_parallel_r(items, ITEMS_NUM, sizeof(*items), sort_item_cmp, items);
+		TIMEIT_END(BLI_mergesort_parallel_r);
+	}
+	sort_items_check(items);
+	MEM_freeN(items);
+
+	items = sort_items_new();
+	{
+		TIMEIT_START(BLI_radix_sort_i32);
+		BLI_radix_sort_i32(items, ITEMS_NUM, sizeof(*items), offsetof(struct SortIntByInt, sort_value));
+		TIMEIT_END(BLI_radix_sort_i32);
+	}
+	sort_items_check(items);
+	MEM_freeN(items);
+
+	BLI_threadapi_exit();
+}
@@ -0,0 +1,172 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_rand.h"
+#include "BLI_sort.h"
+#include "BLI_sort_utils.h"
+#include "BLI_threads.h"
+}
+
+/* Big enough for the parallel sort to use several chunks. */
+#define ITEMS_NUM 100000
+
+/* Element with the key not at the start, and not a multiple of the key size. */
+typedef struct SortItem {
+	char pad;
+	union {
+		unsigned int u;
+		int i;
+		float f;
+	} key;
+	uint64_t key_u64;
+	int index;
+} SortItem;
+
+static void sort_items_init(SortItem *items, int items_num, unsigned int key_range)
+{
+	struct RNG *rng = BLI_rng_new(0);
+	for (int i = 0; i < items_num; i++) {
+		items[i].pad = 0;
+		items[i].key.u = BLI_rng_get_uint(rng) % key_range;
+		items[i].key_u64 = ((uint64_t)BLI_rng_get_uint(rng) << 32) | BLI_rng_get_uint(rng);
+		items[i].index = i;
+	}
+	BLI_rng_free(rng);
+}
+
+static int sort_item_cmp_u32(const void *a_, const void *b_, void *UNUSED(thunk))
+{
+	const SortItem *a = (const SortItem *)a_, *b = (const SortItem *)b_;
+	return (a->key.u > b->key.u) ? 1 : (a->key.u < b->key.u) ? -1 : 0;
+}
+
+TEST(sort, RadixU32Stable)
+{
+	SortItem *items = (SortItem *)MEM_mallocN(sizeof(*items) * ITEMS_NUM, __func__);
+
+	/* few distinct keys, so stability is tested */
+	sort_items_init(items, ITEMS_NUM, 1000);
+	BLI_radix_sort_u32(items, ITEMS_NUM, sizeof(*items), offsetof(SortItem, key));
+
+	for (int i = 1; i < ITEMS_NUM; i++) {
+		EXPECT_LE(items[i - 1].key.u, items[i].key.u);
+		if (items[i - 1].key.u == items[i].key.u) {
+			EXPECT_LT(items[i - 1].index, items[i].index);
+		}
+	}
+
+	MEM_freeN(items);
+}
+
+TEST(sort, RadixI32)
+{
+	SortItem *items = (SortItem *)MEM_mallocN(sizeof(*items) * ITEMS_NUM, __func__);
+
+	sort_items_init(items, ITEMS_NUM, UINT_MAX);
+	items[0].key.i = INT_MIN;
+	items[1].key.i = INT_MAX;
+	items[2].key.i = -1;
+	items[3].key.i = 0;
+	BLI_radix_sort_i32(items, ITEMS_NUM, sizeof(*items), offsetof(SortItem, key));
+
+	EXPECT_EQ(INT_MIN, items[0].key.i);
+	EXPECT_EQ(INT_MAX, items[ITEMS_NUM - 1].key.i);
+	for (int i = 1; i < ITEMS_NUM; i++) {
+		EXPECT_LE(items[i - 1].key.i, items[i].key.i);
+	}
+
+	MEM_freeN(items);
+}
+
+TEST(sort, RadixFloat)
+{
+	SortItem *items = (SortItem *)MEM_mallocN(sizeof(*items) * ITEMS_NUM, __func__);
+	struct RNG *rng = BLI_rng_new(1);
+
+	sort_items_init(items, ITEMS_NUM, 1);
+	for (int i = 0; i < ITEMS_NUM; i++) {
+		items[i].key.f = (BLI_rng_get_float(rng) - 0.5f) * 1e6f;
+	}
+	items[0].key.f = -INFINITY;
+	items[1].key.f = INFINITY;
+	items[2].key.f = 0.0f;
+	items[3].key.f = -1e-30f;
+	BLI_rng_free(rng);
+
+	BLI_radix_sort_fl(items, ITEMS_NUM, sizeof(*items), offsetof(SortItem, key));
+
+	EXPECT_EQ(-INFINITY, items[0].key.f);
+	EXPECT_EQ(INFINITY, items[ITEMS_NUM - 1].key.f);
+	for (int i = 1; i < ITEMS_NUM; i++) {
+		EXPECT_LE(items[i - 1].key.f, items[i].key.f);
+	}
+
+	MEM_freeN(items);
+}
+
+TEST(sort, RadixU64)
+{
+	SortItem *items = (SortItem *)MEM_mallocN(sizeof(*items) * ITEMS_NUM, __func__);
+
+	sort_items_init(items, ITEMS_NUM, 1);
+	BLI_radix_sort_u64(items, ITEMS_NUM, sizeof(*items), offsetof(SortItem, key_u64));
+
+	for (int i = 1; i < ITEMS_NUM; i++) {
+		EXPECT_LE(items[i - 1].key_u64, items[i].key_u64);
+	}
+
+	MEM_freeN(items);
+}
+
+TEST(sort, RadixSmall)
+{
+	int keys[3] = {2, -5, 2};
+
+	BLI_radix_sort_i32(keys, 0, sizeof(int), 0);
+	BLI_radix_sort_i32(keys, 1, sizeof(int), 0);
+	EXPECT_EQ(2, keys[0]);
+
+	BLI_radix_sort_i32(keys, 3, sizeof(int), 0);
+	EXPECT_EQ(-5, keys[0]);
+	EXPECT_EQ(2, keys[1]);
+	EXPECT_EQ(2, keys[2]);
+}
+
+TEST(sort, MergeSortParallel)
+{
+	/* several threads even on a single core, so the merges run */
+	BLI_system_num_threads_override_set(4);
+	BLI_threadapi_init();
+
+	/* sizes around the chunk boundaries, and below the threshold */
+	const int sizes[] = {0, 1, 100, 8191, 8192, 8193, 65537, ITEMS_NUM};
+	SortItem *items = (SortItem *)MEM_mallocN(sizeof(*items) * ITEMS_NUM, __func__);
+
+	for (int s = 0; s < (int)ARRAY_SIZE(sizes); s++) {
+		const int items_num = sizes[s];
+
+		sort_items_init(items, items_num, 1000);
+		BLI_mergesort_parallel_r(items, (size_t)items_num, sizeof(*items), sort_item_cmp_u32, NULL);
+
+		/* sorted, and each element there exactly once */
+		int64_t index_sum = items_num ? items[0].index : 0;
+		for (int i = 1; i < items_num; i++) {
+			EXPECT_LE(items[i - 1].key.u, items[i].key.u);
+			index_sum += items[i].index;
+		}
+		EXPECT_EQ((int64_t)items_num * (items_num - 1) / 2, index_sum);
+	}
+
+	MEM_freeN(items);
+
+	BLI_threadapi_exit();
+	BLI_system_num_threads_override_set(0);
+}
@@ -0,0 +1,161 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include <string.h>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+
+#include "DNA_ID.h"
+#include "DNA_key_types.h"
+#include "DNA_material_types.h"
+#include "DNA_mesh_types.h"
+
+#include "BLI_listbase.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_global.h"
+#include "BKE_key.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_material.h"
+#include "BKE_mesh.h"
+
+#include "BLO_readfile.h"
+#include "BLO_undofile.h"
+#include "BLO_writefile.h"
+}
+
+static ID *find_id(ListBase *lb, const char *name)
+{
+	return (ID *)BLI_findstring(lb, name, offsetof(ID, name));
+}
+
+/* read an undo step, main is the current one (freed), memfile_current its step */
+static Main *read_undo_step(Main *main, MemFile *memfile, MemFile *memfile_current)
+{
+	BlendFileData *bfd = BLO_read_from_memfile(main, "", memfile, memfile_current, NULL);
+	Main *main_new;
+
+	EXPECT_TRUE(bfd != NULL);
+	main_new = bfd->main;
+	MEM_freeN(bfd);
+
+	BKE_main_free(main);
+	G.main = main_new;
+	BLO_memfile_main_read(memfile, main_new);
+
+	return main_new;
+}
+
+/* the ID pointers of the mesh are the ones of main */
+static void expect_mesh_linked(Main *main, Mesh *me_expected)
+{
+	Mesh *me = (Mesh *)find_id(&main->mesh, "MEMesh");
+
+	ASSERT_TRUE(me != NULL);
+	/* kept, not read again */
+	EXPECT_EQ(me_expected, me);
+
+	ASSERT_EQ(2, me->totcol);
+	EXPECT_EQ(find_id(&main->mat, "MARed"), (ID *)me->mat[0]);
+	EXPECT_EQ(find_id(&main->mat, "MABlue"), (ID *)me->mat[1]);
+	EXPECT_TRUE(me->mat[0] != NULL);
+	EXPECT_EQ(1, me->mat[0]->id.us);
+
+	EXPECT_TRUE(me->key != NULL);
+	EXPECT_EQ(main->key.first, (void *)me->key);
+	EXPECT_EQ((ID *)me, me->key->from);
+
+	EXPECT_TRUE(me->texcomesh != NULL);
+	EXPECT_EQ(find_id(&main->mesh, "METexco"), (ID *)me->texcomesh);
+}
+
+TEST(blo_undo, KeptMeshUndoRedo)
+{
+	MemFile memfile_a, memfile_b;
+	Main *main = BKE_main_new();
+	Material *ma;
+	Mesh *me;
+
+	memset(&memfile_a, 0, sizeof(memfile_a));
+	memset(&memfile_b, 0, sizeof(memfile_b));
+
+	G.main = main;
+	me = BKE_mesh_add(main, "Mesh");
+	BKE_material_append_id(&me->id, BKE_material_add(main, "Red"));
+	ma = BKE_material_add(main, "Blue");
+	BKE_material_append_id(&me->id, ma);
+	me->key = BKE_key_add(&me->id);
+	me->texcomesh = BKE_mesh_add(main, "Texco");
+	id_us_plus(&me->texcomesh->id);
+
+	/* two undo steps, only the material changes */
+	BLO_write_file_mem(main, NULL, &memfile_a, 0);
+	ma->r = 0.25f;
+	BLO_write_file_mem(main, &memfile_a, &memfile_b, 0);
+
+	/* undo: the current main wrote the step it's read with */
+	main = read_undo_step(main, &memfile_a, &memfile_b);
+	expect_mesh_linked(main, me);
+	EXPECT_EQ(0.8f, ((Material *)find_id(&main->mat, "MABlue"))->r);
+
+	/* redo: the current main was read, its IDs aren't where they're stored */
+	main = read_undo_step(main, &memfile_b, &memfile_a);
+	expect_mesh_linked(main, me);
+	EXPECT_EQ(0.25f, ((Material *)find_id(&main->mat, "MABlue"))->r);
+
+	/* and again */
+	main = read_undo_step(main, &memfile_a, &memfile_b);
+	expect_mesh_linked(main, me);
+
+	BKE_main_free(main);
+	G.main = NULL;
+	BLO_memfile_free(&memfile_a);
+	BLO_memfile_free(&memfile_b);
+}
+
+TEST(blo_undo, EditedSinceStep)
+{
+	MemFile memfile_a, memfile_b;
+	Main *main = BKE_main_new();
+	Material *ma;
+	Mesh *me, *me_read;
+
+	memset(&memfile_a, 0, sizeof(memfile_a));
+	memset(&memfile_b, 0, sizeof(memfile_b));
+
+	G.main = main;
+	me = BKE_mesh_add(main, "Mesh");
+	me->smoothresh = 0.5f;
+	ma = BKE_material_add(main, "Blue");
+
+	BLO_write_file_mem(main, NULL, &memfile_a, 0);
+	ma->r = 0.25f;
+	BLO_write_file_mem(main, &memfile_a, &memfile_b, 0);
+
+	/* edited without an undo step (operators without undo, scripts),
+	 * memfile_b doesn't store the mesh as it is now */
+	me->smoothresh = 1.0f;
+
+	main = read_undo_step(main, &memfile_a, &memfile_b);
+	me_read = (Mesh *)find_id(&main->mesh, "MEMesh");
+	ASSERT_TRUE(me_read != NULL);
+	EXPECT_NE(me, me_read);
+	EXPECT_EQ(0.5f, me_read->smoothresh);
+
+	/* the same after an undo, the current main was read from its step */
+	me_read->smoothresh = 2.0f;
+	me = me_read;
+
+	main = read_undo_step(main, &memfile_b, &memfile_a);
+	me_read = (Mesh *)find_id(&main->mesh, "MEMesh");
+	ASSERT_TRUE(me_read != NULL);
+	EXPECT_NE(me, me_read);
+	EXPECT_EQ(0.5f, me_read->smoothresh);
+
+	BKE_main_free(main);
+	G.main = NULL;
+	BLO_memfile_free(&memfile_a);
+	BLO_memfile_free(&memfile_b);
+}
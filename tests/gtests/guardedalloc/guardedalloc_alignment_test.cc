@@ -51,3 +51,17 @@ TEST(guardedalloc, GuardedAlignedAlloc32)
 	DoBasicAlignmentChecks(16);
 }
 #endif
+
+TEST(guardedalloc, SlabAlignedAlloc16)
+{
+	MEM_use_slab_allocator();
+	DoBasicAlignmentChecks(16);
+}
+
+#ifndef __APPLE__
+TEST(guardedalloc, SlabAlignedAlloc32)
+{
+	MEM_use_slab_allocator();
+	DoBasicAlignmentChecks(32);
+}
+#endif
@@ -0,0 +1,84 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <string>
+
+#include "MEM_guardedalloc.h"
+
+#define PROFILE_FILEPATH "guardedalloc_heap_profiler_test.json"
+
+namespace {
+
+std::string ReadFile(const char *filepath)
+{
+	std::ifstream file(filepath);
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	return buffer.str();
+}
+
+/* The line of the tags array with totals of the given name. */
+std::string TagLine(const std::string &json, const std::string &name_json)
+{
+	const size_t start = json.find("{\"name\": " + name_json + ",");
+	if (start == std::string::npos) {
+		return "";
+	}
+	return json.substr(start, json.find('\n', start) - start);
+}
+
+}  // namespace
+
+TEST(guardedalloc, HeapProfiler)
+{
+	/* sampling every byte, so the estimates are exact */
+	MEM_use_heap_profiler(PROFILE_FILEPATH, 1);
+
+	/* same name at another address */
+	char name_a[] = "profiler_test_a";
+	void *blocks_a[10], *blocks_b[5], *block_quoted;
+
+	for (int i = 0; i < 10; i++) {
+		blocks_a[i] = MEM_mallocN(100, (i & 1) ? name_a : "profiler_test_a");
+	}
+	for (int i = 0; i < 5; i++) {
+		blocks_b[i] = MEM_callocN(1000, "profiler_test_b");
+	}
+	block_quoted = MEM_mallocN(16, "profiler \"test\"");
+
+	for (int i = 0; i < 5; i++) {
+		MEM_freeN(blocks_a[i]);
+	}
+	blocks_b[0] = MEM_reallocN_id(blocks_b[0], 2000, "profiler_test_b");
+
+	ASSERT_TRUE(MEM_heap_profiler_write());
+	const std::string json = ReadFile(PROFILE_FILEPATH);
+	remove(PROFILE_FILEPATH);
+
+	const std::string tag_a = TagLine(json, "\"profiler_test_a\"");
+	EXPECT_NE(std::string::npos, tag_a.find("\"alloc_count\": 10,"));
+	EXPECT_NE(std::string::npos, tag_a.find("\"alloc_bytes\": 1000,"));
+	EXPECT_NE(std::string::npos, tag_a.find("\"live_bytes\": 500,"));
+	EXPECT_NE(std::string::npos, tag_a.find("\"peak_live_bytes\": 1000,"));
+	EXPECT_NE(std::string::npos, tag_a.find("\"sizes\": {\"64\": 10}"));
+
+	const std::string tag_b = TagLine(json, "\"profiler_test_b\"");
+	EXPECT_NE(std::string::npos, tag_b.find("\"alloc_count\": 6,"));
+	EXPECT_NE(std::string::npos, tag_b.find("\"live_bytes\": 6000,"));
+	EXPECT_NE(std::string::npos, tag_b.find("\"peak_live_bytes\": 6000,"));
+
+	EXPECT_NE("", TagLine(json, "\"profiler \\\"test\\\"\""));
+	EXPECT_NE(std::string::npos, json.find("\"timeline\": ["));
+
+	for (int i = 5; i < 10; i++) {
+		MEM_freeN(blocks_a[i]);
+	}
+	for (int i = 0; i < 5; i++) {
+		MEM_freeN(blocks_b[i]);
+	}
+	MEM_freeN(block_quoted);
+}
@@ -0,0 +1,102 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "MEM_guardedalloc.h"
+
+/* Roughly what reading a big .blend file does: lots of small structs,
+ * now and then a big array, and about half of it still alive at the end. */
+#define ALLOCS_NUM 2000000
+#define LIVE_NUM 4096
+
+namespace {
+
+/* Same sequence for every allocator, so timings can be compared. */
+unsigned int lcg_next(unsigned int *seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+	return *seed >> 8;
+}
+
+size_t trace_block_size(unsigned int *seed)
+{
+	const unsigned int r = lcg_next(seed);
+	if ((r & 1023) == 0) {
+		/* arrays, 4KB .. 1MB */
+		return (size_t)4096 << ((r >> 10) % 9);
+	}
+	/* structs, 16 .. 512 bytes */
+	return 16 + (size_t)((r >> 10) % 497);
+}
+
+void allocation_trace_run(const char *id)
+{
+	void **live = (void **)calloc(LIVE_NUM, sizeof(*live));
+	void **kept = (void **)malloc(sizeof(*kept) * ALLOCS_NUM);
+	unsigned int kept_num = 0;
+	unsigned int seed = 0;
+
+	const clock_t start = clock();
+
+	for (unsigned int i = 0; i < ALLOCS_NUM; i++) {
+		const size_t len = trace_block_size(&seed);
+		const unsigned int slot = lcg_next(&seed) % LIVE_NUM;
+
+		if (live[slot]) {
+			/* half of the replaced blocks stay allocated until the end */
+			if (lcg_next(&seed) & 1) {
+				kept[kept_num++] = live[slot];
+			}
+			else {
+				MEM_freeN(live[slot]);
+			}
+		}
+
+		live[slot] = (i & 3) ? MEM_mallocN(len, __func__) : MEM_callocN(len, __func__);
+		memset(live[slot], 1, 8);
+	}
+
+	const clock_t alloc_end = clock();
+
+	for (unsigned int i = 0; i < LIVE_NUM; i++) {
+		if (live[i]) {
+			MEM_freeN(live[i]);
+		}
+	}
+	for (unsigned int i = 0; i < kept_num; i++) {
+		MEM_freeN(kept[i]);
+	}
+
+	const clock_t end = clock();
+
+	printf("%s: alloc %.3fs, free %.3fs (%u blocks kept, peak %.1f MB)\n",
+	       id,
+	       (double)(alloc_end - start) / CLOCKS_PER_SEC,
+	       (double)(end - alloc_end) / CLOCKS_PER_SEC,
+	       kept_num,
+	       (double)MEM_get_peak_memory() / (1024.0 * 1024.0));
+
+	EXPECT_EQ(0, MEM_get_memory_blocks_in_use());
+
+	free(live);
+	free(kept);
+}
+
+}  // namespace
+
+/* The lock-free allocator is the default one and can't be switched back to,
+ * so it has to run first. */
+TEST(guardedalloc, AllocationTrace)
+{
+	allocation_trace_run("lockfree");
+
+	MEM_use_slab_allocator();
+	allocation_trace_run("slab");
+
+	MEM_use_guarded_allocator();
+	allocation_trace_run("guarded");
+}
@@ -0,0 +1,115 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+/* same rounding as the allocators apply */
+#define SIZE_ALIGN_4(len) (((len) + 3) & ~(size_t)3)
+
+#define BLOCKS_NUM 10000
+
+namespace {
+
+/* Deterministic sizes, so failures can be reproduced. */
+size_t BlockSize(unsigned int i)
+{
+	return (size_t)((i * 2654435761u) >> 22);  /* 0..1023 */
+}
+
+}  // namespace
+
+TEST(guardedalloc, SlabAllocNLen)
+{
+	MEM_use_slab_allocator();
+
+	/* cover every size class, and the switch to the system allocator */
+	for (size_t len = 0; len < 2048; len++) {
+		char *ptr = (char *)MEM_mallocN(len, __func__);
+		EXPECT_EQ(SIZE_ALIGN_4(len), MEM_allocN_len(ptr));
+		memset(ptr, 1, MEM_allocN_len(ptr));
+		MEM_freeN(ptr);
+	}
+}
+
+TEST(guardedalloc, SlabCallocClearsReusedBlocks)
+{
+	MEM_use_slab_allocator();
+
+	for (size_t len = 4; len < 1024; len += 60) {
+		char *ptr = (char *)MEM_mallocN(len, __func__);
+		memset(ptr, 255, len);
+		MEM_freeN(ptr);
+
+		/* most likely the very same block as above */
+		ptr = (char *)MEM_callocN(len, __func__);
+		for (size_t i = 0; i < len; i++) {
+			EXPECT_EQ(0, ptr[i]);
+		}
+		MEM_freeN(ptr);
+	}
+}
+
+TEST(guardedalloc, SlabReallocKeepsContents)
+{
+	MEM_use_slab_allocator();
+
+	size_t len = 8;
+	unsigned char *ptr = (unsigned char *)MEM_mallocN(len, __func__);
+	for (size_t i = 0; i < len; i++) {
+		ptr[i] = (unsigned char)i;
+	}
+
+	/* grow from the smallest size class up to system allocated blocks */
+	while (len < 8192) {
+		len *= 2;
+		ptr = (unsigned char *)MEM_recallocN(ptr, len);
+		for (size_t i = 0; i < len / 2; i++) {
+			EXPECT_EQ((unsigned char)i, ptr[i]);
+		}
+		for (size_t i = len / 2; i < len; i++) {
+			EXPECT_EQ(0, ptr[i]);
+			ptr[i] = (unsigned char)i;
+		}
+	}
+
+	/* and shrink back */
+	ptr = (unsigned char *)MEM_reallocN(ptr, 12);
+	for (size_t i = 0; i < 12; i++) {
+		EXPECT_EQ((unsigned char)i, ptr[i]);
+	}
+	MEM_freeN(ptr);
+}
+
+TEST(guardedalloc, SlabManyBlocks)
+{
+	MEM_use_slab_allocator();
+
+	const unsigned int blocks_in_use = MEM_get_memory_blocks_in_use();
+	const size_t memory_in_use = MEM_get_memory_in_use();
+	unsigned int **blocks = (unsigned int **)MEM_mallocN(sizeof(*blocks) * BLOCKS_NUM, __func__);
+
+	/* twice, so the second round gets blocks which went through the thread cache and shared pools */
+	for (int round = 0; round < 2; round++) {
+		for (unsigned int i = 0; i < BLOCKS_NUM; i++) {
+			blocks[i] = (unsigned int *)MEM_mallocN(sizeof(unsigned int) + BlockSize(i), __func__);
+			blocks[i][0] = i;
+		}
+
+		/* a block handed out twice would have been overwritten */
+		for (unsigned int i = 0; i < BLOCKS_NUM; i++) {
+			EXPECT_EQ(i, blocks[i][0]);
+		}
+
+		for (unsigned int i = 0; i < BLOCKS_NUM; i++) {
+			MEM_freeN(blocks[i]);
+		}
+	}
+
+	MEM_freeN(blocks);
+
+	EXPECT_EQ(blocks_in_use, MEM_get_memory_blocks_in_use());
+	EXPECT_EQ(memory_in_use, MEM_get_memory_in_use());
+}
@@ -0,0 +1,204 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Time loading a .blend file with lots of small data blocks,
+written in another order than they are linked.
+
+This runs with a regular Python 3, not inside Blender:
+a text datablock with many lines is added to a template file,
+every line and its string being one block, in random order.
+
+Example Usage:
+
+python3 tests/python/bl_load_blocks_performance.py \\
+    --blender=./bin/blender \\
+    --template=release/datafiles/preview.blend \\
+    --blocks=10000000
+"""
+
+import os
+import random
+import struct
+import subprocess
+import tempfile
+import time
+
+
+def sdna_parse(data):
+    """ Struct sizes and member offsets, from the data of the DNA1 block. """
+    assert(data[0:8] == b'SDNANAME')
+    offset = 4
+
+    def read_int():
+        nonlocal offset
+        value = struct.unpack_from('<i', data, offset)[0]
+        offset += 4
+        return value
+
+    def read_strings(tag):
+        nonlocal offset
+        assert(data[offset:offset + 4] == tag)
+        offset += 4
+        strings = []
+        for i in range(read_int()):
+            end = data.index(b'\0', offset)
+            strings.append(data[offset:end].decode('ascii'))
+            offset = end + 1
+        offset = (offset + 3) & ~3
+        return strings
+
+    names = read_strings(b'NAME')
+    types = read_strings(b'TYPE')
+
+    assert(data[offset:offset + 4] == b'TLEN')
+    offset += 4
+    type_lengths = struct.unpack_from('<%dh' % len(types), data, offset)
+    offset = (offset + 2 * len(types) + 3) & ~3
+
+    assert(data[offset:offset + 4] == b'STRC')
+    offset += 4
+    structs = {}
+    for i in range(read_int()):
+        type_index, members_num = struct.unpack_from('<hh', data, offset)
+        offset += 4
+        members = {}
+        member_offset = 0
+        for j in range(members_num):
+            member_type, member_name = struct.unpack_from('<hh', data, offset)
+            offset += 4
+            name = names[member_name]
+            if name.startswith(('*', '(*')):
+                size = 8
+            else:
+                size = type_lengths[member_type]
+            for dim in name.split('[')[1:]:
+                size *= int(dim.rstrip(']'))
+            # '*next', '(*func)()', 'name[66]' -> 'next', 'func', 'name'
+            key = name.lstrip('(*').split('[')[0].split(')')[0]
+            members[key] = member_offset
+            member_offset += size
+        structs[types[type_index]] = (i, type_lengths[type_index], members)
+
+    return structs
+
+
+def blocks_read(data):
+    assert(data[0:12] == b'BLENDER-v' + data[9:12])
+    offset = 12
+    blocks = []
+    while True:
+        code, length = struct.unpack_from('<4si', data, offset)
+        end = offset + 24 + (length if code != b'ENDB' else 0)
+        blocks.append((code, data[offset:end]))
+        if code == b'ENDB':
+            return blocks
+        offset = end
+
+
+def file_write(template, filepath, blocks_num):
+    data = open(template, 'rb').read()
+    if data[7:9] != b'-v':
+        raise Exception("Template must be an uncompressed, 64 bit little endian file")
+
+    blocks = blocks_read(data)
+    structs = sdna_parse([b for code, b in blocks if code == b'DNA1'][0][24:])
+
+    text_index, text_size, text_members = structs['Text']
+    id_members = structs['ID'][2]
+    line_index, line_size, line_members = structs['TextLine']
+
+    lines_num = blocks_num // 2
+    line_text = b'line\0\0\0\0'
+
+    def line_old(i):
+        return 0x100000000 + i * 128
+
+    def line_str_old(i):
+        return 0x100000000 + i * 128 + 64
+
+    text = bytearray(text_size)
+    name = b'TXbench'
+    name_offset = text_members['id'] + id_members['name']
+    text[name_offset:name_offset + len(name)] = name
+    struct.pack_into('<QQ', text, text_members['lines'],
+                     line_old(0), line_old(lines_num - 1))
+    struct.pack_into('<QQ', text, text_members['curl'],
+                     line_old(0), line_old(0))
+
+    with open(filepath, 'wb') as f:
+        f.write(data[0:12])
+        for code, block in blocks:
+            if code == b'DNA1':
+                f.write(struct.pack('<4siQii', b'TX\0\0', text_size,
+                                    0x10000, text_index, 1))
+                f.write(text)
+
+                order = list(range(lines_num))
+                random.seed(0)
+                random.shuffle(order)
+                line = bytearray(line_size)
+                for i in order:
+                    struct.pack_into(
+                        '<QQQQii', line, 0,
+                        line_old(i + 1) if i + 1 < lines_num else 0,
+                        line_old(i - 1) if i > 0 else 0,
+                        line_str_old(i), 0, 4, 0)
+                    f.write(struct.pack('<4siQii', b'DATA', line_size,
+                                        line_old(i), line_index, 1))
+                    f.write(line)
+                    f.write(struct.pack('<4siQii', b'DATA', len(line_text),
+                                        line_str_old(i), 0, 1))
+                    f.write(line_text)
+            f.write(block)
+
+
+def load_time(blender, filepath):
+    time_start = time.time()
+    subprocess.check_call([blender, '--background', '--factory-startup',
+                           filepath],
+                          stdout=subprocess.DEVNULL)
+    return time.time() - time_start
+
+
+def main():
+    import argparse
+
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('--blender', required=True)
+    parser.add_argument('--template', required=True,
+                        help="uncompressed 64 bit .blend to add blocks to")
+    parser.add_argument('--blocks', type=int, default=10000000)
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tempdir:
+        filepath = os.path.join(tempdir, 'blocks.blend')
+        file_write(args.template, filepath, args.blocks)
+
+        time_template = load_time(args.blender, args.template)
+        time_blocks = load_time(args.blender, filepath)
+
+        print("%d blocks (%.1f MB): %.2fs, template %.2fs" %
+              (args.blocks, os.path.getsize(filepath) / (1024.0 * 1024.0),
+               time_blocks, time_template))
+
+
+if __name__ == '__main__':
+    main()